@@ -222,3 +222,7 @@ int __init fips_signature_selftest(void)
 	key_put(keyring);
 	return 0;
 }
+
+#ifdef CONFIG_FIPS_SIGNATURE_KUNIT_BENCH
+#include "selftest_kunit.c"
+#endif
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit benchmark of the public key operation of signature verification
+ *
+ * Included from selftest.c, to reuse its test data. Times verify_signature()
+ * alone, as the signature of a module or an IMA-appraised file costs it once
+ * the digest is known.
+ */
+
+#include <kunit/bench.h>
+#include <kunit/test.h>
+
+#include <keys/asymmetric-type.h>
+#include <crypto/public_key.h>
+#include "pkcs7_parser.h"
+
+struct certs_bench_ctx {
+	struct key *key;
+	const struct public_key_signature *sig;
+};
+
+static void certs_bench_verify(void *data)
+{
+	struct certs_bench_ctx *ctx = data;
+
+	verify_signature(ctx->key, ctx->sig);
+}
+
+static void __init certs_bench_run(struct kunit *test,
+				   const struct certs_test *t,
+				   struct key *keyring)
+{
+	struct certs_bench_ctx ctx;
+	struct pkcs7_message *pkcs7;
+	struct kunit_bench bench = {
+		.name = "verify_signature",
+		.fn = certs_bench_verify,
+		.ctx = &ctx,
+	};
+	int ret;
+
+	pkcs7 = pkcs7_parse_message(t->pkcs7, t->pkcs7_len);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, pkcs7);
+	pkcs7_supply_detached_data(pkcs7, t->data, t->data_len);
+
+	/* Computes the digest, the benchmark then only verifies it */
+	ret = pkcs7_verify(pkcs7, VERIFYING_MODULE_SIGNATURE);
+	KUNIT_EXPECT_EQ(test, ret, 0);
+	if (ret < 0)
+		goto out;
+
+	ctx.sig = pkcs7->signed_infos->sig;
+	ctx.key = find_asymmetric_key(keyring, ctx.sig->auth_ids[0], NULL, NULL,
+				      false);
+	KUNIT_EXPECT_FALSE(test, IS_ERR(ctx.key));
+	if (IS_ERR(ctx.key))
+		goto out;
+
+	/* Do not time a verification that fails */
+	ret = verify_signature(ctx.key, ctx.sig);
+	KUNIT_EXPECT_EQ(test, ret, 0);
+	if (!ret) {
+		kunit_info(test, "%s %s\n", ctx.sig->pkey_algo,
+			   ctx.sig->hash_algo);
+		kunit_bench_run(test, &bench, NULL);
+	}
+	key_put(ctx.key);
+out:
+	pkcs7_free_message(pkcs7);
+}
+
+static void __init certs_bench_verify_signature(struct kunit *test)
+{
+	struct key *keyring;
+	int ret, i;
+
+	if (!kunit_bench_enabled(test))
+		kunit_skip(test, "benchmarks disabled or not exclusive");
+
+	keyring = keyring_alloc(".certs_bench",
+				GLOBAL_ROOT_UID, GLOBAL_ROOT_GID, current_cred(),
+				(KEY_POS_ALL & ~KEY_POS_SETATTR) |
+				KEY_USR_VIEW | KEY_USR_READ |
+				KEY_USR_SEARCH,
+				KEY_ALLOC_NOT_IN_QUOTA,
+				NULL, NULL);
+	KUNIT_ASSERT_FALSE(test, IS_ERR(keyring));
+
+	ret = x509_load_certificate_list(certs_selftest_keys,
+					 sizeof(certs_selftest_keys) - 1, keyring);
+	KUNIT_EXPECT_EQ(test, ret, 0);
+	for (i = 0; !ret && i < ARRAY_SIZE(certs_tests); i++)
+		certs_bench_run(test, &certs_tests[i], keyring);
+
+	key_put(keyring);
+}
+
+static struct kunit_case __initdata certs_bench_cases[] = {
+	KUNIT_CASE(certs_bench_verify_signature),
+	{}
+};
+
+static struct kunit_suite __initdata certs_bench_suite = {
+	.name = "certs_selftest",
+	.test_cases = certs_bench_cases,
+	/* for the timings */
+	.exclusive = true,
+};
+
+kunit_test_init_section_suites(&certs_bench_suite);
@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Programmable completion latency model for timer completions
+ * (irqmode=2): per-direction latency distributions, periodic GC-like stalls
+ * and a per-queue limit on concurrently serviced commands, plus measured
+ * completion latency histograms exported through sysfs.
+ */
+#include <linux/random.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/math64.h>
+#include "null_blk.h"
+
+#undef pr_fmt
+#define pr_fmt(fmt)	"null_blk: " fmt
+
+/* log2(e) in Q16 fixed point */
+#define NULL_LAT_LOG2E		94548
+#define NULL_LAT_MAX_NSEC	(10ULL * NSEC_PER_SEC)
+
+struct null_lat_stats {
+	u64 hist[2][NULL_LAT_BUCKETS];
+};
+
+static bool null_lat_modelled(struct nullb_device *dev)
+{
+	return dev->lat_dist != NULL_LAT_FIXED || dev->read_lat_nsec ||
+		dev->write_lat_nsec || dev->gc_interval_msec ||
+		dev->max_outstanding;
+}
+
+int null_lat_validate_conf(struct nullb_device *dev)
+{
+	if (dev->lat_dist > NULL_LAT_BIMODAL) {
+		pr_err("invalid lat_dist %u\n", dev->lat_dist);
+		return -EINVAL;
+	}
+	dev->lat_sigma = min_t(unsigned int, dev->lat_sigma, 4000);
+	dev->lat_slow_ppm = min_t(unsigned int, dev->lat_slow_ppm, 1000000);
+
+	if (dev->gc_interval_msec && dev->gc_stall_msec >= dev->gc_interval_msec) {
+		pr_err("gc_stall_msec must be smaller than gc_interval_msec\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int null_lat_setup(struct nullb *nullb, unsigned int nr_queues)
+{
+	struct nullb_device *dev = nullb->dev;
+
+	nullb->lat_epoch = ktime_get();
+
+	nullb->lat_stats = alloc_percpu(struct null_lat_stats);
+	if (!nullb->lat_stats)
+		return -ENOMEM;
+
+	if (dev->max_outstanding) {
+		nullb->lat_slots = kcalloc(nr_queues * dev->max_outstanding,
+					   sizeof(ktime_t), GFP_KERNEL);
+		if (!nullb->lat_slots) {
+			free_percpu(nullb->lat_stats);
+			nullb->lat_stats = NULL;
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+void null_lat_cleanup(struct nullb *nullb)
+{
+	kfree(nullb->lat_slots);
+	nullb->lat_slots = NULL;
+	free_percpu(nullb->lat_stats);
+	nullb->lat_stats = NULL;
+}
+
+void null_lat_init_queue(struct nullb *nullb, struct nullb_queue *nq)
+{
+	unsigned int max = nullb->dev->max_outstanding;
+
+	spin_lock_init(&nq->lat_lock);
+	if (nullb->lat_slots) {
+		nq->lat_slots = nullb->lat_slots + (nq - nullb->queues) * max;
+		memset(nq->lat_slots, 0, max * sizeof(ktime_t));
+	}
+}
+
+/*
+ * Sample a log-normal latency with the given median and shape sigma (in
+ * thousandths), without using the FPU: the normal variate comes from an
+ * Irwin-Hall sum of 12 uniforms and exp() is evaluated as a power of two
+ * with a quadratic approximation of the fractional part.
+ */
+static u64 null_lat_lognormal(u64 median, unsigned int sigma)
+{
+	s64 z = 0, y;
+	u64 f, frac;
+	int i, ip;
+
+	for (i = 0; i < 12; i++)
+		z += get_random_u16();
+	z -= 6LL << 16;
+
+	y = div_s64(z * sigma, 1000);
+	y = (y * NULL_LAT_LOG2E) >> 16;
+
+	ip = y >> 16;
+	f = y & 0xffff;
+	frac = 65536 + ((f * 43025) >> 16) + ((((f * f) >> 16) * 22512) >> 16);
+	ip = clamp(ip, -32, 20);
+
+	median = (median * frac) >> 16;
+	median = ip >= 0 ? median << ip : median >> -ip;
+
+	return min_t(u64, median, NULL_LAT_MAX_NSEC);
+}
+
+static u64 null_lat_sample(struct nullb_device *dev, bool is_write)
+{
+	u64 base = is_write ? dev->write_lat_nsec : dev->read_lat_nsec;
+
+	if (!base)
+		base = dev->completion_nsec;
+
+	switch (dev->lat_dist) {
+	case NULL_LAT_LOGNORMAL:
+		return null_lat_lognormal(base, dev->lat_sigma);
+	case NULL_LAT_BIMODAL:
+		if (get_random_u32_below(1000000) < dev->lat_slow_ppm)
+			return dev->lat_slow_nsec;
+		return base;
+	default:
+		return base;
+	}
+}
+
+/* Push a completion time that falls inside a GC stall to the end of it. */
+static ktime_t null_lat_gc_stall(struct nullb *nullb, ktime_t done)
+{
+	struct nullb_device *dev = nullb->dev;
+	u64 interval = (u64)dev->gc_interval_msec * NSEC_PER_MSEC;
+	u64 stall = (u64)dev->gc_stall_msec * NSEC_PER_MSEC;
+	u64 phase;
+
+	if (!interval || !stall)
+		return done;
+
+	div64_u64_rem(ktime_sub(done, nullb->lat_epoch), interval, &phase);
+	if (phase < stall)
+		done = ktime_add_ns(done, stall - phase);
+	return done;
+}
+
+/*
+ * Return the delay after which @cmd should complete.  With max_outstanding
+ * set, each queue services at most that many commands at a time: a command
+ * starts once the earliest busy slot frees up and occupies it until its own
+ * completion.
+ */
+ktime_t null_lat_next(struct nullb_cmd *cmd, bool is_write)
+{
+	struct nullb_queue *nq = cmd->nq;
+	struct nullb_device *dev = nq->dev;
+	struct nullb *nullb = dev->nullb;
+	ktime_t now = ktime_get(), start = now, done;
+	unsigned int i, slot = 0;
+	unsigned long flags;
+
+	cmd->lat_start = now;
+	cmd->lat_write = is_write;
+
+	if (!null_lat_modelled(dev))
+		return dev->completion_nsec;
+
+	if (nq->lat_slots) {
+		spin_lock_irqsave(&nq->lat_lock, flags);
+		for (i = 1; i < dev->max_outstanding; i++)
+			if (nq->lat_slots[i] < nq->lat_slots[slot])
+				slot = i;
+		start = max(now, nq->lat_slots[slot]);
+	}
+
+	done = ktime_add_ns(start, null_lat_sample(dev, is_write));
+	done = null_lat_gc_stall(nullb, done);
+
+	if (nq->lat_slots) {
+		nq->lat_slots[slot] = done;
+		spin_unlock_irqrestore(&nq->lat_lock, flags);
+	}
+
+	return ktime_sub(done, now);
+}
+
+void null_lat_account(struct nullb_cmd *cmd)
+{
+	struct nullb *nullb = cmd->nq->dev->nullb;
+	u64 lat = ktime_to_ns(ktime_sub(ktime_get(), cmd->lat_start));
+	unsigned int bucket = lat ? min_t(unsigned int, ilog2(lat),
+						 NULL_LAT_BUCKETS - 1) : 0;
+
+	this_cpu_inc(nullb->lat_stats->hist[cmd->lat_write][bucket]);
+}
+
+static ssize_t null_lat_hist_show(struct device *dev, char *page, bool write)
+{
+	struct nullb *nullb = dev_to_disk(dev)->private_data;
+	u64 hist[NULL_LAT_BUCKETS] = { };
+	int cpu, i, last = -1;
+	ssize_t len = 0;
+
+	for_each_possible_cpu(cpu) {
+		struct null_lat_stats *s = per_cpu_ptr(nullb->lat_stats, cpu);
+
+		for (i = 0; i < NULL_LAT_BUCKETS; i++)
+			hist[i] += s->hist[write][i];
+	}
+
+	for (i = 0; i < NULL_LAT_BUCKETS; i++)
+		if (hist[i])
+			last = i;
+
+	/* one "<bucket lower bound in ns> <count>" line per log2 bucket */
+	for (i = 0; i <= last; i++)
+		len += sysfs_emit_at(page, len, "%llu %llu\n",
+				     i ? 1ULL << i : 0ULL, hist[i]);
+	return len;
+}
+
+static ssize_t read_lat_hist_show(struct device *dev,
+				  struct device_attribute *attr, char *page)
+{
+	return null_lat_hist_show(dev, page, false);
+}
+static DEVICE_ATTR_RO(read_lat_hist);
+
+static ssize_t write_lat_hist_show(struct device *dev,
+				   struct device_attribute *attr, char *page)
+{
+	return null_lat_hist_show(dev, page, true);
+}
+static DEVICE_ATTR_RO(write_lat_hist);
+
+static ssize_t lat_hist_reset_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *page, size_t count)
+{
+	struct nullb *nullb = dev_to_disk(dev)->private_data;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(nullb->lat_stats, cpu), 0,
+		       sizeof(struct null_lat_stats));
+	return count;
+}
+static DEVICE_ATTR_WO(lat_hist_reset);
+
+static struct attribute *null_lat_attrs[] = {
+	&dev_attr_read_lat_hist.attr,
+	&dev_attr_write_lat_hist.attr,
+	&dev_attr_lat_hist_reset.attr,
+	NULL,
+};
+
+static const struct attribute_group null_lat_attr_group = {
+	.name	= "null_blk",
+	.attrs	= null_lat_attrs,
+};
+
+const struct attribute_group *null_lat_attr_groups[] = {
+	&null_lat_attr_group,
+	NULL,
+};
@@ -427,6 +427,15 @@ NULLB_DEVICE_ATTR(zone_max_active, uint, NULL);
 NULLB_DEVICE_ATTR(virt_boundary, bool, NULL);
 NULLB_DEVICE_ATTR(no_sched, bool, NULL);
 NULLB_DEVICE_ATTR(shared_tag_bitmap, bool, NULL);
+NULLB_DEVICE_ATTR(lat_dist, uint, NULL);
+NULLB_DEVICE_ATTR(read_lat_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(write_lat_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(lat_sigma, uint, NULL);
+NULLB_DEVICE_ATTR(lat_slow_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(lat_slow_ppm, uint, NULL);
+NULLB_DEVICE_ATTR(gc_interval_msec, uint, NULL);
+NULLB_DEVICE_ATTR(gc_stall_msec, uint, NULL);
+NULLB_DEVICE_ATTR(max_outstanding, uint, NULL);
 
 static ssize_t nullb_device_power_show(struct config_item *item, char *page)
 {
@@ -572,6 +581,15 @@ static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_virt_boundary,
 	&nullb_device_attr_no_sched,
 	&nullb_device_attr_shared_tag_bitmap,
+	&nullb_device_attr_lat_dist,
+	&nullb_device_attr_read_lat_nsec,
+	&nullb_device_attr_write_lat_nsec,
+	&nullb_device_attr_lat_sigma,
+	&nullb_device_attr_lat_slow_nsec,
+	&nullb_device_attr_lat_slow_ppm,
+	&nullb_device_attr_gc_interval_msec,
+	&nullb_device_attr_gc_stall_msec,
+	&nullb_device_attr_max_outstanding,
 	NULL,
 };
 
@@ -629,10 +647,13 @@ static ssize_t memb_group_features_show(struct config_item *item, char *page)
 {
 	return snprintf(page, PAGE_SIZE,
 			"badblocks,blocking,blocksize,cache_size,"
-			"completion_nsec,discard,home_node,hw_queue_depth,"
-			"irqmode,max_sectors,mbps,memory_backed,no_sched,"
-			"poll_queues,power,queue_mode,shared_tag_bitmap,size,"
-			"submit_queues,use_per_node_hctx,virt_boundary,zoned,"
+			"completion_nsec,discard,gc_interval_msec,"
+			"gc_stall_msec,home_node,hw_queue_depth,irqmode,"
+			"lat_dist,lat_sigma,lat_slow_nsec,lat_slow_ppm,"
+			"max_outstanding,max_sectors,mbps,memory_backed,"
+			"no_sched,poll_queues,power,queue_mode,read_lat_nsec,"
+			"shared_tag_bitmap,size,submit_queues,"
+			"use_per_node_hctx,virt_boundary,write_lat_nsec,zoned,"
 			"zone_capacity,zone_max_active,zone_max_open,"
 			"zone_nr_conv,zone_offline,zone_readonly,zone_size\n");
 }
@@ -813,15 +834,25 @@ static void end_cmd(struct nullb_cmd *cmd)
 
 static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 {
-	end_cmd(container_of(timer, struct nullb_cmd, timer));
+	struct nullb_cmd *cmd = container_of(timer, struct nullb_cmd, timer);
+
+	null_lat_account(cmd);
+	end_cmd(cmd);
 
 	return HRTIMER_NORESTART;
 }
 
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	enum req_op op;
+	ktime_t kt;
+
+	if (cmd->nq->dev->queue_mode == NULL_Q_BIO)
+		op = bio_op(cmd->bio);
+	else
+		op = req_op(cmd->rq);
 
+	kt = null_lat_next(cmd, op_is_write(op));
 	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
 }
 
@@ -1718,6 +1749,7 @@ static void cleanup_queues(struct nullb *nullb)
 		cleanup_queue(&nullb->queues[i]);
 
 	kfree(nullb->queues);
+	null_lat_cleanup(nullb);
 }
 
 static void null_exit_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
@@ -1735,6 +1767,7 @@ static void null_init_queue(struct nullb *nullb, struct nullb_queue *nq)
 	nq->dev = nullb->dev;
 	INIT_LIST_HEAD(&nq->poll_list);
 	spin_lock_init(&nq->poll_lock);
+	null_lat_init_queue(nullb, nq);
 }
 
 static int null_init_hctx(struct blk_mq_hw_ctx *hctx, void *driver_data,
@@ -1865,6 +1898,11 @@ static int setup_queues(struct nullb *nullb)
 	if (!nullb->queues)
 		return -ENOMEM;
 
+	if (null_lat_setup(nullb, nqueues)) {
+		kfree(nullb->queues);
+		return -ENOMEM;
+	}
+
 	nullb->queue_depth = nullb->dev->hw_queue_depth;
 	return 0;
 }
@@ -1911,7 +1949,7 @@ static int null_gendisk_register(struct nullb *nullb)
 			return ret;
 	}
 
-	return add_disk(disk);
+	return device_add_disk(NULL, disk, null_lat_attr_groups);
 }
 
 static int null_init_tag_set(struct nullb *nullb, struct blk_mq_tag_set *set)
@@ -2001,7 +2039,7 @@ static int null_validate_conf(struct nullb_device *dev)
 		return -EINVAL;
 	}
 
-	return 0;
+	return null_lat_validate_conf(dev);
 }
 
 #ifdef CONFIG_BLK_DEV_NULL_BLK_FAULT_INJECTION
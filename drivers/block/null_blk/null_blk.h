@@ -25,6 +25,8 @@ struct nullb_cmd {
 	bool fake_timeout;
 	struct nullb_queue *nq;
 	struct hrtimer timer;
+	ktime_t lat_start;
+	bool lat_write;
 };
 
 struct nullb_queue {
@@ -37,6 +39,9 @@ struct nullb_queue {
 	struct list_head poll_list;
 	spinlock_t poll_lock;
 
+	ktime_t *lat_slots; /* busy-until time of each max_outstanding slot */
+	spinlock_t lat_lock;
+
 	struct nullb_cmd *cmds;
 };
 
@@ -60,6 +65,15 @@ struct nullb_zone {
 	unsigned int capacity;
 };
 
+/* Completion latency distributions */
+enum {
+	NULL_LAT_FIXED		= 0,
+	NULL_LAT_LOGNORMAL	= 1,
+	NULL_LAT_BIMODAL	= 2,
+};
+
+#define NULL_LAT_BUCKETS	40
+
 /* Queue modes */
 enum {
 	NULL_Q_BIO	= 0,
@@ -106,6 +120,15 @@ struct nullb_device {
 	unsigned int hw_queue_depth; /* queue depth */
 	unsigned int index; /* index of the disk, only valid with a disk */
 	unsigned int mbps; /* Bandwidth throttle cap (in MB/s) */
+	unsigned int lat_dist; /* completion latency distribution */
+	unsigned long read_lat_nsec; /* median read latency, 0: completion_nsec */
+	unsigned long write_lat_nsec; /* median write latency, 0: completion_nsec */
+	unsigned int lat_sigma; /* log-normal shape in thousandths */
+	unsigned long lat_slow_nsec; /* bimodal slow mode latency */
+	unsigned int lat_slow_ppm; /* bimodal slow mode probability in ppm */
+	unsigned int gc_interval_msec; /* period of GC-like stalls */
+	unsigned int gc_stall_msec; /* length of each GC-like stall */
+	unsigned int max_outstanding; /* commands serviced at once per queue */
 	bool blocking; /* blocking blk-mq device */
 	bool use_per_node_hctx; /* use per-node allocation for hardware context */
 	bool power; /* power on/off the device */
@@ -128,6 +151,9 @@ struct nullb {
 	unsigned int queue_depth;
 	atomic_long_t cur_bytes;
 	struct hrtimer bw_timer;
+	ktime_t lat_epoch;
+	ktime_t *lat_slots;
+	struct null_lat_stats __percpu *lat_stats;
 	unsigned long cache_flush_pos;
 	spinlock_t lock;
 
@@ -141,6 +167,14 @@ blk_status_t null_handle_discard(struct nullb_device *dev, sector_t sector,
 blk_status_t null_process_cmd(struct nullb_cmd *cmd, enum req_op op,
 			      sector_t sector, unsigned int nr_sectors);
 
+int null_lat_validate_conf(struct nullb_device *dev);
+int null_lat_setup(struct nullb *nullb, unsigned int nr_queues);
+void null_lat_cleanup(struct nullb *nullb);
+void null_lat_init_queue(struct nullb *nullb, struct nullb_queue *nq);
+ktime_t null_lat_next(struct nullb_cmd *cmd, bool is_write);
+void null_lat_account(struct nullb_cmd *cmd);
+extern const struct attribute_group *null_lat_attr_groups[];
+
 #ifdef CONFIG_BLK_DEV_ZONED
 int null_init_zoned_dev(struct nullb_device *dev, struct request_queue *q);
 int null_register_zoned_dev(struct nullb *nullb);
@@ -864,7 +864,8 @@ static void bcmgenet_set_ring_rx_coalesce(struct bcmgenet_rx_ring *ring,
 	pkts = ring->rx_max_coalesced_frames;
 
 	if (ec->use_adaptive_rx_coalesce && !ring->dim.use_dim) {
-		moder = net_dim_get_def_rx_moderation(ring->dim.dim.mode);
+		moder = net_dim_get_def_rx_irq_moder(ring->priv->dev,
+						     ring->dim.dim.mode);
 		usecs = moder.usec;
 		pkts = moder.pkts;
 	}
@@ -2426,7 +2427,7 @@ static void bcmgenet_dim_work(struct work_struct *work)
 	struct bcmgenet_rx_ring *ring =
 			container_of(ndim, struct bcmgenet_rx_ring, dim);
 	struct dim_cq_moder cur_profile =
-			net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+			net_dim_get_rx_irq_moder(ring->priv->dev, dim);
 
 	bcmgenet_set_rx_coalesce(ring, cur_profile.usec, cur_profile.pkts);
 	dim->state = DIM_START_MEASURE;
@@ -2620,7 +2621,8 @@ static void bcmgenet_init_rx_coalesce(struct bcmgenet_rx_ring *ring)
 
 	/* If DIM was enabled, re-apply default parameters */
 	if (dim->use_dim) {
-		moder = net_dim_get_def_rx_moderation(dim->dim.mode);
+		moder = net_dim_get_def_rx_irq_moder(ring->priv->dev,
+						     dim->dim.mode);
 		usecs = moder.usec;
 		pkts = moder.pkts;
 	}
@@ -4134,10 +4136,20 @@ static int bcmgenet_probe(struct platform_device *pdev)
 
 	reset_umac(priv);
 
-	err = bcmgenet_mii_init(dev);
+	/* RX DIM profiles can be changed through ethtool */
+	err = net_dim_init_irq_moder(dev, DIM_PROFILE_RX,
+				     DIM_COALESCE_USEC | DIM_COALESCE_PKTS,
+				     DIM_CQ_PERIOD_MODE_START_FROM_EQE,
+				     DIM_CQ_PERIOD_MODE_START_FROM_EQE);
 	if (err)
 		goto err_clk_disable;
 
+	err = bcmgenet_mii_init(dev);
+	if (err) {
+		net_dim_free_irq_moder(dev);
+		goto err_clk_disable;
+	}
+
 	/* setup number of real queues  + 1 (GENET_V1 has 0 hardware queues
 	 * just the ring 16 descriptor based TX
 	 */
@@ -4158,6 +4170,7 @@ static int bcmgenet_probe(struct platform_device *pdev)
 	err = register_netdev(dev);
 	if (err) {
 		bcmgenet_mii_exit(dev);
+		net_dim_free_irq_moder(dev);
 		goto err;
 	}
 
@@ -4177,6 +4190,7 @@ static int bcmgenet_remove(struct platform_device *pdev)
 	dev_set_drvdata(&pdev->dev, NULL);
 	unregister_netdev(priv->dev);
 	bcmgenet_mii_exit(priv->dev);
+	net_dim_free_irq_moder(priv->dev);
 	free_netdev(priv->dev);
 
 	return 0;
@@ -2,6 +2,7 @@
 // Copyright (c) 2020 Facebook
 
 #include <linux/debugfs.h>
+#include <linux/dim.h>
 #include <linux/ethtool.h>
 #include <linux/random.h>
 
@@ -50,6 +51,8 @@ static int nsim_get_coalesce(struct net_device *dev,
 	struct netdevsim *ns = netdev_priv(dev);
 
 	memcpy(coal, &ns->ethtool.coalesce, sizeof(ns->ethtool.coalesce));
+	memcpy(kernel_coal, &ns->ethtool.kernel_coalesce,
+	       sizeof(ns->ethtool.kernel_coalesce));
 	return 0;
 }
 
@@ -61,6 +64,14 @@ static int nsim_set_coalesce(struct net_device *dev,
 	struct netdevsim *ns = netdev_priv(dev);
 
 	memcpy(&ns->ethtool.coalesce, coal, sizeof(ns->ethtool.coalesce));
+	memcpy(&ns->ethtool.kernel_coalesce, kernel_coal,
+	       sizeof(ns->ethtool.kernel_coalesce));
+	net_dim_set_rx_mode(dev, kernel_coal->use_cqe_mode_rx ?
+			    DIM_CQ_PERIOD_MODE_START_FROM_CQE :
+			    DIM_CQ_PERIOD_MODE_START_FROM_EQE);
+	net_dim_set_tx_mode(dev, kernel_coal->use_cqe_mode_tx ?
+			    DIM_CQ_PERIOD_MODE_START_FROM_CQE :
+			    DIM_CQ_PERIOD_MODE_START_FROM_EQE);
 	return 0;
 }
 
@@ -140,6 +151,41 @@ nsim_set_fecparam(struct net_device *dev, struct ethtool_fecparam *fecparam)
 	return 0;
 }
 
+/* What the DIM works of a driver would apply, step by step */
+static void nsim_dim_show_profile(struct seq_file *file, bool tx)
+{
+	struct net_device *dev = file->private;
+	struct dim_cq_moder moder;
+	struct dim dim = {};
+
+	rtnl_lock();
+	dim.mode = tx ? dev->irq_moder->dim_tx_mode :
+			dev->irq_moder->dim_rx_mode;
+	rtnl_unlock();
+
+	for (dim.profile_ix = 0;
+	     dim.profile_ix < NET_DIM_PARAMS_NUM_PROFILES; dim.profile_ix++) {
+		moder = tx ? net_dim_get_tx_irq_moder(dev, &dim) :
+			     net_dim_get_rx_irq_moder(dev, &dim);
+		seq_printf(file, "%u %u %u\n", moder.usec, moder.pkts,
+			   moder.comps);
+	}
+}
+
+static int nsim_dim_rx_profile_show(struct seq_file *file, void *data)
+{
+	nsim_dim_show_profile(file, false);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nsim_dim_rx_profile);
+
+static int nsim_dim_tx_profile_show(struct seq_file *file, void *data)
+{
+	nsim_dim_show_profile(file, true);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(nsim_dim_tx_profile);
+
 static const struct ethtool_ops nsim_ethtool_ops = {
 	.supported_coalesce_params	= ETHTOOL_COALESCE_ALL_PARAMS,
 	.get_pause_stats	        = nsim_get_pause_stats,
@@ -163,9 +209,19 @@ static void nsim_ethtool_ring_init(struct netdevsim *ns)
 	ns->ethtool.ring.tx_max_pending = 4096;
 }
 
-void nsim_ethtool_init(struct netdevsim *ns)
+int nsim_ethtool_init(struct netdevsim *ns)
 {
 	struct dentry *ethtool, *dir;
+	int err;
+
+	err = net_dim_init_irq_moder(ns->netdev,
+				     DIM_PROFILE_RX | DIM_PROFILE_TX,
+				     DIM_COALESCE_USEC | DIM_COALESCE_PKTS |
+				     DIM_COALESCE_COMPS,
+				     DIM_CQ_PERIOD_MODE_START_FROM_EQE,
+				     DIM_CQ_PERIOD_MODE_START_FROM_EQE);
+	if (err)
+		return err;
 
 	ns->netdev->ethtool_ops = &nsim_ethtool_ops;
 
@@ -196,4 +252,20 @@ void nsim_ethtool_init(struct netdevsim *ns)
 			   &ns->ethtool.ring.rx_mini_max_pending);
 	debugfs_create_u32("tx_max_pending", 0600, dir,
 			   &ns->ethtool.ring.tx_max_pending);
+
+	/* removed with the profiles, the port directory outlives them */
+	dir = debugfs_create_dir("dim", ethtool);
+	debugfs_create_file("rx_profile", 0400, dir, ns->netdev,
+			    &nsim_dim_rx_profile_fops);
+	debugfs_create_file("tx_profile", 0400, dir, ns->netdev,
+			    &nsim_dim_tx_profile_fops);
+	ns->ethtool.dim_ddir = dir;
+
+	return 0;
+}
+
+void nsim_ethtool_uninit(struct netdevsim *ns)
+{
+	debugfs_remove_recursive(ns->ethtool.dim_ddir);
+	net_dim_free_irq_moder(ns->netdev);
 }
@@ -353,15 +353,19 @@ nsim_create(struct nsim_dev *nsim_dev, struct nsim_dev_port *nsim_dev_port)
 	ns->nsim_bus_dev = nsim_dev->nsim_bus_dev;
 	SET_NETDEV_DEV(dev, &ns->nsim_bus_dev->dev);
 	SET_NETDEV_DEVLINK_PORT(dev, &nsim_dev_port->devlink_port);
-	nsim_ethtool_init(ns);
+	err = nsim_ethtool_init(ns);
+	if (err)
+		goto err_free_netdev;
 	if (nsim_dev_port_is_pf(nsim_dev_port))
 		err = nsim_init_netdevsim(ns);
 	else
 		err = nsim_init_netdevsim_vf(ns);
 	if (err)
-		goto err_free_netdev;
+		goto err_ethtool_uninit;
 	return ns;
 
+err_ethtool_uninit:
+	nsim_ethtool_uninit(ns);
 err_free_netdev:
 	free_netdev(dev);
 	return ERR_PTR(err);
@@ -380,6 +384,7 @@ void nsim_destroy(struct netdevsim *ns)
 	rtnl_unlock();
 	if (nsim_dev_port_is_pf(ns->nsim_dev_port))
 		nsim_udp_tunnels_info_destroy(dev);
+	nsim_ethtool_uninit(ns);
 	free_netdev(dev);
 }
 
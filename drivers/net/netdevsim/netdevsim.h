@@ -65,8 +65,10 @@ struct nsim_ethtool {
 	u32 channels;
 	struct nsim_ethtool_pauseparam pauseparam;
 	struct ethtool_coalesce coalesce;
+	struct kernel_ethtool_coalesce kernel_coalesce;
 	struct ethtool_ringparam ring;
 	struct ethtool_fecparam fec;
+	struct dentry *dim_ddir;
 };
 
 struct netdevsim {
@@ -108,7 +110,8 @@ struct netdevsim *
 nsim_create(struct nsim_dev *nsim_dev, struct nsim_dev_port *nsim_dev_port);
 void nsim_destroy(struct netdevsim *ns);
 
-void nsim_ethtool_init(struct netdevsim *ns);
+int nsim_ethtool_init(struct netdevsim *ns);
+void nsim_ethtool_uninit(struct netdevsim *ns);
 
 void nsim_udp_tunnels_debugfs_create(struct nsim_dev *nsim_dev);
 int nsim_udp_tunnels_info_create(struct nsim_dev *nsim_dev,
@@ -19,6 +19,7 @@
 
 struct kmem_cache *nvmet_bvec_cache;
 struct workqueue_struct *buffered_io_wq;
+struct workqueue_struct *file_ring_wq;
 struct workqueue_struct *zbd_wq;
 static const struct nvmet_fabrics_ops *nvmet_transports[NVMF_TRTYPE_MAX];
 static DEFINE_IDA(cntlid_ida);
@@ -688,6 +689,8 @@ struct nvmet_ns *nvmet_ns_alloc(struct nvmet_subsys *subsys, u32 nsid)
 
 	uuid_gen(&ns->uuid);
 	ns->buffered_io = false;
+	ns->ring_io = false;
+	ns->poll_io = false;
 	ns->csi = NVME_CSI_NVM;
 
 	return ns;
@@ -801,6 +804,7 @@ void nvmet_sq_destroy(struct nvmet_sq *sq)
 	wait_for_completion(&sq->confirm_done);
 	wait_for_completion(&sq->free_done);
 	percpu_ref_exit(&sq->ref);
+	nvmet_file_ring_destroy(sq);
 	nvmet_auth_sq_free(sq);
 
 	if (ctrl) {
@@ -836,6 +840,7 @@ int nvmet_sq_init(struct nvmet_sq *sq)
 	}
 	init_completion(&sq->free_done);
 	init_completion(&sq->confirm_done);
+	nvmet_file_ring_init(sq);
 	nvmet_auth_sq_init(sq);
 
 	return 0;
@@ -1665,9 +1670,14 @@ static int __init nvmet_init(void)
 	if (!buffered_io_wq)
 		goto out_free_zbd_work_queue;
 
+	file_ring_wq = alloc_workqueue("nvmet-file-ring-wq",
+			WQ_MEM_RECLAIM | WQ_HIGHPRI, 0);
+	if (!file_ring_wq)
+		goto out_free_buffered_work_queue;
+
 	nvmet_wq = alloc_workqueue("nvmet-wq", WQ_MEM_RECLAIM, 0);
 	if (!nvmet_wq)
-		goto out_free_buffered_work_queue;
+		goto out_free_file_ring_work_queue;
 
 	error = nvmet_init_discovery();
 	if (error)
@@ -1682,6 +1692,8 @@ static int __init nvmet_init(void)
 	nvmet_exit_discovery();
 out_free_nvmet_work_queue:
 	destroy_workqueue(nvmet_wq);
+out_free_file_ring_work_queue:
+	destroy_workqueue(file_ring_wq);
 out_free_buffered_work_queue:
 	destroy_workqueue(buffered_io_wq);
 out_free_zbd_work_queue:
@@ -1697,6 +1709,7 @@ static void __exit nvmet_exit(void)
 	nvmet_exit_discovery();
 	ida_destroy(&cntlid_ida);
 	destroy_workqueue(nvmet_wq);
+	destroy_workqueue(file_ring_wq);
 	destroy_workqueue(buffered_io_wq);
 	destroy_workqueue(zbd_wq);
 	kmem_cache_destroy(nvmet_bvec_cache);
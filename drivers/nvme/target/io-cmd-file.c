@@ -21,7 +21,8 @@ void nvmet_file_ns_revalidate(struct nvmet_ns *ns)
 void nvmet_file_ns_disable(struct nvmet_ns *ns)
 {
 	if (ns->file) {
-		if (ns->buffered_io)
+		/* the ring hands commands that would block to buffered_io_wq */
+		if (ns->buffered_io || ns->ring_io)
 			flush_workqueue(buffered_io_wq);
 		mempool_destroy(ns->bvec_pool);
 		ns->bvec_pool = NULL;
@@ -49,6 +50,16 @@ int nvmet_file_ns_enable(struct nvmet_ns *ns)
 
 	nvmet_file_ns_revalidate(ns);
 
+	/*
+	 * Polled completions need O_DIRECT and a file that can be polled;
+	 * otherwise fall back to interrupt driven completions on the ring.
+	 */
+	ns->file_poll = ns->ring_io && ns->poll_io && !ns->buffered_io &&
+			ns->file->f_op->iopoll;
+	if (ns->poll_io && !ns->file_poll)
+		pr_warn("polled I/O not supported for %s, using interrupts\n",
+			ns->device_path);
+
 	/*
 	 * i_blkbits can be greater than the universally accepted upper bound,
 	 * so make sure we export a sane namespace lba_shift.
@@ -117,6 +128,38 @@ static void nvmet_file_io_done(struct kiocb *iocb, long ret)
 	nvmet_req_complete(req, status);
 }
 
+static void nvmet_file_submit_buffered_io(struct nvmet_req *req);
+
+/*
+ * Completion handler for IOCB_NOWAIT direct I/O issued from the file ring.
+ * -EAGAIN means the block layer ran out of tags or other resources, which
+ * is no error for the host: retry the command on buffered_io_wq, where it
+ * may block.
+ */
+static void nvmet_file_ring_io_done(struct kiocb *iocb, long ret)
+{
+	struct nvmet_req *req = container_of(iocb, struct nvmet_req, f.iocb);
+
+	if (ret == -EAGAIN)
+		nvmet_file_submit_buffered_io(req);
+	else
+		nvmet_file_io_done(iocb, ret);
+}
+
+/*
+ * Completion handler for IOCB_HIPRI requests issued from the file ring.  The
+ * request is only completed back to the transport by the ring worker once it
+ * has been reaped, so it stays on the worker's poll list until then.
+ */
+static void nvmet_file_poll_done(struct kiocb *iocb, long ret)
+{
+	struct nvmet_req *req = container_of(iocb, struct nvmet_req, f.iocb);
+
+	req->f.poll_res = ret;
+	/* pairs with smp_load_acquire() in nvmet_file_ring_reap() */
+	smp_store_release(&req->f.poll_done, true);
+}
+
 static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 {
 	ssize_t nr_bvec = req->sg_cnt;
@@ -133,8 +176,8 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 
 	pos = le64_to_cpu(req->cmd->rw.slba) << req->ns->blksize_shift;
 	if (unlikely(pos + req->transfer_len > req->ns->size)) {
-		nvmet_req_complete(req, errno_to_nvme_status(req, -ENOSPC));
-		return true;
+		ret = -ENOSPC;
+		goto complete;
 	}
 
 	memset(&req->f.iocb, 0, sizeof(struct kiocb));
@@ -172,10 +215,15 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 
 	/*
 	 * A NULL ki_complete ask for synchronous execution, which we want
-	 * for the IOCB_NOWAIT case.
+	 * for the buffered IOCB_NOWAIT case.  Direct I/O from the ring is
+	 * asynchronous even with IOCB_NOWAIT.
 	 */
-	if (!(ki_flags & IOCB_NOWAIT))
+	if (ki_flags & IOCB_HIPRI)
+		req->f.iocb.ki_complete = nvmet_file_poll_done;
+	else if (!(ki_flags & IOCB_NOWAIT))
 		req->f.iocb.ki_complete = nvmet_file_io_done;
+	else if (!req->ns->buffered_io)
+		req->f.iocb.ki_complete = nvmet_file_ring_io_done;
 
 	ret = nvmet_file_submit_bvec(req, pos, bv_cnt, total_len, ki_flags);
 
@@ -183,6 +231,9 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 	case -EIOCBQUEUED:
 		return true;
 	case -EAGAIN:
+		/* reaped like any polled completion, then retried */
+		if (ki_flags & IOCB_HIPRI)
+			break;
 		if (WARN_ON_ONCE(!(ki_flags & IOCB_NOWAIT)))
 			goto complete;
 		return false;
@@ -198,7 +249,10 @@ static bool nvmet_file_execute_io(struct nvmet_req *req, int ki_flags)
 	}
 
 complete:
-	nvmet_file_io_done(&req->f.iocb, ret);
+	if (ki_flags & IOCB_HIPRI)
+		nvmet_file_poll_done(&req->f.iocb, ret);
+	else
+		nvmet_file_io_done(&req->f.iocb, ret);
 	return true;
 }
 
@@ -215,6 +269,120 @@ static void nvmet_file_submit_buffered_io(struct nvmet_req *req)
 	queue_work(buffered_io_wq, &req->f.work);
 }
 
+/*
+ * Never block the ring worker, every other command of the queue waits on it:
+ * try without waiting, and leave what would block to buffered_io_wq.
+ */
+static void nvmet_file_ring_submit_nowait(struct nvmet_req *req)
+{
+	if (likely(!req->f.mpool_alloc) &&
+	    (req->ns->file->f_mode & FMODE_NOWAIT) &&
+	    nvmet_file_execute_io(req, IOCB_NOWAIT))
+		return;
+	nvmet_file_submit_buffered_io(req);
+}
+
+static void nvmet_file_ring_submit_polled(struct nvmet_req *req,
+		struct list_head *poll_list)
+{
+	req->f.poll_done = false;
+	nvmet_file_execute_io(req, IOCB_HIPRI);
+	/*
+	 * Every outcome of a polled submission ends in nvmet_file_poll_done(),
+	 * so the request is still ours and can be reaped like the others.
+	 */
+	list_add_tail(&req->f.poll_entry, poll_list);
+}
+
+static void nvmet_file_ring_submit(struct nvmet_file_ring *ring,
+		struct list_head *poll_list)
+{
+	struct nvmet_req *req, *next;
+	struct llist_node *entries;
+	struct blk_plug plug;
+
+	entries = llist_del_all(&ring->submit_list);
+	if (!entries)
+		return;
+	entries = llist_reverse_order(entries);
+
+	blk_start_plug(&plug);
+	llist_for_each_entry_safe(req, next, entries, f.ring_node) {
+		if (req->ns->file_poll)
+			nvmet_file_ring_submit_polled(req, poll_list);
+		else
+			nvmet_file_ring_submit_nowait(req);
+	}
+	blk_finish_plug(&plug);
+}
+
+static void nvmet_file_ring_reap(struct list_head *poll_list)
+{
+	struct nvmet_req *req, *tmp;
+
+	list_for_each_entry_safe(req, tmp, poll_list, f.poll_entry) {
+		struct kiocb *iocb = &req->f.iocb;
+
+		if (!smp_load_acquire(&req->f.poll_done))
+			iocb->ki_filp->f_op->iopoll(iocb, NULL, 0);
+		if (!smp_load_acquire(&req->f.poll_done))
+			continue;
+
+		list_del(&req->f.poll_entry);
+		/*
+		 * Polled bios are REQ_NOWAIT and fail with -EAGAIN when the
+		 * device runs out of tags.  That is transient, resubmit without
+		 * polling rather than failing the command.
+		 */
+		if (req->f.poll_res == -EAGAIN)
+			nvmet_file_ring_submit_nowait(req);
+		else
+			nvmet_file_io_done(iocb, req->f.poll_res);
+	}
+}
+
+static void nvmet_file_ring_work(struct work_struct *w)
+{
+	struct nvmet_file_ring *ring =
+		container_of(w, struct nvmet_file_ring, work);
+	LIST_HEAD(poll_list);
+
+	/*
+	 * Keep picking up new submissions while polling so that commands
+	 * arriving during the poll loop are batched in with it instead of
+	 * waiting for another work item invocation.
+	 */
+	for (;;) {
+		nvmet_file_ring_submit(ring, &poll_list);
+		if (list_empty(&poll_list))
+			break;
+		nvmet_file_ring_reap(&poll_list);
+		cond_resched();
+	}
+}
+
+static void nvmet_file_ring_queue(struct nvmet_req *req)
+{
+	struct nvmet_file_ring *ring = &req->sq->file_ring;
+
+	/* only the producer that finds the ring empty needs to kick it */
+	if (llist_add(&req->f.ring_node, &ring->submit_list))
+		queue_work(file_ring_wq, &ring->work);
+}
+
+void nvmet_file_ring_init(struct nvmet_sq *sq)
+{
+	init_llist_head(&sq->file_ring.submit_list);
+	INIT_WORK(&sq->file_ring.work, nvmet_file_ring_work);
+}
+
+void nvmet_file_ring_destroy(struct nvmet_sq *sq)
+{
+	/* all requests hold a sq reference, so the ring is idle by now */
+	WARN_ON_ONCE(!llist_empty(&sq->file_ring.submit_list));
+	cancel_work_sync(&sq->file_ring.work);
+}
+
 static void nvmet_file_execute_rw(struct nvmet_req *req)
 {
 	ssize_t nr_bvec = req->sg_cnt;
@@ -245,8 +413,13 @@ static void nvmet_file_execute_rw(struct nvmet_req *req)
 		    (req->ns->file->f_mode & FMODE_NOWAIT) &&
 		    nvmet_file_execute_io(req, IOCB_NOWAIT))
 			return;
-		nvmet_file_submit_buffered_io(req);
-	} else
+		if (req->ns->ring_io)
+			nvmet_file_ring_queue(req);
+		else
+			nvmet_file_submit_buffered_io(req);
+	} else if (req->ns->ring_io)
+		nvmet_file_ring_queue(req);
+	else
 		nvmet_file_execute_io(req, 0);
 }
 
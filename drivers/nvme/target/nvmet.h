@@ -12,6 +12,7 @@
 #include <linux/kref.h>
 #include <linux/percpu-refcount.h>
 #include <linux/list.h>
+#include <linux/llist.h>
 #include <linux/mutex.h>
 #include <linux/uuid.h>
 #include <linux/nvme.h>
@@ -69,6 +70,9 @@ struct nvmet_ns {
 	u32			anagrpid;
 
 	bool			buffered_io;
+	bool			ring_io;
+	bool			poll_io;
+	bool			file_poll;
 	bool			enabled;
 	struct nvmet_subsys	*subsys;
 	const char		*device_path;
@@ -101,6 +105,17 @@ struct nvmet_cq {
 	u16			size;
 };
 
+/*
+ * Per-queue submission ring for file-backed namespaces with ring_io set.
+ * Commands are pushed locklessly and a single work item per queue drains
+ * them in batches under a block plug, reaping polled completions when the
+ * namespace has poll_io enabled.
+ */
+struct nvmet_file_ring {
+	struct llist_head	submit_list;
+	struct work_struct	work;
+};
+
 struct nvmet_sq {
 	struct nvmet_ctrl	*ctrl;
 	struct percpu_ref	ref;
@@ -121,6 +136,7 @@ struct nvmet_sq {
 	u8			*dhchap_skey;
 	int			dhchap_skey_len;
 #endif
+	struct nvmet_file_ring	file_ring;
 	struct completion	free_done;
 	struct completion	confirm_done;
 };
@@ -364,6 +380,10 @@ struct nvmet_req {
 			struct kiocb            iocb;
 			struct bio_vec          *bvec;
 			struct work_struct      work;
+			struct llist_node	ring_node;
+			struct list_head	poll_entry;
+			long			poll_res;
+			bool			poll_done;
 		} f;
 		struct {
 			struct bio		inline_bio;
@@ -398,6 +418,7 @@ struct nvmet_req {
 #define NVMET_MAX_MPOOL_BVEC		16
 extern struct kmem_cache *nvmet_bvec_cache;
 extern struct workqueue_struct *buffered_io_wq;
+extern struct workqueue_struct *file_ring_wq;
 extern struct workqueue_struct *zbd_wq;
 extern struct workqueue_struct *nvmet_wq;
 
@@ -577,6 +598,8 @@ u16 nvmet_file_flush(struct nvmet_req *req);
 void nvmet_ns_changed(struct nvmet_subsys *subsys, u32 nsid);
 void nvmet_bdev_ns_revalidate(struct nvmet_ns *ns);
 void nvmet_file_ns_revalidate(struct nvmet_ns *ns);
+void nvmet_file_ring_init(struct nvmet_sq *sq);
+void nvmet_file_ring_destroy(struct nvmet_sq *sq);
 bool nvmet_ns_revalidate(struct nvmet_ns *ns);
 u16 blk_to_nvme_status(struct nvmet_req *req, blk_status_t blk_sts);
 
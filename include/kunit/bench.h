@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * KUnit microbenchmark API.
+ *
+ * Times a function in a KUnit test case until its median settles, and
+ * reports the distribution in a KTAP diagnostic line tools can parse:
+ *
+ *     # bench: <test>:<name> samples=<n> min=<ns> p50=<ns> p90=<ns>
+ *       p99=<ns> max=<ns> mean=<ns> stable=<0|1> [cpu=<cpu>] [mbps=<MB/s>]
+ *
+ * all on one line, times in nanoseconds per call of the function.
+ *
+ * Benchmarks are slow, so the cases using them are skipped unless the
+ * kernel is booted with kunit.bench=1. Their suites have to be marked
+ * &kunit_suite.exclusive, they are skipped when running concurrently with
+ * other suites.
+ */
+
+#ifndef _KUNIT_BENCH_H
+#define _KUNIT_BENCH_H
+
+#include <linux/types.h>
+
+struct kunit;
+
+/**
+ * struct kunit_bench - how to run a benchmark
+ * @name: name of the benchmark in the report
+ * @fn: function to time
+ * @ctx: argument of @fn
+ * @warmup: calls of @fn before timing, default 16
+ * @loops: calls of @fn per sample, for functions too short for the clock,
+ *	   default 1
+ * @min_samples: samples taken before checking the median, and how many
+ *		 more each further check takes, default 64
+ * @max_samples: upper bound of the samples, default 4096
+ * @stable_pct: the median is stable once a round of @min_samples moves it by
+ *		at most this many percent, default 2
+ * @pin_cpu: run on @cpu only
+ * @cpu: CPU to run on if @pin_cpu
+ * @bytes: bytes one call of @fn processes, to report a throughput, or 0
+ */
+struct kunit_bench {
+	const char *name;
+	void (*fn)(void *ctx);
+	void *ctx;
+	unsigned int warmup;
+	unsigned int loops;
+	unsigned int min_samples;
+	unsigned int max_samples;
+	unsigned int stable_pct;
+	bool pin_cpu;
+	unsigned int cpu;
+	u64 bytes;
+};
+
+/**
+ * struct kunit_bench_result - distribution of a benchmark, per call of @fn
+ * @samples: number of samples
+ * @min: fastest sample, in ns
+ * @p50: median, in ns
+ * @p90: 90th percentile, in ns
+ * @p99: 99th percentile, in ns
+ * @max: slowest sample, in ns
+ * @mean: mean, in ns
+ * @stable: whether the median settled before @max_samples
+ */
+struct kunit_bench_result {
+	unsigned int samples;
+	u64 min;
+	u64 p50;
+	u64 p90;
+	u64 p99;
+	u64 max;
+	u64 mean;
+	bool stable;
+};
+
+/**
+ * kunit_bench_stats() - compute the distribution of samples
+ * @samples: sample times, in ns, sorted in place
+ * @n: number of samples, at least one
+ * @res: where to store the distribution
+ *
+ * Percentiles are nearest rank. kunit_bench_run() uses this, and it is
+ * exported for subsystems with their own timing loop.
+ */
+void kunit_bench_stats(u64 *samples, unsigned int n,
+		       struct kunit_bench_result *res);
+
+/**
+ * kunit_bench_enabled() - whether kunit_bench_run() runs benchmarks in @test
+ * @test: the test case
+ *
+ * For test cases that need to allocate or prepare much before calling
+ * kunit_bench_run(), and would rather skip early.
+ */
+bool kunit_bench_enabled(struct kunit *test);
+
+/**
+ * kunit_bench_run() - run and report a benchmark
+ * @test: the test case
+ * @bench: the benchmark
+ * @res: where to store the distribution, or NULL
+ *
+ * Skips @test if benchmarks are not enabled with kunit.bench=1 or if its
+ * suite runs concurrently with other suites, and fails it if @bench->cpu is
+ * pinned but not online or the samples cannot be allocated.
+ *
+ * Return: 0 on success, a negative error code otherwise.
+ */
+int kunit_bench_run(struct kunit *test, const struct kunit_bench *bench,
+		    struct kunit_bench_result *res);
+
+#endif /* _KUNIT_BENCH_H */
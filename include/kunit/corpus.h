@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * KUnit helper generating synthetic data for compression tests.
+ */
+
+#ifndef _KUNIT_CORPUS_H
+#define _KUNIT_CORPUS_H
+
+#include <linux/types.h>
+
+/**
+ * enum kunit_corpus - kind of data kunit_fill_corpus() generates
+ * @KUNIT_CORPUS_TEXT: words and punctuation, roughly like prose or source
+ * @KUNIT_CORPUS_BINARY: short period runs, copies from earlier data and
+ *			 random bytes, so that every kind of match shows up
+ * @KUNIT_CORPUS_RANDOM: random bytes, which do not compress
+ */
+enum kunit_corpus {
+	KUNIT_CORPUS_TEXT,
+	KUNIT_CORPUS_BINARY,
+	KUNIT_CORPUS_RANDOM,
+};
+
+/**
+ * kunit_fill_corpus() - fill a buffer with data to compress
+ * @buf: buffer to fill
+ * @size: size of @buf
+ * @kind: kind of data
+ * @window: farthest distance copies in %KUNIT_CORPUS_BINARY data reach back,
+ *	    e.g. the window size of the compressor
+ * @seed: seed of the pseudo random generator, the same seed gives the same
+ *	  data
+ */
+void kunit_fill_corpus(u8 *buf, size_t size, enum kunit_corpus kind,
+		       size_t window, u64 seed);
+
+#endif /* _KUNIT_CORPUS_H */
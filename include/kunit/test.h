@@ -32,6 +32,7 @@
 DECLARE_STATIC_KEY_FALSE(kunit_running);
 
 struct kunit;
+struct kunit_output;
 
 /* Size of log associated with test. */
 #define KUNIT_LOG_SIZE	512
@@ -162,6 +163,8 @@ static inline char *kunit_status_to_ok_not_ok(enum kunit_status status)
  * @init:	called before every test case.
  * @exit:	called after every test case.
  * @test_cases:	a null terminated array of test cases.
+ * @exclusive:	the suite must not run concurrently with other suites, e.g.
+ *		because it changes global state or measures performance.
  *
  * A kunit_suite is a collection of related &struct kunit_case s, such that
  * @init is called before every test case and @exit is called after every
@@ -178,11 +181,13 @@ struct kunit_suite {
 	int (*init)(struct kunit *test);
 	void (*exit)(struct kunit *test);
 	struct kunit_case *test_cases;
+	bool exclusive;
 
 	/* private: internal use only */
 	char status_comment[KUNIT_STATUS_COMMENT_SIZE];
 	struct dentry *debugfs;
 	char *log;
+	struct kunit_output *output; /* Held back output, see kunit_log() */
 	int suite_init_err;
 };
 
@@ -203,6 +208,8 @@ struct kunit {
 	/* private: internal use only. */
 	const char *name; /* Read only after initialization! */
 	char *log; /* Points at case log after initialization */
+	struct kunit_output *output; /* Points at suite output while running */
+	int cpu; /* CPU the test case runs on, or -1 for any */
 	struct kunit_try_catch try_catch;
 	/* param_value is the current parameter value for a test case. */
 	const void *param_value;
@@ -377,6 +384,9 @@ void kunit_cleanup(struct kunit *test);
 
 void __printf(2, 3) kunit_log_append(char *log, const char *fmt, ...);
 
+void __printf(2, 3) kunit_log_print(struct kunit_output *output,
+				    const char *fmt, ...);
+
 /**
  * kunit_mark_skipped() - Marks @test_or_suite as skipped
  *
@@ -416,10 +426,13 @@ void __printf(2, 3) kunit_log_append(char *log, const char *fmt, ...);
 /*
  * printk and log to per-test or per-suite log buffer.  Logging only done
  * if CONFIG_KUNIT_DEBUGFS is 'y'; if it is 'n', no log is allocated/used.
+ * While the suite runs in parallel with others, the printk is held back in
+ * its output and printed once the suites before it are done.
  */
 #define kunit_log(lvl, test_or_suite, fmt, ...)				\
 	do {								\
-		printk(lvl fmt, ##__VA_ARGS__);				\
+		kunit_log_print((test_or_suite)->output, lvl fmt,	\
+				##__VA_ARGS__);				\
 		kunit_log_append((test_or_suite)->log,	fmt "\n",	\
 				 ##__VA_ARGS__);			\
 	} while (0)
@@ -1414,6 +1427,25 @@ do {									       \
 		return NULL;									\
 	}
 
+/**
+ * KUNIT_ARRAY_PARAM_DESC() - Define test parameter generator from an array.
+ * @name:  prefix for the test parameter generator function.
+ * @array: array of test parameters.
+ * @desc_member: structure member from array element to use as description
+ *
+ * Define function @name_gen_params which uses @array to generate parameters.
+ */
+#define KUNIT_ARRAY_PARAM_DESC(name, array, desc_member)					\
+	static const void *name##_gen_params(const void *prev, char *desc)			\
+	{											\
+		typeof((array)[0]) *__next = prev ? ((typeof(__next)) prev) + 1 : (array);	\
+		if (__next - (array) < ARRAY_SIZE((array))) {					\
+			strscpy(desc, __next->desc_member, KUNIT_PARAM_DESC_SIZE);		\
+			return __next;								\
+		}										\
+		return NULL;									\
+	}
+
 // TODO(dlatypov@google.com): consider eventually migrating users to explicitly
 // include resource.h themselves if they need it.
 #include <kunit/resource.h>
@@ -25,6 +25,7 @@ struct console_font;
 struct module;
 struct tty_struct;
 struct notifier_block;
+struct printk_buffers;
 
 enum con_scroll {
 	SM_UP,
@@ -184,6 +185,8 @@ enum cons_flags {
  * @dropped:		Number of unreported dropped ringbuffer records
  * @data:		Driver private data
  * @node:		hlist node for the console list
+ * @thread:		Printing kthread of the console, if any
+ * @pbufs:		Output buffers used by @thread
  */
 struct console {
 	char			name[16];
@@ -203,6 +206,8 @@ struct console {
 	unsigned long		dropped;
 	void			*data;
 	struct hlist_node	node;
+	struct task_struct	*thread;
+	struct printk_buffers	*pbufs;
 };
 
 #ifdef CONFIG_LOCKDEP
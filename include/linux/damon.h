@@ -110,11 +110,51 @@ enum damos_action {
 	NR_DAMOS_ACTIONS,
 };
 
+/**
+ * enum damos_quota_goal_metric - Represents the metric a quota goal tracks.
+ *
+ * @DAMOS_QUOTA_USER_INPUT:	Value fed by the user.
+ * @DAMOS_QUOTA_SOME_MEM_PSI_US:	System level some memory PSI in us per
+ *				quota reset interval.
+ * @DAMOS_QUOTA_FREE_MEM_BP:	Free memory rate of the system in [0,10000].
+ * @NR_DAMOS_QUOTA_GOAL_METRICS:	Total number of DAMOS quota goal metrics.
+ */
+enum damos_quota_goal_metric {
+	DAMOS_QUOTA_USER_INPUT,
+	DAMOS_QUOTA_SOME_MEM_PSI_US,
+	DAMOS_QUOTA_FREE_MEM_BP,
+	NR_DAMOS_QUOTA_GOAL_METRICS,
+};
+
+/**
+ * struct damos_quota_goal - Value that the quota of a scheme should achieve.
+ * @metric:		Metric to be used for representing the goal.
+ * @target_value:	Target value of @metric to achieve with the tuning.
+ * @current_value:	Current value of @metric.
+ * @last_psi_total:	Last measured total PSI, for the PSI metrics.
+ * @list:		List head for siblings.
+ *
+ * DAMON measures @current_value of @metric at the beginning of each quota
+ * reset interval, except for &DAMOS_QUOTA_USER_INPUT, which the user sets.
+ * Applying the action more aggressively is assumed to increase @metric.
+ */
+struct damos_quota_goal {
+	enum damos_quota_goal_metric metric;
+	unsigned long target_value;
+	unsigned long current_value;
+	/* metric-dependent fields */
+	union {
+		u64 last_psi_total;
+	};
+	struct list_head list;
+};
+
 /**
  * struct damos_quota - Controls the aggressiveness of the given scheme.
  * @ms:			Maximum milliseconds that the scheme can use.
  * @sz:			Maximum bytes of memory that the action can be applied.
  * @reset_interval:	Charge reset interval in milliseconds.
+ * @goals:		Goals to tune the effective quota toward.
  *
  * @weight_sz:		Weight of the region's size for prioritization.
  * @weight_nr_accesses:	Weight of the region's nr_accesses for prioritization.
@@ -132,6 +172,14 @@ enum damos_action {
  * throughput of the scheme's action.  DAMON then compares it against &sz and
  * uses smaller one as the effective quota.
  *
+ * If &goals is not empty, DAMON also calculates how much of the goals is
+ * achieved, as the highest ratio of &struct damos_quota_goal->current_value to
+ * &struct damos_quota_goal->target_value, at the beginning of each
+ * &reset_interval.  It then increases or decreases a third size quota in
+ * proportion to how far that ratio is from one, and uses it as the effective
+ * quota if it is the smallest.  The time and size quotas hence work as upper
+ * limits of the feedback driven one.
+ *
  * For selecting regions within the quota, DAMON prioritizes current scheme's
  * target memory regions using the &struct damon_operations->get_scheme_score.
  * You could customize the prioritization logic by setting &weight_sz,
@@ -142,6 +190,7 @@ struct damos_quota {
 	unsigned long ms;
 	unsigned long sz;
 	unsigned long reset_interval;
+	struct list_head goals;
 
 	unsigned int weight_sz;
 	unsigned int weight_nr_accesses;
@@ -153,6 +202,7 @@ struct damos_quota {
 	unsigned long total_charged_ns;
 
 	unsigned long esz;	/* Effective size quota in bytes */
+	unsigned long esz_bp;	/* Goal based size quota in bp of bytes */
 
 	/* For charging the quota */
 	unsigned long charged_sz;
@@ -444,12 +494,42 @@ struct damon_callback {
 	void (*before_terminate)(struct damon_ctx *context);
 };
 
+/**
+ * struct damon_intervals_goal - Monitoring intervals auto-tuning goal.
+ *
+ * @access_bp:		Access events observation ratio to achieve in bp.
+ * @aggrs:		Number of aggregations to achieve @access_bp within.
+ * @min_sample_us:	Minimum resulting sampling interval in microseconds.
+ * @max_sample_us:	Maximum resulting sampling interval in microseconds.
+ *
+ * DAMON automatically tunes &damon_attrs->sample_interval and
+ * &damon_attrs->aggr_interval aiming the ratio in bp (1/10,000) of
+ * DAMON-observed access events to the theoretical maximum amount of the events
+ * within @aggrs aggregations be same to @access_bp.  Access events of a region
+ * are weighted by its size.  The ratio between the two intervals is kept, and
+ * the sampling interval is kept within [@min_sample_us, @max_sample_us].
+ *
+ * Longer intervals let DAMON find more accesses per sample, so the intervals
+ * are increased if the observed ratio is lower than @access_bp, and decreased
+ * otherwise.  Note that the age thresholds of &struct damos_access_pattern are
+ * in aggregation intervals, so the time they mean changes with the intervals.
+ *
+ * Zero @aggrs or @access_bp disables the tuning.
+ */
+struct damon_intervals_goal {
+	unsigned long access_bp;
+	unsigned long aggrs;
+	unsigned long min_sample_us;
+	unsigned long max_sample_us;
+};
+
 /**
  * struct damon_attrs - Monitoring attributes for accuracy/overhead control.
  *
  * @sample_interval:		The time between access samplings.
  * @aggr_interval:		The time between monitor results aggregations.
  * @ops_update_interval:	The time between monitoring operations updates.
+ * @intervals_goal:		Intervals auto-tuning goal.
  * @min_nr_regions:		The minimum number of adaptive monitoring
  *				regions.
  * @max_nr_regions:		The maximum number of adaptive monitoring
@@ -461,6 +541,8 @@ struct damon_callback {
  * memory regions need update (e.g., by ``mmap()`` calls from the application,
  * in case of virtual memory monitoring) and applies the changes for each
  * @ops_update_interval.  All time intervals are in micro-seconds.
+ * If @intervals_goal is set, @sample_interval and @aggr_interval are tuned
+ * while the monitoring runs.
  * Please refer to &struct damon_operations and &struct damon_callback for more
  * detail.
  */
@@ -468,6 +550,7 @@ struct damon_attrs {
 	unsigned long sample_interval;
 	unsigned long aggr_interval;
 	unsigned long ops_update_interval;
+	struct damon_intervals_goal intervals_goal;
 	unsigned long min_nr_regions;
 	unsigned long max_nr_regions;
 };
@@ -509,6 +592,11 @@ struct damon_ctx {
 	struct timespec64 last_aggregation;
 	struct timespec64 last_ops_update;
 
+	/* For the intervals auto-tuning */
+	unsigned long nr_tune_aggrs;
+	u64 tune_access_events;
+	u64 tune_max_access_events;
+
 /* public: */
 	struct task_struct *kdamond;
 	struct mutex kdamond_lock;
@@ -573,6 +661,12 @@ static inline unsigned long damon_sz_region(struct damon_region *r)
 #define damos_for_each_filter_safe(f, next, scheme) \
 	list_for_each_entry_safe(f, next, &(scheme)->filters, list)
 
+#define damos_for_each_quota_goal(goal, quota) \
+	list_for_each_entry(goal, &(quota)->goals, list)
+
+#define damos_for_each_quota_goal_safe(goal, next, quota) \
+	list_for_each_entry_safe(goal, next, &(quota)->goals, list)
+
 #ifdef CONFIG_DAMON
 
 struct damon_region *damon_new_region(unsigned long start, unsigned long end);
@@ -598,6 +692,12 @@ struct damos_filter *damos_new_filter(enum damos_filter_type type,
 void damos_add_filter(struct damos *s, struct damos_filter *f);
 void damos_destroy_filter(struct damos_filter *f);
 
+struct damos_quota_goal *damos_new_quota_goal(
+		enum damos_quota_goal_metric metric,
+		unsigned long target_value);
+void damos_add_quota_goal(struct damos_quota *q, struct damos_quota_goal *g);
+void damos_destroy_quota_goal(struct damos_quota_goal *g);
+
 struct damos *damon_new_scheme(struct damos_access_pattern *pattern,
 			enum damos_action action, struct damos_quota *quota,
 			struct damos_watermarks *wmarks);
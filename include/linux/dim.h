@@ -10,6 +10,8 @@
 #include <linux/types.h>
 #include <linux/workqueue.h>
 
+struct net_device;
+
 /*
  * Number of events between DIM iterations.
  * Causes a moderation of the algorithm run.
@@ -127,6 +129,33 @@ enum dim_cq_period_mode {
 	DIM_CQ_PERIOD_NUM_MODES
 };
 
+#define DIM_PROFILE_RX		BIT(0)	/* RX profile modification */
+#define DIM_PROFILE_TX		BIT(1)	/* TX profile modification */
+
+#define DIM_COALESCE_USEC	BIT(0)	/* profiles set the CQ timer */
+#define DIM_COALESCE_PKTS	BIT(1)	/* profiles set the CQ packet counter */
+#define DIM_COALESCE_COMPS	BIT(2)	/* profiles set the completion count */
+
+/**
+ * struct dim_irq_moder - Structure for the per device net DIM profiles.
+ * Replaceable from user space through ethtool, RCU protected.
+ *
+ * @profile_flags: DIM_PROFILE_* directions with a modifiable profile
+ * @coal_flags: DIM_COALESCE_* fields the device honours
+ * @dim_rx_mode: CQ period mode of the RX CQs
+ * @dim_tx_mode: CQ period mode of the TX CQs
+ * @rx_profile: RX profile of each CQ period mode
+ * @tx_profile: TX profile of each CQ period mode
+ */
+struct dim_irq_moder {
+	u8 profile_flags;
+	u8 coal_flags;
+	u8 dim_rx_mode;
+	u8 dim_tx_mode;
+	struct dim_cq_moder __rcu *rx_profile[DIM_CQ_PERIOD_NUM_MODES];
+	struct dim_cq_moder __rcu *tx_profile[DIM_CQ_PERIOD_NUM_MODES];
+};
+
 /**
  * enum dim_state - DIM algorithm states
  *
@@ -275,6 +304,14 @@ dim_update_sample_with_comps(u16 event_ctr, u64 packets, u64 bytes, u64 comps,
 
 /* Net DIM */
 
+/*
+ * Net DIM profiles:
+ *        There are different set of profiles for each CQ period mode.
+ *        There are different set of profiles for RX/TX CQs.
+ *        Each profile size must be of NET_DIM_PARAMS_NUM_PROFILES
+ */
+#define NET_DIM_PARAMS_NUM_PROFILES 5
+
 /**
  *	net_dim_get_rx_moderation - provide a CQ moderation object for the given RX profile
  *	@cq_period_mode: CQ period mode
@@ -301,6 +338,82 @@ struct dim_cq_moder net_dim_get_tx_moderation(u8 cq_period_mode, int ix);
  */
 struct dim_cq_moder net_dim_get_def_tx_moderation(u8 cq_period_mode);
 
+/**
+ *	net_dim_init_irq_moder - set up the user modifiable profiles of a device
+ *	@dev: the net device, whose @irq_moder it allocates
+ *	@profile_flags: DIM_PROFILE_* directions to make modifiable
+ *	@coal_flags: DIM_COALESCE_* fields the device honours
+ *	@rx_mode: initial CQ period mode of the RX CQs
+ *	@tx_mode: initial CQ period mode of the TX CQs
+ *
+ * The profiles start as copies of the default ones. Called before the
+ * device is registered, and undone with net_dim_free_irq_moder().
+ */
+int net_dim_init_irq_moder(struct net_device *dev, u8 profile_flags,
+			   u8 coal_flags, u8 rx_mode, u8 tx_mode);
+
+/**
+ *	net_dim_free_irq_moder - free the profiles of net_dim_init_irq_moder()
+ *	@dev: the net device
+ *
+ * The DIM works of the device must not be running anymore.
+ */
+void net_dim_free_irq_moder(struct net_device *dev);
+
+/**
+ *	net_dim_set_rx_mode - record the CQ period mode of the RX CQs
+ *	@dev: the net device
+ *	@rx_mode: CQ period mode
+ *
+ * Selects the profile ethtool shows and modifies. Called under RTNL.
+ */
+void net_dim_set_rx_mode(struct net_device *dev, u8 rx_mode);
+
+/**
+ *	net_dim_set_tx_mode - record the CQ period mode of the TX CQs
+ *	@dev: the net device
+ *	@tx_mode: CQ period mode
+ */
+void net_dim_set_tx_mode(struct net_device *dev, u8 tx_mode);
+
+/**
+ *	net_dim_get_rx_irq_moder - provide the CQ moderation a DIM instance chose
+ *	@dev: the net device
+ *	@dim: DIM instance of an RX CQ
+ *
+ * Looks the profile index of @dim up in the RX profile of the device for the
+ * CQ period mode of @dim, or in the default one if it has none.
+ */
+struct dim_cq_moder
+net_dim_get_rx_irq_moder(struct net_device *dev, struct dim *dim);
+
+/**
+ *	net_dim_get_tx_irq_moder - provide the CQ moderation a DIM instance chose
+ *	@dev: the net device
+ *	@dim: DIM instance of a TX CQ
+ */
+struct dim_cq_moder
+net_dim_get_tx_irq_moder(struct net_device *dev, struct dim *dim);
+
+/**
+ *	net_dim_get_def_rx_irq_moder - provide the default RX CQ moderation
+ *	@dev: the net device
+ *	@cq_period_mode: CQ period mode
+ *
+ * The starting point of a DIM instance, taken from the RX profile of the
+ * device like net_dim_get_rx_irq_moder() does.
+ */
+struct dim_cq_moder
+net_dim_get_def_rx_irq_moder(struct net_device *dev, u8 cq_period_mode);
+
+/**
+ *	net_dim_get_def_tx_irq_moder - provide the default TX CQ moderation
+ *	@dev: the net device
+ *	@cq_period_mode: CQ period mode
+ */
+struct dim_cq_moder
+net_dim_get_def_tx_irq_moder(struct net_device *dev, u8 cq_period_mode);
+
 /**
  *	net_dim - main DIM algorithm entry point
  *	@dim: DIM instance information
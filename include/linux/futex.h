@@ -4,6 +4,7 @@
 
 #include <linux/sched.h>
 #include <linux/ktime.h>
+#include <linux/mm_types.h>
 
 #include <uapi/linux/futex.h>
 
@@ -90,4 +91,23 @@ static inline long do_futex(u32 __user *uaddr, int op, u32 val,
 }
 #endif
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+static inline void futex_mm_init(struct mm_struct *mm)
+{
+	RCU_INIT_POINTER(mm->futex_phash, NULL);
+	mm->futex_phash_flags = 0;
+	mutex_init(&mm->futex_hash_lock);
+}
+
+void futex_hash_free(struct mm_struct *mm);
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3);
+#else
+static inline void futex_mm_init(struct mm_struct *mm) { }
+static inline void futex_hash_free(struct mm_struct *mm) { }
+static inline int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	return -EINVAL;
+}
+#endif
+
 #endif
@@ -14,6 +14,7 @@ struct irq_affinity_notify;
 struct proc_dir_entry;
 struct module;
 struct irq_desc;
+struct irq_handler_stats;
 struct irq_domain;
 struct pt_regs;
 
@@ -50,6 +51,9 @@ struct pt_regs;
  * @request_mutex:	mutex to protect request/free before locking desc->lock
  * @dir:		/proc/irq/ procfs entry
  * @debugfs_file:	dentry for the debugfs file
+ * @handler_stats:	per cpu handler statistics, see kernel/irq/stats.c
+ * @handler_stats_on:	handler statistics are collected
+ * @storm_threshold:	interrupt rate per second reported as a storm
  * @name:		flow handler name for /proc/interrupts output
  */
 struct irq_desc {
@@ -94,6 +98,11 @@ struct irq_desc {
 	struct dentry		*debugfs_file;
 	const char		*dev_name;
 #endif
+#ifdef CONFIG_GENERIC_IRQ_STATS
+	struct irq_handler_stats __percpu *handler_stats;
+	bool			handler_stats_on;
+	unsigned int		storm_threshold;
+#endif
 #ifdef CONFIG_SPARSE_IRQ
 	struct rcu_head		rcu;
 	struct kobject		kobj;
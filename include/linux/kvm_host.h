@@ -335,6 +335,10 @@ struct kvm_vcpu {
 
 	struct mutex mutex;
 	struct kvm_run *run;
+#ifdef CONFIG_KVM_MMIO
+	/* Only with KVM_CAP_COALESCED_MMIO_PER_VCPU */
+	struct kvm_coalesced_mmio_ring *coalesced_mmio_ring;
+#endif
 
 #ifndef __KVM_HAVE_ARCH_WQP
 	struct rcuwait wait;
@@ -767,6 +771,7 @@ struct kvm {
 	struct kvm_coalesced_mmio_ring *coalesced_mmio_ring;
 	spinlock_t ring_lock;
 	struct list_head coalesced_zones;
+	bool coalesced_mmio_per_vcpu;
 #endif
 
 	struct mutex irq_lock;
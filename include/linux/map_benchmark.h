@@ -10,6 +10,7 @@
 #define DMA_MAP_MAX_THREADS     1024
 #define DMA_MAP_MAX_SECONDS     300
 #define DMA_MAP_MAX_TRANS_DELAY (10 * NSEC_PER_MSEC)
+#define DMA_MAP_MAX_BURST       1024
 
 #define DMA_MAP_BIDIRECTIONAL   0
 #define DMA_MAP_TO_DEVICE       1
@@ -27,5 +28,6 @@ struct map_benchmark {
 	__u32 dma_dir; /* DMA data direction */
 	__u32 dma_trans_ns; /* time for DMA transmission in ns */
 	__u32 granule;  /* how many PAGE_SIZE will do map/unmap once a time */
+	__u32 burst; /* how many mappings each thread keeps alive at once */
 };
 #endif /* _KERNEL_DMA_BENCHMARK_H */
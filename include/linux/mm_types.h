@@ -11,6 +11,7 @@
 #include <linux/rbtree.h>
 #include <linux/maple_tree.h>
 #include <linux/rwsem.h>
+#include <linux/mutex.h>
 #include <linux/completion.h>
 #include <linux/cpumask.h>
 #include <linux/uprobes.h>
@@ -551,6 +552,7 @@ struct vm_area_struct {
 } __randomize_layout;
 
 struct kioctx_table;
+struct futex_private_hash;
 struct mm_struct {
 	struct {
 		struct maple_tree mm_mt;
@@ -737,6 +739,13 @@ struct mm_struct {
 #ifdef CONFIG_IOMMU_SVA
 		u32 pasid;
 #endif
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+		/* private futex hash, NULL while the global hash is used */
+		struct futex_private_hash __rcu *futex_phash;
+		unsigned long futex_phash_flags;
+		/* serializes replacements of futex_phash */
+		struct mutex futex_hash_lock;
+#endif
 #ifdef CONFIG_KSM
 		/*
 		 * Represent how many pages of this process are involved in KSM
@@ -103,7 +103,7 @@ int mpi_print(enum gcry_mpi_format format, unsigned char *buffer,
 			size_t buflen, size_t *nwritten, MPI a);
 
 /*-- mpi-mod.c --*/
-void mpi_mod(MPI rem, MPI dividend, MPI divisor);
+int mpi_mod(MPI rem, MPI dividend, MPI divisor);
 
 /* Context used with Barrett reduction.  */
 struct barrett_ctx_s;
@@ -150,8 +150,8 @@ void mpi_mul(MPI w, MPI u, MPI v);
 void mpi_mulm(MPI w, MPI u, MPI v, MPI m);
 
 /*-- mpi-div.c --*/
-void mpi_tdiv_r(MPI rem, MPI num, MPI den);
-void mpi_fdiv_r(MPI rem, MPI dividend, MPI divisor);
+int mpi_tdiv_r(MPI rem, MPI num, MPI den);
+int mpi_fdiv_r(MPI rem, MPI dividend, MPI divisor);
 void mpi_fdiv_q(MPI quot, MPI dividend, MPI divisor);
 
 /*-- mpi-inv.c --*/
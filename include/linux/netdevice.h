@@ -58,6 +58,7 @@ struct device;
 struct ethtool_ops;
 struct phy_device;
 struct dsa_port;
+struct dim_irq_moder;
 struct ip_tunnel_parm;
 struct macsec_context;
 struct macsec_ops;
@@ -2025,6 +2026,9 @@ enum netdev_ml_priv_type {
  *			SET_NETDEV_DEVLINK_PORT macro. This pointer is static
  *			during the time netdevice is registered.
  *
+ *	@irq_moder:	User modifiable net DIM profiles, see
+ *			net_dim_init_irq_moder().
+ *
  *	FIXME: cleanup struct net_device such that network protocol info
  *	moves out.
  */
@@ -2381,6 +2385,8 @@ struct net_device {
 	struct rtnl_hw_stats64	*offload_xstats_l3;
 
 	struct devlink_port	*devlink_port;
+
+	struct dim_irq_moder	*irq_moder;
 };
 #define to_net_dev(d) container_of(d, struct net_device, dev)
 
@@ -1505,6 +1505,10 @@ extern void perf_callchain_kernel(struct perf_callchain_entry_ctx *entry, struct
 extern struct perf_callchain_entry *
 get_perf_callchain(struct pt_regs *regs, u32 init_nr, bool kernel, bool user,
 		   u32 max_stack, bool crosstask, bool add_mark);
+extern struct perf_callchain_entry *
+get_perf_callchain_deferred(struct pt_regs *regs, bool kernel, u32 max_stack,
+			    u64 cookie);
+extern struct perf_callchain_entry *perf_callchain_user_deferred(void);
 extern int get_callchain_buffers(int max_stack);
 extern void put_callchain_buffers(void);
 extern struct perf_callchain_entry *get_callchain_entry(int *rctx);
@@ -1513,6 +1517,21 @@ extern void put_callchain_entry(int rctx);
 extern int sysctl_perf_event_max_stack;
 extern int sysctl_perf_event_max_contexts_per_stack;
 
+/*
+ * A user stack unwinder for deferred callchains, e.g. one using .sframe
+ * unwind tables.  ->unwind() runs in task context on return to user space
+ * and may fault; it returns false to leave the stack to the next unwinder
+ * and finally to the frame pointer based perf_callchain_user().
+ */
+struct perf_user_unwinder {
+	struct list_head	list;
+	bool			(*unwind)(struct perf_callchain_entry_ctx *entry,
+					  struct pt_regs *regs);
+};
+
+extern void perf_register_user_unwinder(struct perf_user_unwinder *uw);
+extern void perf_unregister_user_unwinder(struct perf_user_unwinder *uw);
+
 static inline int perf_callchain_store_context(struct perf_callchain_entry_ctx *ctx, u64 ip)
 {
 	if (ctx->contexts < sysctl_perf_event_max_contexts_per_stack) {
@@ -28,6 +28,8 @@
  * @iprim:	prim-th root of 1, index form
  * @gfpoly:	The primitive generator polynominal
  * @gffunc:	Function to generate the field, if non-canonical representation
+ * @synmul:	Split nibble multiplication tables of the roots, for the
+ *		syndromes, if the symbol size is 8 bits or less
  * @users:	Users of this structure
  * @list:	List entry for the rs codec list
 */
@@ -43,6 +45,7 @@ struct rs_codec {
 	int		iprim;
 	int		gfpoly;
 	int		(*gffunc)(int);
+	uint8_t		*synmul;
 	int		users;
 	struct list_head list;
 };
@@ -54,6 +54,8 @@ struct io_uring_task;
 struct mempolicy;
 struct nameidata;
 struct nsproxy;
+struct perf_callchain_entry;
+struct perf_event;
 struct perf_event_context;
 struct pid_namespace;
 struct pipe_inode_info;
@@ -723,6 +725,22 @@ enum perf_event_task_context {
 	perf_nr_task_contexts,
 };
 
+#define PERF_UNWIND_MAX_EVENTS	4
+
+/*
+ * Events waiting for the user callchain of the current kernel entry, which
+ * is unwound once on return to user space; see perf_callchain_defer().
+ */
+struct perf_unwind_task {
+	struct callback_head		work;
+	u64				cookie;
+	unsigned int			state;
+	unsigned int			nr_events;
+	struct perf_event		*events[PERF_UNWIND_MAX_EVENTS];
+	struct perf_callchain_entry	*entry;
+	size_t				entry_size;
+};
+
 struct wake_q_node {
 	struct wake_q_node *next;
 };
@@ -1240,6 +1258,7 @@ struct task_struct {
 	struct perf_event_context	*perf_event_ctxp;
 	struct mutex			perf_event_mutex;
 	struct list_head		perf_event_list;
+	struct perf_unwind_task		perf_unwind;
 #endif
 #ifdef CONFIG_DEBUG_PREEMPT
 	unsigned long			preempt_disable_ip;
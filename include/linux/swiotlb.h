@@ -8,6 +8,7 @@
 #include <linux/types.h>
 #include <linux/limits.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 struct device;
 struct page;
@@ -87,6 +88,25 @@ dma_addr_t swiotlb_map(struct device *dev, phys_addr_t phys,
  * @for_alloc:  %true if the pool is used for memory allocation
  * @nareas:  The area number in the pool.
  * @area_nslabs: The slot number in the area.
+ * @total_used:	The number of used IO TLB blocks in this pool and all the
+ *		pools added to it, for debugfs.
+ * @used_hiwater: The high watermark of @total_used, for debugfs.
+ * @pools:	Pools allocated at run time to extend this one.
+ * @node:	Entry of a run time allocated pool in the @pools list of the
+ *		pool it extends.
+ * @lock:	Protects @pools and the counters below.
+ * @can_grow:	%true if more pools may be allocated at run time.
+ * @transient:	%true if the pool was allocated for a single mapping and is
+ *		freed when that mapping is unmapped.
+ * @retiring:	%true while an idle pool is about to be released.
+ * @last_used:	Jiffies when the pool last had slots released.
+ * @phys_limit:	Maximum physical address of run time allocated pools.
+ * @dyn_alloc:	Work to allocate a new pool.
+ * @dyn_free:	Work to release idle pools.
+ * @nr_pools:	The number of pools on @pools, not counting transient ones.
+ * @dyn_nslabs:	The number of IO TLB blocks in those pools.
+ * @transient_nslabs: The number of IO TLB blocks in transient pools.
+ * @rcu:	RCU head to free a run time allocated pool.
  */
 struct io_tlb_mem {
 	phys_addr_t start;
@@ -102,14 +122,44 @@ struct io_tlb_mem {
 	unsigned int area_nslabs;
 	struct io_tlb_area *areas;
 	struct io_tlb_slot *slots;
+#ifdef CONFIG_DEBUG_FS
+	atomic_long_t total_used;
+	atomic_long_t used_hiwater;
+#endif
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	struct list_head pools;
+	struct list_head node;
+	spinlock_t lock;
+	bool can_grow;
+	bool transient;
+	bool retiring;
+	unsigned long last_used;
+	phys_addr_t phys_limit;
+	struct work_struct dyn_alloc;
+	struct delayed_work dyn_free;
+	unsigned long nr_pools;
+	unsigned long dyn_nslabs;
+	unsigned long transient_nslabs;
+	struct rcu_head rcu;
+#endif
 };
 extern struct io_tlb_mem io_tlb_default_mem;
 
+struct io_tlb_mem *swiotlb_find_pool(struct device *dev, phys_addr_t paddr);
+
 static inline bool is_swiotlb_buffer(struct device *dev, phys_addr_t paddr)
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 
-	return mem && paddr >= mem->start && paddr < mem->end;
+	if (!mem)
+		return false;
+	if (paddr >= mem->start && paddr < mem->end)
+		return true;
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	if (mem->can_grow && !list_empty(&mem->pools))
+		return swiotlb_find_pool(dev, paddr);
+#endif
+	return false;
 }
 
 static inline bool is_swiotlb_force_bounce(struct device *dev)
@@ -42,7 +42,17 @@ struct uprobe_consumer {
 				enum uprobe_filter_ctx ctx,
 				struct mm_struct *mm);
 
-	struct uprobe_consumer *next;
+	struct list_head cons_node;
+};
+
+/*
+ * One probe of a uprobe_register_batch()/uprobe_unregister_batch() call,
+ * all probes of a batch belong to the same inode.
+ */
+struct uprobe_batch_entry {
+	loff_t			offset;
+	loff_t			ref_ctr_offset;
+	struct uprobe_consumer	*uc;
 };
 
 #ifdef CONFIG_UPROBES
@@ -114,6 +124,10 @@ extern int uprobe_register(struct inode *inode, loff_t offset, struct uprobe_con
 extern int uprobe_register_refctr(struct inode *inode, loff_t offset, loff_t ref_ctr_offset, struct uprobe_consumer *uc);
 extern int uprobe_apply(struct inode *inode, loff_t offset, struct uprobe_consumer *uc, bool);
 extern void uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consumer *uc);
+extern void uprobe_unregister_nosync(struct inode *inode, loff_t offset, struct uprobe_consumer *uc);
+extern void uprobe_unregister_sync(void);
+extern int uprobe_register_batch(struct inode *inode, struct uprobe_batch_entry *entries, unsigned int cnt);
+extern void uprobe_unregister_batch(struct inode *inode, struct uprobe_batch_entry *entries, unsigned int cnt);
 extern int uprobe_mmap(struct vm_area_struct *vma);
 extern void uprobe_munmap(struct vm_area_struct *vma, unsigned long start, unsigned long end);
 extern void uprobe_start_dup_mmap(void);
@@ -166,6 +180,22 @@ static inline void
 uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consumer *uc)
 {
 }
+static inline void
+uprobe_unregister_nosync(struct inode *inode, loff_t offset, struct uprobe_consumer *uc)
+{
+}
+static inline void uprobe_unregister_sync(void)
+{
+}
+static inline int
+uprobe_register_batch(struct inode *inode, struct uprobe_batch_entry *entries, unsigned int cnt)
+{
+	return -ENOSYS;
+}
+static inline void
+uprobe_unregister_batch(struct inode *inode, struct uprobe_batch_entry *entries, unsigned int cnt)
+{
+}
 static inline int uprobe_mmap(struct vm_area_struct *vma)
 {
 	return 0;
@@ -18,10 +18,24 @@
 #include <linux/init_syscalls.h>
 #include <linux/task_work.h>
 #include <linux/umh.h>
+#include <linux/uio.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/completion.h>
+#include <linux/zstd.h>
+#include <asm/unaligned.h>
 
 static __initdata bool csum_present;
 static __initdata u32 io_csum;
 
+static void __init update_csum(const unsigned char *p, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; i++)
+		io_csum += p[i];
+}
+
 static ssize_t __init xwrite(struct file *file, const unsigned char *p,
 		size_t count, loff_t *pos)
 {
@@ -38,12 +52,8 @@ static ssize_t __init xwrite(struct file *file, const unsigned char *p,
 		} else if (rv == 0)
 			break;
 
-		if (csum_present) {
-			ssize_t i;
-
-			for (i = 0; i < rv; i++)
-				io_csum += p[i];
-		}
+		if (csum_present)
+			update_csum(p, rv);
 
 		p += rv;
 		out += rv;
@@ -53,6 +63,40 @@ static ssize_t __init xwrite(struct file *file, const unsigned char *p,
 	return out;
 }
 
+/*
+ * Copy file bodies straight into the page cache of the freshly created
+ * rootfs inode. Nobody else can see the file yet, so this skips what
+ * kernel_write() does on every call (fsnotify, time and privilege updates)
+ * and hands whole body chunks to ->write_begin/->write_end in one go.
+ */
+static ssize_t __init xwrite_pagecache(struct file *file,
+		const unsigned char *p, size_t count, loff_t *pos)
+{
+	struct inode *inode = file_inode(file);
+	struct kvec kvec = { .iov_base = (void *)p, .iov_len = count };
+	struct iov_iter iter;
+	struct kiocb kiocb;
+	ssize_t rv;
+
+	if (!file->f_mapping->a_ops->write_begin)
+		return xwrite(file, p, count, pos);
+
+	init_sync_kiocb(&kiocb, file);
+	kiocb.ki_pos = *pos;
+	iov_iter_kvec(&iter, ITER_SOURCE, &kvec, 1, count);
+
+	inode_lock(inode);
+	rv = generic_perform_write(&kiocb, &iter);
+	inode_unlock(inode);
+	if (rv <= 0)
+		return rv;
+
+	if (csum_present)
+		update_csum(p, rv);
+	*pos += rv;
+	return rv;
+}
+
 static __initdata char *message;
 static void __init error(char *x)
 {
@@ -408,7 +452,8 @@ static int __init do_name(void)
 static int __init do_copy(void)
 {
 	if (byte_count >= body_len) {
-		if (xwrite(wfile, victim, body_len, &wfile_pos) != body_len)
+		if (xwrite_pagecache(wfile, victim, body_len,
+				     &wfile_pos) != body_len)
 			error("write error");
 
 		do_utime_path(&wfile->f_path, mtime);
@@ -419,7 +464,8 @@ static int __init do_copy(void)
 		state = SkipIt;
 		return 0;
 	} else {
-		if (xwrite(wfile, victim, byte_count, &wfile_pos) != byte_count)
+		if (xwrite_pagecache(wfile, victim, byte_count,
+				     &wfile_pos) != byte_count)
 			error("write error");
 		body_len -= byte_count;
 		eat(byte_count);
@@ -487,11 +533,336 @@ static unsigned long my_inptr __initdata; /* index of next byte to be processed
 
 #include <linux/decompress/generic.h>
 
+/*
+ * Decompression and cpio unpacking run as a two stage pipeline on SMP: the
+ * decompressor copies its output into a ring of chunks that a kthread feeds
+ * to the cpio state machine, so that file creation and page cache copies
+ * overlap with decompressing the next chunk.
+ */
+#define UNPACK_CHUNK_SIZE	(128 * 1024)
+#define UNPACK_NR_CHUNKS	4
+
+static __initdata struct unpack_pipe {
+	char *buf[UNPACK_NR_CHUNKS];
+	unsigned long len[UNPACK_NR_CHUNKS];
+	unsigned int head;		/* next chunk to fill */
+	unsigned int tail;		/* next chunk to unpack */
+	bool done;
+	bool running;
+	wait_queue_head_t wait;
+	struct completion exited;
+} unpack_pipe;
+
+static bool __initdata initramfs_pipeline = true;
+static int __init initramfs_pipeline_setup(char *str)
+{
+	return kstrtobool(str, &initramfs_pipeline) == 0;
+}
+__setup("initramfs_pipeline=", initramfs_pipeline_setup);
+
+static int __init unpack_pipe_fn(void *unused)
+{
+	unsigned int tail = unpack_pipe.tail, head;
+
+	for (;;) {
+		wait_event(unpack_pipe.wait, smp_load_acquire(&unpack_pipe.head) != tail ||
+				      READ_ONCE(unpack_pipe.done));
+		head = smp_load_acquire(&unpack_pipe.head);
+		if (head == tail)
+			break;
+
+		while (tail != head) {
+			unsigned int i = tail % UNPACK_NR_CHUNKS;
+
+			flush_buffer(unpack_pipe.buf[i], unpack_pipe.len[i]);
+			smp_store_release(&unpack_pipe.tail, ++tail);
+			wake_up(&unpack_pipe.wait);
+		}
+	}
+
+	complete(&unpack_pipe.exited);
+	return 0;
+}
+
+static long __init pipe_flush(void *bufv, unsigned long len)
+{
+	char *buf = bufv;
+	long origLen = len;
+
+	while (len) {
+		unsigned int head = unpack_pipe.head, i = head % UNPACK_NR_CHUNKS;
+		unsigned long n = min_t(unsigned long, len, UNPACK_CHUNK_SIZE);
+
+		wait_event(unpack_pipe.wait, head - smp_load_acquire(&unpack_pipe.tail) <
+				      UNPACK_NR_CHUNKS || READ_ONCE(message));
+		if (READ_ONCE(message))
+			return -1;
+
+		memcpy(unpack_pipe.buf[i], buf, n);
+		unpack_pipe.len[i] = n;
+		smp_store_release(&unpack_pipe.head, head + 1);
+		wake_up(&unpack_pipe.wait);
+
+		buf += n;
+		len -= n;
+	}
+	return origLen;
+}
+
+static bool __init unpack_pipe_start(void)
+{
+	struct task_struct *tsk;
+	int i;
+
+	if (!initramfs_pipeline || num_online_cpus() < 2)
+		return false;
+
+	for (i = 0; i < UNPACK_NR_CHUNKS; i++) {
+		unpack_pipe.buf[i] = kmalloc(UNPACK_CHUNK_SIZE, GFP_KERNEL);
+		if (!unpack_pipe.buf[i])
+			goto out_free;
+	}
+	unpack_pipe.head = unpack_pipe.tail = 0;
+	unpack_pipe.done = false;
+	init_waitqueue_head(&unpack_pipe.wait);
+	init_completion(&unpack_pipe.exited);
+
+	tsk = kthread_run(unpack_pipe_fn, NULL, "initramfs_unpack");
+	if (!IS_ERR(tsk)) {
+		unpack_pipe.running = true;
+		return true;
+	}
+
+out_free:
+	while (i--)
+		kfree(unpack_pipe.buf[i]);
+	return false;
+}
+
+/* Wait for the unpacking side to drain the pipe and exit. */
+static void __init unpack_pipe_stop(void)
+{
+	int i;
+
+	if (!unpack_pipe.running)
+		return;
+
+	unpack_pipe.running = false;
+	WRITE_ONCE(unpack_pipe.done, true);
+	wake_up(&unpack_pipe.wait);
+	wait_for_completion(&unpack_pipe.exited);
+
+	for (i = 0; i < UNPACK_NR_CHUNKS; i++)
+		kfree(unpack_pipe.buf[i]);
+}
+
+#ifdef CONFIG_RD_ZSTD
+/*
+ * Archives made of several independent zstd frames that record their
+ * decompressed size (as written by pzstd or zstd --block-size, for example)
+ * are decompressed a window of frames at a time in parallel, and handed to
+ * the cpio unpacker in order.
+ */
+#define UNZSTD_MAX_FRAME_SIZE	(64 << 20)
+
+struct unzstd_frame {
+	const void *src;
+	size_t src_len;
+	void *dst;
+	size_t dst_len;
+	async_cookie_t cookie;
+	int err;
+};
+
+static ASYNC_DOMAIN_EXCLUSIVE(unzstd_domain);
+
+#ifdef CONFIG_INITRAMFS_KUNIT_TEST
+/* Source of the frame whose decompression runs out of memory, for tests */
+static const void *unzstd_fail_src __initdata;
+#endif
+
+static void * __init unzstd_alloc_wksp(struct unzstd_frame *f, size_t size)
+{
+#ifdef CONFIG_INITRAMFS_KUNIT_TEST
+	if (f->src == unzstd_fail_src)
+		return NULL;
+#endif
+	return kvmalloc(size, GFP_KERNEL);
+}
+
+static void __init unzstd_frame_fn(void *data, async_cookie_t cookie)
+{
+	struct unzstd_frame *f = data;
+	size_t wksp_size = zstd_dctx_workspace_bound();
+	void *wksp = unzstd_alloc_wksp(f, wksp_size);
+	zstd_dctx *dctx;
+	size_t ret;
+
+	f->err = -ENOMEM;
+	if (!wksp)
+		return;
+
+	dctx = zstd_init_dctx(wksp, wksp_size);
+	if (dctx) {
+		ret = zstd_decompress_dctx(dctx, f->dst, f->dst_len,
+					   f->src, f->src_len);
+		f->err = zstd_is_error(ret) || ret != f->dst_len ? -EINVAL : 0;
+	}
+	kvfree(wksp);
+}
+
+static bool __init is_zstd_frame(const char *buf, unsigned long len)
+{
+	u32 magic;
+
+	if (len < 4)
+		return false;
+	magic = get_unaligned_le32(buf);
+	return magic == ZSTD_MAGICNUMBER ||
+		(magic & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START;
+}
+
+/*
+ * Returns the number of frames at @buf if they can all be decompressed on
+ * their own, 0 otherwise.
+ */
+static unsigned int __init unzstd_count_frames(const char *buf,
+					       unsigned long len)
+{
+	unsigned int nr = 0, nr_data = 0;
+	zstd_frame_header fh;
+	size_t size;
+
+	while (is_zstd_frame(buf, len)) {
+		if (zstd_get_frame_header(&fh, buf, len))
+			return 0;
+		size = zstd_find_frame_compressed_size(buf, len);
+		if (zstd_is_error(size))
+			return 0;
+		if (fh.frameType != ZSTD_skippableFrame) {
+			if (fh.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+			    fh.frameContentSize > UNZSTD_MAX_FRAME_SIZE)
+				return 0;
+			nr_data++;
+		}
+		nr++;
+		buf += size;
+		len -= size;
+	}
+
+	return nr_data > 1 ? nr : 0;
+}
+
+/*
+ * Decompressed frames in flight may take up to a quarter of the memory
+ * available, at least one frame is always attempted.
+ */
+static unsigned long __init unzstd_budget(void)
+{
+	return (si_mem_available() << PAGE_SHIFT) / 4;
+}
+
+/*
+ * Returns 0 once the whole archive is unpacked, -EOPNOTSUPP if it is not
+ * made of frames that can be decompressed in parallel, or -ENOMEM if it ran
+ * out of memory for them. The frames before my_inptr are unpacked then, the
+ * rest is left to the serial decompressor.
+ */
+static int __init unzstd_parallel(char *buf, unsigned long len,
+				  long (*flush)(void *, unsigned long))
+{
+	unsigned int nr = unzstd_count_frames(buf, len), window, i, next;
+	size_t wksp_size = zstd_dctx_workspace_bound();
+	unsigned long budget, inflight = 0, pos = 0;
+	struct unzstd_frame *frames;
+	zstd_frame_header fh;
+	int err = 0;
+
+	if (!nr || num_online_cpus() < 2)
+		return -EOPNOTSUPP;
+
+	frames = kcalloc(nr, sizeof(*frames), GFP_KERNEL);
+	if (!frames)
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < nr; i++) {
+		zstd_get_frame_header(&fh, buf + pos, len - pos);
+		frames[i].src = buf + pos;
+		frames[i].src_len = zstd_find_frame_compressed_size(buf + pos,
+								    len - pos);
+		if (fh.frameType != ZSTD_skippableFrame)
+			frames[i].dst_len = fh.frameContentSize;
+		pos += frames[i].src_len;
+	}
+
+	window = min(num_online_cpus(), 8U);
+	budget = unzstd_budget();
+	for (i = 0, next = 0; i < nr; i++) {
+		for (; next < nr && next < i + window; next++) {
+			struct unzstd_frame *f = &frames[next];
+
+			if (!f->dst_len)
+				continue;
+			if (inflight &&
+			    inflight + f->dst_len + wksp_size > budget)
+				break;
+			f->dst = kvmalloc(f->dst_len, GFP_KERNEL | __GFP_NOWARN);
+			if (!f->dst)
+				break;
+			inflight += f->dst_len + wksp_size;
+			f->cookie = async_schedule_domain(unzstd_frame_fn, f,
+							  &unzstd_domain);
+		}
+
+		if (!frames[i].dst_len)
+			continue;
+		if (!frames[i].dst) {
+			err = -ENOMEM;
+			break;
+		}
+		async_synchronize_cookie_domain(frames[i].cookie + 1,
+						&unzstd_domain);
+		err = frames[i].err;
+		if (!err && flush(frames[i].dst, frames[i].dst_len) < 0)
+			err = -EINVAL;
+		if (err)
+			break;
+		kvfree(frames[i].dst);
+		frames[i].dst = NULL;
+		inflight -= frames[i].dst_len + wksp_size;
+	}
+
+	async_synchronize_full_domain(&unzstd_domain);
+	for (next = 0; next < nr; next++)
+		kvfree(frames[next].dst);
+
+	if (err == -ENOMEM) {
+		/* Frame i and the ones after it are left to the serial path */
+		pos = (const char *)frames[i].src - buf;
+		pr_info("Initramfs: out of memory for parallel unzstd, continuing serially\n");
+	} else if (err) {
+		error("decompressor failed");
+	}
+	kfree(frames);
+
+	my_inptr = pos;
+	return err == -ENOMEM ? -ENOMEM : 0;
+}
+#else
+static int __init unzstd_parallel(char *buf, unsigned long len,
+				  long (*flush)(void *, unsigned long))
+{
+	return -EOPNOTSUPP;
+}
+#endif /* CONFIG_RD_ZSTD */
+
 static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 {
 	long written;
 	decompress_fn decompress;
 	const char *compress_name;
+	unsigned long skip;
+	int res;
 	static __initdata char msg_buf[64];
 
 	header_buf = kmalloc(110, GFP_KERNEL);
@@ -522,9 +893,25 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 		this_header = 0;
 		decompress = decompress_method(buf, len, &compress_name);
 		pr_debug("Detected %s compressed data\n", compress_name);
-		if (decompress) {
-			int res = decompress(buf, len, NULL, flush_buffer, NULL,
-				   &my_inptr, error);
+		res = -EOPNOTSUPP;
+		skip = 0;
+		if (decompress && !strcmp(compress_name, "zstd")) {
+			res = unzstd_parallel(buf, len, flush_buffer);
+			/* the serial path takes over from my_inptr */
+			if (res == -ENOMEM)
+				skip = my_inptr;
+		}
+		if (!res) {
+			/* done, the frames were decompressed in parallel */
+		} else if (decompress) {
+			bool piped = unpack_pipe_start();
+
+			res = decompress(buf + skip, len - skip, NULL,
+					 piped ? pipe_flush : flush_buffer, NULL,
+					 &my_inptr, error);
+			my_inptr += skip;
+
+			unpack_pipe_stop();
 			if (res)
 				error("decompressor failed");
 		} else if (compress_name) {
@@ -760,3 +1147,7 @@ static int __init populate_rootfs(void)
 	return 0;
 }
 rootfs_initcall(populate_rootfs);
+
+#ifdef CONFIG_INITRAMFS_KUNIT_TEST
+#include "initramfs_test.c"
+#endif
@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit tests for the parallel zstd decompression of the initramfs
+ *
+ * Included from initramfs.c, the code under test is static and __init.
+ */
+
+#include <kunit/test.h>
+
+#include <linux/decompress/unzstd.h>
+
+#define UNZSTD_TEST_FRAMES	5
+#define UNZSTD_TEST_FRAME_SIZE	(64 * 1024)
+#define UNZSTD_TEST_SIZE	(UNZSTD_TEST_FRAMES * UNZSTD_TEST_FRAME_SIZE)
+
+struct unzstd_test_ctx {
+	u8 *src;
+	u8 *comp;
+	size_t comp_len;
+	size_t frame_off[UNZSTD_TEST_FRAMES];
+};
+
+static u8 *unzstd_test_out __initdata;
+static unsigned long unzstd_test_out_len __initdata;
+
+static long __init unzstd_test_flush(void *buf, unsigned long len)
+{
+	if (len > UNZSTD_TEST_SIZE - unzstd_test_out_len)
+		return -1;
+	memcpy(unzstd_test_out + unzstd_test_out_len, buf, len);
+	unzstd_test_out_len += len;
+	return len;
+}
+
+/* Compress the corpus as one zstd frame per UNZSTD_TEST_FRAME_SIZE bytes */
+static void __init unzstd_test_prepare(struct kunit *test,
+				       struct unzstd_test_ctx *ctx)
+{
+	zstd_parameters params = zstd_get_params(3, UNZSTD_TEST_FRAME_SIZE);
+	size_t bound = zstd_compress_bound(UNZSTD_TEST_FRAME_SIZE);
+	size_t wksp_size = zstd_cctx_workspace_bound(&params.cParams);
+	zstd_cctx *cctx;
+	void *wksp;
+	size_t ret;
+	int i;
+
+	if (num_online_cpus() < 2)
+		kunit_skip(test, "needs at least two CPUs");
+
+	/* populate_rootfs() may still be running and uses the same state */
+	wait_for_initramfs();
+
+	ctx->src = kunit_kmalloc(test, UNZSTD_TEST_SIZE, GFP_KERNEL);
+	ctx->comp = kunit_kmalloc(test, bound * UNZSTD_TEST_FRAMES, GFP_KERNEL);
+	unzstd_test_out = kunit_kzalloc(test, UNZSTD_TEST_SIZE, GFP_KERNEL);
+	wksp = kunit_kmalloc(test, wksp_size, GFP_KERNEL);
+	KUNIT_ASSERT_TRUE(test, ctx->src && ctx->comp && unzstd_test_out &&
+				wksp);
+	unzstd_test_out_len = 0;
+
+	for (i = 0; i < UNZSTD_TEST_SIZE; i++)
+		ctx->src[i] = (i >> 3) ^ (i * 131) % 17;
+
+	cctx = zstd_init_cctx(wksp, wksp_size);
+	KUNIT_ASSERT_NOT_NULL(test, cctx);
+
+	ctx->comp_len = 0;
+	for (i = 0; i < UNZSTD_TEST_FRAMES; i++) {
+		ctx->frame_off[i] = ctx->comp_len;
+		ret = zstd_compress_cctx(cctx, ctx->comp + ctx->comp_len, bound,
+					 ctx->src + i * UNZSTD_TEST_FRAME_SIZE,
+					 UNZSTD_TEST_FRAME_SIZE, &params);
+		KUNIT_ASSERT_FALSE(test, zstd_is_error(ret));
+		ctx->comp_len += ret;
+	}
+
+	message = NULL;
+	unzstd_fail_src = NULL;
+}
+
+static void __init unzstd_test_parallel(struct kunit *test)
+{
+	struct unzstd_test_ctx ctx;
+
+	unzstd_test_prepare(test, &ctx);
+
+	KUNIT_EXPECT_EQ(test, unzstd_parallel((char *)ctx.comp, ctx.comp_len,
+					      unzstd_test_flush), 0);
+	KUNIT_EXPECT_PTR_EQ(test, message, NULL);
+	KUNIT_EXPECT_EQ(test, my_inptr, ctx.comp_len);
+	KUNIT_ASSERT_EQ(test, unzstd_test_out_len, UNZSTD_TEST_SIZE);
+	KUNIT_EXPECT_EQ(test, memcmp(unzstd_test_out, ctx.src,
+				     UNZSTD_TEST_SIZE), 0);
+}
+
+/*
+ * A frame in the middle runs out of memory: the frames before it are
+ * unpacked, and the serial decompressor picks up right at it.
+ */
+static void __init unzstd_test_worker_enomem(struct kunit *test)
+{
+	struct unzstd_test_ctx ctx;
+	long pos = 0;
+	int ret;
+
+	unzstd_test_prepare(test, &ctx);
+	unzstd_fail_src = ctx.comp + ctx.frame_off[2];
+
+	ret = unzstd_parallel((char *)ctx.comp, ctx.comp_len, unzstd_test_flush);
+	unzstd_fail_src = NULL;
+	KUNIT_ASSERT_EQ(test, ret, -ENOMEM);
+	KUNIT_EXPECT_PTR_EQ(test, message, NULL);
+	KUNIT_ASSERT_EQ(test, my_inptr, ctx.frame_off[2]);
+	KUNIT_ASSERT_EQ(test, unzstd_test_out_len, 2 * UNZSTD_TEST_FRAME_SIZE);
+
+	ret = unzstd(ctx.comp + my_inptr, ctx.comp_len - my_inptr, NULL,
+		     unzstd_test_flush, NULL, &pos, error);
+	KUNIT_EXPECT_EQ(test, ret, 0);
+	KUNIT_EXPECT_EQ(test, pos, ctx.comp_len - ctx.frame_off[2]);
+	KUNIT_ASSERT_EQ(test, unzstd_test_out_len, UNZSTD_TEST_SIZE);
+	KUNIT_EXPECT_EQ(test, memcmp(unzstd_test_out, ctx.src,
+				     UNZSTD_TEST_SIZE), 0);
+}
+
+static struct kunit_case __initdata initramfs_test_cases[] = {
+	KUNIT_CASE(unzstd_test_parallel),
+	KUNIT_CASE(unzstd_test_worker_enomem),
+	{}
+};
+
+static struct kunit_suite __initdata initramfs_test_suite = {
+	.name = "initramfs",
+	.test_cases = initramfs_test_cases,
+};
+
+kunit_test_init_section_suites(&initramfs_test_suite);
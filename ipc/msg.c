@@ -30,6 +30,7 @@
 #include <linux/mm.h>
 #include <linux/proc_fs.h>
 #include <linux/list.h>
+#include <linux/rbtree.h>
 #include <linux/security.h>
 #include <linux/sched/wake_q.h>
 #include <linux/syscalls.h>
@@ -57,8 +58,11 @@ struct msg_queue {
 	struct pid *q_lspid;		/* pid of last msgsnd */
 	struct pid *q_lrpid;		/* last receive pid */
 
-	struct list_head q_messages;
-	struct list_head q_receivers;
+	struct list_head q_messages;	/* all messages, oldest first */
+	struct rb_root_cached q_msgtree; /* the same, by type then age */
+	struct list_head q_receivers;	/* receivers not in SEARCH_EQUAL mode */
+	struct rb_root q_rcvtree;	/* SEARCH_EQUAL receivers, by type */
+	u64 q_rseq;			/* receiver arrival order */
 	struct list_head q_senders;
 } __randomize_layout;
 
@@ -72,9 +76,17 @@ struct msg_queue {
  * wake_q_add_safe() is used. See ipc/mqueue.c for more details
  */
 
-/* one msg_receiver structure for each sleeping receiver */
+/*
+ * one msg_receiver structure for each sleeping receiver
+ *
+ * Receivers waiting for one exact type sit in q_rcvtree, all others in
+ * q_receivers. r_seq records the arrival order across both, so that a sender
+ * still serves receivers strictly first come, first served.
+ */
 struct msg_receiver {
 	struct list_head	r_list;
+	struct rb_node		r_node;
+	u64			r_seq;
 	struct task_struct	*r_tsk;
 
 	int			r_mode;
@@ -168,7 +180,10 @@ static int newque(struct ipc_namespace *ns, struct ipc_params *params)
 	msq->q_qbytes = ns->msg_ctlmnb;
 	msq->q_lspid = msq->q_lrpid = NULL;
 	INIT_LIST_HEAD(&msq->q_messages);
+	msq->q_msgtree = RB_ROOT_CACHED;
 	INIT_LIST_HEAD(&msq->q_receivers);
+	msq->q_rcvtree = RB_ROOT;
+	msq->q_rseq = 0;
 	INIT_LIST_HEAD(&msq->q_senders);
 
 	/* ipc_addid() locks msq upon success. */
@@ -246,20 +261,36 @@ static void ss_wakeup(struct msg_queue *msq,
 	}
 }
 
+static void expunge_one(struct msg_receiver *msr, int res,
+			struct wake_q_head *wake_q)
+{
+	struct task_struct *r_tsk;
+
+	r_tsk = get_task_struct(msr->r_tsk);
+
+	/* see MSG_BARRIER for purpose/pairing */
+	smp_store_release(&msr->r_msg, ERR_PTR(res));
+	wake_q_add_safe(wake_q, r_tsk);
+}
+
 static void expunge_all(struct msg_queue *msq, int res,
 			struct wake_q_head *wake_q)
 {
 	struct msg_receiver *msr, *t;
 
-	list_for_each_entry_safe(msr, t, &msq->q_receivers, r_list) {
-		struct task_struct *r_tsk;
-
-		r_tsk = get_task_struct(msr->r_tsk);
+	list_for_each_entry_safe(msr, t, &msq->q_receivers, r_list)
+		expunge_one(msr, res, wake_q);
 
-		/* see MSG_BARRIER for purpose/pairing */
-		smp_store_release(&msr->r_msg, ERR_PTR(res));
-		wake_q_add_safe(wake_q, r_tsk);
+	/*
+	 * Empty the tree on the way: a post-order walk never goes back to a
+	 * node it has visited, which may be gone with its receiver's stack by
+	 * then. The receivers see the cleared node and don't unlink it again.
+	 */
+	rbtree_postorder_for_each_entry_safe(msr, t, &msq->q_rcvtree, r_node) {
+		RB_CLEAR_NODE(&msr->r_node);
+		expunge_one(msr, res, wake_q);
 	}
+	msq->q_rcvtree = RB_ROOT;
 }
 
 /*
@@ -813,17 +844,106 @@ static int testmsg(struct msg_msg *msg, long type, int mode)
 	return 0;
 }
 
+/*
+ * Messages are indexed by type in q_msgtree next to the q_messages list.
+ * Equal types are inserted to the right, so an in-order walk yields the
+ * messages of each type oldest first.
+ */
+static inline bool msg_type_less(struct rb_node *a, const struct rb_node *b)
+{
+	return rb_entry(a, struct msg_msg, m_rb)->m_type <
+		rb_entry(b, struct msg_msg, m_rb)->m_type;
+}
+
+static inline int msg_type_cmp(const void *key, const struct rb_node *node)
+{
+	long type = *(const long *)key;
+	long m_type = rb_entry(node, struct msg_msg, m_rb)->m_type;
+
+	if (type < m_type)
+		return -1;
+	return type > m_type;
+}
+
+static inline void msg_enqueue(struct msg_queue *msq, struct msg_msg *msg)
+{
+	list_add_tail(&msg->m_list, &msq->q_messages);
+	rb_add_cached(&msg->m_rb, &msq->q_msgtree, msg_type_less);
+}
+
+static inline void msg_dequeue(struct msg_queue *msq, struct msg_msg *msg)
+{
+	list_del(&msg->m_list);
+	rb_erase_cached(&msg->m_rb, &msq->q_msgtree);
+}
+
+static inline bool msr_type_less(struct rb_node *a, const struct rb_node *b)
+{
+	return rb_entry(a, struct msg_receiver, r_node)->r_msgtype <
+		rb_entry(b, struct msg_receiver, r_node)->r_msgtype;
+}
+
+static inline int msr_type_cmp(const void *key, const struct rb_node *node)
+{
+	long type = *(const long *)key;
+	long r_type = rb_entry(node, struct msg_receiver, r_node)->r_msgtype;
+
+	if (type < r_type)
+		return -1;
+	return type > r_type;
+}
+
+static inline void msr_add(struct msg_queue *msq, struct msg_receiver *msr)
+{
+	msr->r_seq = msq->q_rseq++;
+	if (msr->r_mode == SEARCH_EQUAL)
+		rb_add(&msr->r_node, &msq->q_rcvtree, msr_type_less);
+	else
+		list_add_tail(&msr->r_list, &msq->q_receivers);
+}
+
+static inline void msr_del(struct msg_queue *msq, struct msg_receiver *msr)
+{
+	if (msr->r_mode != SEARCH_EQUAL)
+		list_del(&msr->r_list);
+	else if (!RB_EMPTY_NODE(&msr->r_node))
+		rb_erase(&msr->r_node, &msq->q_rcvtree);
+}
+
+/*
+ * Hand @msg to the longest waiting receiver that accepts it. The receivers
+ * waiting for exactly m_type and all the others are merged by arrival order.
+ */
 static inline int pipelined_send(struct msg_queue *msq, struct msg_msg *msg,
 				 struct wake_q_head *wake_q)
 {
 	struct msg_receiver *msr, *t;
+	struct rb_node *node;
+
+	node = rb_find_first(&msg->m_type, &msq->q_rcvtree, msr_type_cmp);
+	t = list_first_entry(&msq->q_receivers, struct msg_receiver, r_list);
+
+	for (;;) {
+		bool list_done = list_entry_is_head(t, &msq->q_receivers, r_list);
+
+		if (node && (list_done ||
+			     rb_entry(node, struct msg_receiver, r_node)->r_seq <
+			     t->r_seq)) {
+			msr = rb_entry(node, struct msg_receiver, r_node);
+			node = rb_next_match(&msg->m_type, node, msr_type_cmp);
+		} else if (!list_done) {
+			msr = t;
+			t = list_next_entry(t, r_list);
+			if (!testmsg(msg, msr->r_msgtype, msr->r_mode))
+				continue;
+		} else {
+			break;
+		}
 
-	list_for_each_entry_safe(msr, t, &msq->q_receivers, r_list) {
-		if (testmsg(msg, msr->r_msgtype, msr->r_mode) &&
-		    !security_msg_queue_msgrcv(&msq->q_perm, msg, msr->r_tsk,
+		if (!security_msg_queue_msgrcv(&msq->q_perm, msg, msr->r_tsk,
 					       msr->r_msgtype, msr->r_mode)) {
 
-			list_del(&msr->r_list);
+			msr_del(msq, msr);
 			if (msr->r_maxsize < msg->m_ts) {
 				wake_q_add(wake_q, msr->r_tsk);
 
@@ -938,7 +1058,7 @@ static long do_msgsnd(int msqid, long mtype, void __user *mtext,
 
 	if (!pipelined_send(msq, msg, &wake_q)) {
 		/* no one is waiting for this message, enqueue it */
-		list_add_tail(&msg->m_list, &msq->q_messages);
+		msg_enqueue(msq, msg);
 		msq->q_cbytes += msgsz;
 		msq->q_qnum++;
 		percpu_counter_add_local(&ns->percpu_msg_bytes, msgsz);
@@ -1071,28 +1191,48 @@ static inline void free_copy(struct msg_msg *copy)
 }
 #endif
 
-static struct msg_msg *find_msg(struct msg_queue *msq, long *msgtyp, int mode)
+static struct msg_msg *find_msg(struct msg_queue *msq, long msgtyp, int mode)
 {
-	struct msg_msg *msg, *found = NULL;
+	struct msg_msg *msg;
+	struct rb_node *node;
 	long count = 0;
 
-	list_for_each_entry(msg, &msq->q_messages, m_list) {
-		if (testmsg(msg, *msgtyp, mode) &&
-		    !security_msg_queue_msgrcv(&msq->q_perm, msg, current,
-					       *msgtyp, mode)) {
-			if (mode == SEARCH_LESSEQUAL && msg->m_type != 1) {
-				*msgtyp = msg->m_type - 1;
-				found = msg;
-			} else if (mode == SEARCH_NUMBER) {
-				if (*msgtyp == count)
-					return msg;
-			} else
+	switch (mode) {
+	case SEARCH_EQUAL:
+		/* the oldest message of that type */
+		rb_for_each(node, &msgtyp, &msq->q_msgtree.rb_root, msg_type_cmp) {
+			msg = rb_entry(node, struct msg_msg, m_rb);
+			if (!security_msg_queue_msgrcv(&msq->q_perm, msg, current,
+						       msgtyp, mode))
 				return msg;
-			count++;
 		}
+		break;
+	case SEARCH_LESSEQUAL:
+		/* the oldest message of the lowest type */
+		for (node = rb_first_cached(&msq->q_msgtree); node;
+		     node = rb_next(node)) {
+			msg = rb_entry(node, struct msg_msg, m_rb);
+			if (msg->m_type > msgtyp)
+				break;
+			if (!security_msg_queue_msgrcv(&msq->q_perm, msg, current,
+						       msgtyp, mode))
+				return msg;
+		}
+		break;
+	default:
+		list_for_each_entry(msg, &msq->q_messages, m_list) {
+			if (testmsg(msg, msgtyp, mode) &&
+			    !security_msg_queue_msgrcv(&msq->q_perm, msg, current,
+						       msgtyp, mode)) {
+				if (mode != SEARCH_NUMBER || msgtyp == count)
+					return msg;
+				count++;
+			}
+		}
+		break;
 	}
 
-	return found ?: ERR_PTR(-EAGAIN);
+	return ERR_PTR(-EAGAIN);
 }
 
 static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, int msgflg,
@@ -1141,7 +1281,7 @@ static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, in
 			goto out_unlock0;
 		}
 
-		msg = find_msg(msq, &msgtyp, mode);
+		msg = find_msg(msq, msgtyp, mode);
 		if (!IS_ERR(msg)) {
 			/*
 			 * Found a suitable message.
@@ -1160,7 +1300,7 @@ static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, in
 				goto out_unlock0;
 			}
 
-			list_del(&msg->m_list);
+			msg_dequeue(msq, msg);
 			msq->q_qnum--;
 			msq->q_rtime = ktime_get_real_seconds();
 			ipc_update_pid(&msq->q_lrpid, task_tgid(current));
@@ -1178,7 +1318,6 @@ static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, in
 			goto out_unlock0;
 		}
 
-		list_add_tail(&msr_d.r_list, &msq->q_receivers);
 		msr_d.r_tsk = current;
 		msr_d.r_msgtype = msgtyp;
 		msr_d.r_mode = mode;
@@ -1186,6 +1325,7 @@ static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, in
 			msr_d.r_maxsize = INT_MAX;
 		else
 			msr_d.r_maxsize = bufsz;
+		msr_add(msq, &msr_d);
 
 		/* memory barrier not require due to ipc_lock_object() */
 		WRITE_ONCE(msr_d.r_msg, ERR_PTR(-EAGAIN));
@@ -1236,7 +1376,7 @@ static long do_msgrcv(int msqid, void __user *buf, size_t bufsz, long msgtyp, in
 		if (msg != ERR_PTR(-EAGAIN))
 			goto out_unlock0;
 
-		list_del(&msr_d.r_list);
+		msr_del(msq, &msr_d);
 		if (signal_pending(current)) {
 			msg = ERR_PTR(-ERESTARTNOHAND);
 			goto out_unlock0;
@@ -10,6 +10,35 @@
 static DEFINE_SPINLOCK(cgroup_rstat_lock);
 static DEFINE_PER_CPU(raw_spinlock_t, cgroup_rstat_cpu_lock);
 
+/*
+ * The subtree currently being flushed under cgroup_rstat_lock, if any.
+ * Flushes and reads of that subtree or of its descendants sleep until the
+ * ongoing flush is done instead of spinning on cgroup_rstat_lock only to
+ * find nothing left to do.  cgroup_rstat_flush_seq is odd while a flush
+ * is owned so that waiters can tell when the flush they saw is over.
+ *
+ * There is one owner, not one per subtree: flushing a cgroup propagates its
+ * deltas into its parent, in the base stats, bpf_rstat_flush() and the
+ * ->css_rstat_flush() callbacks alike, so flushes of disjoint subtrees still
+ * write to their common ancestors and rely on cgroup_rstat_lock for that.
+ */
+static struct cgroup *cgroup_rstat_ongoing;
+static unsigned long cgroup_rstat_flush_seq;
+static DECLARE_WAIT_QUEUE_HEAD(cgroup_rstat_flush_waitq);
+
+/*
+ * Ratelimited flushes are served from stats at most this old.  While there
+ * are ratelimited readers, the default hierarchy is flushed asynchronously
+ * twice as often so that they rarely have to flush themselves.
+ */
+#define CGROUP_RSTAT_MAX_STALENESS	(4UL * HZ)
+#define CGROUP_RSTAT_ASYNC_PERIOD	(CGROUP_RSTAT_MAX_STALENESS / 2)
+
+static bool cgroup_rstat_async_wanted;
+static void cgroup_rstat_async_workfn(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(cgroup_rstat_async_work,
+			       cgroup_rstat_async_workfn);
+
 static void cgroup_base_stat_flush(struct cgroup *cgrp, int cpu);
 
 static struct cgroup_rstat_cpu *cgroup_rstat_cpu(struct cgroup *cgrp, int cpu)
@@ -218,6 +247,77 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
 	}
 }
 
+/*
+ * Flush @cgrp's subtree and advertise it as the ongoing flush while doing
+ * so.  If the lock was dropped by an owner rescheduling halfway through its
+ * flush, the ownership stays with that owner.
+ */
+static void cgroup_rstat_flush_owned(struct cgroup *cgrp, bool may_sleep)
+{
+	unsigned long start = jiffies;
+	bool owner = !cgroup_rstat_ongoing;
+
+	lockdep_assert_held(&cgroup_rstat_lock);
+
+	if (owner) {
+		WRITE_ONCE(cgroup_rstat_ongoing, cgrp);
+		/* pairs with smp_rmb() in cgroup_rstat_ongoing_seq() */
+		smp_wmb();
+		WRITE_ONCE(cgroup_rstat_flush_seq, cgroup_rstat_flush_seq + 1);
+	}
+
+	cgroup_rstat_flush_locked(cgrp, may_sleep);
+	WRITE_ONCE(cgrp->rstat_flush_time, start);
+
+	if (owner) {
+		WRITE_ONCE(cgroup_rstat_flush_seq, cgroup_rstat_flush_seq + 1);
+		WRITE_ONCE(cgroup_rstat_ongoing, NULL);
+		if (wq_has_sleeper(&cgroup_rstat_flush_waitq))
+			wake_up_all(&cgroup_rstat_flush_waitq);
+	}
+}
+
+/*
+ * Return the flush sequence of the ongoing flush if it covers @cgrp's
+ * subtree, 0 otherwise.
+ */
+static unsigned long cgroup_rstat_ongoing_seq(struct cgroup *cgrp)
+{
+	struct cgroup *ongoing;
+	unsigned long seq;
+
+	seq = READ_ONCE(cgroup_rstat_flush_seq);
+	if (!(seq & 1))
+		return 0;
+	smp_rmb();
+
+	/* cgroups are RCU freed, @ongoing may be released under us */
+	rcu_read_lock();
+	ongoing = READ_ONCE(cgroup_rstat_ongoing);
+	if (!ongoing || !cgroup_is_descendant(cgrp, ongoing))
+		seq = 0;
+	rcu_read_unlock();
+
+	return seq;
+}
+
+/*
+ * Wait for the ongoing flush if it covers @cgrp's subtree.  Returns %true
+ * if there was one, in which case @cgrp's subtree is as up to date as that
+ * flush made it; updates racing with it may still be pending.
+ */
+static bool cgroup_rstat_wait_ongoing(struct cgroup *cgrp)
+{
+	unsigned long seq = cgroup_rstat_ongoing_seq(cgrp);
+
+	if (!seq)
+		return false;
+
+	wait_event(cgroup_rstat_flush_waitq,
+		   READ_ONCE(cgroup_rstat_flush_seq) != seq);
+	return true;
+}
+
 /**
  * cgroup_rstat_flush - flush stats in @cgrp's subtree
  * @cgrp: target cgroup
@@ -229,14 +329,19 @@ static void cgroup_rstat_flush_locked(struct cgroup *cgrp, bool may_sleep)
  * This also gets all cgroups in the subtree including @cgrp off the
  * ->updated_children lists.
  *
+ * If a flush covering @cgrp's subtree is in progress, it is waited for
+ * first, which leaves only the updates racing with it to be flushed here.
+ *
  * This function may block.
  */
 __bpf_kfunc void cgroup_rstat_flush(struct cgroup *cgrp)
 {
 	might_sleep();
 
+	cgroup_rstat_wait_ongoing(cgrp);
+
 	spin_lock_irq(&cgroup_rstat_lock);
-	cgroup_rstat_flush_locked(cgrp, true);
+	cgroup_rstat_flush_owned(cgrp, true);
 	spin_unlock_irq(&cgroup_rstat_lock);
 }
 
@@ -251,16 +356,71 @@ void cgroup_rstat_flush_irqsafe(struct cgroup *cgrp)
 	unsigned long flags;
 
 	spin_lock_irqsave(&cgroup_rstat_lock, flags);
-	cgroup_rstat_flush_locked(cgrp, false);
+	cgroup_rstat_flush_owned(cgrp, false);
 	spin_unlock_irqrestore(&cgroup_rstat_lock, flags);
 }
 
+/*
+ * Is @cgrp's subtree covered by a flush, of itself or of an ancestor, that
+ * started less than CGROUP_RSTAT_MAX_STALENESS ago?
+ */
+static bool cgroup_rstat_fresh(struct cgroup *cgrp)
+{
+	for (; cgrp; cgrp = cgroup_parent(cgrp)) {
+		if (time_before(jiffies, READ_ONCE(cgrp->rstat_flush_time) +
+				CGROUP_RSTAT_MAX_STALENESS))
+			return true;
+	}
+	return false;
+}
+
+static void cgroup_rstat_async_workfn(struct work_struct *work)
+{
+	cgroup_rstat_flush(&cgrp_dfl_root.cgrp);
+
+	/* keep going only while there are ratelimited readers */
+	if (xchg(&cgroup_rstat_async_wanted, false))
+		queue_delayed_work(system_unbound_wq, &cgroup_rstat_async_work,
+				   CGROUP_RSTAT_ASYNC_PERIOD);
+}
+
+/**
+ * cgroup_rstat_flush_ratelimited - flush stats in @cgrp's subtree if stale
+ * @cgrp: target cgroup
+ *
+ * Like cgroup_rstat_flush() but for readers which can live with stats that
+ * are up to CGROUP_RSTAT_MAX_STALENESS old.  While such readers are around,
+ * the default hierarchy is flushed asynchronously so that they usually
+ * don't need to flush or touch cgroup_rstat_lock at all.  Readers have to
+ * opt into this, the cgroup interface files keep flushing synchronously.
+ *
+ * This function may block.
+ */
+__bpf_kfunc void cgroup_rstat_flush_ratelimited(struct cgroup *cgrp)
+{
+	might_sleep();
+
+	if (!READ_ONCE(cgroup_rstat_async_wanted))
+		WRITE_ONCE(cgroup_rstat_async_wanted, true);
+	if (!delayed_work_pending(&cgroup_rstat_async_work))
+		queue_delayed_work(system_unbound_wq, &cgroup_rstat_async_work,
+				   CGROUP_RSTAT_ASYNC_PERIOD);
+
+	if (cgroup_rstat_fresh(cgrp) || cgroup_rstat_wait_ongoing(cgrp))
+		return;
+
+	spin_lock_irq(&cgroup_rstat_lock);
+	cgroup_rstat_flush_owned(cgrp, true);
+	spin_unlock_irq(&cgroup_rstat_lock);
+}
+
 /**
  * cgroup_rstat_flush_hold - flush stats in @cgrp's subtree and hold
  * @cgrp: target cgroup
  *
  * Flush stats in @cgrp's subtree and prevent further flushes.  Must be
- * paired with cgroup_rstat_flush_release().
+ * paired with cgroup_rstat_flush_release().  Like cgroup_rstat_flush(), a
+ * flush covering @cgrp's subtree which is in progress is waited for first.
  *
  * This function may block.
  */
@@ -268,8 +428,11 @@ void cgroup_rstat_flush_hold(struct cgroup *cgrp)
 	__acquires(&cgroup_rstat_lock)
 {
 	might_sleep();
+
+	cgroup_rstat_wait_ongoing(cgrp);
+
 	spin_lock_irq(&cgroup_rstat_lock);
-	cgroup_rstat_flush_locked(cgrp, true);
+	cgroup_rstat_flush_owned(cgrp, true);
 }
 
 /**
@@ -292,6 +455,9 @@ int cgroup_rstat_init(struct cgroup *cgrp)
 			return -ENOMEM;
 	}
 
+	/* not flushed yet, see cgroup_rstat_fresh() */
+	cgrp->rstat_flush_time = jiffies - CGROUP_RSTAT_MAX_STALENESS;
+
 	/* ->updated_children list is self terminated */
 	for_each_possible_cpu(cpu) {
 		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
@@ -536,6 +702,7 @@ void cgroup_base_stat_cputime_show(struct seq_file *seq)
 BTF_SET8_START(bpf_rstat_kfunc_ids)
 BTF_ID_FLAGS(func, cgroup_rstat_updated)
 BTF_ID_FLAGS(func, cgroup_rstat_flush, KF_SLEEPABLE)
+BTF_ID_FLAGS(func, cgroup_rstat_flush_ratelimited, KF_SLEEPABLE)
 BTF_SET8_END(bpf_rstat_kfunc_ids)
 
 static const struct btf_kfunc_id_set bpf_rstat_kfunc_set = {
@@ -96,6 +96,92 @@ static int map_benchmark_thread(void *data)
 	return ret;
 }
 
+/*
+ * Map a burst of buffers before unmapping any of them, so that the threads
+ * together keep threads * burst mappings alive.  With bounce buffering this
+ * puts the swiotlb under pressure.
+ */
+static int map_benchmark_burst_thread(void *data)
+{
+	struct map_benchmark_data *map = data;
+	int burst = map->bparam.burst;
+	u64 size = map->bparam.granule * PAGE_SIZE;
+	dma_addr_t *dma_addrs;
+	void **bufs;
+	int ret = 0;
+	int i, n;
+
+	bufs = kcalloc(burst, sizeof(*bufs), GFP_KERNEL);
+	dma_addrs = kcalloc(burst, sizeof(*dma_addrs), GFP_KERNEL);
+	if (!bufs || !dma_addrs) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < burst; i++) {
+		bufs[i] = alloc_pages_exact(size, GFP_KERNEL);
+		if (!bufs[i]) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		/* see map_benchmark_thread() */
+		if (map->dir != DMA_FROM_DEVICE)
+			memset(bufs[i], 0x66, size);
+	}
+
+	while (!kthread_should_stop())  {
+		u64 map_100ns = 0, unmap_100ns = 0, map_sq = 0, unmap_sq = 0;
+		ktime_t stime;
+		u64 delta;
+
+		for (n = 0; n < burst; n++) {
+			stime = ktime_get();
+			dma_addrs[n] = dma_map_single(map->dev, bufs[n], size,
+						      map->dir);
+			if (unlikely(dma_mapping_error(map->dev, dma_addrs[n]))) {
+				pr_err("dma_map_single failed on %s after %d mappings\n",
+				       dev_name(map->dev), n);
+				ret = -ENOMEM;
+				break;
+			}
+			delta = div64_ul(ktime_sub(ktime_get(), stime), 100);
+			map_100ns += delta;
+			map_sq += delta * delta;
+		}
+
+		/* Pretend DMA is transmitting */
+		if (n == burst)
+			ndelay(map->bparam.dma_trans_ns);
+
+		for (i = 0; i < n; i++) {
+			stime = ktime_get();
+			dma_unmap_single(map->dev, dma_addrs[i], size, map->dir);
+			delta = div64_ul(ktime_sub(ktime_get(), stime), 100);
+			unmap_100ns += delta;
+			unmap_sq += delta * delta;
+		}
+
+		if (ret)
+			break;
+
+		atomic64_add(map_100ns, &map->sum_map_100ns);
+		atomic64_add(unmap_100ns, &map->sum_unmap_100ns);
+		atomic64_add(map_sq, &map->sum_sq_map);
+		atomic64_add(unmap_sq, &map->sum_sq_unmap);
+		atomic64_add(burst, &map->loops);
+	}
+
+out:
+	if (bufs) {
+		for (i = 0; i < burst; i++)
+			if (bufs[i])
+				free_pages_exact(bufs[i], size);
+	}
+	kfree(dma_addrs);
+	kfree(bufs);
+	return ret;
+}
+
 static int do_map_benchmark(struct map_benchmark_data *map)
 {
 	struct task_struct **tsk;
@@ -113,8 +199,9 @@ static int do_map_benchmark(struct map_benchmark_data *map)
 	get_device(map->dev);
 
 	for (i = 0; i < threads; i++) {
-		tsk[i] = kthread_create_on_node(map_benchmark_thread, map,
-				map->bparam.node, "dma-map-benchmark/%d", i);
+		tsk[i] = kthread_create_on_node(map->bparam.burst > 1 ?
+				map_benchmark_burst_thread : map_benchmark_thread,
+				map, map->bparam.node, "dma-map-benchmark/%d", i);
 		if (IS_ERR(tsk[i])) {
 			pr_err("create dma_map thread failed\n");
 			ret = PTR_ERR(tsk[i]);
@@ -218,6 +305,11 @@ static long map_benchmark_ioctl(struct file *file, unsigned int cmd,
 			return -EINVAL;
 		}
 
+		if (map->bparam.burst > DMA_MAP_MAX_BURST) {
+			pr_err("invalid burst size\n");
+			return -EINVAL;
+		}
+
 		switch (map->bparam.dma_dir) {
 		case DMA_MAP_BIDIRECTIONAL:
 			map->dir = DMA_BIDIRECTIONAL;
@@ -35,6 +35,7 @@
 #include <linux/memblock.h>
 #include <linux/mm.h>
 #include <linux/pfn.h>
+#include <linux/rculist.h>
 #include <linux/scatterlist.h>
 #include <linux/set_memory.h>
 #include <linux/spinlock.h>
@@ -45,6 +46,8 @@
 #include <linux/of.h>
 #include <linux/of_fdt.h>
 #include <linux/of_reserved_mem.h>
+#endif
+#if defined(CONFIG_DMA_RESTRICTED_POOL) || defined(CONFIG_SWIOTLB_DYNAMIC)
 #include <linux/slab.h>
 #endif
 
@@ -62,6 +65,13 @@
 
 #define INVALID_PHYS_ADDR (~(phys_addr_t)0)
 
+/*
+ * Largest pool allocated at run time, and how long such a pool has to stay
+ * unused before it is given back.
+ */
+#define IO_TLB_DYN_MAX_SLABS	(SLABS_PER_PAGE << (MAX_ORDER - 1))
+#define IO_TLB_DYN_IDLE		(30 * HZ)
+
 struct io_tlb_slot {
 	phys_addr_t orig_addr;
 	size_t alloc_size;
@@ -267,6 +277,9 @@ static void swiotlb_init_io_tlb_mem(struct io_tlb_mem *mem, phys_addr_t start,
 	mem->area_nslabs = nslabs / mem->nareas;
 
 	mem->force_bounce = swiotlb_force_bounce || (flags & SWIOTLB_FORCE);
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	INIT_LIST_HEAD(&mem->pools);
+#endif
 
 	for (i = 0; i < mem->nareas; i++) {
 		spin_lock_init(&mem->areas[i].lock);
@@ -275,7 +288,8 @@ static void swiotlb_init_io_tlb_mem(struct io_tlb_mem *mem, phys_addr_t start,
 	}
 
 	for (i = 0; i < mem->nslabs; i++) {
-		mem->slots[i].list = IO_TLB_SEGSIZE - io_tlb_offset(i);
+		mem->slots[i].list = min(IO_TLB_SEGSIZE - io_tlb_offset(i),
+					 nslabs - i);
 		mem->slots[i].orig_addr = INVALID_PHYS_ADDR;
 		mem->slots[i].alloc_size = 0;
 	}
@@ -292,6 +306,253 @@ static void swiotlb_init_io_tlb_mem(struct io_tlb_mem *mem, phys_addr_t start,
 	return;
 }
 
+static unsigned long mem_used(struct io_tlb_mem *mem)
+{
+	int i;
+	unsigned long used = 0;
+
+	for (i = 0; i < mem->nareas; i++)
+		used += mem->areas[i].used;
+	return used;
+}
+
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+
+static gfp_t swiotlb_gfp_zone(phys_addr_t phys_limit)
+{
+	if (IS_ENABLED(CONFIG_ZONE_DMA) &&
+	    phys_limit <= DMA_BIT_MASK(zone_dma_bits))
+		return GFP_DMA;
+	if (IS_ENABLED(CONFIG_ZONE_DMA32) && phys_limit <= DMA_BIT_MASK(32))
+		return GFP_DMA32;
+	return 0;
+}
+
+/* As many areas as the boot time pool, as long as each gets a segment. */
+static unsigned int swiotlb_pool_nareas(unsigned long nslabs)
+{
+	unsigned int nareas = default_nareas ?: 1;
+
+	while (nareas > 1 && nslabs < nareas * IO_TLB_SEGSIZE)
+		nareas >>= 1;
+	return nareas;
+}
+
+/*
+ * Allocate a pool of at least @nslabs slots below @phys_limit.  Pools
+ * allocated without being able to block are transient: memory encryption
+ * is not supported for those, as set_memory_decrypted() may sleep.
+ */
+static struct io_tlb_mem *swiotlb_alloc_pool(unsigned long nslabs,
+		unsigned int nareas, phys_addr_t phys_limit, gfp_t gfp)
+{
+	unsigned int order = get_order(nslabs << IO_TLB_SHIFT);
+	struct io_tlb_mem *pool;
+	struct page *page;
+
+	if (order >= MAX_ORDER)
+		return NULL;
+	nslabs = SLABS_PER_PAGE << order;
+
+	pool = kzalloc(sizeof(*pool), gfp);
+	if (!pool)
+		return NULL;
+	pool->areas = kcalloc(nareas, sizeof(*pool->areas), gfp);
+	if (!pool->areas)
+		goto error_areas;
+	pool->slots = kcalloc(nslabs, sizeof(*pool->slots), gfp);
+	if (!pool->slots)
+		goto error_slots;
+
+	page = alloc_pages(gfp | swiotlb_gfp_zone(phys_limit) | __GFP_NOWARN,
+			   order);
+	if (!page)
+		goto error_page;
+	if (page_to_phys(page) + (PAGE_SIZE << order) - 1 > phys_limit) {
+		__free_pages(page, order);
+		goto error_page;
+	}
+
+	if (gfpflags_allow_blocking(gfp))
+		set_memory_decrypted((unsigned long)page_address(page),
+				     1 << order);
+	else
+		pool->transient = true;
+
+	swiotlb_init_io_tlb_mem(pool, page_to_phys(page), nslabs, 0, true,
+				nareas);
+	pool->last_used = jiffies;
+	return pool;
+
+error_page:
+	kfree(pool->slots);
+error_slots:
+	kfree(pool->areas);
+error_areas:
+	kfree(pool);
+	return NULL;
+}
+
+static void swiotlb_free_pool(struct io_tlb_mem *pool)
+{
+	unsigned int order = get_order(pool->end - pool->start);
+
+	if (!pool->transient)
+		set_memory_encrypted((unsigned long)pool->vaddr, 1 << order);
+	__free_pages(pfn_to_page(PFN_DOWN(pool->start)), order);
+	kfree(pool->slots);
+	kfree(pool->areas);
+	kfree(pool);
+}
+
+static void swiotlb_free_pool_rcu(struct rcu_head *rcu)
+{
+	swiotlb_free_pool(container_of(rcu, struct io_tlb_mem, rcu));
+}
+
+static void swiotlb_add_pool(struct io_tlb_mem *mem, struct io_tlb_mem *pool)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&mem->lock, flags);
+	list_add_rcu(&pool->node, &mem->pools);
+	if (pool->transient) {
+		mem->transient_nslabs += pool->nslabs;
+	} else {
+		mem->nr_pools++;
+		mem->dyn_nslabs += pool->nslabs;
+	}
+	spin_unlock_irqrestore(&mem->lock, flags);
+
+	if (!pool->transient)
+		schedule_delayed_work(&mem->dyn_free, IO_TLB_DYN_IDLE);
+}
+
+/* Caller ensures that no slot of @pool is in use and nobody can grab one. */
+static void swiotlb_del_pool(struct io_tlb_mem *mem, struct io_tlb_mem *pool)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&mem->lock, flags);
+	list_del_rcu(&pool->node);
+	if (pool->transient) {
+		mem->transient_nslabs -= pool->nslabs;
+	} else {
+		mem->nr_pools--;
+		mem->dyn_nslabs -= pool->nslabs;
+	}
+	spin_unlock_irqrestore(&mem->lock, flags);
+}
+
+/*
+ * Add a pool when more than half of the slots are in use.  A failing lookup
+ * may also be due to alignment or segment boundary constraints, which a new
+ * pool of the same kind would not help with.
+ */
+static void swiotlb_dyn_alloc(struct work_struct *work)
+{
+	struct io_tlb_mem *mem =
+		container_of(work, struct io_tlb_mem, dyn_alloc);
+	unsigned long nslabs = min_t(unsigned long, default_nslabs,
+				     IO_TLB_DYN_MAX_SLABS);
+	unsigned long used = mem_used(mem), total = mem->nslabs;
+	struct io_tlb_mem *pool;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node) {
+		if (pool->transient)
+			continue;
+		used += mem_used(pool);
+		total += pool->nslabs;
+	}
+	rcu_read_unlock();
+	if (used < total / 2)
+		return;
+
+	while (!(pool = swiotlb_alloc_pool(nslabs, swiotlb_pool_nareas(nslabs),
+					   mem->phys_limit, GFP_KERNEL))) {
+		if (nslabs <= IO_TLB_MIN_SLABS) {
+			pr_warn_ratelimited("failed to allocate a new pool\n");
+			return;
+		}
+		nslabs >>= 1;
+	}
+
+	swiotlb_add_pool(mem, pool);
+}
+
+static struct io_tlb_mem *swiotlb_idle_pool(struct io_tlb_mem *mem)
+{
+	struct io_tlb_mem *pool;
+
+	list_for_each_entry(pool, &mem->pools, node) {
+		if (pool->transient || mem_used(pool) ||
+		    time_before(jiffies, READ_ONCE(pool->last_used) +
+					 IO_TLB_DYN_IDLE))
+			continue;
+		return pool;
+	}
+	return NULL;
+}
+
+/*
+ * Release pools that stayed unused for IO_TLB_DYN_IDLE.  A pool is first
+ * marked as retiring so that swiotlb_find_slots() skips it; once all the
+ * lookups that may have missed the mark are over, the pool goes away if it
+ * is still unused.
+ */
+static void swiotlb_dyn_free(struct work_struct *work)
+{
+	struct io_tlb_mem *mem =
+		container_of(to_delayed_work(work), struct io_tlb_mem, dyn_free);
+	struct io_tlb_mem *pool;
+	unsigned long flags;
+
+	for (;;) {
+		spin_lock_irqsave(&mem->lock, flags);
+		pool = swiotlb_idle_pool(mem);
+		if (pool)
+			WRITE_ONCE(pool->retiring, true);
+		spin_unlock_irqrestore(&mem->lock, flags);
+		if (!pool)
+			break;
+
+		synchronize_rcu();
+
+		if (mem_used(pool)) {
+			WRITE_ONCE(pool->last_used, jiffies);
+			WRITE_ONCE(pool->retiring, false);
+			continue;
+		}
+
+		swiotlb_del_pool(mem, pool);
+		synchronize_rcu();
+		swiotlb_free_pool(pool);
+	}
+
+	if (READ_ONCE(mem->nr_pools))
+		schedule_delayed_work(&mem->dyn_free, IO_TLB_DYN_IDLE);
+}
+
+static void swiotlb_init_dyn(struct io_tlb_mem *mem, phys_addr_t phys_limit)
+{
+	spin_lock_init(&mem->lock);
+	INIT_WORK(&mem->dyn_alloc, swiotlb_dyn_alloc);
+	INIT_DELAYED_WORK(&mem->dyn_free, swiotlb_dyn_free);
+	mem->phys_limit = phys_limit;
+	/* remapped pools are not supported */
+	mem->can_grow = !swiotlb_unencrypted_base;
+}
+
+#else /* !CONFIG_SWIOTLB_DYNAMIC */
+
+static inline void swiotlb_init_dyn(struct io_tlb_mem *mem,
+				    phys_addr_t phys_limit)
+{
+}
+
+#endif /* CONFIG_SWIOTLB_DYNAMIC */
+
 static void __init *swiotlb_memblock_alloc(unsigned long nslabs,
 		unsigned int flags,
 		int (*remap)(void *tlb, unsigned long nslabs))
@@ -378,6 +639,8 @@ void __init swiotlb_init_remap(bool addressing_limit, unsigned int flags,
 
 	swiotlb_init_io_tlb_mem(mem, __pa(tlb), nslabs, flags, false,
 				default_nareas);
+	swiotlb_init_dyn(mem, flags & SWIOTLB_ANY ?
+			 virt_to_phys(high_memory - 1) : ARCH_LOW_ADDRESS_LIMIT);
 
 	if (flags & SWIOTLB_VERBOSE)
 		swiotlb_print_info();
@@ -459,6 +722,12 @@ int swiotlb_init_late(size_t size, gfp_t gfp_mask,
 			     (nslabs << IO_TLB_SHIFT) >> PAGE_SHIFT);
 	swiotlb_init_io_tlb_mem(mem, virt_to_phys(vstart), nslabs, 0, true,
 				default_nareas);
+	if (gfp_mask & __GFP_DMA)
+		swiotlb_init_dyn(mem, DMA_BIT_MASK(zone_dma_bits));
+	else if (gfp_mask & __GFP_DMA32)
+		swiotlb_init_dyn(mem, DMA_BIT_MASK(32));
+	else
+		swiotlb_init_dyn(mem, virt_to_phys(high_memory - 1));
 
 	swiotlb_print_info();
 	return 0;
@@ -519,7 +788,7 @@ static unsigned int swiotlb_align_offset(struct device *dev, u64 addr)
 static void swiotlb_bounce(struct device *dev, phys_addr_t tlb_addr, size_t size,
 			   enum dma_data_direction dir)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *mem = swiotlb_find_pool(dev, tlb_addr);
 	int index = (tlb_addr - mem->start) >> IO_TLB_SHIFT;
 	phys_addr_t orig_addr = mem->slots[index].orig_addr;
 	size_t alloc_size = mem->slots[index].alloc_size;
@@ -612,11 +881,10 @@ static unsigned int wrap_area_index(struct io_tlb_mem *mem, unsigned int index)
  * Find a suitable number of IO TLB entries size that will fit this request and
  * allocate a buffer from that IO TLB pool.
  */
-static int swiotlb_do_find_slots(struct device *dev, int area_index,
-		phys_addr_t orig_addr, size_t alloc_size,
+static int swiotlb_do_find_slots(struct device *dev, struct io_tlb_mem *mem,
+		int area_index, phys_addr_t orig_addr, size_t alloc_size,
 		unsigned int alloc_align_mask)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 	struct io_tlb_area *area = mem->areas + area_index;
 	unsigned long boundary_mask = dma_get_seg_boundary(dev);
 	dma_addr_t tbl_dma_addr =
@@ -705,33 +973,220 @@ static int swiotlb_do_find_slots(struct device *dev, int area_index,
 	return slot_index;
 }
 
-static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
-		size_t alloc_size, unsigned int alloc_align_mask)
+static int swiotlb_pool_find_slots(struct device *dev, struct io_tlb_mem *pool,
+		phys_addr_t orig_addr, size_t alloc_size,
+		unsigned int alloc_align_mask)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
-	int start = raw_smp_processor_id() & (mem->nareas - 1);
+	int start = raw_smp_processor_id() & (pool->nareas - 1);
 	int i = start, index;
 
 	do {
-		index = swiotlb_do_find_slots(dev, i, orig_addr, alloc_size,
-					      alloc_align_mask);
+		index = swiotlb_do_find_slots(dev, pool, i, orig_addr,
+					      alloc_size, alloc_align_mask);
 		if (index >= 0)
 			return index;
-		if (++i >= mem->nareas)
+		if (++i >= pool->nareas)
 			i = 0;
 	} while (i != start);
 
 	return -1;
 }
 
-static unsigned long mem_used(struct io_tlb_mem *mem)
+#ifdef CONFIG_DEBUG_FS
+
+static void inc_used_and_hiwater(struct io_tlb_mem *mem, unsigned int nslots)
 {
-	int i;
-	unsigned long used = 0;
+	unsigned long old_hiwater, new_used;
 
-	for (i = 0; i < mem->nareas; i++)
-		used += mem->areas[i].used;
-	return used;
+	new_used = atomic_long_add_return(nslots, &mem->total_used);
+	old_hiwater = atomic_long_read(&mem->used_hiwater);
+	do {
+		if (new_used <= old_hiwater)
+			break;
+	} while (!atomic_long_try_cmpxchg(&mem->used_hiwater,
+					  &old_hiwater, new_used));
+}
+
+static void dec_used(struct io_tlb_mem *mem, unsigned int nslots)
+{
+	atomic_long_sub(nslots, &mem->total_used);
+}
+
+#else /* !CONFIG_DEBUG_FS */
+
+static void inc_used_and_hiwater(struct io_tlb_mem *mem, unsigned int nslots)
+{
+}
+
+static void dec_used(struct io_tlb_mem *mem, unsigned int nslots)
+{
+}
+
+#endif /* CONFIG_DEBUG_FS */
+
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+
+/*
+ * Allocate a pool for a single mapping of @alloc_size bytes, with enough
+ * slack to satisfy the device's minimum alignment.  Used when all the
+ * pools are full, until swiotlb_dyn_alloc() has added a new one.
+ */
+static struct io_tlb_mem *swiotlb_alloc_transient(struct device *dev,
+		size_t alloc_size)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	unsigned int align_mask = dma_get_min_align_mask(dev) & ~(IO_TLB_SIZE - 1);
+	unsigned long nslabs = nr_slots(alloc_size) + (align_mask >> IO_TLB_SHIFT);
+	phys_addr_t phys_limit = mem->phys_limit;
+	struct io_tlb_mem *pool;
+
+	if (cc_platform_has(CC_ATTR_MEM_ENCRYPT))
+		return NULL;
+
+	if (dev->dma_mask)
+		phys_limit = min_not_zero(phys_limit, (phys_addr_t)*dev->dma_mask);
+	phys_limit = min_not_zero(phys_limit, (phys_addr_t)dev->bus_dma_limit);
+
+	pool = swiotlb_alloc_pool(nslabs, 1, phys_limit, GFP_NOWAIT);
+	if (pool)
+		swiotlb_add_pool(mem, pool);
+	return pool;
+}
+
+static int swiotlb_dyn_find_slots(struct device *dev, phys_addr_t orig_addr,
+		size_t alloc_size, unsigned int alloc_align_mask,
+		struct io_tlb_mem **retpool)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *pool;
+	int index;
+
+	if (!mem->can_grow)
+		return -1;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node) {
+		if (pool->transient || READ_ONCE(pool->retiring))
+			continue;
+		index = swiotlb_pool_find_slots(dev, pool, orig_addr,
+						alloc_size, alloc_align_mask);
+		if (index >= 0) {
+			rcu_read_unlock();
+			*retpool = pool;
+			return index;
+		}
+	}
+	rcu_read_unlock();
+
+	schedule_work(&mem->dyn_alloc);
+
+	pool = swiotlb_alloc_transient(dev, alloc_size);
+	if (!pool)
+		return -1;
+
+	index = swiotlb_pool_find_slots(dev, pool, orig_addr, alloc_size,
+					alloc_align_mask);
+	if (index < 0) {
+		swiotlb_del_pool(mem, pool);
+		call_rcu(&pool->rcu, swiotlb_free_pool_rcu);
+		return -1;
+	}
+
+	*retpool = pool;
+	return index;
+}
+
+/* A transient pool goes away with its only mapping. */
+static bool swiotlb_release_transient(struct io_tlb_mem *mem,
+				      struct io_tlb_mem *pool)
+{
+	if (!pool->transient)
+		return false;
+
+	swiotlb_del_pool(mem, pool);
+	call_rcu(&pool->rcu, swiotlb_free_pool_rcu);
+	return true;
+}
+
+static void swiotlb_pool_released(struct io_tlb_mem *mem,
+				  struct io_tlb_mem *pool)
+{
+	if (pool != mem)
+		WRITE_ONCE(pool->last_used, jiffies);
+}
+
+struct io_tlb_mem *swiotlb_find_pool(struct device *dev, phys_addr_t paddr)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *pool;
+
+	if (paddr >= mem->start && paddr < mem->end)
+		return mem;
+	if (!mem->can_grow)
+		return NULL;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node) {
+		if (paddr >= pool->start && paddr < pool->end)
+			goto out;
+	}
+	pool = NULL;
+out:
+	rcu_read_unlock();
+	return pool;
+}
+
+#else /* !CONFIG_SWIOTLB_DYNAMIC */
+
+static int swiotlb_dyn_find_slots(struct device *dev, phys_addr_t orig_addr,
+		size_t alloc_size, unsigned int alloc_align_mask,
+		struct io_tlb_mem **retpool)
+{
+	return -1;
+}
+
+static bool swiotlb_release_transient(struct io_tlb_mem *mem,
+				      struct io_tlb_mem *pool)
+{
+	return false;
+}
+
+static void swiotlb_pool_released(struct io_tlb_mem *mem,
+				  struct io_tlb_mem *pool)
+{
+}
+
+struct io_tlb_mem *swiotlb_find_pool(struct device *dev, phys_addr_t paddr)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+
+	if (paddr >= mem->start && paddr < mem->end)
+		return mem;
+	return NULL;
+}
+
+#endif /* CONFIG_SWIOTLB_DYNAMIC */
+
+/*
+ * Find slots for a mapping in the pool of @dev, then in the pools added to
+ * it at run time.  Returns the slot index and stores the pool in @retpool.
+ */
+static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
+		size_t alloc_size, unsigned int alloc_align_mask,
+		struct io_tlb_mem **retpool)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	int index;
+
+	*retpool = mem;
+	index = swiotlb_pool_find_slots(dev, mem, orig_addr, alloc_size,
+					alloc_align_mask);
+	if (index < 0)
+		index = swiotlb_dyn_find_slots(dev, orig_addr, alloc_size,
+					       alloc_align_mask, retpool);
+	if (index >= 0)
+		inc_used_and_hiwater(mem, nr_slots(alloc_size));
+	return index;
 }
 
 phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
@@ -741,6 +1196,7 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 	unsigned int offset = swiotlb_align_offset(dev, orig_addr);
+	struct io_tlb_mem *pool;
 	unsigned int i;
 	int index;
 	phys_addr_t tlb_addr;
@@ -761,7 +1217,7 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 	}
 
 	index = swiotlb_find_slots(dev, orig_addr,
-				   alloc_size + offset, alloc_align_mask);
+				   alloc_size + offset, alloc_align_mask, &pool);
 	if (index == -1) {
 		if (!(attrs & DMA_ATTR_NO_WARN))
 			dev_warn_ratelimited(dev,
@@ -776,8 +1232,8 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 	 * needed.
 	 */
 	for (i = 0; i < nr_slots(alloc_size + offset); i++)
-		mem->slots[index + i].orig_addr = slot_addr(orig_addr, i);
-	tlb_addr = slot_addr(mem->start, index) + offset;
+		pool->slots[index + i].orig_addr = slot_addr(orig_addr, i);
+	tlb_addr = slot_addr(pool->start, index) + offset;
 	/*
 	 * When dir == DMA_FROM_DEVICE we could omit the copy from the orig
 	 * to the tlb buffer, if we knew for sure the device will
@@ -791,7 +1247,8 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 
 static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *root = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *mem = swiotlb_find_pool(dev, tlb_addr);
 	unsigned long flags;
 	unsigned int offset = swiotlb_align_offset(dev, tlb_addr);
 	int index = (tlb_addr - offset - mem->start) >> IO_TLB_SHIFT;
@@ -800,6 +1257,10 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr)
 	struct io_tlb_area *area = &mem->areas[aindex];
 	int count, i;
 
+	dec_used(root, nslots);
+	if (swiotlb_release_transient(root, mem))
+		return;
+
 	/*
 	 * Return the buffer to the free list by setting the corresponding
 	 * entries to indicate the number of contiguous entries available.
@@ -834,6 +1295,8 @@ static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr)
 		mem->slots[i].list = ++count;
 	area->used -= nslots;
 	spin_unlock_irqrestore(&area->lock, flags);
+
+	swiotlb_pool_released(root, mem);
 }
 
 /*
@@ -928,13 +1391,72 @@ bool is_swiotlb_active(struct device *dev)
 }
 EXPORT_SYMBOL_GPL(is_swiotlb_active);
 
+#ifdef CONFIG_DEBUG_FS
+
+static int io_tlb_nslabs_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data;
+
+	*val = mem->nslabs;
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	*val += READ_ONCE(mem->dyn_nslabs);
+#endif
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_nslabs, io_tlb_nslabs_get, NULL, "%llu\n");
+
 static int io_tlb_used_get(void *data, u64 *val)
 {
-	*val = mem_used(&io_tlb_default_mem);
+	struct io_tlb_mem *mem = data;
+
+	*val = atomic_long_read(&mem->total_used);
 	return 0;
 }
 DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_used, io_tlb_used_get, NULL, "%llu\n");
 
+static int io_tlb_hiwater_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data;
+
+	*val = atomic_long_read(&mem->used_hiwater);
+	return 0;
+}
+
+static int io_tlb_hiwater_set(void *data, u64 val)
+{
+	struct io_tlb_mem *mem = data;
+
+	/* Only allow setting to zero */
+	if (val != 0)
+		return -EINVAL;
+
+	atomic_long_set(&mem->used_hiwater, val);
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_hiwater, io_tlb_hiwater_get,
+			 io_tlb_hiwater_set, "%llu\n");
+
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+static int io_tlb_pools_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data;
+
+	*val = READ_ONCE(mem->nr_pools);
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_pools, io_tlb_pools_get, NULL, "%llu\n");
+
+static int io_tlb_transient_used_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data;
+
+	*val = READ_ONCE(mem->transient_nslabs);
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_transient_used, io_tlb_transient_used_get,
+			 NULL, "%llu\n");
+#endif /* CONFIG_SWIOTLB_DYNAMIC */
+
 static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 					 const char *dirname)
 {
@@ -942,11 +1464,32 @@ static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 	if (!mem->nslabs)
 		return;
 
-	debugfs_create_ulong("io_tlb_nslabs", 0400, mem->debugfs, &mem->nslabs);
-	debugfs_create_file("io_tlb_used", 0400, mem->debugfs, NULL,
+	debugfs_create_file("io_tlb_nslabs", 0400, mem->debugfs, mem,
+			&fops_io_tlb_nslabs);
+	debugfs_create_file("io_tlb_used", 0400, mem->debugfs, mem,
 			&fops_io_tlb_used);
+	debugfs_create_file("io_tlb_used_hiwater", 0600, mem->debugfs, mem,
+			&fops_io_tlb_hiwater);
+#ifdef CONFIG_SWIOTLB_DYNAMIC
+	if (!mem->can_grow)
+		return;
+
+	debugfs_create_file("io_tlb_pools", 0400, mem->debugfs, mem,
+			&fops_io_tlb_pools);
+	debugfs_create_file("io_tlb_transient_nslabs", 0400, mem->debugfs,
+			mem, &fops_io_tlb_transient_used);
+#endif
 }
 
+#else /* !CONFIG_DEBUG_FS */
+
+static inline void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
+						const char *dirname)
+{
+}
+
+#endif /* CONFIG_DEBUG_FS */
+
 static int __init __maybe_unused swiotlb_create_default_debugfs(void)
 {
 	swiotlb_create_debugfs_files(&io_tlb_default_mem, "swiotlb");
@@ -962,17 +1505,18 @@ late_initcall(swiotlb_create_default_debugfs);
 struct page *swiotlb_alloc(struct device *dev, size_t size)
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *pool;
 	phys_addr_t tlb_addr;
 	int index;
 
 	if (!mem)
 		return NULL;
 
-	index = swiotlb_find_slots(dev, 0, size, 0);
+	index = swiotlb_find_slots(dev, 0, size, 0, &pool);
 	if (index == -1)
 		return NULL;
 
-	tlb_addr = slot_addr(mem->start, index);
+	tlb_addr = slot_addr(pool->start, index);
 
 	return pfn_to_page(PFN_DOWN(tlb_addr));
 }
@@ -10,6 +10,7 @@
 
 #include <linux/perf_event.h>
 #include <linux/slab.h>
+#include <linux/srcu.h>
 #include <linux/sched/task_stack.h>
 
 #include "internal.h"
@@ -34,6 +35,10 @@ static atomic_t nr_callchain_events;
 static DEFINE_MUTEX(callchain_mutex);
 static struct callchain_cpus_entries *callchain_cpus_entries;
 
+static LIST_HEAD(user_unwinders);
+static DEFINE_MUTEX(user_unwinders_mutex);
+DEFINE_STATIC_SRCU(user_unwinders_srcu);
+
 
 __weak void perf_callchain_kernel(struct perf_callchain_entry_ctx *entry,
 				  struct pt_regs *regs)
@@ -225,6 +230,106 @@ get_perf_callchain(struct pt_regs *regs, u32 init_nr, bool kernel, bool user,
 	return entry;
 }
 
+/*
+ * Like get_perf_callchain(), but rather than walking the user stack, end the
+ * callchain with a PERF_CONTEXT_USER_DEFERRED marker and @cookie; the user
+ * part is emitted later in a PERF_RECORD_CALLCHAIN_DEFERRED record carrying
+ * the same cookie, see perf_callchain_user_deferred().
+ */
+struct perf_callchain_entry *
+get_perf_callchain_deferred(struct pt_regs *regs, bool kernel, u32 max_stack,
+			    u64 cookie)
+{
+	struct perf_callchain_entry *entry;
+
+	entry = get_perf_callchain(regs, 0, kernel, false, max_stack, false, true);
+	if (!entry)
+		return NULL;
+
+	/* Both the marker and the cookie, or neither. */
+	if (entry->nr + 2 > sysctl_perf_event_max_stack +
+			    sysctl_perf_event_max_contexts_per_stack)
+		return entry;
+
+	entry->ip[entry->nr++] = PERF_CONTEXT_USER_DEFERRED;
+	entry->ip[entry->nr++] = cookie;
+
+	return entry;
+}
+
+void perf_register_user_unwinder(struct perf_user_unwinder *uw)
+{
+	mutex_lock(&user_unwinders_mutex);
+	list_add_tail_rcu(&uw->list, &user_unwinders);
+	mutex_unlock(&user_unwinders_mutex);
+}
+EXPORT_SYMBOL_GPL(perf_register_user_unwinder);
+
+void perf_unregister_user_unwinder(struct perf_user_unwinder *uw)
+{
+	mutex_lock(&user_unwinders_mutex);
+	list_del_rcu(&uw->list);
+	mutex_unlock(&user_unwinders_mutex);
+
+	synchronize_srcu(&user_unwinders_srcu);
+}
+EXPORT_SYMBOL_GPL(perf_unregister_user_unwinder);
+
+/*
+ * Unwind the user stack of current into its deferred callchain buffer.
+ * Called from task context on the way back to user space, so unlike the
+ * NMI-time walk the unwinders may fault in the stack and unwind tables.
+ * Registered unwinders are tried first, the frame pointer based
+ * perf_callchain_user() is the fallback.
+ */
+struct perf_callchain_entry *perf_callchain_user_deferred(void)
+{
+	struct perf_unwind_task *info = &current->perf_unwind;
+	struct perf_callchain_entry_ctx ctx;
+	struct perf_user_unwinder *uw;
+	struct pt_regs *regs;
+	size_t size;
+	int idx;
+
+	if (!current->mm || (current->flags & PF_EXITING))
+		return NULL;
+
+	/* Both the stack depth and the contexts per stack size the entry */
+	size = perf_callchain_entry__sizeof();
+	if (!info->entry || info->entry_size != size) {
+		kfree(info->entry);
+		info->entry = kmalloc(size, GFP_KERNEL);
+		if (!info->entry)
+			return NULL;
+		info->entry_size = size;
+	}
+
+	regs = task_pt_regs(current);
+
+	ctx.entry	   = info->entry;
+	ctx.max_stack	   = sysctl_perf_event_max_stack;
+	ctx.nr		   = info->entry->nr = 0;
+	ctx.contexts	   = 0;
+	ctx.contexts_maxed = false;
+
+	perf_callchain_store_context(&ctx, PERF_CONTEXT_USER);
+
+	idx = srcu_read_lock(&user_unwinders_srcu);
+	list_for_each_entry_srcu(uw, &user_unwinders, list,
+				 srcu_read_lock_held(&user_unwinders_srcu)) {
+		if (uw->unwind(&ctx, regs))
+			goto unlock;
+		/* drop whatever a failed unwinder left behind */
+		ctx.nr = 0;
+		info->entry->nr = 1;
+	}
+	perf_callchain_user(&ctx, regs);
+unlock:
+	srcu_read_unlock(&user_unwinders_srcu, idx);
+
+	return info->entry;
+}
+
 /*
  * Used for sysctl_perf_event_max_stack and
  * sysctl_perf_event_max_contexts_per_stack.
@@ -7540,6 +7540,172 @@ static u64 perf_get_page_size(unsigned long addr)
 
 static struct perf_callchain_entry __empty_callchain = { .nr = 0, };
 
+struct perf_callchain_deferred_event {
+	struct perf_event_header	header;
+	u64				cookie;
+	u64				nr;
+};
+
+static void perf_event_callchain_deferred_output(struct perf_event *event,
+						 struct perf_callchain_entry *entry,
+						 u64 cookie)
+{
+	struct perf_callchain_deferred_event callchain_event = {
+		.header = {
+			.type = PERF_RECORD_CALLCHAIN_DEFERRED,
+			.misc = PERF_RECORD_MISC_USER,
+			.size = sizeof(callchain_event) +
+				entry->nr * sizeof(u64),
+		},
+		.cookie = cookie,
+		.nr = entry->nr,
+	};
+	struct perf_output_handle handle;
+	struct perf_sample_data sample;
+	int ret;
+
+	perf_event_header__init_id(&callchain_event.header, &sample, event);
+	ret = perf_output_begin(&handle, &sample, event,
+				callchain_event.header.size);
+	if (ret)
+		return;
+
+	perf_output_put(&handle, callchain_event);
+	__output_copy(&handle, entry->ip, entry->nr * sizeof(u64));
+	perf_event__output_id_sample(event, &handle, &sample);
+
+	perf_output_end(&handle);
+}
+
+/*
+ * perf_unwind_task::state
+ *
+ * IDLE -> BUSY -> PENDING: a sample claims the deferral and queues the work.
+ * PENDING -> BUSY -> IDLE: the work closes the batch it has output.
+ *
+ * Samples only append to the batch while it is PENDING.  Samples nesting in
+ * a BUSY window (an NMI on top of the IRQ that arms the deferral, or on top
+ * of the work) walk the user stack right away instead.
+ */
+#define PERF_UNWIND_IDLE	0
+#define PERF_UNWIND_BUSY	1
+#define PERF_UNWIND_PENDING	2
+
+/*
+ * Runs on return to user space of a task that took deferred callchain
+ * samples: unwind the user stack once and hand it to every event that
+ * asked for it during this kernel entry.
+ */
+static void perf_callchain_deferred_work(struct callback_head *head)
+{
+	struct perf_unwind_task *info = container_of(head, struct perf_unwind_task, work);
+	struct perf_callchain_entry *entry;
+	unsigned int i, nr;
+
+	entry = perf_callchain_user_deferred();
+
+	/*
+	 * Samples taken until here still saw the same user stack.  Stop them
+	 * from appending; any that interrupts us completes before we go on,
+	 * so nr_events is stable afterwards.
+	 */
+	WRITE_ONCE(info->state, PERF_UNWIND_BUSY);
+	barrier();
+	nr = READ_ONCE(info->nr_events);
+	for (i = 0; i < nr; i++) {
+		struct perf_event *event = info->events[i];
+
+		if (entry)
+			perf_event_callchain_deferred_output(event, entry,
+							     info->cookie);
+		info->events[i] = NULL;
+		put_event(event);
+	}
+	WRITE_ONCE(info->nr_events, 0);
+	barrier();
+	WRITE_ONCE(info->state, PERF_UNWIND_IDLE);
+}
+
+static DEFINE_PER_CPU(u32, perf_callchain_cookie);
+
+/*
+ * Try to leave the user part of @event's callchain to the return of current
+ * to user space, where a single unwind serves all the samples taken during
+ * this kernel entry and the unwinder may fault.  Returns false if the user
+ * stack has to be walked right away.
+ *
+ * Only ever called on the task itself, from NMI or IRQ context, so it nests
+ * with perf_callchain_deferred_work() but never runs concurrently with it.
+ * An NMI sample may nest in an IRQ sample though, so the state and the
+ * event slots are claimed with cmpxchg().
+ */
+static bool perf_callchain_defer(struct perf_event *event, struct pt_regs *regs,
+				 u64 *cookie)
+{
+	struct perf_unwind_task *info = &current->perf_unwind;
+	unsigned int i, nr;
+
+	if (!current->mm || (current->flags & (PF_KTHREAD | PF_EXITING)))
+		return false;
+
+	/* An NMI returning straight to user space does not run task work. */
+	if (in_nmi() && user_mode(regs))
+		return false;
+
+	switch (READ_ONCE(info->state)) {
+	case PERF_UNWIND_IDLE:
+		if (cmpxchg(&info->state, PERF_UNWIND_IDLE,
+			    PERF_UNWIND_BUSY) != PERF_UNWIND_IDLE)
+			return false;
+
+		/* the cpu in the low bits keeps cookies unique */
+		info->cookie = ((u64)this_cpu_inc_return(perf_callchain_cookie) << 32) |
+			       smp_processor_id();
+		init_task_work(&info->work, perf_callchain_deferred_work);
+		if (task_work_add(current, &info->work, TWA_RESUME)) {
+			WRITE_ONCE(info->state, PERF_UNWIND_IDLE);
+			return false;
+		}
+		barrier();
+		WRITE_ONCE(info->state, PERF_UNWIND_PENDING);
+		break;
+
+	case PERF_UNWIND_PENDING:
+		break;
+
+	default:
+		return false;
+	}
+
+	if (!atomic_long_inc_not_zero(&event->refcount))
+		return false;
+
+	/*
+	 * A nested sample may have claimed a slot it did not fill yet; slots
+	 * are NULL until filled, so it cannot be mistaken for @event.
+	 */
+	do {
+		nr = READ_ONCE(info->nr_events);
+		for (i = 0; i < nr; i++) {
+			if (READ_ONCE(info->events[i]) == event) {
+				/* the event is running, not the last reference */
+				atomic_long_dec(&event->refcount);
+				goto out;
+			}
+		}
+
+		if (nr == PERF_UNWIND_MAX_EVENTS) {
+			atomic_long_dec(&event->refcount);
+			return false;
+		}
+	} while (cmpxchg(&info->nr_events, nr, nr + 1) != nr);
+
+	WRITE_ONCE(info->events[nr], event);
+out:
+	*cookie = info->cookie;
+	return true;
+}
+
 struct perf_callchain_entry *
 perf_callchain(struct perf_event *event, struct pt_regs *regs)
 {
@@ -7549,10 +7715,18 @@ perf_callchain(struct perf_event *event, struct pt_regs *regs)
 	bool crosstask = event->ctx->task && event->ctx->task != current;
 	const u32 max_stack = event->attr.sample_max_stack;
 	struct perf_callchain_entry *callchain;
+	u64 cookie;
 
 	if (!kernel && !user)
 		return &__empty_callchain;
 
+	if (user && !crosstask && event->attr.defer_callchain &&
+	    perf_callchain_defer(event, regs, &cookie)) {
+		callchain = get_perf_callchain_deferred(regs, kernel, max_stack,
+							cookie);
+		return callchain ?: &__empty_callchain;
+	}
+
 	callchain = get_perf_callchain(regs, 0, kernel, user,
 				       max_stack, crosstask, true);
 	return callchain ?: &__empty_callchain;
@@ -13066,6 +13240,9 @@ void perf_event_exit_task(struct task_struct *child)
 
 	perf_event_exit_task_context(child);
 
+	kfree(child->perf_unwind.entry);
+	child->perf_unwind.entry = NULL;
+
 	/*
 	 * The perf_event_exit_task_context calls perf_event_task
 	 * with child's task_ctx, which generates EXIT events for
@@ -13494,6 +13671,8 @@ int perf_event_init_task(struct task_struct *child, u64 clone_flags)
 	child->perf_event_ctxp = NULL;
 	mutex_init(&child->perf_event_mutex);
 	INIT_LIST_HEAD(&child->perf_event_list);
+	/* none of the parent's deferred callchain state carries over */
+	memset(&child->perf_unwind, 0, sizeof(child->perf_unwind));
 
 	ret = perf_event_init_context(child, clone_flags);
 	if (ret) {
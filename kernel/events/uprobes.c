@@ -26,6 +26,8 @@
 #include <linux/task_work.h>
 #include <linux/shmem_fs.h>
 #include <linux/khugepaged.h>
+#include <linux/srcu.h>
+#include <linux/sort.h>
 
 #include <linux/uprobes.h>
 
@@ -39,7 +41,14 @@ static struct rb_root uprobes_tree = RB_ROOT;
  */
 #define no_uprobe_events()	RB_EMPTY_ROOT(&uprobes_tree)
 
-static DEFINE_SPINLOCK(uprobes_treelock);	/* serialize rbtree access */
+static DEFINE_RWLOCK(uprobes_treelock);	/* serialize rbtree access */
+static seqcount_rwlock_t uprobes_seqcount = SEQCNT_RWLOCK_ZERO(uprobes_seqcount, &uprobes_treelock);
+
+/* protects the consumer lists walked on breakpoint hits */
+DEFINE_STATIC_SRCU(uprobes_srcu);
+
+/* serializes uprobe_register_batch() and uprobe_unregister_batch() */
+static DEFINE_MUTEX(uprobes_batch_mutex);
 
 #define UPROBES_HASH_SZ	13
 /* serialize uprobe->pending_list */
@@ -57,11 +66,13 @@ struct uprobe {
 	struct rw_semaphore	register_rwsem;
 	struct rw_semaphore	consumer_rwsem;
 	struct list_head	pending_list;
-	struct uprobe_consumer	*consumers;
+	struct list_head	consumers;
+	unsigned int		consumers_gen;	/* bumped on consumer_add() */
 	struct inode		*inode;		/* Also hold a ref to inode */
 	loff_t			offset;
 	loff_t			ref_ctr_offset;
 	unsigned long		flags;
+	struct rcu_head		rcu;
 
 	/*
 	 * The generic code assumes that it has two members of unknown type
@@ -606,7 +617,8 @@ static void put_uprobe(struct uprobe *uprobe)
 		mutex_lock(&delayed_uprobe_lock);
 		delayed_uprobe_remove(uprobe, NULL);
 		mutex_unlock(&delayed_uprobe_lock);
-		kfree(uprobe);
+		/* find_uprobe_rcu() may still be looking at it */
+		kfree_rcu(uprobe, rcu);
 	}
 }
 
@@ -649,31 +661,49 @@ static inline int __uprobe_cmp(struct rb_node *a, const struct rb_node *b)
 	return uprobe_cmp(u->inode, u->offset, __node_2_uprobe(b));
 }
 
-static struct uprobe *__find_uprobe(struct inode *inode, loff_t offset)
+/*
+ * Find a uprobe corresponding to a given inode:offset without taking
+ * uprobes_treelock.  Must be called under rcu_read_lock(), the returned
+ * uprobe may already be on its way out and is only guaranteed to stay
+ * around until rcu_read_unlock().
+ */
+static struct uprobe *find_uprobe_rcu(struct inode *inode, loff_t offset)
 {
 	struct __uprobe_key key = {
 		.inode = inode,
 		.offset = offset,
 	};
-	struct rb_node *node = rb_find(&key, &uprobes_tree, __uprobe_cmp_key);
+	struct rb_node *node;
+	unsigned int seq;
 
-	if (node)
-		return get_uprobe(__node_2_uprobe(node));
+	do {
+		seq = read_seqcount_begin(&uprobes_seqcount);
+		node = rb_find_rcu(&key, &uprobes_tree, __uprobe_cmp_key);
+		/*
+		 * A lockless lookup can only give false negatives, a found
+		 * node is always the right one.  Retry the misses that raced
+		 * with a tree modification.
+		 */
+		if (node)
+			return __node_2_uprobe(node);
+	} while (read_seqcount_retry(&uprobes_seqcount, seq));
 
 	return NULL;
 }
 
 /*
- * Find a uprobe corresponding to a given inode:offset
- * Acquires uprobes_treelock
+ * Find a uprobe corresponding to a given inode:offset and take a
+ * reference to it.  Lockless, this is the breakpoint hit path.
  */
 static struct uprobe *find_uprobe(struct inode *inode, loff_t offset)
 {
 	struct uprobe *uprobe;
 
-	spin_lock(&uprobes_treelock);
-	uprobe = __find_uprobe(inode, offset);
-	spin_unlock(&uprobes_treelock);
+	rcu_read_lock();
+	uprobe = find_uprobe_rcu(inode, offset);
+	if (uprobe && !refcount_inc_not_zero(&uprobe->ref))
+		uprobe = NULL;
+	rcu_read_unlock();
 
 	return uprobe;
 }
@@ -682,7 +712,7 @@ static struct uprobe *__insert_uprobe(struct uprobe *uprobe)
 {
 	struct rb_node *node;
 
-	node = rb_find_add(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
+	node = rb_find_add_rcu(&uprobe->rb_node, &uprobes_tree, __uprobe_cmp);
 	if (node)
 		return get_uprobe(__node_2_uprobe(node));
 
@@ -692,7 +722,7 @@ static struct uprobe *__insert_uprobe(struct uprobe *uprobe)
 }
 
 /*
- * Acquire uprobes_treelock.
+ * Acquire uprobes_treelock for write.
  * Matching uprobe already exists in rbtree;
  *	increment (access refcount) and return the matching uprobe.
  *
@@ -703,9 +733,11 @@ static struct uprobe *insert_uprobe(struct uprobe *uprobe)
 {
 	struct uprobe *u;
 
-	spin_lock(&uprobes_treelock);
+	write_lock(&uprobes_treelock);
+	write_seqcount_begin(&uprobes_seqcount);
 	u = __insert_uprobe(uprobe);
-	spin_unlock(&uprobes_treelock);
+	write_seqcount_end(&uprobes_seqcount);
+	write_unlock(&uprobes_treelock);
 
 	return u;
 }
@@ -734,6 +766,7 @@ static struct uprobe *alloc_uprobe(struct inode *inode, loff_t offset,
 	uprobe->ref_ctr_offset = ref_ctr_offset;
 	init_rwsem(&uprobe->register_rwsem);
 	init_rwsem(&uprobe->consumer_rwsem);
+	INIT_LIST_HEAD(&uprobe->consumers);
 
 	/* add to uprobes_tree, sorted on inode:offset */
 	cur_uprobe = insert_uprobe(uprobe);
@@ -755,8 +788,9 @@ static struct uprobe *alloc_uprobe(struct inode *inode, loff_t offset,
 static void consumer_add(struct uprobe *uprobe, struct uprobe_consumer *uc)
 {
 	down_write(&uprobe->consumer_rwsem);
-	uc->next = uprobe->consumers;
-	uprobe->consumers = uc;
+	list_add_rcu(&uc->cons_node, &uprobe->consumers);
+	smp_wmb(); /* pairs with the smp_rmb() in handler_chain() */
+	WRITE_ONCE(uprobe->consumers_gen, uprobe->consumers_gen + 1);
 	up_write(&uprobe->consumer_rwsem);
 }
 
@@ -764,16 +798,19 @@ static void consumer_add(struct uprobe *uprobe, struct uprobe_consumer *uc)
  * For uprobe @uprobe, delete the consumer @uc.
  * Return true if the @uc is deleted successfully
  * or return false.
+ *
+ * Breakpoint hits may still be running @uc's handlers until
+ * uprobe_unregister_sync() returns.
  */
 static bool consumer_del(struct uprobe *uprobe, struct uprobe_consumer *uc)
 {
-	struct uprobe_consumer **con;
+	struct uprobe_consumer *con;
 	bool ret = false;
 
 	down_write(&uprobe->consumer_rwsem);
-	for (con = &uprobe->consumers; *con; con = &(*con)->next) {
-		if (*con == uc) {
-			*con = uc->next;
+	list_for_each_entry(con, &uprobe->consumers, cons_node) {
+		if (con == uc) {
+			list_del_rcu(&uc->cons_node);
 			ret = true;
 			break;
 		}
@@ -878,7 +915,7 @@ static bool filter_chain(struct uprobe *uprobe,
 	bool ret = false;
 
 	down_read(&uprobe->consumer_rwsem);
-	for (uc = uprobe->consumers; uc; uc = uc->next) {
+	list_for_each_entry(uc, &uprobe->consumers, cons_node) {
 		ret = consumer_filter(uc, ctx, mm);
 		if (ret)
 			break;
@@ -937,9 +974,11 @@ static void delete_uprobe(struct uprobe *uprobe)
 	if (WARN_ON(!uprobe_is_active(uprobe)))
 		return;
 
-	spin_lock(&uprobes_treelock);
+	write_lock(&uprobes_treelock);
+	write_seqcount_begin(&uprobes_seqcount);
 	rb_erase(&uprobe->rb_node, &uprobes_tree);
-	spin_unlock(&uprobes_treelock);
+	write_seqcount_end(&uprobes_seqcount);
+	write_unlock(&uprobes_treelock);
 	RB_CLEAR_NODE(&uprobe->rb_node); /* for uprobe_is_active() */
 	put_uprobe(uprobe);
 }
@@ -957,10 +996,16 @@ static inline struct map_info *free_map_info(struct map_info *info)
 	return next;
 }
 
+/*
+ * Collect the mappings of file offsets @start to @end of @mapping.  Each
+ * map_info is the address of the first offset not below @start in one vma.
+ */
 static struct map_info *
-build_map_info(struct address_space *mapping, loff_t offset, bool is_register)
+build_map_info(struct address_space *mapping, loff_t start, loff_t end,
+	       bool is_register)
 {
-	unsigned long pgoff = offset >> PAGE_SHIFT;
+	unsigned long pgoff = start >> PAGE_SHIFT;
+	unsigned long pgoff_last = end >> PAGE_SHIFT;
 	struct vm_area_struct *vma;
 	struct map_info *curr = NULL;
 	struct map_info *prev = NULL;
@@ -969,7 +1014,7 @@ build_map_info(struct address_space *mapping, loff_t offset, bool is_register)
 
  again:
 	i_mmap_lock_read(mapping);
-	vma_interval_tree_foreach(vma, &mapping->i_mmap, pgoff, pgoff) {
+	vma_interval_tree_foreach(vma, &mapping->i_mmap, pgoff, pgoff_last) {
 		if (!valid_vma(vma, is_register))
 			continue;
 
@@ -997,7 +1042,8 @@ build_map_info(struct address_space *mapping, loff_t offset, bool is_register)
 		curr = info;
 
 		info->mm = vma->vm_mm;
-		info->vaddr = offset_to_vaddr(vma, offset);
+		info->vaddr = offset_to_vaddr(vma,
+				max_t(loff_t, start, vaddr_to_offset(vma, vma->vm_start)));
 	}
 	i_mmap_unlock_read(mapping);
 
@@ -1035,8 +1081,8 @@ register_for_each_vma(struct uprobe *uprobe, struct uprobe_consumer *new)
 	int err = 0;
 
 	percpu_down_write(&dup_mmap_sem);
-	info = build_map_info(uprobe->inode->i_mapping,
-					uprobe->offset, is_register);
+	info = build_map_info(uprobe->inode->i_mapping, uprobe->offset,
+			      uprobe->offset, is_register);
 	if (IS_ERR(info)) {
 		err = PTR_ERR(info);
 		goto out;
@@ -1091,17 +1137,21 @@ __uprobe_unregister(struct uprobe *uprobe, struct uprobe_consumer *uc)
 
 	err = register_for_each_vma(uprobe, NULL);
 	/* TODO : cant unregister? schedule a worker thread */
-	if (!uprobe->consumers && !err)
+	if (list_empty(&uprobe->consumers) && !err)
 		delete_uprobe(uprobe);
 }
 
 /*
- * uprobe_unregister - unregister an already registered probe.
+ * uprobe_unregister_nosync - unregister an already registered probe.
  * @inode: the file in which the probe has to be removed.
  * @offset: offset from the start of the file.
  * @uc: identify which probe if multiple probes are colocated.
+ *
+ * Breakpoint hits may still be running @uc's handlers on return, @uc can
+ * only be freed or reused after uprobe_unregister_sync().  This allows
+ * unregistering many probes for the price of a single grace period.
  */
-void uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consumer *uc)
+void uprobe_unregister_nosync(struct inode *inode, loff_t offset, struct uprobe_consumer *uc)
 {
 	struct uprobe *uprobe;
 
@@ -1114,7 +1164,16 @@ void uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consume
 	up_write(&uprobe->register_rwsem);
 	put_uprobe(uprobe);
 }
-EXPORT_SYMBOL_GPL(uprobe_unregister);
+EXPORT_SYMBOL_GPL(uprobe_unregister_nosync);
+
+/*
+ * uprobe_unregister_sync - wait for the handlers of unregistered consumers.
+ */
+void uprobe_unregister_sync(void)
+{
+	synchronize_srcu(&uprobes_srcu);
+}
+EXPORT_SYMBOL_GPL(uprobe_unregister_sync);
 
 /*
  * __uprobe_register - register a probe
@@ -1134,12 +1193,9 @@ EXPORT_SYMBOL_GPL(uprobe_unregister);
  * Return errno if it cannot successully install probes
  * else return 0 (success)
  */
-static int __uprobe_register(struct inode *inode, loff_t offset,
-			     loff_t ref_ctr_offset, struct uprobe_consumer *uc)
+static int uprobe_register_check(struct inode *inode, loff_t offset,
+				 loff_t ref_ctr_offset, struct uprobe_consumer *uc)
 {
-	struct uprobe *uprobe;
-	int ret;
-
 	/* Uprobe must have at least one set consumer */
 	if (!uc->handler && !uc->ret_handler)
 		return -EINVAL;
@@ -1161,6 +1217,19 @@ static int __uprobe_register(struct inode *inode, loff_t offset,
 	if (!IS_ALIGNED(ref_ctr_offset, sizeof(short)))
 		return -EINVAL;
 
+	return 0;
+}
+
+static int __uprobe_register(struct inode *inode, loff_t offset,
+			     loff_t ref_ctr_offset, struct uprobe_consumer *uc)
+{
+	struct uprobe *uprobe;
+	int ret;
+
+	ret = uprobe_register_check(inode, offset, ref_ctr_offset, uc);
+	if (ret)
+		return ret;
+
  retry:
 	uprobe = alloc_uprobe(inode, offset, ref_ctr_offset);
 	if (!uprobe)
@@ -1185,6 +1254,9 @@ static int __uprobe_register(struct inode *inode, loff_t offset,
 
 	if (unlikely(ret == -EAGAIN))
 		goto retry;
+	/* the caller may free @uc once we return an error */
+	if (ret)
+		uprobe_unregister_sync();
 	return ret;
 }
 
@@ -1202,6 +1274,304 @@ int uprobe_register_refctr(struct inode *inode, loff_t offset,
 }
 EXPORT_SYMBOL_GPL(uprobe_register_refctr);
 
+static int uprobe_batch_cmp(const void *a, const void *b)
+{
+	const struct uprobe_batch_entry *ea = a, *eb = b;
+
+	if (ea->offset < eb->offset)
+		return -1;
+	return ea->offset > eb->offset;
+}
+
+/* Index of the first of the sorted @entries at or above @offset. */
+static unsigned int uprobe_batch_first(struct uprobe_batch_entry *entries,
+				       unsigned int cnt, loff_t offset)
+{
+	unsigned int lo = 0, hi = cnt;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (entries[mid].offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * register_for_each_vma() for a whole batch: install or remove the
+ * breakpoints of all @uprobes in a single walk over the mappings of @inode.
+ */
+static int register_for_each_vma_batch(struct inode *inode, struct uprobe **uprobes,
+				       struct uprobe_batch_entry *entries,
+				       unsigned int cnt, bool is_register)
+{
+	struct map_info *info;
+	int err = 0;
+
+	percpu_down_write(&dup_mmap_sem);
+	info = build_map_info(inode->i_mapping, entries[0].offset,
+			      entries[cnt - 1].offset, is_register);
+	if (IS_ERR(info)) {
+		err = PTR_ERR(info);
+		goto out;
+	}
+
+	while (info) {
+		struct mm_struct *mm = info->mm;
+		struct vm_area_struct *vma;
+		loff_t start, end;
+		unsigned int i;
+
+		if (err && is_register)
+			goto free;
+
+		mmap_write_lock(mm);
+		vma = find_vma(mm, info->vaddr);
+		if (!vma || !valid_vma(vma, is_register) ||
+		    file_inode(vma->vm_file) != inode ||
+		    vma->vm_start > info->vaddr)
+			goto unlock;
+
+		start = vaddr_to_offset(vma, vma->vm_start);
+		end = vaddr_to_offset(vma, vma->vm_end);
+
+		for (i = uprobe_batch_first(entries, cnt, start);
+		     i < cnt && entries[i].offset < end; i++) {
+			unsigned long vaddr = offset_to_vaddr(vma, entries[i].offset);
+
+			if (is_register) {
+				if (!consumer_filter(entries[i].uc,
+						     UPROBE_FILTER_REGISTER, mm))
+					continue;
+				err = install_breakpoint(uprobes[i], mm, vma, vaddr);
+				if (err)
+					break;
+			} else if (test_bit(MMF_HAS_UPROBES, &mm->flags)) {
+				if (!filter_chain(uprobes[i],
+						  UPROBE_FILTER_UNREGISTER, mm))
+					err |= remove_breakpoint(uprobes[i], mm, vaddr);
+			}
+		}
+
+ unlock:
+		mmap_write_unlock(mm);
+ free:
+		mmput(mm);
+		info = free_map_info(info);
+	}
+ out:
+	percpu_up_write(&dup_mmap_sem);
+	return err;
+}
+
+/*
+ * Take the register_rwsem of every uprobe of a batch.  Colocated probes
+ * share a uprobe, which the sorting of the batch makes adjacent.
+ */
+static void uprobe_batch_lock(struct uprobe **uprobes, unsigned int cnt)
+{
+	unsigned int i;
+
+	lockdep_assert_held(&uprobes_batch_mutex);
+
+	for (i = 0; i < cnt; i++) {
+		if (i && uprobes[i] == uprobes[i - 1])
+			continue;
+		down_write_nest_lock(&uprobes[i]->register_rwsem,
+				     &uprobes_batch_mutex);
+	}
+}
+
+static void uprobe_batch_unlock(struct uprobe **uprobes, unsigned int cnt)
+{
+	unsigned int i;
+
+	for (i = 0; i < cnt; i++) {
+		if (i && uprobes[i] == uprobes[i - 1])
+			continue;
+		up_write(&uprobes[i]->register_rwsem);
+	}
+}
+
+static void __uprobe_unregister_batch(struct inode *inode, struct uprobe **uprobes,
+				      struct uprobe_batch_entry *entries,
+				      unsigned int cnt)
+{
+	unsigned int i;
+	int err;
+
+	for (i = 0; i < cnt; i++)
+		WARN_ON(!consumer_del(uprobes[i], entries[i].uc));
+
+	err = register_for_each_vma_batch(inode, uprobes, entries, cnt, false);
+
+	for (i = 0; i < cnt; i++) {
+		if (i && uprobes[i] == uprobes[i - 1])
+			continue;
+		/* TODO : cant unregister? schedule a worker thread */
+		if (list_empty(&uprobes[i]->consumers) && !err)
+			delete_uprobe(uprobes[i]);
+	}
+}
+
+/*
+ * uprobe_register_batch - register probes at several offsets of a file
+ * @inode: the file in which the probes have to be placed.
+ * @entries: offsets, ref_ctr_offsets and consumers of the probes.
+ * @cnt: number of @entries.
+ *
+ * Equivalent to uprobe_register_refctr() on each of @entries, except that
+ * the breakpoints are installed in one walk over the mappings of @inode
+ * rather than one walk per probe.  @entries is sorted by offset in place.
+ * Either all the probes get registered or none of them.
+ *
+ * Return errno if it cannot successully install probes
+ * else return 0 (success)
+ */
+int uprobe_register_batch(struct inode *inode, struct uprobe_batch_entry *entries,
+			  unsigned int cnt)
+{
+	struct uprobe **uprobes;
+	unsigned int i, n;
+	int ret;
+
+	if (!cnt)
+		return 0;
+
+	for (i = 0; i < cnt; i++) {
+		ret = uprobe_register_check(inode, entries[i].offset,
+					    entries[i].ref_ctr_offset,
+					    entries[i].uc);
+		if (ret)
+			return ret;
+	}
+
+	sort(entries, cnt, sizeof(*entries), uprobe_batch_cmp, NULL);
+
+	uprobes = kvcalloc(cnt, sizeof(*uprobes), GFP_KERNEL);
+	if (!uprobes)
+		return -ENOMEM;
+
+ retry:
+	for (n = 0; n < cnt; n++) {
+		uprobes[n] = alloc_uprobe(inode, entries[n].offset,
+					  entries[n].ref_ctr_offset);
+		if (IS_ERR_OR_NULL(uprobes[n])) {
+			ret = uprobes[n] ? PTR_ERR(uprobes[n]) : -ENOMEM;
+			goto put;
+		}
+	}
+
+	mutex_lock(&uprobes_batch_mutex);
+	uprobe_batch_lock(uprobes, cnt);
+
+	/* We can race with delete_uprobe(), see __uprobe_register(). */
+	ret = -EAGAIN;
+	for (i = 0; i < cnt; i++) {
+		if (unlikely(!uprobe_is_active(uprobes[i])))
+			goto unlock;
+	}
+
+	for (i = 0; i < cnt; i++)
+		consumer_add(uprobes[i], entries[i].uc);
+
+	ret = register_for_each_vma_batch(inode, uprobes, entries, cnt, true);
+	if (ret)
+		__uprobe_unregister_batch(inode, uprobes, entries, cnt);
+ unlock:
+	uprobe_batch_unlock(uprobes, cnt);
+	mutex_unlock(&uprobes_batch_mutex);
+ put:
+	while (n--)
+		put_uprobe(uprobes[n]);
+
+	if (unlikely(ret == -EAGAIN))
+		goto retry;
+	kvfree(uprobes);
+
+	/* the caller may free the consumers once we return an error */
+	if (ret)
+		uprobe_unregister_sync();
+	return ret;
+}
+EXPORT_SYMBOL_GPL(uprobe_register_batch);
+
+/*
+ * uprobe_unregister_batch - unregister probes registered with
+ * uprobe_register_batch().
+ * @inode: the file in which the probes have to be removed.
+ * @entries: the probes, as passed to uprobe_register_batch().
+ * @cnt: number of @entries.
+ */
+void uprobe_unregister_batch(struct inode *inode, struct uprobe_batch_entry *entries,
+			     unsigned int cnt)
+{
+	struct uprobe **uprobes;
+	unsigned int i, n;
+
+	if (!cnt)
+		return;
+
+	sort(entries, cnt, sizeof(*entries), uprobe_batch_cmp, NULL);
+
+	uprobes = kvcalloc(cnt, sizeof(*uprobes), GFP_KERNEL);
+	if (!uprobes)
+		goto slow;
+
+	for (n = 0; n < cnt; n++) {
+		uprobes[n] = find_uprobe(inode, entries[n].offset);
+		if (WARN_ON(!uprobes[n]))
+			break;
+	}
+
+	if (n == cnt) {
+		mutex_lock(&uprobes_batch_mutex);
+		uprobe_batch_lock(uprobes, cnt);
+		__uprobe_unregister_batch(inode, uprobes, entries, cnt);
+		uprobe_batch_unlock(uprobes, cnt);
+		mutex_unlock(&uprobes_batch_mutex);
+	}
+
+	for (i = 0; i < n; i++)
+		put_uprobe(uprobes[i]);
+	kvfree(uprobes);
+
+	if (n == cnt)
+		goto sync;
+ slow:
+	/* out of memory or inconsistent batch, go one probe at a time */
+	for (i = 0; i < cnt; i++)
+		uprobe_unregister_nosync(inode, entries[i].offset, entries[i].uc);
+ sync:
+	uprobe_unregister_sync();
+}
+EXPORT_SYMBOL_GPL(uprobe_unregister_batch);
+
+/*
+ * uprobe_unregister - unregister an already registered probe.
+ * @inode: the file in which the probe has to be removed.
+ * @offset: offset from the start of the file.
+ * @uc: identify which probe if multiple probes are colocated.
+ *
+ * A batch of one, each call waits for a grace period of uprobes_srcu.
+ * Callers removing many probes should use uprobe_unregister_batch(), or
+ * uprobe_unregister_nosync() followed by one uprobe_unregister_sync().
+ */
+void uprobe_unregister(struct inode *inode, loff_t offset, struct uprobe_consumer *uc)
+{
+	struct uprobe_batch_entry entry = {
+		.offset	= offset,
+		.uc	= uc,
+	};
+
+	uprobe_unregister_batch(inode, &entry, 1);
+}
+EXPORT_SYMBOL_GPL(uprobe_unregister);
+
 /*
  * uprobe_apply - unregister an already registered probe.
  * @inode: the file in which the probe has to be removed.
@@ -1221,10 +1591,12 @@ int uprobe_apply(struct inode *inode, loff_t offset,
 		return ret;
 
 	down_write(&uprobe->register_rwsem);
-	for (con = uprobe->consumers; con && con != uc ; con = con->next)
-		;
-	if (con)
-		ret = register_for_each_vma(uprobe, add ? uc : NULL);
+	list_for_each_entry(con, &uprobe->consumers, cons_node) {
+		if (con == uc) {
+			ret = register_for_each_vma(uprobe, add ? uc : NULL);
+			break;
+		}
+	}
 	up_write(&uprobe->register_rwsem);
 	put_uprobe(uprobe);
 
@@ -1300,7 +1672,7 @@ static void build_probe_list(struct inode *inode,
 	min = vaddr_to_offset(vma, start);
 	max = min + (end - start) - 1;
 
-	spin_lock(&uprobes_treelock);
+	read_lock(&uprobes_treelock);
 	n = find_node_in_range(inode, min, max);
 	if (n) {
 		for (t = n; t; t = rb_prev(t)) {
@@ -1318,7 +1690,7 @@ static void build_probe_list(struct inode *inode,
 			get_uprobe(u);
 		}
 	}
-	spin_unlock(&uprobes_treelock);
+	read_unlock(&uprobes_treelock);
 }
 
 /* @vma contains reference counter, not the probed instruction. */
@@ -1409,9 +1781,9 @@ vma_has_uprobes(struct vm_area_struct *vma, unsigned long start, unsigned long e
 	min = vaddr_to_offset(vma, start);
 	max = min + (end - start) - 1;
 
-	spin_lock(&uprobes_treelock);
+	read_lock(&uprobes_treelock);
 	n = find_node_in_range(inode, min, max);
-	spin_unlock(&uprobes_treelock);
+	read_unlock(&uprobes_treelock);
 
 	return !!n;
 }
@@ -2073,11 +2445,20 @@ static void handler_chain(struct uprobe *uprobe, struct pt_regs *regs)
 	struct uprobe_consumer *uc;
 	int remove = UPROBE_HANDLER_REMOVE;
 	bool need_prep = false; /* prepare return uprobe, when needed */
+	bool has_consumers = false;
+	unsigned int gen;
+	int idx;
+
+	gen = READ_ONCE(uprobe->consumers_gen);
+	smp_rmb(); /* pairs with the smp_wmb() in consumer_add() */
 
-	down_read(&uprobe->register_rwsem);
-	for (uc = uprobe->consumers; uc; uc = uc->next) {
+	idx = srcu_read_lock(&uprobes_srcu);
+	list_for_each_entry_srcu(uc, &uprobe->consumers, cons_node,
+				 srcu_read_lock_held(&uprobes_srcu)) {
 		int rc = 0;
 
+		has_consumers = true;
+
 		if (uc->handler) {
 			rc = uc->handler(uc, regs);
 			WARN(rc & ~UPROBE_HANDLER_MASK,
@@ -2089,15 +2470,24 @@ static void handler_chain(struct uprobe *uprobe, struct pt_regs *regs)
 
 		remove &= rc;
 	}
+	srcu_read_unlock(&uprobes_srcu, idx);
 
 	if (need_prep && !remove)
 		prepare_uretprobe(uprobe, regs); /* put bp at return */
 
-	if (remove && uprobe->consumers) {
-		WARN_ON(!uprobe_is_active(uprobe));
-		unapply_uprobe(uprobe, current->mm);
+	if (remove && has_consumers) {
+		down_read(&uprobe->register_rwsem);
+		/*
+		 * Don't remove the breakpoint if a consumer whose handler
+		 * did not get a say has been added in the meantime.
+		 */
+		if (!list_empty(&uprobe->consumers) &&
+		    READ_ONCE(uprobe->consumers_gen) == gen) {
+			WARN_ON(!uprobe_is_active(uprobe));
+			unapply_uprobe(uprobe, current->mm);
+		}
+		up_read(&uprobe->register_rwsem);
 	}
-	up_read(&uprobe->register_rwsem);
 }
 
 static void
@@ -2105,13 +2495,15 @@ handle_uretprobe_chain(struct return_instance *ri, struct pt_regs *regs)
 {
 	struct uprobe *uprobe = ri->uprobe;
 	struct uprobe_consumer *uc;
+	int idx;
 
-	down_read(&uprobe->register_rwsem);
-	for (uc = uprobe->consumers; uc; uc = uc->next) {
+	idx = srcu_read_lock(&uprobes_srcu);
+	list_for_each_entry_srcu(uc, &uprobe->consumers, cons_node,
+				 srcu_read_lock_held(&uprobes_srcu)) {
 		if (uc->ret_handler)
 			uc->ret_handler(uc, ri->func, regs);
 	}
-	up_read(&uprobe->register_rwsem);
+	srcu_read_unlock(&uprobes_srcu, idx);
 }
 
 static struct return_instance *find_next_ret_chain(struct return_instance *ri)
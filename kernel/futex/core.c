@@ -37,6 +37,9 @@
 #include <linux/memblock.h>
 #include <linux/fault-inject.h>
 #include <linux/slab.h>
+#include <linux/prctl.h>
+#include <linux/sched/mm.h>
+#include <linux/sched/signal.h>
 
 #include "futex.h"
 #include "../locking/rtmutex_common.h"
@@ -105,19 +108,396 @@ late_initcall(fail_futex_debugfs);
 
 #endif /* CONFIG_FAIL_FUTEX */
 
+static inline u32 futex_key_hash(union futex_key *key)
+{
+	return jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
+		      key->both.offset);
+}
+
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+
+/*
+ * Processes whose private futexes contend on the global hash get a hash of
+ * their own. It is allocated on the node of the contending thread, sized
+ * after the number of threads, and grown when the process gains threads.
+ * PR_FUTEX_HASH allows to pick the size or to opt out instead.
+ *
+ * A replacement publishes the new table in mm->futex_phash before it is
+ * ready, waits for an RCU grace period and then moves all queued waiters
+ * over. Every operation hashes its key and takes the bucket lock within one
+ * RCU read side critical section (the held bucket lock extends it) and
+ * then checks with futex_hash_valid() that it hashed into the current and
+ * ready table. If not, it drops the lock, waits for the replacement to
+ * finish and starts over. After the grace period nobody can thus operate
+ * on the old table, so the waiters can be moved without missing a wakeup.
+ * Lockless fast paths which skip empty buckets check futex_hash_ready()
+ * first, an empty bucket of a table that is not ready proves nothing.
+ * Replacements are serialized per process by mm->futex_hash_lock.
+ * Tasks sleeping on a moved futex_q find their new bucket through
+ * q->lock_ptr, see futex_q_lockptr_lock().
+ */
+struct futex_private_hash {
+	struct rcu_head			rcu;
+	unsigned int			hash_mask;
+	bool				ready;
+	struct futex_hash_bucket	queues[];
+};
+
+/* mm->futex_phash_flags */
+#define FUTEX_PHASH_GROWING	0	/* a resize work is pending */
+#define FUTEX_PHASH_CUSTOM	1	/* size set by PR_FUTEX_HASH */
+
+#define FUTEX_PHASH_MIN_SLOTS	16
+
+/*
+ * Published while the waiters of a private hash move back to the global
+ * hash. It never becomes ready, so nobody uses the global hash before that
+ * is done.
+ */
+static struct futex_private_hash futex_phash_global;
+
+static struct futex_private_hash *futex_private_hash(union futex_key *key)
+{
+	struct futex_private_hash *fph;
+
+	if (!futex_key_is_private(key))
+		return NULL;
+
+	fph = rcu_dereference(key->private.mm->futex_phash);
+	return fph != &futex_phash_global ? fph : NULL;
+}
+
+/**
+ * futex_hash_ready - Check without the bucket lock whether @hb is usable
+ * @key:	The futex key @hb was looked up with
+ * @hb:	The hash bucket
+ *
+ * Lockless variant of futex_hash_valid() for the fast paths which look at
+ * the waiter count of a bucket before locking it. A bucket of a table that
+ * is not ready yet does not have the waiters of the old table moved over,
+ * so its waiter count cannot be trusted.
+ *
+ * Called under rcu_read_lock(). Orders the waiter count read after it
+ * against the completion of the rehash.
+ */
+bool futex_hash_ready(union futex_key *key, struct futex_hash_bucket *hb)
+{
+	struct futex_private_hash *fph = hb->priv;
+
+	if (!futex_key_is_private(key))
+		return true;
+
+	if (rcu_access_pointer(key->private.mm->futex_phash) != fph)
+		return false;
+
+	return !fph || smp_load_acquire(&fph->ready);
+}
+
+/**
+ * futex_hash_valid - Check whether @hb is the right bucket for @key
+ * @key:	The futex key @hb was looked up with
+ * @hb:	The locked hash bucket
+ *
+ * Return: false if a private hash replacement of the key's process is in
+ * progress. The caller must drop the lock, call futex_hash_wait() and look
+ * the bucket up again.
+ */
+bool futex_hash_valid(union futex_key *key, struct futex_hash_bucket *hb)
+{
+	lockdep_assert_held(&hb->lock);
+
+	return futex_hash_ready(key, hb);
+}
+
+/**
+ * futex_hash_wait - Wait for a private hash replacement to complete
+ * @key:	The futex key for which futex_hash_valid() failed
+ */
+void futex_hash_wait(union futex_key *key)
+{
+	struct mm_struct *mm;
+
+	if (!futex_key_is_private(key))
+		return;
+
+	/* Private keys belong to current->mm, which cannot go away */
+	mm = key->private.mm;
+	mutex_lock(&mm->futex_hash_lock);
+	mutex_unlock(&mm->futex_hash_lock);
+}
+
+static unsigned int futex_hash_default_slots(void)
+{
+	unsigned int threads = min_t(unsigned int, get_nr_threads(current),
+				     num_online_cpus());
+	unsigned long slots = roundup_pow_of_two(4 * threads);
+
+	return clamp_t(unsigned long, slots, FUTEX_PHASH_MIN_SLOTS,
+		       futex_hashsize);
+}
+
+static struct futex_private_hash *futex_private_hash_alloc(unsigned int slots,
+							    int node)
+{
+	struct futex_private_hash *fph;
+	unsigned int i;
+
+	fph = kvzalloc_node(struct_size(fph, queues, slots),
+			    GFP_KERNEL_ACCOUNT | __GFP_NOWARN, node);
+	if (!fph)
+		return NULL;
+
+	fph->hash_mask = slots - 1;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+		fph->queues[i].priv = fph;
+	}
+
+	return fph;
+}
+
+static struct futex_hash_bucket *
+futex_hash_bucket(struct futex_private_hash *fph, union futex_key *key)
+{
+	u32 hash = futex_key_hash(key);
+
+	if (fph)
+		return &fph->queues[hash & fph->hash_mask];
+
+	return &futex_queues[hash & (futex_hashsize - 1)];
+}
+
+/*
+ * Move the private futex waiters of @mm from @old to @new, either of which
+ * is the global hash if NULL. All operations on @old have been flushed out
+ * by the caller.
+ */
+static void futex_rehash(struct mm_struct *mm, struct futex_private_hash *old,
+			 struct futex_private_hash *new)
+{
+	struct futex_hash_bucket *queues = old ? old->queues : futex_queues;
+	unsigned long i, size = old ? old->hash_mask + 1 : futex_hashsize;
+
+	for (i = 0; i < size; i++) {
+		struct futex_hash_bucket *hb = &queues[i], *hb2;
+		struct futex_q *this, *next;
+
+		if (!futex_hb_waiters_pending(hb))
+			continue;
+
+		spin_lock(&hb->lock);
+		plist_for_each_entry_safe(this, next, &hb->chain, list) {
+			if (!futex_key_is_private(&this->key) ||
+			    this->key.private.mm != mm)
+				continue;
+
+			hb2 = futex_hash_bucket(new, &this->key);
+
+			plist_del(&this->list, &hb->chain);
+			futex_hb_waiters_dec(hb);
+
+			spin_lock_nested(&hb2->lock, SINGLE_DEPTH_NESTING);
+			plist_add(&this->list, &hb2->chain);
+			futex_hb_waiters_inc(hb2);
+			this->lock_ptr = &hb2->lock;
+			spin_unlock(&hb2->lock);
+		}
+		spin_unlock(&hb->lock);
+	}
+}
+
+/*
+ * Switch @mm to a private hash with @slots buckets, or back to the global
+ * hash if @slots is 0.
+ */
+static int futex_hash_replace(struct mm_struct *mm, unsigned int slots,
+			      int node, bool custom)
+{
+	struct futex_private_hash *old, *new = NULL;
+	unsigned int old_slots;
+
+	if (slots) {
+		new = futex_private_hash_alloc(slots, node);
+		if (!new)
+			return -ENOMEM;
+	}
+
+	/*
+	 * Only replacements of the same process serialize here, each of them
+	 * waits for a grace period below.
+	 */
+	mutex_lock(&mm->futex_hash_lock);
+	old = rcu_dereference_protected(mm->futex_phash,
+					lockdep_is_held(&mm->futex_hash_lock));
+	old_slots = old ? old->hash_mask + 1 : 0;
+
+	/* Growing on contention never overrides a size picked by the user */
+	if (!custom && (test_bit(FUTEX_PHASH_CUSTOM, &mm->futex_phash_flags) ||
+			old_slots >= slots))
+		goto out_free;
+	if (old_slots == slots)
+		goto out_custom;
+
+	rcu_assign_pointer(mm->futex_phash, new ?: &futex_phash_global);
+	/* Flush out everybody who might still operate on @old */
+	synchronize_rcu();
+	futex_rehash(mm, old, new);
+	if (new)
+		smp_store_release(&new->ready, true);
+	else
+		rcu_assign_pointer(mm->futex_phash, NULL);
+	new = old;
+
+out_custom:
+	if (custom)
+		set_bit(FUTEX_PHASH_CUSTOM, &mm->futex_phash_flags);
+out_free:
+	mutex_unlock(&mm->futex_hash_lock);
+	/* Tasks may still look at their old q->lock_ptr */
+	if (new)
+		kvfree_rcu(new, rcu);
+	return 0;
+}
+
+struct futex_hash_grow {
+	struct work_struct	work;
+	struct mm_struct	*mm;
+	unsigned int		slots;
+	int			node;
+};
+
+static void futex_hash_grow_work(struct work_struct *work)
+{
+	struct futex_hash_grow *grow = container_of(work, struct futex_hash_grow, work);
+	struct mm_struct *mm = grow->mm;
+
+	if (atomic_read(&mm->mm_users))
+		futex_hash_replace(mm, grow->slots, grow->node, false);
+
+	clear_bit(FUTEX_PHASH_GROWING, &mm->futex_phash_flags);
+	mmdrop(mm);
+	kfree(grow);
+}
+
+/*
+ * Called under rcu_read_lock() when a waiter found its hash bucket lock
+ * contended: give the process a private hash, or a larger one when it has
+ * gained threads since the current one was sized.
+ */
+static void futex_hash_contended(union futex_key *key)
+{
+	struct futex_private_hash *fph;
+	struct futex_hash_grow *grow;
+	struct mm_struct *mm;
+	unsigned int slots;
+
+	if (!futex_key_is_private(key))
+		return;
+
+	mm = key->private.mm;
+	if (mm != current->mm || (READ_ONCE(mm->futex_phash_flags) &
+				  (BIT(FUTEX_PHASH_GROWING) | BIT(FUTEX_PHASH_CUSTOM))))
+		return;
+
+	slots = futex_hash_default_slots();
+	fph = rcu_dereference(mm->futex_phash);
+	if (fph && fph->hash_mask + 1 >= slots)
+		return;
+
+	if (test_and_set_bit(FUTEX_PHASH_GROWING, &mm->futex_phash_flags))
+		return;
+
+	grow = kmalloc(sizeof(*grow), GFP_NOWAIT | __GFP_NOWARN);
+	if (!grow) {
+		clear_bit(FUTEX_PHASH_GROWING, &mm->futex_phash_flags);
+		return;
+	}
+
+	mmgrab(mm);
+	grow->mm = mm;
+	grow->slots = slots;
+	grow->node = numa_node_id();
+	INIT_WORK(&grow->work, futex_hash_grow_work);
+	queue_work(system_unbound_wq, &grow->work);
+}
+
+static int futex_hash_set_slots(unsigned int slots)
+{
+	if (slots && (slots < 2 || !is_power_of_2(slots) ||
+		      slots > futex_hashsize))
+		return -EINVAL;
+
+	return futex_hash_replace(current->mm, slots, numa_node_id(), true);
+}
+
+static int futex_hash_get_slots(void)
+{
+	struct futex_private_hash *fph;
+	int slots = 0;
+
+	rcu_read_lock();
+	fph = rcu_dereference(current->mm->futex_phash);
+	if (fph && fph != &futex_phash_global)
+		slots = fph->hash_mask + 1;
+	rcu_read_unlock();
+
+	return slots;
+}
+
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		if (arg3 > UINT_MAX)
+			return -EINVAL;
+		return futex_hash_set_slots(arg3);
+
+	case PR_FUTEX_HASH_GET_SLOTS:
+		return futex_hash_get_slots();
+	}
+
+	return -EINVAL;
+}
+
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(rcu_dereference_raw(mm->futex_phash));
+}
+
+#else /* CONFIG_FUTEX_PRIVATE_HASH */
+
+static inline struct futex_private_hash *futex_private_hash(union futex_key *key)
+{
+	return NULL;
+}
+
+static inline struct futex_hash_bucket *
+futex_hash_bucket(struct futex_private_hash *fph, union futex_key *key)
+{
+	return &futex_queues[futex_key_hash(key) & (futex_hashsize - 1)];
+}
+
+static inline void futex_hash_contended(union futex_key *key) { }
+
+#endif /* !CONFIG_FUTEX_PRIVATE_HASH */
+
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket of a futex key
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket in the private hash of the process for private
+ * futexes, if it has one, or in the global hash otherwise.
+ *
+ * Must be called under rcu_read_lock(), which has to be held until the
+ * bucket lock is taken and which can be dropped then. With the lock held
+ * the caller has to check futex_hash_valid() before relying on the bucket.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
-	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
-			  key->both.offset);
-
-	return &futex_queues[hash & (futex_hashsize - 1)];
+	return futex_hash_bucket(futex_private_hash(key), key);
 }
 
 
@@ -515,6 +895,8 @@ struct futex_hash_bucket *futex_q_lock(struct futex_q *q)
 {
 	struct futex_hash_bucket *hb;
 
+retry:
+	rcu_read_lock();
 	hb = futex_hash(&q->key);
 
 	/*
@@ -529,15 +911,26 @@ struct futex_hash_bucket *futex_q_lock(struct futex_q *q)
 
 	q->lock_ptr = &hb->lock;
 
-	spin_lock(&hb->lock);
+	if (!spin_trylock(&hb->lock)) {
+		futex_hash_contended(&q->key);
+		spin_lock(&hb->lock);
+	}
+	rcu_read_unlock();
+
+	if (unlikely(!futex_hash_valid(&q->key, hb))) {
+		futex_q_unlock(hb);
+		futex_hash_wait(&q->key);
+		goto retry;
+	}
 	return hb;
 }
 
 void futex_q_unlock(struct futex_hash_bucket *hb)
 	__releases(&hb->lock)
 {
-	spin_unlock(&hb->lock);
+	/* The bucket is only guaranteed to stay around while it is locked */
 	futex_hb_waiters_dec(hb);
+	spin_unlock(&hb->lock);
 }
 
 void __futex_queue(struct futex_q *q, struct futex_hash_bucket *hb)
@@ -575,6 +968,11 @@ int futex_unqueue(struct futex_q *q)
 	spinlock_t *lock_ptr;
 	int ret = 0;
 
+	/*
+	 * The bucket q->lock_ptr points to may be freed by a private hash
+	 * replacement as soon as q has been moved away from it.
+	 */
+	rcu_read_lock();
 	/* In the common case we don't take the spinlock, which is nice. */
 retry:
 	/*
@@ -609,10 +1007,35 @@ int futex_unqueue(struct futex_q *q)
 		spin_unlock(lock_ptr);
 		ret = 1;
 	}
+	rcu_read_unlock();
 
 	return ret;
 }
 
+/**
+ * futex_q_lockptr_lock() - Lock the hash bucket a queued futex_q is on
+ * @q:	The queued futex_q
+ *
+ * For waiters which dropped the hash bucket lock while queued: the futex_q
+ * may have been moved to another bucket in the meantime, by a requeue or a
+ * private hash replacement. See futex_unqueue() for the retry logic.
+ */
+void futex_q_lockptr_lock(struct futex_q *q)
+{
+	spinlock_t *lock_ptr;
+
+	rcu_read_lock();
+retry:
+	lock_ptr = READ_ONCE(q->lock_ptr);
+	spin_lock(lock_ptr);
+
+	if (unlikely(lock_ptr != q->lock_ptr)) {
+		spin_unlock(lock_ptr);
+		goto retry;
+	}
+	rcu_read_unlock();
+}
+
 /*
  * PI futexes can not be requeued and must remove themselves from the
  * hash bucket. The hash bucket lock (i.e. lock_ptr) is held.
@@ -957,7 +1380,6 @@ static void exit_pi_state_list(struct task_struct *curr)
 		next = head->next;
 		pi_state = list_entry(next, struct futex_pi_state, list);
 		key = pi_state->key;
-		hb = futex_hash(&key);
 
 		/*
 		 * We can race against put_pi_state() removing itself from the
@@ -977,7 +1399,17 @@ static void exit_pi_state_list(struct task_struct *curr)
 		}
 		raw_spin_unlock_irq(&curr->pi_lock);
 
+		rcu_read_lock();
+		hb = futex_hash(&key);
 		spin_lock(&hb->lock);
+		rcu_read_unlock();
+		if (unlikely(!futex_hash_valid(&key, hb))) {
+			spin_unlock(&hb->lock);
+			put_pi_state(pi_state);
+			futex_hash_wait(&key);
+			raw_spin_lock_irq(&curr->pi_lock);
+			continue;
+		}
 		raw_spin_lock_irq(&pi_state->pi_mutex.wait_lock);
 		raw_spin_lock(&curr->pi_lock);
 		/*
@@ -1142,6 +1574,7 @@ static int __init futex_init(void)
 		atomic_set(&futex_queues[i].waiters, 0);
 		plist_head_init(&futex_queues[i].chain);
 		spin_lock_init(&futex_queues[i].lock);
+		futex_queues[i].priv = NULL;
 	}
 
 	return 0;
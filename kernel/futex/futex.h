@@ -46,6 +46,7 @@ struct futex_hash_bucket {
 	atomic_t waiters;
 	spinlock_t lock;
 	struct plist_head chain;
+	struct futex_private_hash *priv;
 } ____cacheline_aligned_in_smp;
 
 /*
@@ -125,6 +126,33 @@ futex_setup_timer(ktime_t *time, struct hrtimer_sleeper *timeout,
 
 extern struct futex_hash_bucket *futex_hash(union futex_key *key);
 
+#ifdef CONFIG_FUTEX_PRIVATE_HASH
+extern bool futex_hash_ready(union futex_key *key, struct futex_hash_bucket *hb);
+extern bool futex_hash_valid(union futex_key *key, struct futex_hash_bucket *hb);
+extern void futex_hash_wait(union futex_key *key);
+#else
+static inline bool futex_hash_ready(union futex_key *key,
+				    struct futex_hash_bucket *hb)
+{
+	return true;
+}
+static inline bool futex_hash_valid(union futex_key *key,
+				    struct futex_hash_bucket *hb)
+{
+	return true;
+}
+static inline void futex_hash_wait(union futex_key *key) { }
+#endif
+
+/*
+ * Private futexes have no reference on an inode or mm and are only ever
+ * used by the threads of key->private.mm.
+ */
+static inline bool futex_key_is_private(union futex_key *key)
+{
+	return !(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED));
+}
+
 /**
  * futex_match - Check whether two futex keys are equal
  * @key1:	Pointer to key1
@@ -154,6 +182,7 @@ extern struct futex_q *futex_top_waiter(struct futex_hash_bucket *hb, union fute
 extern void __futex_unqueue(struct futex_q *q);
 extern void __futex_queue(struct futex_q *q, struct futex_hash_bucket *hb);
 extern int futex_unqueue(struct futex_q *q);
+extern void futex_q_lockptr_lock(struct futex_q *q);
 
 /**
  * futex_queue() - Enqueue the futex_q on the futex_hash_bucket
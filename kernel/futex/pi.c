@@ -818,7 +818,7 @@ static int __fixup_pi_state_owner(u32 __user *uaddr, struct futex_q *q,
 		break;
 	}
 
-	spin_lock(q->lock_ptr);
+	futex_q_lockptr_lock(q);
 	raw_spin_lock_irq(&pi_state->pi_mutex.wait_lock);
 
 	/*
@@ -1039,7 +1039,7 @@ int futex_lock_pi(u32 __user *uaddr, unsigned int flags, ktime_t *time, int tryl
 	ret = rt_mutex_wait_proxy_lock(&q.pi_state->pi_mutex, to, &rt_waiter);
 
 cleanup:
-	spin_lock(q.lock_ptr);
+	futex_q_lockptr_lock(&q);
 	/*
 	 * If we failed to acquire the lock (deadlock/signal/timeout), we must
 	 * first acquire the hb->lock before removing the lock from the
@@ -1121,8 +1121,15 @@ int futex_unlock_pi(u32 __user *uaddr, unsigned int flags)
 	if (ret)
 		return ret;
 
+	rcu_read_lock();
 	hb = futex_hash(&key);
 	spin_lock(&hb->lock);
+	rcu_read_unlock();
+	if (unlikely(!futex_hash_valid(&key, hb))) {
+		spin_unlock(&hb->lock);
+		futex_hash_wait(&key);
+		goto retry;
+	}
 
 	/*
 	 * Check waiters first. We do not trust user space values at
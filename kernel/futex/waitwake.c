@@ -155,13 +155,27 @@ int futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 	if (unlikely(ret != 0))
 		return ret;
 
+retry:
+	rcu_read_lock();
 	hb = futex_hash(&key);
 
-	/* Make sure we really have tasks to wakeup */
-	if (!futex_hb_waiters_pending(hb))
+	/*
+	 * Make sure we really have tasks to wakeup. The waiter count of a
+	 * private hash is only meaningful once the waiters of the previous
+	 * one have been moved over, take the slow path until then.
+	 */
+	if (futex_hash_ready(&key, hb) && !futex_hb_waiters_pending(hb)) {
+		rcu_read_unlock();
 		return ret;
+	}
 
 	spin_lock(&hb->lock);
+	rcu_read_unlock();
+	if (unlikely(!futex_hash_valid(&key, hb))) {
+		spin_unlock(&hb->lock);
+		futex_hash_wait(&key);
+		goto retry;
+	}
 
 	plist_for_each_entry_safe(this, next, &hb->chain, list) {
 		if (futex_match (&this->key, &key)) {
@@ -252,11 +266,19 @@ int futex_wake_op(u32 __user *uaddr1, unsigned int flags, u32 __user *uaddr2,
 	if (unlikely(ret != 0))
 		return ret;
 
+retry_private:
+	rcu_read_lock();
 	hb1 = futex_hash(&key1);
 	hb2 = futex_hash(&key2);
-
-retry_private:
 	double_lock_hb(hb1, hb2);
+	rcu_read_unlock();
+	if (unlikely(!futex_hash_valid(&key1, hb1) ||
+		     !futex_hash_valid(&key2, hb2))) {
+		double_unlock_hb(hb1, hb2);
+		futex_hash_wait(&key1);
+		goto retry_private;
+	}
+
 	op_ret = futex_atomic_op_inuser(op, uaddr2);
 	if (unlikely(op_ret < 0)) {
 		double_unlock_hb(hb1, hb2);
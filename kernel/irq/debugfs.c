@@ -184,6 +184,9 @@ static int irq_debug_show(struct seq_file *m, void *p)
 	irq_debug_show_masks(m, desc);
 	irq_debug_show_data(m, data, 0);
 	raw_spin_unlock_irq(&desc->lock);
+#ifdef CONFIG_GENERIC_IRQ_STATS
+	irq_stats_show(m, desc);
+#endif
 	return 0;
 }
 
@@ -196,7 +199,7 @@ static ssize_t irq_debug_write(struct file *file, const char __user *user_buf,
 			       size_t count, loff_t *ppos)
 {
 	struct irq_desc *desc = file_inode(file)->i_private;
-	char buf[8] = { 0, };
+	char buf[24] = { 0, };
 	size_t size;
 
 	size = min(sizeof(buf) - 1, count);
@@ -209,6 +212,34 @@ static ssize_t irq_debug_write(struct file *file, const char __user *user_buf,
 		return err ? err : count;
 	}
 
+#ifdef CONFIG_GENERIC_IRQ_STATS
+	if (str_has_prefix(buf, "stats ")) {
+		char *arg = strim(buf + 6);
+		int err = 0;
+
+		if (!strcmp(arg, "on"))
+			err = irq_stats_enable(desc, true);
+		else if (!strcmp(arg, "off"))
+			err = irq_stats_enable(desc, false);
+		else if (!strcmp(arg, "reset"))
+			irq_stats_reset(desc);
+		else
+			err = -EINVAL;
+
+		return err ? err : count;
+	}
+
+	if (str_has_prefix(buf, "storm ")) {
+		unsigned int rate;
+
+		if (kstrtouint(strim(buf + 6), 0, &rate))
+			return -EINVAL;
+
+		irq_stats_set_storm_threshold(desc, rate);
+		return count;
+	}
+#endif
+
 	return count;
 }
 
@@ -133,6 +133,7 @@ void __irq_wake_thread(struct irq_desc *desc, struct irqaction *action)
 	 */
 	atomic_inc(&desc->threads_active);
 
+	irq_stats_note_wakeup(desc, action);
 	wake_up_process(action->thread);
 }
 
@@ -188,9 +189,11 @@ irqreturn_t __handle_irq_event_percpu(struct irq_desc *desc)
 
 irqreturn_t handle_irq_event_percpu(struct irq_desc *desc)
 {
+	u64 start = irq_stats_start(desc);
 	irqreturn_t retval;
 
 	retval = __handle_irq_event_percpu(desc);
+	irq_stats_account_handler(desc, start);
 
 	add_interrupt_randomness(desc->irq_data.irq);
 
@@ -395,6 +395,94 @@ static inline void record_irq_time(struct irq_desc *desc) {}
 #endif /* CONFIG_IRQ_TIMINGS */
 
 
+#ifdef CONFIG_GENERIC_IRQ_STATS
+
+#define IRQ_STATS_BUCKETS	32
+
+/**
+ * struct irq_duration_stats - duration statistics
+ * @count:	number of samples
+ * @total_ns:	sum of the samples
+ * @max_ns:	largest sample
+ * @hist:	log2 histogram of the samples
+ */
+struct irq_duration_stats {
+	u64	count;
+	u64	total_ns;
+	u64	max_ns;
+	u64	hist[IRQ_STATS_BUCKETS];
+};
+
+/**
+ * struct irq_handler_stats - per cpu interrupt handler statistics
+ * @handler:		hard interrupt handler execution time
+ * @thread_wakeup:	delay between waking a threaded handler and its start
+ * @window_start:	start of the current storm detection window
+ * @window_count:	number of interrupts in the current window
+ * @storms:		number of storms detected
+ */
+struct irq_handler_stats {
+	struct irq_duration_stats	handler;
+	struct irq_duration_stats	thread_wakeup;
+	u64				window_start;
+	unsigned int			window_count;
+	unsigned long			storms;
+};
+
+struct seq_file;
+
+DECLARE_STATIC_KEY_FALSE(irq_handler_stats_key);
+
+void __irq_stats_account_handler(struct irq_desc *desc, u64 start);
+void __irq_stats_account_thread(struct irq_desc *desc, struct irqaction *action);
+int irq_stats_enable(struct irq_desc *desc, bool on);
+void irq_stats_reset(struct irq_desc *desc);
+void irq_stats_set_storm_threshold(struct irq_desc *desc, unsigned int rate);
+void irq_stats_free(struct irq_desc *desc);
+void irq_stats_show(struct seq_file *m, struct irq_desc *desc);
+
+/* Pairs with the release in irq_stats_enable(), which publishes the stats */
+static __always_inline bool irq_stats_on(struct irq_desc *desc)
+{
+	return static_branch_unlikely(&irq_handler_stats_key) &&
+	       smp_load_acquire(&desc->handler_stats_on);
+}
+
+static inline u64 irq_stats_start(struct irq_desc *desc)
+{
+	return irq_stats_on(desc) ? local_clock() : 0;
+}
+
+static inline void irq_stats_account_handler(struct irq_desc *desc, u64 start)
+{
+	if (start)
+		__irq_stats_account_handler(desc, start);
+}
+
+static inline void irq_stats_note_wakeup(struct irq_desc *desc,
+					 struct irqaction *action)
+{
+	if (irq_stats_on(desc))
+		WRITE_ONCE(action->wake_time, local_clock());
+}
+
+static inline void irq_stats_account_thread(struct irq_desc *desc,
+					    struct irqaction *action)
+{
+	if (irq_stats_on(desc))
+		__irq_stats_account_thread(desc, action);
+}
+#else
+static inline u64 irq_stats_start(struct irq_desc *desc) { return 0; }
+static inline void irq_stats_account_handler(struct irq_desc *desc, u64 start) { }
+static inline void irq_stats_note_wakeup(struct irq_desc *desc,
+					 struct irqaction *action) { }
+static inline void irq_stats_account_thread(struct irq_desc *desc,
+					    struct irqaction *action) { }
+static inline int irq_stats_enable(struct irq_desc *desc, bool on) { return 0; }
+static inline void irq_stats_free(struct irq_desc *desc) { }
+#endif /* CONFIG_GENERIC_IRQ_STATS */
+
 #ifdef CONFIG_GENERIC_IRQ_CHIP
 void irq_init_generic_chip(struct irq_chip_generic *gc, const char *name,
 			   int num_ct, unsigned int irq_base,
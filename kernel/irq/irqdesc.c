@@ -431,6 +431,7 @@ static void irq_kobj_release(struct kobject *kobj)
 
 	free_masks(desc);
 	free_percpu(desc->kstat_irqs);
+	irq_stats_free(desc);
 	kfree(desc);
 }
 
@@ -446,6 +447,7 @@ static void free_desc(unsigned int irq)
 	struct irq_desc *desc = irq_to_desc(irq);
 
 	irq_remove_debugfs_entry(desc);
+	irq_stats_enable(desc, false);
 	unregister_irq_proc(irq, desc);
 
 	/*
@@ -599,6 +601,8 @@ static void free_desc(unsigned int irq)
 	raw_spin_lock_irqsave(&desc->lock, flags);
 	desc_set_defaults(irq, desc, irq_desc_get_node(desc), NULL, NULL);
 	raw_spin_unlock_irqrestore(&desc->lock, flags);
+	irq_stats_enable(desc, false);
+	irq_stats_free(desc);
 }
 
 static inline int alloc_descs(unsigned int start, unsigned int cnt, int node,
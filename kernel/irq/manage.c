@@ -1313,6 +1313,7 @@ static int irq_thread(void *data)
 		irqreturn_t action_ret;
 
 		irq_thread_check_affinity(desc, action);
+		irq_stats_account_thread(desc, action);
 
 		action_ret = handler_fn(desc, action);
 		if (action_ret == IRQ_WAKE_THREAD)
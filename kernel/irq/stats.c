@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Per interrupt handler statistics
+ *
+ * Opt-in accounting, enabled per interrupt through the irq debugfs file,
+ * of the hard interrupt handler execution time and of the wakeup latency
+ * of the threaded handlers, plus interrupt storm detection.
+ */
+#include <linux/irq.h>
+#include <linux/interrupt.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+
+#include <trace/events/irq.h>
+
+#include "internals.h"
+
+/* Interrupt rate is sampled over windows of 100ms */
+#define IRQ_STORM_WINDOW_NS	(100 * NSEC_PER_MSEC)
+#define IRQ_STORM_WINDOWS	(NSEC_PER_SEC / IRQ_STORM_WINDOW_NS)
+
+DEFINE_STATIC_KEY_FALSE(irq_handler_stats_key);
+
+static DEFINE_MUTEX(irq_stats_mutex);
+
+static void irq_duration_add(struct irq_duration_stats *s, u64 delta)
+{
+	unsigned int bucket = delta ? min_t(unsigned int, ilog2(delta),
+					    IRQ_STATS_BUCKETS - 1) : 0;
+
+	s->count++;
+	s->total_ns += delta;
+	if (delta > s->max_ns)
+		s->max_ns = delta;
+	s->hist[bucket]++;
+}
+
+static void irq_storm_check(struct irq_desc *desc, struct irq_handler_stats *s,
+			    u64 now)
+{
+	unsigned int threshold = READ_ONCE(desc->storm_threshold);
+
+	if (!threshold)
+		return;
+
+	if (now - s->window_start >= IRQ_STORM_WINDOW_NS) {
+		s->window_start = now;
+		s->window_count = 0;
+	}
+
+	/* Report once per window, when the rate goes past the threshold */
+	if (s->window_count++ * IRQ_STORM_WINDOWS <= threshold &&
+	    s->window_count * IRQ_STORM_WINDOWS > threshold) {
+		s->storms++;
+		trace_irq_storm(irq_desc_get_irq(desc), threshold);
+	}
+}
+
+/* Called from hard interrupt context with interrupts disabled */
+void __irq_stats_account_handler(struct irq_desc *desc, u64 start)
+{
+	struct irq_handler_stats *s = this_cpu_ptr(desc->handler_stats);
+	u64 now = local_clock();
+
+	irq_duration_add(&s->handler, now - start);
+	irq_storm_check(desc, s, now);
+}
+
+void __irq_stats_account_thread(struct irq_desc *desc, struct irqaction *action)
+{
+	u64 wake_time = xchg(&action->wake_time, 0);
+	struct irq_handler_stats *s;
+
+	if (!wake_time)
+		return;
+
+	/* Keep the hard interrupt handler off the thread fields */
+	s = get_cpu_ptr(desc->handler_stats);
+	irq_duration_add(&s->thread_wakeup, local_clock() - wake_time);
+	put_cpu_ptr(desc->handler_stats);
+}
+
+/*
+ * Forget the wakeups noted while the stats were on, so that they are not
+ * accounted as a huge latency once the stats are turned on again.
+ */
+static void irq_stats_clear_wakeups(struct irq_desc *desc)
+{
+	struct irqaction *action;
+
+	if (!desc->action)
+		return;
+
+	/* Let the handlers which still saw the stats on note their wakeup */
+	synchronize_hardirq(irq_desc_get_irq(desc));
+
+	raw_spin_lock_irq(&desc->lock);
+	for_each_action_of_desc(desc, action) {
+		WRITE_ONCE(action->wake_time, 0);
+		if (action->secondary)
+			WRITE_ONCE(action->secondary->wake_time, 0);
+	}
+	raw_spin_unlock_irq(&desc->lock);
+}
+
+int irq_stats_enable(struct irq_desc *desc, bool on)
+{
+	struct irq_handler_stats __percpu *stats;
+	int ret = 0;
+
+	mutex_lock(&irq_stats_mutex);
+	if (on == desc->handler_stats_on)
+		goto out;
+
+	if (on && !desc->handler_stats) {
+		stats = alloc_percpu(struct irq_handler_stats);
+		if (!stats) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		desc->handler_stats = stats;
+	}
+
+	/*
+	 * The release orders the allocation of the stats before the handlers
+	 * see them on. The stats buffer stays around until the descriptor is
+	 * freed, so a handler which still sees the old state is harmless.
+	 */
+	smp_store_release(&desc->handler_stats_on, on);
+	if (on) {
+		static_branch_inc(&irq_handler_stats_key);
+	} else {
+		static_branch_dec(&irq_handler_stats_key);
+		irq_stats_clear_wakeups(desc);
+	}
+out:
+	mutex_unlock(&irq_stats_mutex);
+	return ret;
+}
+
+void irq_stats_reset(struct irq_desc *desc)
+{
+	int cpu;
+
+	mutex_lock(&irq_stats_mutex);
+	if (desc->handler_stats) {
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(desc->handler_stats, cpu), 0,
+			       sizeof(struct irq_handler_stats));
+	}
+	mutex_unlock(&irq_stats_mutex);
+}
+
+void irq_stats_set_storm_threshold(struct irq_desc *desc, unsigned int rate)
+{
+	WRITE_ONCE(desc->storm_threshold, rate);
+}
+
+/* Called once the descriptor is unused, with irq_stats_enable(@desc, false) */
+void irq_stats_free(struct irq_desc *desc)
+{
+	free_percpu(desc->handler_stats);
+	desc->handler_stats = NULL;
+	desc->storm_threshold = 0;
+}
+
+static void irq_duration_show(struct seq_file *m, const char *name,
+			      struct irq_duration_stats *s)
+{
+	int i, last = -1;
+
+	for (i = 0; i < IRQ_STATS_BUCKETS; i++)
+		if (s->hist[i])
+			last = i;
+
+	seq_printf(m, "%s:\n", name);
+	seq_printf(m, "    count:    %llu\n", s->count);
+	seq_printf(m, "    total_ns: %llu\n", s->total_ns);
+	seq_printf(m, "    max_ns:   %llu\n", s->max_ns);
+	/* one "<bucket lower bound in ns> <count>" line per log2 bucket */
+	for (i = 0; i <= last; i++)
+		seq_printf(m, "    %12llu %llu\n", i ? 1ULL << i : 0ULL,
+			   s->hist[i]);
+}
+
+static void irq_duration_sum(struct irq_duration_stats *sum,
+			     struct irq_duration_stats *s)
+{
+	int i;
+
+	sum->count += s->count;
+	sum->total_ns += s->total_ns;
+	sum->max_ns = max(sum->max_ns, s->max_ns);
+	for (i = 0; i < IRQ_STATS_BUCKETS; i++)
+		sum->hist[i] += s->hist[i];
+}
+
+void irq_stats_show(struct seq_file *m, struct irq_desc *desc)
+{
+	struct irq_duration_stats handler = { }, wakeup = { };
+	unsigned long storms = 0;
+	int cpu;
+
+	seq_printf(m, "hstats:   %s\n",
+		   READ_ONCE(desc->handler_stats_on) ? "on" : "off");
+	seq_printf(m, "storm:    %u/s\n", desc->storm_threshold);
+	if (!desc->handler_stats)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct irq_handler_stats *s = per_cpu_ptr(desc->handler_stats, cpu);
+
+		irq_duration_sum(&handler, &s->handler);
+		irq_duration_sum(&wakeup, &s->thread_wakeup);
+		storms += s->storms;
+	}
+
+	seq_printf(m, "storms:   %lu\n", storms);
+	irq_duration_show(m, "handler", &handler);
+	irq_duration_show(m, "thread wakeup", &wakeup);
+}
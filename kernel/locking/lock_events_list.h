@@ -35,6 +35,16 @@ LOCK_EVENT(pv_wait_head)	/* # of vCPU wait's at the queue head	   */
 LOCK_EVENT(pv_wait_node)	/* # of vCPU wait's at non-head queue node */
 #endif /* CONFIG_PARAVIRT_SPINLOCKS */
 
+#ifdef CONFIG_NUMA_AWARE_SPINLOCKS
+/*
+ * Locking events for NUMA-aware qspinlock.
+ */
+LOCK_EVENT(cna_local_handoff)	/* # of handoffs within the holder's node  */
+LOCK_EVENT(cna_remote_handoff)	/* # of handoffs to another node	   */
+LOCK_EVENT(cna_reorder)		/* # of waiter runs moved to the 2nd queue */
+LOCK_EVENT(cna_flush)		/* # of 2nd queue flushes for fairness	   */
+#endif /* CONFIG_NUMA_AWARE_SPINLOCKS */
+
 /*
  * Locking events for qspinlock
  *
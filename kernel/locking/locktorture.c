@@ -29,6 +29,7 @@
 #include <linux/slab.h>
 #include <linux/torture.h>
 #include <linux/reboot.h>
+#include <linux/topology.h>
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Paul E. McKenney <paulmck@linux.ibm.com>");
@@ -64,10 +65,13 @@ static struct task_struct **reader_tasks;
 static bool lock_is_write_held;
 static atomic_t lock_is_read_held;
 static unsigned long last_lock_release;
+static int last_lock_node = NUMA_NO_NODE;
 
 struct lock_stress_stats {
 	long n_lock_fail;
 	long n_lock_acquired;
+	long n_lock_local_handoff;	/* previous writer on the same node */
+	long n_lock_remote_handoff;	/* previous writer on another node */
 };
 
 /* Forward reference. */
@@ -100,10 +104,11 @@ struct lock_torture_cxt {
 	struct lock_torture_ops *cur_ops;
 	struct lock_stress_stats *lwsa; /* writer statistics */
 	struct lock_stress_stats *lrsa; /* reader statistics */
+	long *lnsa; /* per-NUMA-node writer acquisitions */
 };
 static struct lock_torture_cxt cxt = { 0, 0, false, false,
 				       ATOMIC_INIT(0),
-				       NULL, NULL};
+				       NULL, NULL, NULL};
 /*
  * Definitions for lock torture testing.
  */
@@ -683,6 +688,7 @@ static int lock_torture_writer(void *arg)
 {
 	struct lock_stress_stats *lwsp = arg;
 	int tid = lwsp - cxt.lwsa;
+	int node;
 	DEFINE_TORTURE_RANDOM(rand);
 
 	VERBOSE_TOROUT_STRING("lock_torture_writer task started");
@@ -701,6 +707,19 @@ static int lock_torture_writer(void *arg)
 			lwsp->n_lock_fail++; /* rare, but... */
 
 		lwsp->n_lock_acquired++;
+
+		/* Record which node the lock was handed over from and to. */
+		node = numa_node_id();
+		if (last_lock_node != NUMA_NO_NODE) {
+			if (last_lock_node == node)
+				lwsp->n_lock_local_handoff++;
+			else
+				lwsp->n_lock_remote_handoff++;
+		}
+		last_lock_node = node;
+		if (cxt.lnsa)
+			cxt.lnsa[node]++;
+
 		cxt.cur_ops->write_delay(&rand);
 		lock_is_write_held = false;
 		WRITE_ONCE(last_lock_release, jiffies);
@@ -757,7 +776,7 @@ static void __torture_print_stats(char *page,
 	bool fail = false;
 	int i, n_stress;
 	long max = 0, min = statp ? data_race(statp[0].n_lock_acquired) : 0;
-	long long sum = 0;
+	long long sum = 0, local = 0, remote = 0;
 
 	n_stress = write ? cxt.nrealwriters_stress : cxt.nrealreaders_stress;
 	for (i = 0; i < n_stress; i++) {
@@ -769,6 +788,8 @@ static void __torture_print_stats(char *page,
 			max = cur;
 		if (min > cur)
 			min = cur;
+		local += data_race(statp[i].n_lock_local_handoff);
+		remote += data_race(statp[i].n_lock_remote_handoff);
 	}
 	page += sprintf(page,
 			"%s:  Total: %lld  Max/Min: %ld/%ld %s  Fail: %d %s\n",
@@ -776,6 +797,13 @@ static void __torture_print_stats(char *page,
 			sum, max, min,
 			!onoff_interval && max / 2 > min ? "???" : "",
 			fail, fail ? "!!!" : "");
+	if (write && nr_node_ids > 1) {
+		page += sprintf(page, "Handoffs:  Local: %lld  Remote: %lld  Per-node:",
+				local, remote);
+		for (i = 0; cxt.lnsa && i < nr_node_ids; i++)
+			page += sprintf(page, " %d:%ld", i, data_race(cxt.lnsa[i]));
+		page += sprintf(page, "\n");
+	}
 	if (fail)
 		atomic_inc(&cxt.n_lock_torture_errors);
 }
@@ -790,7 +818,7 @@ static void __torture_print_stats(char *page,
  */
 static void lock_torture_stats_print(void)
 {
-	int size = cxt.nrealwriters_stress * 200 + 8192;
+	int size = cxt.nrealwriters_stress * 200 + nr_node_ids * 24 + 8192;
 	char *buf;
 
 	if (cxt.cur_ops->readlock)
@@ -902,6 +930,8 @@ static void lock_torture_cleanup(void)
 	cxt.lwsa = NULL;
 	kfree(cxt.lrsa);
 	cxt.lrsa = NULL;
+	kfree(cxt.lnsa);
+	cxt.lnsa = NULL;
 
 end:
 	if (cxt.init_called) {
@@ -995,7 +1025,13 @@ static int __init lock_torture_init(void)
 		for (i = 0; i < cxt.nrealwriters_stress; i++) {
 			cxt.lwsa[i].n_lock_fail = 0;
 			cxt.lwsa[i].n_lock_acquired = 0;
+			cxt.lwsa[i].n_lock_local_handoff = 0;
+			cxt.lwsa[i].n_lock_remote_handoff = 0;
 		}
+
+		/* Not fatal: only the per-node breakdown goes missing. */
+		cxt.lnsa = kcalloc(nr_node_ids, sizeof(*cxt.lnsa), GFP_KERNEL);
+		last_lock_node = NUMA_NO_NODE;
 	}
 
 	if (cxt.cur_ops->readlock) {
@@ -1027,6 +1063,8 @@ static int __init lock_torture_init(void)
 			for (i = 0; i < cxt.nrealreaders_stress; i++) {
 				cxt.lrsa[i].n_lock_fail = 0;
 				cxt.lrsa[i].n_lock_acquired = 0;
+				cxt.lrsa[i].n_lock_local_handoff = 0;
+				cxt.lrsa[i].n_lock_remote_handoff = 0;
 			}
 		}
 	}
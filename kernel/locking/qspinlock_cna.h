@@ -0,0 +1,271 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _GEN_CNA_LOCK_SLOWPATH
+#error "do not include this file"
+#endif
+
+#include <linux/topology.h>
+#include <linux/sched/clock.h>
+
+/*
+ * Implement a NUMA-aware version of MCS (aka CNA, or compact NUMA-aware lock).
+ *
+ * In CNA, spinning threads are organized in two queues, a primary queue for
+ * threads running on the same NUMA node as the current lock holder, and a
+ * secondary queue for threads running on other nodes. Schematically, it
+ * looks like this:
+ *
+ *    cna_node
+ *   +----------+     +--------+         +--------+
+ *   |mcs:next  | --> |mcs:next| --> ... |mcs:next| --> NULL  [Primary queue]
+ *   |mcs:locked| -.  +--------+         +--------+
+ *   +----------+  |
+ *                 `----------------------.
+ *                                        v
+ *                 +--------+         +--------+
+ *                 |mcs:next| --> ... |mcs:next|            [Secondary queue]
+ *                 +--------+         +--------+
+ *                     ^                    |
+ *                     `--------------------'
+ *
+ * N.B. locked := 1 if secondary queue is absent. Otherwise, it contains the
+ * encoded pointer to the tail of the secondary queue, which is organized as a
+ * circular list.
+ *
+ * After acquiring the MCS lock and before acquiring the spinlock, the MCS
+ * lock holder checks whether the next waiter in the primary queue (if
+ * exists) is running on the same NUMA node. If it is not, that waiter is
+ * detached from the main queue and moved into the tail of the secondary
+ * queue. This way, we gradually filter the primary queue, leaving only
+ * waiters running on the same preferred NUMA node.
+ *
+ * For details, see https://arxiv.org/abs/1810.05600.
+ *
+ * Waiters that are not in task context (softirq, hardirq, NMI) are never
+ * moved to the secondary queue, and the secondary queue is flushed back into
+ * the primary one once its head has been waiting for longer than
+ * numa_spinlock_threshold nanoseconds, which bounds the unfairness.
+ */
+
+#define CNA_PRIORITY_NODE	0xffff
+
+struct cna_node {
+	struct mcs_spinlock	mcs;
+	u16			numa_node;	/* or CNA_PRIORITY_NODE */
+	u16			real_numa_node;
+	u32			encoded_tail;	/* self */
+	u64			start_time;	/* head of the secondary queue */
+};
+
+/* Default to 1ms, see the numa_spinlock_threshold boot parameter */
+static u64 cna_threshold_ns __ro_after_init = NSEC_PER_MSEC;
+
+static void __init cna_init_nodes_per_cpu(unsigned int cpu)
+{
+	struct mcs_spinlock *base = per_cpu_ptr(&qnodes[0].mcs, cpu);
+	int numa_node = cpu_to_node(cpu);
+	int i;
+
+	for (i = 0; i < MAX_NODES; i++) {
+		struct cna_node *cn = (struct cna_node *)grab_mcs_node(base, i);
+
+		cn->real_numa_node = numa_node;
+		cn->encoded_tail = encode_tail(cpu, i);
+		/*
+		 * make sure @encoded_tail is not confused with other valid
+		 * values for @locked (0 or 1)
+		 */
+		WARN_ON(cn->encoded_tail <= 1);
+	}
+}
+
+static __always_inline void cna_init_node(struct mcs_spinlock *node)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+
+	cn->numa_node = in_task() ? cn->real_numa_node : CNA_PRIORITY_NODE;
+}
+
+static __always_inline struct cna_node *cna_decode_tail(u32 tail)
+{
+	return (struct cna_node *)decode_tail(tail);
+}
+
+/*
+ * Called by the MCS lock holder when it is the last waiter in the primary
+ * queue. With a non-empty secondary queue, the secondary queue becomes the
+ * primary one instead of clearing the tail.
+ */
+static __always_inline bool cna_try_clear_tail(struct qspinlock *lock, u32 val,
+					       struct mcs_spinlock *node)
+{
+	struct cna_node *tail_2nd, *head_2nd;
+	u32 new;
+
+	if (node->locked <= 1)
+		return __try_clear_tail(lock, val, node);
+
+	tail_2nd = cna_decode_tail(node->locked);
+	head_2nd = (struct cna_node *)READ_ONCE(tail_2nd->mcs.next);
+
+	new = tail_2nd->encoded_tail | _Q_LOCKED_VAL;
+	if (!atomic_try_cmpxchg_relaxed(&lock->val, &val, new))
+		return false;
+
+	/*
+	 * The secondary queue is now the primary one. Break the circular list,
+	 * unless a new waiter has already queued behind its tail.
+	 */
+	cmpxchg_relaxed(&tail_2nd->mcs.next, &head_2nd->mcs, NULL);
+
+	lockevent_inc(cna_flush);
+	arch_mcs_pass_lock(&head_2nd->mcs.locked, 1);
+	return true;
+}
+
+/*
+ * Splice the secondary queue in front of @next and pass the MCS lock to its
+ * head.
+ */
+static __always_inline void cna_flush_secondary(struct mcs_spinlock *node,
+						struct mcs_spinlock *next)
+{
+	struct cna_node *tail_2nd = cna_decode_tail(node->locked);
+	struct mcs_spinlock *head_2nd = tail_2nd->mcs.next;
+
+	tail_2nd->mcs.next = next;
+	lockevent_inc(cna_flush);
+	arch_mcs_pass_lock(&head_2nd->locked, 1);
+}
+
+/*
+ * Look for a waiter on the lock holder's node (or a priority waiter) in the
+ * primary queue, starting at @next. The remote waiters found in front of it
+ * are moved to the tail of the secondary queue, and the MCS lock is passed to
+ * that waiter along with the secondary queue. Without such a waiter, or when
+ * the secondary queue has waited for too long, the secondary queue is flushed
+ * back into the primary one.
+ */
+static __always_inline void cna_pass_lock(struct mcs_spinlock *node,
+					  struct mcs_spinlock *next)
+{
+	struct cna_node *cn = (struct cna_node *)node;
+	struct cna_node *first = (struct cna_node *)next;
+	struct cna_node *last = NULL, *cur = first;
+	u32 val = node->locked;
+
+	if (val > 1) {
+		struct cna_node *head_2nd =
+			(struct cna_node *)cna_decode_tail(val)->mcs.next;
+
+		if (local_clock() - head_2nd->start_time > cna_threshold_ns) {
+			cna_flush_secondary(node, next);
+			return;
+		}
+	}
+
+	/* Only follow links that are already in place */
+	while (cur->numa_node != cn->real_numa_node &&
+	       cur->numa_node != CNA_PRIORITY_NODE) {
+		struct cna_node *n = (struct cna_node *)READ_ONCE(cur->mcs.next);
+
+		if (!n) {
+			cur = NULL;
+			break;
+		}
+		last = cur;
+		cur = n;
+	}
+
+	if (!cur) {
+		/* Nothing local in sight */
+		if (val > 1) {
+			cna_flush_secondary(node, next);
+		} else {
+			lockevent_inc(cna_remote_handoff);
+			arch_mcs_spin_unlock_contended(&next->locked);
+		}
+		return;
+	}
+
+	if (last) {
+		/* Move first...last to the tail of the secondary queue */
+		if (val > 1) {
+			struct cna_node *tail_2nd = cna_decode_tail(val);
+
+			last->mcs.next = tail_2nd->mcs.next;
+			tail_2nd->mcs.next = &first->mcs;
+		} else {
+			last->mcs.next = &first->mcs;
+			first->start_time = local_clock();
+		}
+		val = last->encoded_tail;
+		lockevent_inc(cna_reorder);
+	}
+
+	lockevent_inc(cna_local_handoff);
+	arch_mcs_pass_lock(&cur->mcs.locked, val);
+}
+
+#define pv_init_node		cna_init_node
+#define try_clear_tail		cna_try_clear_tail
+#define mcs_pass_lock		cna_pass_lock
+
+/*
+ * numa_spinlock=on|off|auto: use the NUMA-aware slowpath always, never, or
+ * only when there is more than one possible NUMA node (default).
+ */
+static int numa_spinlock_flag __initdata;
+
+static int __init numa_spinlock_setup(char *str)
+{
+	if (!str)
+		return -EINVAL;
+
+	if (!strcmp(str, "auto"))
+		numa_spinlock_flag = 0;
+	else if (!strcmp(str, "on"))
+		numa_spinlock_flag = 1;
+	else if (!strcmp(str, "off"))
+		numa_spinlock_flag = -1;
+	else
+		return -EINVAL;
+
+	return 0;
+}
+early_param("numa_spinlock", numa_spinlock_setup);
+
+static int __init numa_spinlock_threshold_setup(char *str)
+{
+	u64 threshold;
+
+	if (!str || kstrtoull(str, 0, &threshold))
+		return -EINVAL;
+
+	cna_threshold_ns = threshold;
+	return 0;
+}
+early_param("numa_spinlock_threshold", numa_spinlock_threshold_setup);
+
+/*
+ * Switch the slowpath before the secondary CPUs are brought up, so that no
+ * lock is ever queued on by both the native and the NUMA-aware code: a native
+ * waiter handed a secondary queue would drop it on the floor.
+ */
+static int __init cna_init(void)
+{
+	unsigned int cpu;
+
+	BUILD_BUG_ON(sizeof(struct cna_node) > sizeof(struct qnode));
+
+	if (numa_spinlock_flag < 0 ||
+	    (!numa_spinlock_flag && num_possible_nodes() <= 1))
+		return 0;
+
+	for_each_possible_cpu(cpu)
+		cna_init_nodes_per_cpu(cpu);
+
+	static_branch_enable(&numa_spinlock_key);
+	pr_info("Enabling CNA spinlock, threshold %llu ns\n", cna_threshold_ns);
+	return 0;
+}
+early_initcall(cna_init);
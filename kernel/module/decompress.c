@@ -201,9 +201,176 @@ static ssize_t module_xz_decompress(struct load_info *info,
 }
 #elif defined(CONFIG_MODULE_COMPRESS_ZSTD)
 #include <linux/zstd.h>
+#include <linux/workqueue.h>
+#include <linux/cpumask.h>
 #define MODULE_COMPRESSION	zstd
 #define MODULE_DECOMPRESS_FN	module_zstd_decompress
 
+/*
+ * A module compressed as several independent zstd frames, each recording its
+ * decompressed size, is decompressed by a handful of workers in parallel,
+ * straight into a temporary mapping of the final pages.
+ */
+#define MODULE_ZSTD_MAX_WORKERS	8
+
+struct module_zstd_frame {
+	const void *src;
+	size_t src_len;
+	size_t dst_off;
+	size_t dst_len;
+};
+
+struct module_zstd_ctx {
+	struct module_zstd_frame *frames;
+	unsigned int nr_frames;
+	atomic_t next;		/* next frame to decompress */
+	atomic_t error;
+	void *dst;
+};
+
+struct module_zstd_worker {
+	struct work_struct work;
+	struct module_zstd_ctx *ctx;
+};
+
+/*
+ * Returns the number of data frames, or 0 if they can't be decompressed
+ * apart from each other. Fills in @frames if it is not NULL.
+ */
+static unsigned int module_zstd_scan(const void *buf, size_t size,
+				     struct module_zstd_frame *frames,
+				     size_t *total)
+{
+	zstd_frame_header header;
+	unsigned int nr = 0;
+	size_t len;
+
+	*total = 0;
+	while (size) {
+		if (zstd_get_frame_header(&header, buf, size))
+			return 0;
+		len = zstd_find_frame_compressed_size(buf, size);
+		if (zstd_is_error(len))
+			return 0;
+
+		if (header.frameType != ZSTD_skippableFrame) {
+			if (header.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+			    header.frameContentSize > INT_MAX - *total)
+				return 0;
+			if (frames) {
+				frames[nr].src = buf;
+				frames[nr].src_len = len;
+				frames[nr].dst_off = *total;
+				frames[nr].dst_len = header.frameContentSize;
+			}
+			*total += header.frameContentSize;
+			nr++;
+		}
+		buf += len;
+		size -= len;
+	}
+
+	return nr;
+}
+
+static void module_zstd_decompress_work(struct work_struct *work)
+{
+	struct module_zstd_ctx *ctx =
+		container_of(work, struct module_zstd_worker, work)->ctx;
+	size_t wksp_size = zstd_dctx_workspace_bound();
+	void *wksp = kvmalloc(wksp_size, GFP_KERNEL);
+	zstd_dctx *dctx;
+	unsigned int i;
+	size_t ret;
+
+	dctx = wksp ? zstd_init_dctx(wksp, wksp_size) : NULL;
+	if (!dctx) {
+		atomic_set(&ctx->error, -ENOMEM);
+		goto out;
+	}
+
+	while (!atomic_read(&ctx->error) &&
+	       (i = atomic_inc_return(&ctx->next) - 1) < ctx->nr_frames) {
+		struct module_zstd_frame *f = &ctx->frames[i];
+
+		ret = zstd_decompress_dctx(dctx, ctx->dst + f->dst_off,
+					   f->dst_len, f->src, f->src_len);
+		if (zstd_is_error(ret) || ret != f->dst_len) {
+			pr_err("ZSTD-decompression of frame %u failed\n", i);
+			atomic_set(&ctx->error, -EINVAL);
+		}
+	}
+out:
+	kvfree(wksp);
+}
+
+/*
+ * Returns the decompressed size, a negative error, or 0 if the data is not
+ * made of several independent frames and has to be streamed instead.
+ */
+static ssize_t module_zstd_decompress_frames(struct load_info *info,
+					     const void *buf, size_t size)
+{
+	struct module_zstd_worker *workers;
+	struct module_zstd_ctx ctx = { };
+	unsigned int nr_workers, i;
+	size_t total;
+	ssize_t retval;
+
+	ctx.nr_frames = module_zstd_scan(buf, size, NULL, &total);
+	if (ctx.nr_frames < 2 || num_online_cpus() < 2)
+		return 0;
+
+	ctx.frames = kvmalloc_array(ctx.nr_frames, sizeof(*ctx.frames),
+				    GFP_KERNEL);
+	if (!ctx.frames)
+		return -ENOMEM;
+	module_zstd_scan(buf, size, ctx.frames, &total);
+
+	for (i = 0; i < DIV_ROUND_UP(total, PAGE_SIZE); i++) {
+		struct page *page = module_get_next_page(info);
+
+		if (IS_ERR(page)) {
+			retval = PTR_ERR(page);
+			goto out_frames;
+		}
+	}
+
+	ctx.dst = vmap(info->pages, info->used_pages, VM_MAP, PAGE_KERNEL);
+	if (!ctx.dst) {
+		retval = -ENOMEM;
+		goto out_frames;
+	}
+
+	nr_workers = min3(num_online_cpus(), ctx.nr_frames,
+			  (unsigned int)MODULE_ZSTD_MAX_WORKERS);
+	workers = kcalloc(nr_workers, sizeof(*workers), GFP_KERNEL);
+	if (!workers) {
+		retval = -ENOMEM;
+		goto out_vunmap;
+	}
+
+	/* The caller is worker 0 */
+	for (i = 0; i < nr_workers; i++) {
+		INIT_WORK(&workers[i].work, module_zstd_decompress_work);
+		workers[i].ctx = &ctx;
+		if (i)
+			queue_work(system_unbound_wq, &workers[i].work);
+	}
+	module_zstd_decompress_work(&workers[0].work);
+	for (i = 1; i < nr_workers; i++)
+		flush_work(&workers[i].work);
+	kfree(workers);
+
+	retval = atomic_read(&ctx.error) ?: total;
+
+out_vunmap:
+	vunmap(ctx.dst);
+out_frames:
+	kvfree(ctx.frames);
+	return retval;
+}
+
 static ssize_t module_zstd_decompress(struct load_info *info,
 				    const void *buf, size_t size)
 {
@@ -224,6 +391,10 @@ static ssize_t module_zstd_decompress(struct load_info *info,
 		return -EINVAL;
 	}
 
+	retval = module_zstd_decompress_frames(info, buf, size);
+	if (retval)
+		return retval;
+
 	zstd_buf.src = buf;
 	zstd_buf.pos = 0;
 	zstd_buf.size = size;
@@ -257,7 +428,7 @@ static ssize_t module_zstd_decompress(struct load_info *info,
 	do {
 		struct page *page = module_get_next_page(info);
 
-		if (!IS_ERR(page)) {
+		if (IS_ERR(page)) {
 			retval = PTR_ERR(page);
 			goto out;
 		}
@@ -267,7 +438,7 @@ static ssize_t module_zstd_decompress(struct load_info *info,
 		zstd_dec.size = PAGE_SIZE;
 
 		ret = zstd_decompress_stream(dstream, &zstd_dec, &zstd_buf);
-		kunmap(page);
+		kunmap_local(zstd_dec.dst);
 		retval = zstd_get_error_code(ret);
 		if (retval)
 			break;
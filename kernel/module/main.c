@@ -55,6 +55,8 @@
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <linux/cfi.h>
+#include <linux/file.h>
+#include <linux/hash.h>
 #include <uapi/linux/module.h>
 #include "internal.h"
 
@@ -2937,26 +2939,93 @@ SYSCALL_DEFINE3(init_module, void __user *, umod,
 	return load_module(&info, uargs, 0);
 }
 
-SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
+/*
+ * Concurrent finit_module() calls for the same file, as udev issues them
+ * for every device instance on many CPUs at boot, are collapsed into one:
+ * the first caller reads, decompresses and loads the module, the others wait
+ * for it and return its result instead of each allocating a copy only to
+ * fail with -EEXIST.
+ */
+struct idempotent {
+	const void *cookie;
+	struct hlist_node entry;
+	struct completion complete;
+	int ret;
+};
+
+#define IDEM_HASH_BITS 8
+static struct hlist_head idem_hash[1 << IDEM_HASH_BITS];
+static DEFINE_SPINLOCK(idem_lock);
+
+/* Returns true if a load of @cookie was already in flight. */
+static bool idempotent(struct idempotent *u, const void *cookie)
+{
+	struct hlist_head *head = idem_hash + hash_ptr(cookie, IDEM_HASH_BITS);
+	struct idempotent *existing;
+	bool first = true;
+
+	u->ret = 0;
+	u->cookie = cookie;
+	init_completion(&u->complete);
+
+	spin_lock(&idem_lock);
+	hlist_for_each_entry(existing, head, entry) {
+		if (existing->cookie == cookie) {
+			first = false;
+			break;
+		}
+	}
+	hlist_add_head(&u->entry, head);
+	spin_unlock(&idem_lock);
+
+	return !first;
+}
+
+/* Hand @ret to everybody waiting on the same cookie, including @u. */
+static int idempotent_complete(struct idempotent *u, int ret)
+{
+	const void *cookie = u->cookie;
+	struct hlist_head *head = idem_hash + hash_ptr(cookie, IDEM_HASH_BITS);
+	struct hlist_node *next;
+	struct idempotent *pos;
+
+	spin_lock(&idem_lock);
+	hlist_for_each_entry_safe(pos, next, head, entry) {
+		if (pos->cookie != cookie)
+			continue;
+		hlist_del_init(&pos->entry);
+		pos->ret = ret;
+		complete(&pos->complete);
+	}
+	spin_unlock(&idem_lock);
+	return ret;
+}
+
+static int idempotent_wait_for_completion(struct idempotent *u)
+{
+	if (wait_for_completion_interruptible(&u->complete)) {
+		spin_lock(&idem_lock);
+		if (!hlist_unhashed(&u->entry)) {
+			hlist_del(&u->entry);
+			spin_unlock(&idem_lock);
+			return -EINTR;
+		}
+		spin_unlock(&idem_lock);
+	}
+	/* Off the hash means completed, with ->ret set under idem_lock */
+	wait_for_completion(&u->complete);
+	return u->ret;
+}
+
+static int init_module_from_file(struct file *f, const char __user *uargs,
+				 int flags)
 {
 	struct load_info info = { };
 	void *buf = NULL;
 	int len;
 	int err;
 
-	err = may_init_module();
-	if (err)
-		return err;
-
-	pr_debug("finit_module: fd=%d, uargs=%p, flags=%i\n", fd, uargs, flags);
-
-	if (flags & ~(MODULE_INIT_IGNORE_MODVERSIONS
-		      |MODULE_INIT_IGNORE_VERMAGIC
-		      |MODULE_INIT_COMPRESSED_FILE))
-		return -EINVAL;
-
-	len = kernel_read_file_from_fd(fd, 0, &buf, INT_MAX, NULL,
-				       READING_MODULE);
+	len = kernel_read_file(f, 0, &buf, INT_MAX, NULL, READING_MODULE);
 	if (len < 0)
 		return len;
 
@@ -2973,6 +3042,44 @@ SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
 	return load_module(&info, uargs, flags);
 }
 
+static int idempotent_init_module(struct file *f, const char __user *uargs,
+				  int flags)
+{
+	struct idempotent idem;
+
+	if (!f || !(f->f_mode & FMODE_READ))
+		return -EBADF;
+
+	/* Are we the winners of the race and get to do this? */
+	if (!idempotent(&idem, file_inode(f)))
+		return idempotent_complete(&idem,
+				init_module_from_file(f, uargs, flags));
+
+	return idempotent_wait_for_completion(&idem);
+}
+
+SYSCALL_DEFINE3(finit_module, int, fd, const char __user *, uargs, int, flags)
+{
+	struct fd f;
+	int err;
+
+	err = may_init_module();
+	if (err)
+		return err;
+
+	pr_debug("finit_module: fd=%d, uargs=%p, flags=%i\n", fd, uargs, flags);
+
+	if (flags & ~(MODULE_INIT_IGNORE_MODVERSIONS
+		      |MODULE_INIT_IGNORE_VERMAGIC
+		      |MODULE_INIT_COMPRESSED_FILE))
+		return -EINVAL;
+
+	f = fdget(fd);
+	err = idempotent_init_module(f.file, uargs, flags);
+	fdput(f);
+	return err;
+}
+
 static inline int within(unsigned long addr, void *start, unsigned long size)
 {
 	return ((void *)addr >= start && (void *)addr < start + size);
@@ -31,6 +31,7 @@
 #include <linux/ktime.h>
 #include <linux/security.h>
 #include <linux/secretmem.h>
+#include <linux/moduleparam.h>
 #include <trace/events/power.h>
 
 #include "power.h"
@@ -46,6 +47,14 @@ dev_t swsusp_resume_device;
 sector_t swsusp_resume_block;
 __visible int in_suspend __nosavedata;
 
+static char hibernate_compressor[CRYPTO_MAX_ALG_NAME] = CONFIG_HIBERNATION_DEF_COMP;
+
+/*
+ * Compressor actually used for the image: the selected one when writing,
+ * whatever the image header says when reading.
+ */
+char hib_comp_algo[CRYPTO_MAX_ALG_NAME];
+
 enum {
 	HIBERNATION_INVALID,
 	HIBERNATION_PLATFORM,
@@ -726,6 +735,19 @@ int hibernate(void)
 	}
 
 	sleep_flags = lock_system_sleep();
+
+	/* Make sure the selected compressor can be used before going ahead. */
+	if (!nocompress) {
+		strscpy(hib_comp_algo, hibernate_compressor,
+			sizeof(hib_comp_algo));
+		if (crypto_has_comp(hib_comp_algo, 0, 0) != 1) {
+			pr_err("%s compression is not available\n",
+			       hib_comp_algo);
+			error = -EOPNOTSUPP;
+			goto Unlock;
+		}
+	}
+
 	/* The snapshot device should not be opened while we're running */
 	if (!hibernate_acquire()) {
 		error = -EBUSY;
@@ -759,10 +781,16 @@ int hibernate(void)
 
 		if (hibernation_mode == HIBERNATION_PLATFORM)
 			flags |= SF_PLATFORM_MODE;
-		if (nocompress)
+		if (nocompress) {
 			flags |= SF_NOCOMPRESS_MODE;
-		else
-		        flags |= SF_CRC32_MODE;
+		} else {
+			flags |= SF_CRC32_MODE;
+
+			if (!strcmp(hib_comp_algo, COMPRESSION_ALGO_LZ4))
+				flags |= SF_COMPRESSION_ALG_LZ4;
+			else if (!strcmp(hib_comp_algo, COMPRESSION_ALGO_ZSTD))
+				flags |= SF_COMPRESSION_ALG_ZSTD;
+		}
 
 		pm_pr_dbg("Writing hibernation image.\n");
 		error = swsusp_write(flags);
@@ -1349,6 +1377,45 @@ static int __init nohibernate_setup(char *str)
 	return 1;
 }
 
+static int hibernate_compressor_param_set(const char *compressor,
+					  const struct kernel_param *kp)
+{
+	static const char * const comp_algs[] = {
+		COMPRESSION_ALGO_LZO,
+		COMPRESSION_ALGO_LZ4,
+		COMPRESSION_ALGO_ZSTD,
+	};
+	unsigned int sleep_flags;
+	int index, ret;
+
+	index = sysfs_match_string(comp_algs, compressor);
+	if (index < 0) {
+		pr_debug("Cannot set specified compressor %s\n", compressor);
+		return index;
+	}
+
+	sleep_flags = lock_system_sleep();
+	ret = param_set_copystring(comp_algs[index], kp);
+	unlock_system_sleep(sleep_flags);
+
+	return ret;
+}
+
+static const struct kernel_param_ops hibernate_compressor_param_ops = {
+	.set	= hibernate_compressor_param_set,
+	.get	= param_get_string,
+};
+
+static struct kparam_string hibernate_compressor_param_string = {
+	.maxlen	= sizeof(hibernate_compressor),
+	.string	= hibernate_compressor,
+};
+
+module_param_cb(compressor, &hibernate_compressor_param_ops,
+		&hibernate_compressor_param_string, 0644);
+MODULE_PARM_DESC(compressor,
+		 "Compression algorithm to be used with hibernation (lzo, lz4, zstd)");
+
 __setup("noresume", noresume_setup);
 __setup("resume_offset=", resume_offset_setup);
 __setup("resume=", resume_setup);
@@ -6,6 +6,7 @@
 #include <linux/compiler.h>
 #include <linux/cpu.h>
 #include <linux/cpuidle.h>
+#include <linux/crypto.h>
 
 struct swsusp_info {
 	struct new_utsname	uts;
@@ -172,6 +173,17 @@ extern int swsusp_swap_in_use(void);
 #define SF_CRC32_MODE	        4
 #define SF_HW_SIG		8
 
+/* If neither of these is set, the image was compressed with LZO */
+#define SF_COMPRESSION_ALG_LZ4	16
+#define SF_COMPRESSION_ALG_ZSTD	32
+
+#define COMPRESSION_ALGO_LZO	"lzo"
+#define COMPRESSION_ALGO_LZ4	"lz4"
+#define COMPRESSION_ALGO_ZSTD	"zstd"
+
+/* Name of the crypto compressor used for the image being written or read */
+extern char hib_comp_algo[CRYPTO_MAX_ALG_NAME];
+
 /* kernel/power/hibernate.c */
 extern int swsusp_check(void);
 extern void swsusp_free(void);
@@ -514,23 +514,27 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 }
 
 /* We need to remember how much compressed data we need to read. */
-#define LZO_HEADER	sizeof(size_t)
+#define CMP_HEADER	sizeof(size_t)
 
 /* Number of pages/bytes we'll compress at one time. */
-#define LZO_UNC_PAGES	32
-#define LZO_UNC_SIZE	(LZO_UNC_PAGES * PAGE_SIZE)
+#define UNC_PAGES	32
+#define UNC_SIZE	(UNC_PAGES * PAGE_SIZE)
 
-/* Number of pages/bytes we need for compressed data (worst case). */
-#define LZO_CMP_PAGES	DIV_ROUND_UP(lzo1x_worst_compress(LZO_UNC_SIZE) + \
-			             LZO_HEADER, PAGE_SIZE)
-#define LZO_CMP_SIZE	(LZO_CMP_PAGES * PAGE_SIZE)
+/*
+ * Number of pages/bytes we need for compressed data (worst case).  The LZO
+ * bound is the loosest of the supported compressors, so it covers LZ4 and
+ * zstd as well.
+ */
+#define CMP_PAGES	DIV_ROUND_UP(lzo1x_worst_compress(UNC_SIZE) + \
+			             CMP_HEADER, PAGE_SIZE)
+#define CMP_SIZE	(CMP_PAGES * PAGE_SIZE)
 
 /* Maximum number of threads for compression/decompression. */
-#define LZO_THREADS	3
+#define CMP_THREADS	16
 
 /* Minimum/maximum number of pages for read buffering. */
-#define LZO_MIN_RD_PAGES	1024
-#define LZO_MAX_RD_PAGES	8192
+#define CMP_MIN_RD_PAGES	1024
+#define CMP_MAX_RD_PAGES	8192
 
 
 /**
@@ -582,52 +586,20 @@ static int save_image(struct swap_map_handle *handle,
 }
 
 /*
- * Structure used for CRC32.
+ * Number of compression/decompression threads: one per online CPU besides
+ * the one driving the I/O, within the bounds of CMP_THREADS.
  */
-struct crc_data {
-	struct task_struct *thr;                  /* thread */
-	atomic_t ready;                           /* ready to start flag */
-	atomic_t stop;                            /* ready to stop flag */
-	unsigned run_threads;                     /* nr current threads */
-	wait_queue_head_t go;                     /* start crc update */
-	wait_queue_head_t done;                   /* crc update done */
-	u32 *crc32;                               /* points to handle's crc32 */
-	size_t *unc_len[LZO_THREADS];             /* uncompressed lengths */
-	unsigned char *unc[LZO_THREADS];          /* uncompressed data */
-};
-
-/*
- * CRC32 update function that runs in its own thread.
- */
-static int crc32_threadfn(void *data)
+static unsigned int hib_nr_cmp_threads(void)
 {
-	struct crc_data *d = data;
-	unsigned i;
-
-	while (1) {
-		wait_event(d->go, atomic_read(&d->ready) ||
-		                  kthread_should_stop());
-		if (kthread_should_stop()) {
-			d->thr = NULL;
-			atomic_set(&d->stop, 1);
-			wake_up(&d->done);
-			break;
-		}
-		atomic_set(&d->ready, 0);
-
-		for (i = 0; i < d->run_threads; i++)
-			*d->crc32 = crc32_le(*d->crc32,
-			                     d->unc[i], *d->unc_len[i]);
-		atomic_set(&d->stop, 1);
-		wake_up(&d->done);
-	}
-	return 0;
+	return clamp_val(num_online_cpus() - 1, 1, CMP_THREADS);
 }
+
 /*
- * Structure used for LZO data compression.
+ * Structure used for data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
+	struct crypto_comp *cc;                   /* crypto compressor stream */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
@@ -635,17 +607,23 @@ struct cmp_data {
 	wait_queue_head_t done;                   /* compression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
-	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
-	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	u32 crc32;                                /* CRC32 of uncompressed data */
+	unsigned char unc[UNC_SIZE];              /* uncompressed buffer */
+	unsigned char cmp[CMP_SIZE];              /* compressed buffer */
 };
 
 /*
  * Compression function that runs in its own thread.
+ *
+ * The CRC32 of each chunk is computed here as well, so that it is spread
+ * over all the compression threads and overlaps with the I/O instead of
+ * being serialized in a single thread.  The per-chunk values are folded into
+ * the image CRC32 in order with crc32_le_combine().
  */
-static int lzo_compress_threadfn(void *data)
+static int compress_threadfn(void *data)
 {
 	struct cmp_data *d = data;
+	unsigned int cmp_len;
 
 	while (1) {
 		wait_event(d->go, atomic_read(&d->ready) ||
@@ -659,9 +637,12 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		d->crc32 = crc32_le(0, d->unc, d->unc_len);
+
+		cmp_len = CMP_SIZE - CMP_HEADER;
+		d->ret = crypto_comp_compress(d->cc, d->unc, d->unc_len,
+		                              d->cmp + CMP_HEADER, &cmp_len);
+		d->cmp_len = cmp_len;
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -669,12 +650,12 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_compressed_image - Save the suspend image data after compression.
  * @handle: Swap map handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
  */
-static int save_image_lzo(struct swap_map_handle *handle,
+static int save_compressed_image(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
                           unsigned int nr_to_write)
 {
@@ -689,34 +670,21 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	unsigned thr, run_threads, nr_threads;
 	unsigned char *page = NULL;
 	struct cmp_data *data = NULL;
-	struct crc_data *crc = NULL;
 
 	hib_init_batch(&hb);
 
-	/*
-	 * We'll limit the number of threads for compression to limit memory
-	 * footprint.
-	 */
-	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = hib_nr_cmp_threads();
 
 	page = (void *)__get_free_page(GFP_NOIO | __GFP_HIGH);
 	if (!page) {
-		pr_err("Failed to allocate LZO page\n");
+		pr_err("Failed to allocate %s page\n", hib_comp_algo);
 		ret = -ENOMEM;
 		goto out_clean;
 	}
 
 	data = vzalloc(array_size(nr_threads, sizeof(*data)));
 	if (!data) {
-		pr_err("Failed to allocate LZO data\n");
-		ret = -ENOMEM;
-		goto out_clean;
-	}
-
-	crc = kzalloc(sizeof(*crc), GFP_KERNEL);
-	if (!crc) {
-		pr_err("Failed to allocate crc\n");
+		pr_err("Failed to allocate %s data\n", hib_comp_algo);
 		ret = -ENOMEM;
 		goto out_clean;
 	}
@@ -728,7 +696,16 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		init_waitqueue_head(&data[thr].go);
 		init_waitqueue_head(&data[thr].done);
 
-		data[thr].thr = kthread_run(lzo_compress_threadfn,
+		data[thr].cc = crypto_alloc_comp(hib_comp_algo, 0, 0);
+		if (IS_ERR_OR_NULL(data[thr].cc)) {
+			pr_err("Could not allocate comp stream %ld\n",
+			       PTR_ERR(data[thr].cc));
+			data[thr].cc = NULL;
+			ret = -EFAULT;
+			goto out_clean;
+		}
+
+		data[thr].thr = kthread_run(compress_threadfn,
 		                            &data[thr],
 		                            "image_compress/%u", thr);
 		if (IS_ERR(data[thr].thr)) {
@@ -739,26 +716,7 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		}
 	}
 
-	/*
-	 * Start the CRC32 thread.
-	 */
-	init_waitqueue_head(&crc->go);
-	init_waitqueue_head(&crc->done);
-
 	handle->crc32 = 0;
-	crc->crc32 = &handle->crc32;
-	for (thr = 0; thr < nr_threads; thr++) {
-		crc->unc[thr] = data[thr].unc;
-		crc->unc_len[thr] = &data[thr].unc_len;
-	}
-
-	crc->thr = kthread_run(crc32_threadfn, crc, "image_crc32");
-	if (IS_ERR(crc->thr)) {
-		crc->thr = NULL;
-		pr_err("Cannot start CRC32 thread\n");
-		ret = -ENOMEM;
-		goto out_clean;
-	}
 
 	/*
 	 * Adjust the number of required free pages after all allocations have
@@ -766,7 +724,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	 */
 	handle->reqd_free_pages = reqd_free_pages();
 
-	pr_info("Using %u thread(s) for compression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s compression\n",
+		nr_threads, hib_comp_algo);
 	pr_info("Compressing and saving image data (%u pages)...\n",
 		nr_to_write);
 	m = nr_to_write / 10;
@@ -776,7 +735,7 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	start = ktime_get();
 	for (;;) {
 		for (thr = 0; thr < nr_threads; thr++) {
-			for (off = 0; off < LZO_UNC_SIZE; off += PAGE_SIZE) {
+			for (off = 0; off < UNC_SIZE; off += PAGE_SIZE) {
 				ret = snapshot_read_next(snapshot);
 				if (ret < 0)
 					goto out_finish;
@@ -804,10 +763,6 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		if (!thr)
 			break;
 
-		crc->run_threads = thr;
-		atomic_set(&crc->ready, 1);
-		wake_up(&crc->go);
-
 		for (run_threads = thr, thr = 0; thr < run_threads; thr++) {
 			wait_event(data[thr].done,
 			           atomic_read(&data[thr].stop));
@@ -816,18 +771,23 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				pr_err("LZO compression failed\n");
+				pr_err("%s compression failed\n", hib_comp_algo);
 				goto out_finish;
 			}
 
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(data[thr].unc_len))) {
-				pr_err("Invalid LZO compressed length\n");
+				pr_err("Invalid %s compressed length\n",
+				       hib_comp_algo);
 				ret = -1;
 				goto out_finish;
 			}
 
+			handle->crc32 = crc32_le_combine(handle->crc32,
+			                                 data[thr].crc32,
+			                                 data[thr].unc_len);
+
 			*(size_t *)data[thr].cmp = data[thr].cmp_len;
 
 			/*
@@ -839,7 +799,7 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			 * read it.
 			 */
 			for (off = 0;
-			     off < LZO_HEADER + data[thr].cmp_len;
+			     off < CMP_HEADER + data[thr].cmp_len;
 			     off += PAGE_SIZE) {
 				memcpy(page, data[thr].cmp + off, PAGE_SIZE);
 
@@ -848,9 +808,6 @@ static int save_image_lzo(struct swap_map_handle *handle,
 					goto out_finish;
 			}
 		}
-
-		wait_event(crc->done, atomic_read(&crc->stop));
-		atomic_set(&crc->stop, 0);
 	}
 
 out_finish:
@@ -863,15 +820,13 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	swsusp_show_speed(start, stop, nr_to_write, "Wrote");
 out_clean:
 	hib_finish_batch(&hb);
-	if (crc) {
-		if (crc->thr)
-			kthread_stop(crc->thr);
-		kfree(crc);
-	}
 	if (data) {
-		for (thr = 0; thr < nr_threads; thr++)
+		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
 				kthread_stop(data[thr].thr);
+			if (data[thr].cc)
+				crypto_free_comp(data[thr].cc);
+		}
 		vfree(data);
 	}
 	if (page) free_page((unsigned long)page);
@@ -941,7 +896,7 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_compressed_image(&handle, &snapshot, pages - 1);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -979,6 +934,17 @@ static int get_swap_reader(struct swap_map_handle *handle,
 	if (!swsusp_header->image) /* how can this happen? */
 		return -EINVAL;
 
+	/* Decompress with whatever the image was written with. */
+	if (*flags_p & SF_COMPRESSION_ALG_ZSTD)
+		strscpy(hib_comp_algo, COMPRESSION_ALGO_ZSTD,
+			sizeof(hib_comp_algo));
+	else if (*flags_p & SF_COMPRESSION_ALG_LZ4)
+		strscpy(hib_comp_algo, COMPRESSION_ALGO_LZ4,
+			sizeof(hib_comp_algo));
+	else
+		strscpy(hib_comp_algo, COMPRESSION_ALGO_LZO,
+			sizeof(hib_comp_algo));
+
 	handle->cur = NULL;
 	last = handle->maps = NULL;
 	offset = swsusp_header->image;
@@ -1108,10 +1074,11 @@ static int load_image(struct swap_map_handle *handle,
 }
 
 /*
- * Structure used for LZO data decompression.
+ * Structure used for data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
+	struct crypto_comp *cc;                   /* crypto compressor stream */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
@@ -1119,16 +1086,18 @@ struct dec_data {
 	wait_queue_head_t done;                   /* decompression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
-	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
-	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
+	u32 crc32;                                /* CRC32 of uncompressed data */
+	unsigned char unc[UNC_SIZE];              /* uncompressed buffer */
+	unsigned char cmp[CMP_SIZE];              /* compressed buffer */
 };
 
 /*
  * Decompression function that runs in its own thread.
  */
-static int lzo_decompress_threadfn(void *data)
+static int decompress_threadfn(void *data)
 {
 	struct dec_data *d = data;
+	unsigned int unc_len;
 
 	while (1) {
 		wait_event(d->go, atomic_read(&d->ready) ||
@@ -1142,9 +1111,12 @@ static int lzo_decompress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		unc_len = UNC_SIZE;
+		d->ret = crypto_comp_decompress(d->cc, d->cmp + CMP_HEADER,
+		                                d->cmp_len, d->unc, &unc_len);
+		d->unc_len = unc_len;
+		if (!d->ret)
+			d->crc32 = crc32_le(0, d->unc, d->unc_len);
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
@@ -1156,12 +1128,12 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_compressed_image - Load compressed image data and decompress it.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
  */
-static int load_image_lzo(struct swap_map_handle *handle,
+static int load_compressed_image(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
                           unsigned int nr_to_read)
 {
@@ -1179,34 +1151,21 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	unsigned long read_pages = 0;
 	unsigned char **page = NULL;
 	struct dec_data *data = NULL;
-	struct crc_data *crc = NULL;
 
 	hib_init_batch(&hb);
 
-	/*
-	 * We'll limit the number of threads for decompression to limit memory
-	 * footprint.
-	 */
-	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = hib_nr_cmp_threads();
 
-	page = vmalloc(array_size(LZO_MAX_RD_PAGES, sizeof(*page)));
+	page = vmalloc(array_size(CMP_MAX_RD_PAGES, sizeof(*page)));
 	if (!page) {
-		pr_err("Failed to allocate LZO page\n");
+		pr_err("Failed to allocate %s page\n", hib_comp_algo);
 		ret = -ENOMEM;
 		goto out_clean;
 	}
 
 	data = vzalloc(array_size(nr_threads, sizeof(*data)));
 	if (!data) {
-		pr_err("Failed to allocate LZO data\n");
-		ret = -ENOMEM;
-		goto out_clean;
-	}
-
-	crc = kzalloc(sizeof(*crc), GFP_KERNEL);
-	if (!crc) {
-		pr_err("Failed to allocate crc\n");
+		pr_err("Failed to allocate %s data\n", hib_comp_algo);
 		ret = -ENOMEM;
 		goto out_clean;
 	}
@@ -1220,7 +1179,16 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		init_waitqueue_head(&data[thr].go);
 		init_waitqueue_head(&data[thr].done);
 
-		data[thr].thr = kthread_run(lzo_decompress_threadfn,
+		data[thr].cc = crypto_alloc_comp(hib_comp_algo, 0, 0);
+		if (IS_ERR_OR_NULL(data[thr].cc)) {
+			pr_err("Could not allocate comp stream %ld\n",
+			       PTR_ERR(data[thr].cc));
+			data[thr].cc = NULL;
+			ret = -EFAULT;
+			goto out_clean;
+		}
+
+		data[thr].thr = kthread_run(decompress_threadfn,
 		                            &data[thr],
 		                            "image_decompress/%u", thr);
 		if (IS_ERR(data[thr].thr)) {
@@ -1231,26 +1199,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		}
 	}
 
-	/*
-	 * Start the CRC32 thread.
-	 */
-	init_waitqueue_head(&crc->go);
-	init_waitqueue_head(&crc->done);
-
 	handle->crc32 = 0;
-	crc->crc32 = &handle->crc32;
-	for (thr = 0; thr < nr_threads; thr++) {
-		crc->unc[thr] = data[thr].unc;
-		crc->unc_len[thr] = &data[thr].unc_len;
-	}
-
-	crc->thr = kthread_run(crc32_threadfn, crc, "image_crc32");
-	if (IS_ERR(crc->thr)) {
-		crc->thr = NULL;
-		pr_err("Cannot start CRC32 thread\n");
-		ret = -ENOMEM;
-		goto out_clean;
-	}
 
 	/*
 	 * Set the number of pages for read buffering.
@@ -1261,18 +1210,19 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	 */
 	if (low_free_pages() > snapshot_get_image_size())
 		read_pages = (low_free_pages() - snapshot_get_image_size()) / 2;
-	read_pages = clamp_val(read_pages, LZO_MIN_RD_PAGES, LZO_MAX_RD_PAGES);
+	read_pages = clamp_val(read_pages, CMP_MIN_RD_PAGES, CMP_MAX_RD_PAGES);
 
 	for (i = 0; i < read_pages; i++) {
-		page[i] = (void *)__get_free_page(i < LZO_CMP_PAGES ?
+		page[i] = (void *)__get_free_page(i < CMP_PAGES ?
 						  GFP_NOIO | __GFP_HIGH :
 						  GFP_NOIO | __GFP_NOWARN |
 						  __GFP_NORETRY);
 
 		if (!page[i]) {
-			if (i < LZO_CMP_PAGES) {
+			if (i < CMP_PAGES) {
 				ring_size = i;
-				pr_err("Failed to allocate LZO pages\n");
+				pr_err("Failed to allocate %s pages\n",
+				       hib_comp_algo);
 				ret = -ENOMEM;
 				goto out_clean;
 			} else {
@@ -1282,7 +1232,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	}
 	want = ring_size = i;
 
-	pr_info("Using %u thread(s) for decompression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s decompression\n",
+		nr_threads, hib_comp_algo);
 	pr_info("Loading and decompressing image data (%u pages)...\n",
 		nr_to_read);
 	m = nr_to_read / 10;
@@ -1333,23 +1284,18 @@ static int load_image_lzo(struct swap_map_handle *handle,
 				eof = 2;
 		}
 
-		if (crc->run_threads) {
-			wait_event(crc->done, atomic_read(&crc->stop));
-			atomic_set(&crc->stop, 0);
-			crc->run_threads = 0;
-		}
-
 		for (thr = 0; have && thr < nr_threads; thr++) {
 			data[thr].cmp_len = *(size_t *)page[pg];
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
-			             lzo1x_worst_compress(LZO_UNC_SIZE))) {
-				pr_err("Invalid LZO compressed length\n");
+			             lzo1x_worst_compress(UNC_SIZE))) {
+				pr_err("Invalid %s compressed length\n",
+				       hib_comp_algo);
 				ret = -1;
 				goto out_finish;
 			}
 
-			need = DIV_ROUND_UP(data[thr].cmp_len + LZO_HEADER,
+			need = DIV_ROUND_UP(data[thr].cmp_len + CMP_HEADER,
 			                    PAGE_SIZE);
 			if (need > have) {
 				if (eof > 1) {
@@ -1360,7 +1306,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			}
 
 			for (off = 0;
-			     off < LZO_HEADER + data[thr].cmp_len;
+			     off < CMP_HEADER + data[thr].cmp_len;
 			     off += PAGE_SIZE) {
 				memcpy(data[thr].cmp + off,
 				       page[pg], PAGE_SIZE);
@@ -1377,7 +1323,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		/*
 		 * Wait for more data while we are decompressing.
 		 */
-		if (have < LZO_CMP_PAGES && asked) {
+		if (have < CMP_PAGES && asked) {
 			ret = hib_wait_io(&hb);
 			if (ret)
 				goto out_finish;
@@ -1395,18 +1341,24 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				pr_err("LZO decompression failed\n");
+				pr_err("%s decompression failed\n",
+				       hib_comp_algo);
 				goto out_finish;
 			}
 
 			if (unlikely(!data[thr].unc_len ||
-			             data[thr].unc_len > LZO_UNC_SIZE ||
+			             data[thr].unc_len > UNC_SIZE ||
 			             data[thr].unc_len & (PAGE_SIZE - 1))) {
-				pr_err("Invalid LZO uncompressed length\n");
+				pr_err("Invalid %s uncompressed length\n",
+				       hib_comp_algo);
 				ret = -1;
 				goto out_finish;
 			}
 
+			handle->crc32 = crc32_le_combine(handle->crc32,
+			                                 data[thr].crc32,
+			                                 data[thr].unc_len);
+
 			for (off = 0;
 			     off < data[thr].unc_len; off += PAGE_SIZE) {
 				memcpy(data_of(*snapshot),
@@ -1418,25 +1370,13 @@ static int load_image_lzo(struct swap_map_handle *handle,
 				nr_pages++;
 
 				ret = snapshot_write_next(snapshot);
-				if (ret <= 0) {
-					crc->run_threads = thr + 1;
-					atomic_set(&crc->ready, 1);
-					wake_up(&crc->go);
+				if (ret <= 0)
 					goto out_finish;
-				}
 			}
 		}
-
-		crc->run_threads = thr;
-		atomic_set(&crc->ready, 1);
-		wake_up(&crc->go);
 	}
 
 out_finish:
-	if (crc->run_threads) {
-		wait_event(crc->done, atomic_read(&crc->stop));
-		atomic_set(&crc->stop, 0);
-	}
 	stop = ktime_get();
 	if (!ret) {
 		pr_info("Image loading done\n");
@@ -1457,15 +1397,13 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	hib_finish_batch(&hb);
 	for (i = 0; i < ring_size; i++)
 		free_page((unsigned long)page[i]);
-	if (crc) {
-		if (crc->thr)
-			kthread_stop(crc->thr);
-		kfree(crc);
-	}
 	if (data) {
-		for (thr = 0; thr < nr_threads; thr++)
+		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
 				kthread_stop(data[thr].thr);
+			if (data[thr].cc)
+				crypto_free_comp(data[thr].cc);
+		}
 		vfree(data);
 	}
 	vfree(page);
@@ -1499,7 +1437,7 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_compressed_image(&handle, &snapshot, header->pages - 1);
 	}
 	swap_reader_finish(&handle);
 end:
@@ -42,6 +42,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
 #include <linux/sched/clock.h>
@@ -361,6 +362,51 @@ static bool panic_in_progress(void)
  */
 static int console_locked, console_suspended;
 
+/*
+ * Once kthreads can be created, every registered (non-boot) console gets
+ * its own printing kthread and printk() callers no longer print to it
+ * themselves. Direct printing is still used for consoles without a kthread
+ * and whenever allow_direct_printing() says so.
+ */
+static bool printk_kthreads_available;
+static bool have_unthreaded_console;
+static bool printk_console_threads = true;
+module_param_named(console_threads, printk_console_threads, bool, 0444);
+MODULE_PARM_DESC(console_threads, "print to consoles from per-console kthreads");
+
+/*
+ * The number of printing kthreads currently inside a console write, or -1
+ * if the kthreads are blocked by the console_lock owner. The console_lock
+ * is only considered acquired once the kthreads have been blocked, so
+ * holding it still guarantees that no console is inside its write callback.
+ */
+static atomic_t console_kthreads_active = ATOMIC_INIT(0);
+static DECLARE_WAIT_QUEUE_HEAD(console_kthreads_idle_wq);
+
+static bool console_kthreads_atomic_tryblock(void)
+{
+	return atomic_cmpxchg(&console_kthreads_active, 0, -1) == 0;
+}
+
+static void console_kthreads_atomic_unblock(void)
+{
+	atomic_cmpxchg(&console_kthreads_active, -1, 0);
+}
+
+/*
+ * Return true if the printk() caller should print the records itself, on
+ * all consoles including those that have a printing kthread. This is the
+ * case until the kthreads are available and whenever the kthreads cannot
+ * be relied upon: on shutdown, oops or panic.
+ */
+static bool allow_direct_printing(void)
+{
+	return (!printk_kthreads_available ||
+		system_state > SYSTEM_RUNNING ||
+		oops_in_progress ||
+		panic_in_progress());
+}
+
 /*
  *	Array of consoles built from command line options (console=)
  */
@@ -2296,8 +2342,13 @@ asmlinkage int vprintk_emit(int facility, int level,
 
 	printed_len = vprintk_store(facility, level, dev_info, fmt, args);
 
-	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	/*
+	 * If called from the scheduler, we can not call up(). Consoles that
+	 * have a printing kthread are left to it (woken by wake_up_klogd()
+	 * below) unless direct printing is required.
+	 */
+	if (!in_sched &&
+	    (allow_direct_printing() || READ_ONCE(have_unthreaded_console))) {
 		/*
 		 * The caller may be holding system-critical or
 		 * timing-sensitive locks. Disable preemption during
@@ -2609,6 +2660,8 @@ void console_lock(void)
 	down_console_sem();
 	if (console_suspended)
 		return;
+	/* Wait for the printing kthreads to leave their write callbacks. */
+	wait_event(console_kthreads_idle_wq, console_kthreads_atomic_tryblock());
 	console_locked = 1;
 	console_may_schedule = 1;
 }
@@ -2626,7 +2679,7 @@ int console_trylock(void)
 {
 	if (down_trylock_console_sem())
 		return 0;
-	if (console_suspended) {
+	if (console_suspended || !console_kthreads_atomic_tryblock()) {
 		up_console_sem();
 		return 0;
 	}
@@ -2691,7 +2744,12 @@ static inline bool console_is_usable(struct console *con)
 static void __console_unlock(void)
 {
 	console_locked = 0;
+	console_kthreads_atomic_unblock();
 	up_console_sem();
+
+	/* Let the printing kthreads catch up with what was held back. */
+	if (printk_kthreads_available)
+		wake_up_klogd();
 }
 
 /*
@@ -2826,29 +2884,34 @@ static bool printk_get_next_message(struct printk_message *pmsg, u64 seq,
  * Print one record for the given console. The record printed is whatever
  * record is the next available record for the given console.
  *
+ * @pbufs is used to read and format the record.
+ *
  * @handover will be set to true if a printk waiter has taken over the
  * console_lock, in which case the caller is no longer holding both the
- * console_lock and the SRCU read lock. Otherwise it is set to false.
+ * console_lock and the SRCU read lock. Otherwise it is set to false. It is
+ * NULL when called from a printing kthread, which does not take part in
+ * the console_lock handover.
  *
  * @cookie is the cookie from the SRCU read lock.
  *
  * Returns false if the given console has no next record to print, otherwise
  * true.
  *
- * Requires the console_lock and the SRCU read lock.
+ * Requires the SRCU read lock and either the console_lock or, for printing
+ * kthreads, being counted in @console_kthreads_active.
  */
-static bool console_emit_next_record(struct console *con, bool *handover, int cookie)
+static bool console_emit_next_record(struct console *con, struct printk_buffers *pbufs,
+				     bool *handover, int cookie)
 {
-	static struct printk_buffers pbufs;
-
 	bool is_extended = console_srcu_read_flags(con) & CON_EXTENDED;
-	char *outbuf = &pbufs.outbuf[0];
+	char *outbuf = &pbufs->outbuf[0];
 	struct printk_message pmsg = {
-		.pbufs = &pbufs,
+		.pbufs = pbufs,
 	};
 	unsigned long flags;
 
-	*handover = false;
+	if (handover)
+		*handover = false;
 
 	if (!printk_get_next_message(&pmsg, con->seq, is_extended, true))
 		return false;
@@ -2877,7 +2940,8 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 	 * (@console_waiter is cleared).
 	 */
 	printk_safe_enter_irqsave(flags);
-	console_lock_spinning_enable();
+	if (handover)
+		console_lock_spinning_enable();
 
 	/* Do not trace print latency. */
 	stop_critical_timings();
@@ -2889,7 +2953,8 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
 
 	con->seq = pmsg.seq + 1;
 
-	*handover = console_lock_spinning_disable_and_check(cookie);
+	if (handover)
+		*handover = console_lock_spinning_disable_and_check(cookie);
 	printk_safe_exit_irqrestore(flags);
 skip:
 	return true;
@@ -2920,6 +2985,9 @@ static bool console_emit_next_record(struct console *con, bool *handover, int co
  */
 static bool console_flush_all(bool do_cond_resched, u64 *next_seq, bool *handover)
 {
+	static struct printk_buffers pbufs;
+
+	bool direct = allow_direct_printing();
 	bool any_usable = false;
 	struct console *con;
 	bool any_progress;
@@ -2937,9 +3005,13 @@ static bool console_flush_all(bool do_cond_resched, u64 *next_seq, bool *handove
 
 			if (!console_is_usable(con))
 				continue;
+
+			/* Leave consoles with a printing kthread to it. */
+			if (READ_ONCE(con->thread) && !direct)
+				continue;
 			any_usable = true;
 
-			progress = console_emit_next_record(con, handover, cookie);
+			progress = console_emit_next_record(con, &pbufs, handover, cookie);
 
 			/*
 			 * If a handover has occurred, the SRCU read lock
@@ -3340,6 +3412,176 @@ static void console_init_seq(struct console *newcon, bool bootcon_registered)
 
 static int unregister_console_locked(struct console *console);
 
+/* Must be called under console_list_lock(). */
+static void console_update_unthreaded(void)
+{
+	bool unthreaded = false;
+	struct console *con;
+
+	lockdep_assert_console_list_lock_held();
+
+	for_each_console(con) {
+		if (!con->thread) {
+			unthreaded = true;
+			break;
+		}
+	}
+	WRITE_ONCE(have_unthreaded_console, unthreaded);
+}
+
+#ifdef CONFIG_PRINTK
+static bool console_kthreads_atomically_blocked(void)
+{
+	return atomic_read(&console_kthreads_active) == -1;
+}
+
+static bool console_kthread_printing_tryenter(void)
+{
+	return atomic_inc_unless_negative(&console_kthreads_active);
+}
+
+static void console_kthread_printing_exit(void)
+{
+	/*
+	 * The full barrier of atomic_dec_return() pairs with the one in
+	 * prepare_to_wait_event() of a console_lock() waiting for the
+	 * kthreads to become idle.
+	 */
+	if (atomic_dec_return(&console_kthreads_active) == 0 &&
+	    wq_has_sleeper(&console_kthreads_idle_wq))
+		wake_up(&console_kthreads_idle_wq);
+}
+
+static bool printer_should_wake(struct console *con)
+{
+	bool usable;
+	int cookie;
+
+	if (kthread_should_stop())
+		return true;
+
+	if (console_kthreads_atomically_blocked())
+		return false;
+
+	cookie = console_srcu_read_lock();
+	usable = console_is_usable(con);
+	console_srcu_read_unlock(cookie);
+
+	if (!usable)
+		return false;
+
+	return prb_read_valid(prb, con->seq, NULL);
+}
+
+static int printk_kthread_func(void *data)
+{
+	struct console *con = data;
+	bool usable;
+	int cookie;
+	int error;
+
+	for (;;) {
+		error = wait_event_interruptible(log_wait, printer_should_wake(con));
+
+		if (kthread_should_stop())
+			break;
+
+		if (error)
+			continue;
+
+		/* Lost the race against a console_lock() owner, go back to sleep. */
+		if (!console_kthread_printing_tryenter())
+			continue;
+
+		cookie = console_srcu_read_lock();
+		usable = console_is_usable(con);
+		if (usable)
+			console_emit_next_record(con, con->pbufs, NULL, cookie);
+		console_srcu_read_unlock(cookie);
+
+		console_kthread_printing_exit();
+
+		/*
+		 * A printk() caller may have failed to take the console_lock
+		 * because this kthread was printing. Make sure the consoles
+		 * without a kthread get the new records anyway.
+		 */
+		if (usable && READ_ONCE(have_unthreaded_console))
+			defer_console_output();
+
+		cond_resched();
+	}
+
+	return 0;
+}
+
+/* Must be called under console_list_lock(). */
+static void printk_start_kthread(struct console *con)
+{
+	struct task_struct *thread;
+
+	lockdep_assert_console_list_lock_held();
+
+	con->pbufs = kmalloc(sizeof(*con->pbufs), GFP_KERNEL);
+	if (!con->pbufs) {
+		con_printk(KERN_ERR, con, "failed to allocate printing thread buffers\n");
+		return;
+	}
+
+	thread = kthread_run(printk_kthread_func, con, "pr/%s%d",
+			     con->name, con->index);
+	if (IS_ERR(thread)) {
+		con_printk(KERN_ERR, con, "unable to start printing thread\n");
+		kfree(con->pbufs);
+		con->pbufs = NULL;
+		return;
+	}
+
+	WRITE_ONCE(con->thread, thread);
+}
+
+/* Must be called under console_list_lock(). */
+static void printk_stop_kthread(struct console *con)
+{
+	lockdep_assert_console_list_lock_held();
+
+	if (!con->thread)
+		return;
+
+	kthread_stop(con->thread);
+	WRITE_ONCE(con->thread, NULL);
+	kfree(con->pbufs);
+	con->pbufs = NULL;
+}
+
+/*
+ * Hand all real consoles over to printing kthreads. Boot consoles keep
+ * printing directly until the real consoles replace them.
+ */
+static int __init printk_activate_kthreads(void)
+{
+	struct console *con;
+
+	if (!printk_console_threads)
+		return 0;
+
+	console_list_lock();
+	printk_kthreads_available = true;
+	for_each_console(con) {
+		if (!(con->flags & CON_BOOT))
+			printk_start_kthread(con);
+	}
+	console_update_unthreaded();
+	console_list_unlock();
+
+	return 0;
+}
+early_initcall(printk_activate_kthreads);
+#else
+static void printk_start_kthread(struct console *con) { }
+static void printk_stop_kthread(struct console *con) { }
+#endif /* CONFIG_PRINTK */
+
 /*
  * The console driver calls this routine during kernel initialization
  * to register the console printing procedure with printk() and to
@@ -3455,6 +3697,10 @@ void register_console(struct console *newcon)
 	 * register_console() completes.
 	 */
 
+	if (printk_kthreads_available && !(newcon->flags & CON_BOOT))
+		printk_start_kthread(newcon);
+	console_update_unthreaded();
+
 	console_sysfs_notify();
 
 	/*
@@ -3501,6 +3747,8 @@ static int unregister_console_locked(struct console *console)
 	if (!console_is_registered_locked(console))
 		return -ENODEV;
 
+	printk_stop_kthread(console);
+
 	hlist_del_init_rcu(&console->node);
 
 	/*
@@ -3522,6 +3770,7 @@ static int unregister_console_locked(struct console *console)
 	 */
 	synchronize_srcu(&console_srcu);
 
+	console_update_unthreaded();
 	console_sysfs_notify();
 
 	if (console->exit)
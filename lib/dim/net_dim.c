@@ -4,14 +4,10 @@
  */
 
 #include <linux/dim.h>
+#include <linux/netdevice.h>
+#include <linux/rtnetlink.h>
+#include <linux/slab.h>
 
-/*
- * Net DIM profiles:
- *        There are different set of profiles for each CQ period mode.
- *        There are different set of profiles for RX/TX CQs.
- *        Each profile size must be of NET_DIM_PARAMS_NUM_PROFILES
- */
-#define NET_DIM_PARAMS_NUM_PROFILES 5
 #define NET_DIM_DEFAULT_RX_CQ_PKTS_FROM_EQE 256
 #define NET_DIM_DEFAULT_TX_CQ_PKTS_FROM_EQE 128
 #define NET_DIM_DEF_PROFILE_CQE 1
@@ -101,6 +97,151 @@ net_dim_get_def_tx_moderation(u8 cq_period_mode)
 }
 EXPORT_SYMBOL(net_dim_get_def_tx_moderation);
 
+static void net_dim_free_profiles(struct dim_irq_moder *moder)
+{
+	int mode;
+
+	for (mode = 0; mode < DIM_CQ_PERIOD_NUM_MODES; mode++) {
+		kfree(rcu_access_pointer(moder->rx_profile[mode]));
+		kfree(rcu_access_pointer(moder->tx_profile[mode]));
+	}
+}
+
+int net_dim_init_irq_moder(struct net_device *dev, u8 profile_flags,
+			   u8 coal_flags, u8 rx_mode, u8 tx_mode)
+{
+	struct dim_irq_moder *moder;
+	struct dim_cq_moder *p;
+	int mode;
+
+	moder = kzalloc(sizeof(*moder), GFP_KERNEL);
+	if (!moder)
+		return -ENOMEM;
+
+	moder->profile_flags = profile_flags;
+	moder->coal_flags = coal_flags;
+	moder->dim_rx_mode = rx_mode;
+	moder->dim_tx_mode = tx_mode;
+
+	for (mode = 0; mode < DIM_CQ_PERIOD_NUM_MODES; mode++) {
+		if (profile_flags & DIM_PROFILE_RX) {
+			p = kmemdup(rx_profile[mode], sizeof(rx_profile[mode]),
+				    GFP_KERNEL);
+			if (!p)
+				goto err_free;
+			RCU_INIT_POINTER(moder->rx_profile[mode], p);
+		}
+		if (profile_flags & DIM_PROFILE_TX) {
+			p = kmemdup(tx_profile[mode], sizeof(tx_profile[mode]),
+				    GFP_KERNEL);
+			if (!p)
+				goto err_free;
+			RCU_INIT_POINTER(moder->tx_profile[mode], p);
+		}
+	}
+
+	dev->irq_moder = moder;
+	return 0;
+
+err_free:
+	net_dim_free_profiles(moder);
+	kfree(moder);
+	return -ENOMEM;
+}
+EXPORT_SYMBOL(net_dim_init_irq_moder);
+
+void net_dim_free_irq_moder(struct net_device *dev)
+{
+	if (!dev->irq_moder)
+		return;
+
+	net_dim_free_profiles(dev->irq_moder);
+	kfree(dev->irq_moder);
+	dev->irq_moder = NULL;
+}
+EXPORT_SYMBOL(net_dim_free_irq_moder);
+
+void net_dim_set_rx_mode(struct net_device *dev, u8 rx_mode)
+{
+	ASSERT_RTNL();
+	if (dev->irq_moder)
+		dev->irq_moder->dim_rx_mode = rx_mode;
+}
+EXPORT_SYMBOL(net_dim_set_rx_mode);
+
+void net_dim_set_tx_mode(struct net_device *dev, u8 tx_mode)
+{
+	ASSERT_RTNL();
+	if (dev->irq_moder)
+		dev->irq_moder->dim_tx_mode = tx_mode;
+}
+EXPORT_SYMBOL(net_dim_set_tx_mode);
+
+/* @slot is only loaded here, under RCU, it may be replaced concurrently */
+static struct dim_cq_moder
+net_dim_get_irq_moder(struct dim_cq_moder __rcu **slot, struct dim *dim)
+{
+	struct dim_cq_moder cq_moder;
+
+	rcu_read_lock();
+	cq_moder = rcu_dereference(*slot)[dim->profile_ix];
+	rcu_read_unlock();
+
+	cq_moder.cq_period_mode = dim->mode;
+	return cq_moder;
+}
+
+struct dim_cq_moder
+net_dim_get_rx_irq_moder(struct net_device *dev, struct dim *dim)
+{
+	struct dim_irq_moder *moder = dev->irq_moder;
+
+	if (!moder || !(moder->profile_flags & DIM_PROFILE_RX))
+		return net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+
+	return net_dim_get_irq_moder(&moder->rx_profile[dim->mode], dim);
+}
+EXPORT_SYMBOL(net_dim_get_rx_irq_moder);
+
+struct dim_cq_moder
+net_dim_get_tx_irq_moder(struct net_device *dev, struct dim *dim)
+{
+	struct dim_irq_moder *moder = dev->irq_moder;
+
+	if (!moder || !(moder->profile_flags & DIM_PROFILE_TX))
+		return net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+
+	return net_dim_get_irq_moder(&moder->tx_profile[dim->mode], dim);
+}
+EXPORT_SYMBOL(net_dim_get_tx_irq_moder);
+
+static void net_dim_def_profile(struct dim *dim, u8 cq_period_mode)
+{
+	dim->mode = cq_period_mode;
+	dim->profile_ix = cq_period_mode == DIM_CQ_PERIOD_MODE_START_FROM_CQE ?
+			  NET_DIM_DEF_PROFILE_CQE : NET_DIM_DEF_PROFILE_EQE;
+}
+
+struct dim_cq_moder
+net_dim_get_def_rx_irq_moder(struct net_device *dev, u8 cq_period_mode)
+{
+	struct dim dim;
+
+	net_dim_def_profile(&dim, cq_period_mode);
+	return net_dim_get_rx_irq_moder(dev, &dim);
+}
+EXPORT_SYMBOL(net_dim_get_def_rx_irq_moder);
+
+struct dim_cq_moder
+net_dim_get_def_tx_irq_moder(struct net_device *dev, u8 cq_period_mode)
+{
+	struct dim dim;
+
+	net_dim_def_profile(&dim, cq_period_mode);
+	return net_dim_get_tx_irq_moder(dev, &dim);
+}
+EXPORT_SYMBOL(net_dim_get_def_tx_irq_moder);
+
 static int net_dim_step(struct dim *dim)
 {
 	if (dim->tired == (NET_DIM_PARAMS_NUM_PROFILES * 2))
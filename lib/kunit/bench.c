@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit microbenchmark API.
+ */
+
+#include <kunit/bench.h>
+#include <kunit/test.h>
+
+#include <linux/cpumask.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/sched.h>
+#include <linux/sort.h>
+
+static bool enable_bench;
+module_param_named(bench, enable_bench, bool, 0644);
+MODULE_PARM_DESC(bench, "Run the KUnit benchmarks");
+
+#define KUNIT_BENCH_WARMUP		16
+#define KUNIT_BENCH_MIN_SAMPLES		64
+#define KUNIT_BENCH_MAX_SAMPLES		4096
+#define KUNIT_BENCH_STABLE_PCT		2
+
+static int kunit_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	if (x < y)
+		return -1;
+	return x > y;
+}
+
+/* Nearest rank percentile of @n sorted samples */
+static u64 kunit_bench_pct(const u64 *sorted, unsigned int n,
+			   unsigned int pct)
+{
+	unsigned int rank = DIV_ROUND_UP(n * pct, 100);
+
+	return sorted[rank ? rank - 1 : 0];
+}
+
+void kunit_bench_stats(u64 *samples, unsigned int n,
+		       struct kunit_bench_result *res)
+{
+	unsigned int i;
+	u64 sum = 0;
+
+	sort(samples, n, sizeof(*samples), kunit_bench_cmp, NULL);
+	for (i = 0; i < n; i++)
+		sum += samples[i];
+
+	res->samples = n;
+	res->min = samples[0];
+	res->p50 = kunit_bench_pct(samples, n, 50);
+	res->p90 = kunit_bench_pct(samples, n, 90);
+	res->p99 = kunit_bench_pct(samples, n, 99);
+	res->max = samples[n - 1];
+	res->mean = div64_u64(sum, n);
+}
+EXPORT_SYMBOL_GPL(kunit_bench_stats);
+
+static u64 kunit_bench_sample(const struct kunit_bench *bench,
+			      unsigned int loops)
+{
+	unsigned int i;
+	u64 start;
+
+	start = ktime_get_ns();
+	for (i = 0; i < loops; i++)
+		bench->fn(bench->ctx);
+
+	return div_u64(ktime_get_ns() - start, loops);
+}
+
+/* Whether the median moved by at most @pct percent */
+static bool kunit_bench_settled(u64 p50, u64 prev_p50, unsigned int pct)
+{
+	u64 diff = p50 > prev_p50 ? p50 - prev_p50 : prev_p50 - p50;
+
+	return diff * 100 <= prev_p50 * pct;
+}
+
+static void kunit_bench_measure(const struct kunit_bench *bench, u64 *samples,
+				unsigned int max, struct kunit_bench_result *res)
+{
+	unsigned int round = bench->min_samples ?: KUNIT_BENCH_MIN_SAMPLES;
+	unsigned int stable_pct = bench->stable_pct ?: KUNIT_BENCH_STABLE_PCT;
+	unsigned int warmup = bench->warmup ?: KUNIT_BENCH_WARMUP;
+	unsigned int loops = bench->loops ?: 1;
+	unsigned int i, n = 0;
+	u64 prev_p50 = 0;
+
+	for (i = 0; i < warmup; i++)
+		bench->fn(bench->ctx);
+
+	res->stable = false;
+	while (n < max) {
+		for (i = min(n + round, max); n < i; n++)
+			samples[n] = kunit_bench_sample(bench, loops);
+
+		kunit_bench_stats(samples, n, res);
+		if (n > round &&
+		    kunit_bench_settled(res->p50, prev_p50, stable_pct)) {
+			res->stable = true;
+			break;
+		}
+		prev_p50 = res->p50;
+		cond_resched();
+	}
+}
+
+static void kunit_bench_report(struct kunit *test,
+			       const struct kunit_bench *bench,
+			       const struct kunit_bench_result *res)
+{
+	char extra[48] = "";
+	int len = 0;
+
+	if (bench->pin_cpu)
+		len += scnprintf(extra + len, sizeof(extra) - len, " cpu=%u",
+				 bench->cpu);
+	/* bytes per ns are GB/s */
+	if (bench->bytes && res->p50)
+		len += scnprintf(extra + len, sizeof(extra) - len, " mbps=%llu",
+				 div64_u64(bench->bytes * 1000, res->p50));
+
+	kunit_log(KERN_INFO, test,
+		  KUNIT_SUBTEST_INDENT "# bench: %s:%s samples=%u min=%llu p50=%llu p90=%llu p99=%llu max=%llu mean=%llu stable=%d%s",
+		  test->name, bench->name, res->samples, res->min, res->p50,
+		  res->p90, res->p99, res->max, res->mean, res->stable, extra);
+}
+
+bool kunit_bench_enabled(struct kunit *test)
+{
+	/* Only suites running concurrently hold their output back */
+	return enable_bench && !test->output;
+}
+EXPORT_SYMBOL_GPL(kunit_bench_enabled);
+
+int kunit_bench_run(struct kunit *test, const struct kunit_bench *bench,
+		    struct kunit_bench_result *res)
+{
+	unsigned int max = bench->max_samples ?: KUNIT_BENCH_MAX_SAMPLES;
+	struct kunit_bench_result r;
+	cpumask_var_t saved;
+	u64 *samples;
+	int ret;
+
+	if (!enable_bench)
+		kunit_skip(test, "benchmarks disabled, boot with kunit.bench=1");
+	if (!kunit_bench_enabled(test))
+		kunit_skip(test, "benchmarks need an exclusive suite");
+
+	max = max(max, bench->min_samples ?: KUNIT_BENCH_MIN_SAMPLES);
+	samples = kunit_kmalloc_array(test, max, sizeof(*samples), GFP_KERNEL);
+	if (!samples) {
+		KUNIT_FAIL(test, "cannot allocate %u benchmark samples", max);
+		return -ENOMEM;
+	}
+
+	if (!bench->pin_cpu) {
+		kunit_bench_measure(bench, samples, max, &r);
+		goto report;
+	}
+
+	if (bench->cpu >= nr_cpu_ids || !cpu_online(bench->cpu)) {
+		KUNIT_FAIL(test, "CPU %u to benchmark on is not online",
+			   bench->cpu);
+		return -EINVAL;
+	}
+	if (!alloc_cpumask_var(&saved, GFP_KERNEL)) {
+		KUNIT_FAIL(test, "cannot allocate a CPU mask");
+		return -ENOMEM;
+	}
+	cpumask_copy(saved, current->cpus_ptr);
+	ret = set_cpus_allowed_ptr(current, cpumask_of(bench->cpu));
+	if (ret) {
+		free_cpumask_var(saved);
+		KUNIT_FAIL(test, "cannot move to CPU %u: %d", bench->cpu, ret);
+		return ret;
+	}
+
+	kunit_bench_measure(bench, samples, max, &r);
+
+	set_cpus_allowed_ptr(current, saved);
+	free_cpumask_var(saved);
+
+report:
+	kunit_kfree(test, samples);
+	kunit_bench_report(test, bench, &r);
+	if (res)
+		*res = r;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(kunit_bench_run);
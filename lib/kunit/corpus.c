@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit helper generating synthetic data for compression tests.
+ */
+
+#include <kunit/corpus.h>
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/string.h>
+
+static const char * const kunit_corpus_words[] = {
+	"the", "of", "and", "to", "in", "is", "that", "for", "it", "as",
+	"kernel", "page", "memory", "block", "device", "interrupt", "queue",
+	"buffer", "window", "struct", "return", "void", "static", "unsigned",
+};
+
+static void kunit_fill_text(struct rnd_state *rnd, u8 *buf, size_t size)
+{
+	size_t pos = 0;
+
+	while (pos < size) {
+		const char *w = kunit_corpus_words[prandom_u32_state(rnd) %
+						   ARRAY_SIZE(kunit_corpus_words)];
+		size_t len = min(strlen(w), size - pos);
+
+		memcpy(buf + pos, w, len);
+		pos += len;
+		if (pos < size)
+			buf[pos++] = prandom_u32_state(rnd) % 8 ? ' ' : '\n';
+	}
+}
+
+static void kunit_fill_binary(struct rnd_state *rnd, u8 *buf, size_t size,
+			      size_t window)
+{
+	size_t pos = 0, len, i;
+
+	while (pos < size) {
+		u32 r = prandom_u32_state(rnd);
+
+		len = min_t(size_t, 3 + (r >> 8) % 300, size - pos);
+		switch (r % 3) {
+		case 0: {
+			size_t period = 1 + (r >> 4) % 16;
+
+			for (i = 0; i < len; i++)
+				buf[pos + i] = i < period ?
+					prandom_u32_state(rnd) : buf[pos + i - period];
+			break;
+		}
+		case 1:
+			if (pos >= 16 && window) {
+				size_t back = 1 + prandom_u32_state(rnd) %
+						  min(pos, window);
+
+				for (i = 0; i < len; i++)
+					buf[pos + i] = buf[pos + i - back];
+				break;
+			}
+			fallthrough;
+		default:
+			prandom_bytes_state(rnd, buf + pos, len);
+			break;
+		}
+		pos += len;
+	}
+}
+
+void kunit_fill_corpus(u8 *buf, size_t size, enum kunit_corpus kind,
+		       size_t window, u64 seed)
+{
+	struct rnd_state rnd;
+
+	prandom_seed_state(&rnd, seed);
+	switch (kind) {
+	case KUNIT_CORPUS_TEXT:
+		kunit_fill_text(&rnd, buf, size);
+		break;
+	case KUNIT_CORPUS_BINARY:
+		kunit_fill_binary(&rnd, buf, size, window);
+		break;
+	case KUNIT_CORPUS_RANDOM:
+		prandom_bytes_state(&rnd, buf, size);
+		break;
+	}
+}
+EXPORT_SYMBOL_GPL(kunit_fill_corpus);
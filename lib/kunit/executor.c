@@ -2,8 +2,13 @@
 
 #include <linux/reboot.h>
 #include <kunit/test.h>
+#include <asm/sections.h>
 #include <linux/glob.h>
+#include <linux/kthread.h>
 #include <linux/moduleparam.h>
+#include <linux/wait.h>
+
+#include "output-impl.h"
 
 /*
  * These symbols point to the .kunit_test_suites section and are defined in
@@ -16,6 +21,8 @@ extern struct kunit_suite * const __kunit_suites_end[];
 
 static char *filter_glob_param;
 static char *action_param;
+static int parallel_param;
+static unsigned int suite_timeout_param = 600;
 
 module_param_named(filter_glob, filter_glob_param, charp, 0);
 MODULE_PARM_DESC(filter_glob,
@@ -25,6 +32,12 @@ MODULE_PARM_DESC(action,
 		 "Changes KUnit executor behavior, valid values are:\n"
 		 "<none>: run the tests like normal\n"
 		 "'list' to list test names instead of running them.\n");
+module_param_named(parallel, parallel_param, int, 0);
+MODULE_PARM_DESC(parallel,
+		 "Number of CPUs to run KUnit test suites on concurrently at boot-time, 0 or 1 to run them one after another, -1 for all online CPUs");
+module_param_named(suite_timeout, suite_timeout_param, uint, 0);
+MODULE_PARM_DESC(suite_timeout,
+		 "Seconds a KUnit test suite run concurrently may take before it is reported as failed, 0 for no limit");
 
 /* glob_match() needs NULL terminated strings, so we need a copy of filter_glob_param. */
 struct kunit_test_filter {
@@ -162,14 +175,243 @@ static void kunit_handle_shutdown(void)
 
 }
 
-static void kunit_exec_run_tests(struct suite_set *suite_set)
+enum {
+	KUNIT_JOB_RUNNING,
+	KUNIT_JOB_DONE,
+	KUNIT_JOB_ABANDONED,
+};
+
+struct kunit_exec_job {
+	struct kunit_suite *suite;
+	unsigned long deadline;
+	int state;
+};
+
+/* Suites run in parallel, and the oldest one not printed yet */
+struct kunit_exec {
+	struct kunit_exec_job *jobs;
+	size_t next;
+	int nr_cpus;
+	int cpu;
+	bool abandoned;
+};
+
+static atomic_t kunit_exec_running = ATOMIC_INIT(0);
+static DECLARE_WAIT_QUEUE_HEAD(kunit_exec_wait);
+
+static int kunit_exec_nr_cpus(void)
+{
+	int nr_cpus = num_online_cpus();
+
+	if (parallel_param >= 0 && parallel_param < nr_cpus)
+		nr_cpus = parallel_param;
+
+	return nr_cpus;
+}
+
+static int kunit_exec_suite_thread(void *data)
+{
+	struct kunit_exec_job *job = data;
+
+	kunit_run_tests(job->suite);
+
+	/*
+	 * An abandoned job was already given up on, and may not be touched
+	 * beyond this. It kept kunit_running raised for us.
+	 */
+	if (cmpxchg(&job->state, KUNIT_JOB_RUNNING, KUNIT_JOB_DONE) ==
+	    KUNIT_JOB_RUNNING) {
+		atomic_dec(&kunit_exec_running);
+		wake_up(&kunit_exec_wait);
+	} else {
+		static_branch_dec(&kunit_running);
+	}
+
+	return 0;
+}
+
+static bool kunit_exec_job_ready(const struct kunit_exec_job *job)
+{
+	if (READ_ONCE(job->state) != KUNIT_JOB_RUNNING)
+		return true;
+
+	return suite_timeout_param && time_after_eq(jiffies, job->deadline);
+}
+
+static long kunit_exec_job_timeout(const struct kunit_exec_job *job)
+{
+	if (!suite_timeout_param)
+		return MAX_SCHEDULE_TIMEOUT;
+
+	return max_t(long, (long)(job->deadline - jiffies), 1);
+}
+
+static void kunit_exec_start_job(struct kunit_exec *exec,
+				 struct kunit_exec_job *job)
+{
+	struct task_struct *task;
+
+	exec->cpu = cpumask_next(exec->cpu, cpu_online_mask);
+	if (exec->cpu >= nr_cpu_ids)
+		exec->cpu = cpumask_first(cpu_online_mask);
+
+	job->state = KUNIT_JOB_RUNNING;
+	job->deadline = jiffies + suite_timeout_param * HZ;
+	atomic_inc(&kunit_exec_running);
+
+	task = kthread_create(kunit_exec_suite_thread, job, "kunit/%s",
+			      job->suite->name);
+	if (IS_ERR(task)) {
+		/* Its output is held back all the same, run it here */
+		kunit_exec_suite_thread(job);
+		return;
+	}
+
+	/* The test cases run in kthreads of their own, on the same CPU */
+	kthread_bind(task, exec->cpu);
+	kunit_bind_deferred_suite(job->suite, exec->cpu);
+	wake_up_process(task);
+}
+
+/*
+ * Print the suites before @end in order. If @wait, wait for all of them to
+ * finish or time out, otherwise stop at the first one still running.
+ */
+static void kunit_exec_print_jobs(struct kunit_exec *exec, size_t end,
+				  bool wait)
+{
+	struct kunit_exec_job *job;
+
+	while (exec->next < end) {
+		job = &exec->jobs[exec->next];
+		if (!kunit_exec_job_ready(job)) {
+			if (!wait)
+				return;
+			wait_event_timeout(kunit_exec_wait,
+					   kunit_exec_job_ready(job),
+					   kunit_exec_job_timeout(job));
+			continue;
+		}
+
+		/* The kthread drops it once it finally finishes */
+		static_branch_inc(&kunit_running);
+		if (cmpxchg(&job->state, KUNIT_JOB_RUNNING,
+			    KUNIT_JOB_ABANDONED) == KUNIT_JOB_RUNNING) {
+			atomic_dec(&kunit_exec_running);
+			exec->abandoned = true;
+			kunit_print_deferred_suite(job->suite,
+						   suite_timeout_param);
+		} else {
+			static_branch_dec(&kunit_running);
+			kunit_print_deferred_suite(job->suite, 0);
+		}
+		exec->next++;
+	}
+}
+
+/*
+ * Whether @suite has code or data in the init sections, which are freed right
+ * after the tests ran at boot. Such suites are never run in a kthread that
+ * could be given up on and outlive them.
+ */
+static bool kunit_suite_uses_init(struct kunit_suite *suite)
+{
+	struct kunit_case *test_case;
+
+	if (init_section_contains(suite, sizeof(*suite)) ||
+	    init_section_contains(suite->test_cases, sizeof(*suite->test_cases)) ||
+	    is_kernel_inittext((unsigned long)suite->suite_init) ||
+	    is_kernel_inittext((unsigned long)suite->suite_exit) ||
+	    is_kernel_inittext((unsigned long)suite->init) ||
+	    is_kernel_inittext((unsigned long)suite->exit))
+		return true;
+
+	kunit_suite_for_each_test_case(suite, test_case) {
+		if (is_kernel_inittext((unsigned long)test_case->run_case) ||
+		    is_kernel_inittext((unsigned long)test_case->generate_params))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Run the suites on up to exec->nr_cpus CPUs at a time, each in a kthread
+ * bound to one CPU along with the kthreads of its test cases, and print
+ * their output in order once the suites before them are done. Exclusive
+ * suites and suites using init memory run alone, once all before them are
+ * done, though suites that timed out may still be running. Those keep
+ * kunit_running raised, their further output is dropped.
+ *
+ * Returns false if a suite timed out and its kthread still uses it.
+ */
+static bool kunit_exec_run_parallel(struct suite_set *suite_set, int nr_cpus)
+{
+	size_t i, num_suites = suite_set->end - suite_set->start;
+	struct kunit_exec exec = {
+		.nr_cpus = nr_cpus,
+		.cpu = -1,
+	};
+	struct kunit_suite *suite;
+
+	exec.jobs = kcalloc(num_suites, sizeof(*exec.jobs), GFP_KERNEL);
+	if (!exec.jobs) {
+		__kunit_test_suites_init(suite_set->start, num_suites);
+		return true;
+	}
+
+	static_branch_inc(&kunit_running);
+
+	for (i = 0; i < num_suites; i++) {
+		suite = suite_set->start[i];
+		exec.jobs[i].suite = suite;
+
+		if (suite->exclusive || kunit_suite_uses_init(suite) ||
+		    kunit_defer_suite(suite)) {
+			kunit_exec_print_jobs(&exec, i, true);
+			__kunit_test_suites_init(&suite, 1);
+			exec.next = i + 1;
+			continue;
+		}
+
+		while (atomic_read(&kunit_exec_running) >= exec.nr_cpus) {
+			struct kunit_exec_job *oldest = &exec.jobs[exec.next];
+
+			wait_event_timeout(kunit_exec_wait,
+					   atomic_read(&kunit_exec_running) < exec.nr_cpus ||
+					   kunit_exec_job_ready(oldest),
+					   kunit_exec_job_timeout(oldest));
+			kunit_exec_print_jobs(&exec, i, false);
+		}
+
+		kunit_exec_start_job(&exec, &exec.jobs[i]);
+		kunit_exec_print_jobs(&exec, i, false);
+	}
+	kunit_exec_print_jobs(&exec, num_suites, true);
+
+	static_branch_dec(&kunit_running);
+
+	/* Abandoned kthreads still use their job */
+	if (!exec.abandoned)
+		kfree(exec.jobs);
+
+	return !exec.abandoned;
+}
+
+/* Returns false if suites are still in use and must not be freed */
+static bool kunit_exec_run_tests(struct suite_set *suite_set)
 {
 	size_t num_suites = suite_set->end - suite_set->start;
+	int nr_cpus = kunit_exec_nr_cpus();
 
 	pr_info("KTAP version 1\n");
 	pr_info("1..%zu\n", num_suites);
 
+	if (nr_cpus > 1 && num_suites > 1)
+		return kunit_exec_run_parallel(suite_set, nr_cpus);
+
 	__kunit_test_suites_init(suite_set->start, num_suites);
+	return true;
 }
 
 static void kunit_exec_list_tests(struct suite_set *suite_set)
@@ -189,6 +431,7 @@ static void kunit_exec_list_tests(struct suite_set *suite_set)
 int kunit_run_all_tests(void)
 {
 	struct suite_set suite_set = {__kunit_suites_start, __kunit_suites_end};
+	bool done = true;
 	int err = 0;
 	if (!kunit_enabled()) {
 		pr_info("kunit: disabled\n");
@@ -204,15 +447,15 @@ int kunit_run_all_tests(void)
 	}
 
 	if (!action_param)
-		kunit_exec_run_tests(&suite_set);
+		done = kunit_exec_run_tests(&suite_set);
 	else if (strcmp(action_param, "list") == 0)
 		kunit_exec_list_tests(&suite_set);
 	else
 		pr_err("kunit executor: unknown action '%s'\n", action_param);
 
-	if (filter_glob_param) { /* a copy was made of each suite */
+	/* a copy was made of each suite, kept if a suite timed out */
+	if (filter_glob_param && done)
 		kunit_free_suite_set(suite_set);
-	}
 
 out:
 	kunit_handle_shutdown();
@@ -6,6 +6,7 @@
  * Author: Brendan Higgins <brendanhiggins@google.com>
  */
 
+#include <kunit/bench.h>
 #include <kunit/test.h>
 #include <kunit/static_stub.h>
 
@@ -167,6 +168,33 @@ static void example_static_stub_test(struct kunit *test)
 	KUNIT_EXPECT_EQ(test, add_one(1), 2);
 }
 
+static void example_bench_fn(void *ctx)
+{
+	memset(ctx, 0x5a, 4096);
+}
+
+/*
+ * This test shows how to time a function with kunit_bench_run(). It is skipped
+ * unless the kernel is booted with kunit.bench=1, and otherwise prints a
+ * "# bench:" line with the distribution of the times.
+ */
+static void example_bench_test(struct kunit *test)
+{
+	struct kunit_bench bench = {
+		.name = "memset_4k",
+		.fn = example_bench_fn,
+		.bytes = 4096,
+	};
+	struct kunit_bench_result res;
+
+	bench.ctx = kunit_kmalloc(test, 4096, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, bench.ctx);
+
+	KUNIT_ASSERT_EQ(test, kunit_bench_run(test, &bench, &res), 0);
+	KUNIT_EXPECT_LE(test, res.min, res.p50);
+	KUNIT_EXPECT_LE(test, res.p50, res.max);
+}
+
 /*
  * Here we make a list of all the test cases we want to add to the test suite
  * below.
@@ -215,10 +243,26 @@ static struct kunit_suite example_test_suite = {
 	.test_cases = example_test_cases,
 };
 
+static struct kunit_case example_bench_test_cases[] = {
+	KUNIT_CASE(example_bench_test),
+	{}
+};
+
+/*
+ * Benchmarks go into a suite of their own, marked exclusive, so that other
+ * suites running at the same time with kunit.parallel do not skew their
+ * numbers.
+ */
+static struct kunit_suite example_bench_test_suite = {
+	.name = "example_bench",
+	.test_cases = example_bench_test_cases,
+	.exclusive = true,
+};
+
 /*
- * This registers the above test suite telling KUnit that this is a suite of
- * tests that need to be run.
+ * This registers the above test suites telling KUnit that these are suites
+ * of tests that need to be run.
  */
-kunit_test_suites(&example_test_suite);
+kunit_test_suites(&example_test_suite, &example_bench_test_suite);
 
 MODULE_LICENSE("GPL v2");
@@ -5,6 +5,7 @@
  * Copyright (C) 2019, Google LLC.
  * Author: Brendan Higgins <brendanhiggins@google.com>
  */
+#include <kunit/bench.h>
 #include <kunit/test.h>
 
 #include "try-catch-impl.h"
@@ -12,6 +13,7 @@
 struct kunit_try_catch_test_context {
 	struct kunit_try_catch *try_catch;
 	bool function_called;
+	int cpu;
 };
 
 static void kunit_test_successful_try(void *data)
@@ -75,6 +77,34 @@ static void kunit_test_try_catch_unsuccessful_try_does_catch(struct kunit *test)
 	KUNIT_EXPECT_TRUE(test, ctx->function_called);
 }
 
+static void kunit_test_record_cpu(void *data)
+{
+	struct kunit *test = data;
+	struct kunit_try_catch_test_context *ctx = test->priv;
+
+	ctx->cpu = raw_smp_processor_id();
+	ctx->function_called = true;
+}
+
+static void kunit_test_try_catch_runs_on_cpu(struct kunit *test)
+{
+	struct kunit_try_catch_test_context *ctx = test->priv;
+	struct kunit_try_catch *try_catch = ctx->try_catch;
+	int cpu = test->cpu;
+
+	/* As the test cases of a suite run in parallel to others */
+	test->cpu = cpumask_last(cpu_online_mask);
+	kunit_try_catch_init(try_catch,
+			     test,
+			     kunit_test_record_cpu,
+			     kunit_test_no_catch);
+	kunit_try_catch_run(try_catch, test);
+
+	KUNIT_EXPECT_TRUE(test, ctx->function_called);
+	KUNIT_EXPECT_EQ(test, ctx->cpu, test->cpu);
+	test->cpu = cpu;
+}
+
 static int kunit_try_catch_test_init(struct kunit *test)
 {
 	struct kunit_try_catch_test_context *ctx;
@@ -94,6 +124,7 @@ static int kunit_try_catch_test_init(struct kunit *test)
 static struct kunit_case kunit_try_catch_test_cases[] = {
 	KUNIT_CASE(kunit_test_try_catch_successful_try_no_catch),
 	KUNIT_CASE(kunit_test_try_catch_unsuccessful_try_does_catch),
+	KUNIT_CASE(kunit_test_try_catch_runs_on_cpu),
 	{}
 };
 
@@ -457,7 +488,7 @@ static struct kunit_suite kunit_log_test_suite = {
 
 static void kunit_log_test(struct kunit *test)
 {
-	struct kunit_suite suite;
+	struct kunit_suite suite = { };
 
 	suite.log = kunit_kzalloc(test, KUNIT_LOG_SIZE, GFP_KERNEL);
 	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, suite.log);
@@ -521,7 +552,48 @@ static struct kunit_suite kunit_status_test_suite = {
 	.test_cases = kunit_status_test_cases,
 };
 
+static void kunit_bench_stats_test(struct kunit *test)
+{
+	struct kunit_bench_result res;
+	u64 samples[100];
+	unsigned int i;
+
+	/* 100 .. 1 ns, in reverse so that the stats have to sort them */
+	for (i = 0; i < ARRAY_SIZE(samples); i++)
+		samples[i] = ARRAY_SIZE(samples) - i;
+
+	kunit_bench_stats(samples, ARRAY_SIZE(samples), &res);
+	KUNIT_EXPECT_EQ(test, res.samples, 100);
+	KUNIT_EXPECT_EQ(test, res.min, 1);
+	KUNIT_EXPECT_EQ(test, res.p50, 50);
+	KUNIT_EXPECT_EQ(test, res.p90, 90);
+	KUNIT_EXPECT_EQ(test, res.p99, 99);
+	KUNIT_EXPECT_EQ(test, res.max, 100);
+	KUNIT_EXPECT_EQ(test, res.mean, 50);
+	for (i = 1; i < ARRAY_SIZE(samples); i++)
+		KUNIT_EXPECT_LE(test, samples[i - 1], samples[i]);
+
+	/* A single sample is every percentile */
+	samples[0] = 7;
+	kunit_bench_stats(samples, 1, &res);
+	KUNIT_EXPECT_EQ(test, res.min, 7);
+	KUNIT_EXPECT_EQ(test, res.p50, 7);
+	KUNIT_EXPECT_EQ(test, res.p99, 7);
+	KUNIT_EXPECT_EQ(test, res.mean, 7);
+}
+
+static struct kunit_case kunit_bench_test_cases[] = {
+	KUNIT_CASE(kunit_bench_stats_test),
+	{}
+};
+
+static struct kunit_suite kunit_bench_test_suite = {
+	.name = "kunit_bench",
+	.test_cases = kunit_bench_test_cases,
+};
+
 kunit_test_suites(&kunit_try_catch_test_suite, &kunit_resource_test_suite,
-		  &kunit_log_test_suite, &kunit_status_test_suite);
+		  &kunit_log_test_suite, &kunit_status_test_suite,
+		  &kunit_bench_test_suite);
 
 MODULE_LICENSE("GPL v2");
@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Declarations for holding back the output of suites run in parallel, shared
+ * between the executor and the test runner.
+ */
+
+#ifndef _KUNIT_OUTPUT_IMPL_H
+#define _KUNIT_OUTPUT_IMPL_H
+
+struct kunit_suite;
+
+/*
+ * Initialize @suite to run with kunit_run_tests() while other suites run,
+ * holding back its output. Returns -ENOMEM if the output cannot be held back,
+ * @suite is left untouched then.
+ */
+int kunit_defer_suite(struct kunit_suite *suite);
+
+/*
+ * Run the test cases of deferred @suite on @cpu, the one its runner is bound
+ * to. Called before the runner starts.
+ */
+void kunit_bind_deferred_suite(struct kunit_suite *suite, unsigned int cpu);
+
+/*
+ * Print the output held back for @suite and its result. A nonzero @timeout is
+ * the number of seconds after which @suite was given up on while still
+ * running, it is reported as failed and its further output is dropped.
+ */
+void kunit_print_deferred_suite(struct kunit_suite *suite,
+				unsigned int timeout);
+
+#endif /* _KUNIT_OUTPUT_IMPL_H */
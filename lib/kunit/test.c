@@ -18,6 +18,7 @@
 
 #include "debugfs.h"
 #include "hooks-impl.h"
+#include "output-impl.h"
 #include "string-stream.h"
 #include "try-catch-impl.h"
 
@@ -133,6 +134,64 @@ void kunit_log_append(char *log, const char *fmt, ...)
 }
 EXPORT_SYMBOL_GPL(kunit_log_append);
 
+/* printk records of a suite running in parallel, not yet printed */
+struct kunit_output {
+	/* lines and printed are protected by this lock */
+	spinlock_t lock;
+	struct list_head lines;
+	bool printed;
+	/* CPU the suite runs on, or -1 for any */
+	int cpu;
+};
+
+struct kunit_output_line {
+	struct list_head node;
+	char text[];
+};
+
+/*
+ * printk, or hold the record back in @output until kunit_print_deferred_suite().
+ * Records that cannot be held back are printed right away, out of order.
+ * Records of a suite that was given up on after it timed out are dropped, not
+ * to garble the KTAP output of the suites after it.
+ */
+void kunit_log_print(struct kunit_output *output, const char *fmt, ...)
+{
+	struct kunit_output_line *line = NULL;
+	va_list args, args_for_counting;
+	unsigned long flags;
+	int len = 0;
+
+	va_start(args, fmt);
+	if (output) {
+		va_copy(args_for_counting, args);
+		len = vsnprintf(NULL, 0, fmt, args_for_counting) + 1;
+		va_end(args_for_counting);
+
+		/* kunit_log() may be called in atomic context */
+		line = kmalloc(struct_size(line, text, len),
+			       GFP_NOWAIT | __GFP_NOWARN);
+	}
+	if (!line) {
+		if (!output || !READ_ONCE(output->printed))
+			vprintk(fmt, args);
+		va_end(args);
+		return;
+	}
+	vsnprintf(line->text, len, fmt, args);
+	va_end(args);
+
+	spin_lock_irqsave(&output->lock, flags);
+	if (!output->printed) {
+		list_add_tail(&line->node, &output->lines);
+		line = NULL;
+	}
+	spin_unlock_irqrestore(&output->lock, flags);
+
+	kfree(line);
+}
+EXPORT_SYMBOL_GPL(kunit_log_print);
+
 size_t kunit_suite_num_test_cases(struct kunit_suite *suite)
 {
 	struct kunit_case *test_case;
@@ -322,6 +381,8 @@ void kunit_init_test(struct kunit *test, const char *name, char *log)
 	INIT_LIST_HEAD(&test->resources);
 	test->name = name;
 	test->log = log;
+	test->output = NULL;
+	test->cpu = -1;
 	if (test->log)
 		test->log[0] = '\0';
 	test->status = KUNIT_SUCCESS;
@@ -438,6 +499,9 @@ static void kunit_run_case_catch_errors(struct kunit_suite *suite,
 	struct kunit_try_catch *try_catch;
 
 	kunit_init_test(test, test_case->name, test_case->log);
+	test->output = suite->output;
+	if (suite->output)
+		test->cpu = suite->output->cpu;
 	try_catch = &test->try_catch;
 
 	kunit_try_catch_init(try_catch,
@@ -529,7 +593,11 @@ int kunit_run_tests(struct kunit_suite *suite)
 	kunit_print_suite_start(suite);
 
 	kunit_suite_for_each_test_case(suite, test_case) {
-		struct kunit test = { .param_value = NULL, .param_index = 0 };
+		struct kunit test = {
+			.param_value = NULL,
+			.param_index = 0,
+			.output = suite->output,
+		};
 		struct kunit_result_stats param_stats = { 0 };
 		test_case->status = KUNIT_SKIPPED;
 
@@ -586,7 +654,9 @@ int kunit_run_tests(struct kunit_suite *suite)
 
 	kunit_print_suite_stats(suite, suite_stats, total_stats);
 suite_end:
-	kunit_print_suite_end(suite);
+	/* A deferred suite gets its number once the ones before it are done */
+	if (!suite->output)
+		kunit_print_suite_end(suite);
 
 	return 0;
 }
@@ -597,6 +667,62 @@ static void kunit_init_suite(struct kunit_suite *suite)
 	kunit_debugfs_create_suite(suite);
 	suite->status_comment[0] = '\0';
 	suite->suite_init_err = 0;
+	suite->output = NULL;
+}
+
+int kunit_defer_suite(struct kunit_suite *suite)
+{
+	struct kunit_output *output;
+
+	output = kzalloc(sizeof(*output), GFP_KERNEL);
+	if (!output)
+		return -ENOMEM;
+
+	spin_lock_init(&output->lock);
+	INIT_LIST_HEAD(&output->lines);
+	output->cpu = -1;
+
+	kunit_init_suite(suite);
+	suite->output = output;
+
+	return 0;
+}
+
+void kunit_bind_deferred_suite(struct kunit_suite *suite, unsigned int cpu)
+{
+	suite->output->cpu = cpu;
+}
+
+void kunit_print_deferred_suite(struct kunit_suite *suite,
+				unsigned int timeout)
+{
+	struct kunit_output *output = suite->output;
+	struct kunit_output_line *line, *tmp;
+	LIST_HEAD(lines);
+
+	spin_lock_irq(&output->lock);
+	list_splice_init(&output->lines, &lines);
+	output->printed = true;
+	spin_unlock_irq(&output->lock);
+
+	list_for_each_entry_safe(line, tmp, &lines, node) {
+		printk("%s", line->text);
+		kfree(line);
+	}
+
+	if (timeout) {
+		kunit_err(suite, KUNIT_SUBTEST_INDENT
+			  "# timed out after %u seconds", timeout);
+		/* Fails the suite in kunit_suite_has_succeeded() */
+		suite->suite_init_err = -ETIMEDOUT;
+	}
+	kunit_print_suite_end(suite);
+
+	/* A suite that timed out still logs to its output, which drops it */
+	if (!timeout) {
+		suite->output = NULL;
+		kfree(output);
+	}
 }
 
 bool kunit_enabled(void)
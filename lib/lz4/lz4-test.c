@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit tests for the LZ4 decoders
+ *
+ * Every vectorized decoder usable on this machine is checked against the
+ * generic one on a few synthetic corpora, and their throughput is reported.
+ */
+
+#include <kunit/bench.h>
+#include <kunit/corpus.h>
+#include <kunit/test.h>
+
+#include <linux/lz4.h>
+#include <linux/vmalloc.h>
+
+#include "lz4defs.h"
+#include "lz4_simd.h"
+
+#define LZ4_TEST_SIZE		(256 * KB)
+
+struct lz4_test_param {
+	enum kunit_corpus corpus;
+	int block_size;
+	const char *name;
+};
+
+static const struct lz4_test_param lz4_test_params[] = {
+	{ KUNIT_CORPUS_TEXT,	4 * KB,		"text, 4K blocks" },
+	{ KUNIT_CORPUS_TEXT,	128 * KB,	"text, 128K blocks" },
+	{ KUNIT_CORPUS_BINARY,	4 * KB,		"binary, 4K blocks" },
+	{ KUNIT_CORPUS_BINARY,	128 * KB,	"binary, 128K blocks" },
+	{ KUNIT_CORPUS_RANDOM,	64 * KB,	"random, 64K blocks" },
+	{ KUNIT_CORPUS_BINARY,	LZ4_TEST_SIZE - 7, "binary, odd size" },
+};
+
+KUNIT_ARRAY_PARAM_DESC(lz4, lz4_test_params, name);
+
+struct lz4_test_ctx {
+	u8 *src;	/* corpus */
+	u8 *comp;	/* compressed blocks */
+	int *comp_len;	/* compressed size of each block */
+	u8 *out;
+	int nr_blocks;
+};
+
+static void lz4_test_prepare(struct kunit *test, struct lz4_test_ctx *ctx,
+			     const struct lz4_test_param *param)
+{
+	int bound = LZ4_compressBound(param->block_size);
+	void *wrkmem;
+	int i;
+
+	ctx->nr_blocks = DIV_ROUND_UP(LZ4_TEST_SIZE, param->block_size);
+	ctx->src = vmalloc(LZ4_TEST_SIZE);
+	ctx->out = vmalloc(LZ4_TEST_SIZE);
+	ctx->comp = vmalloc((size_t)bound * ctx->nr_blocks);
+	ctx->comp_len = kunit_kcalloc(test, ctx->nr_blocks, sizeof(int),
+				      GFP_KERNEL);
+	wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	KUNIT_ASSERT_TRUE(test, ctx->src && ctx->out && ctx->comp &&
+				ctx->comp_len && wrkmem);
+
+	kunit_fill_corpus(ctx->src, LZ4_TEST_SIZE, param->corpus, 64 * KB - 1,
+			  0x4c5a34);
+
+	for (i = 0; i < ctx->nr_blocks; i++) {
+		int off = i * param->block_size;
+		int len = min(param->block_size, LZ4_TEST_SIZE - off);
+
+		ctx->comp_len[i] = LZ4_compress_default(ctx->src + off,
+					ctx->comp + (size_t)i * bound, len,
+					bound, wrkmem);
+		KUNIT_ASSERT_GT(test, ctx->comp_len[i], 0);
+	}
+	vfree(wrkmem);
+}
+
+static void lz4_test_release(struct lz4_test_ctx *ctx)
+{
+	vfree(ctx->src);
+	vfree(ctx->out);
+	vfree(ctx->comp);
+}
+
+/* Decompress all blocks with @simd (the generic decoder if NULL) */
+static int lz4_test_decompress(struct kunit *test, struct lz4_test_ctx *ctx,
+			       const struct lz4_test_param *param,
+			       const struct lz4_simd_decoder *simd)
+{
+	int bound = LZ4_compressBound(param->block_size);
+	int i, total = 0;
+
+	for (i = 0; i < ctx->nr_blocks; i++) {
+		int off = i * param->block_size;
+		int len = min(param->block_size, LZ4_TEST_SIZE - off);
+		int ret;
+
+		ret = lz4_decompress_safe_using(simd,
+				ctx->comp + (size_t)i * bound,
+				ctx->out + off, ctx->comp_len[i], len);
+		if (ret != len) {
+			KUNIT_FAIL(test, "%s: block %d: got %d, expected %d",
+				   simd ? simd->name : "generic", i, ret, len);
+			return -1;
+		}
+		total += len;
+	}
+	return total;
+}
+
+static void lz4_test_roundtrip(struct kunit *test)
+{
+	const struct lz4_test_param *param = test->param_value;
+	const struct lz4_simd_decoder * const *simd;
+	struct lz4_test_ctx ctx;
+	int ret, len;
+
+	lz4_test_prepare(test, &ctx, param);
+
+	KUNIT_EXPECT_EQ(test, lz4_test_decompress(test, &ctx, param, NULL),
+			LZ4_TEST_SIZE);
+	KUNIT_EXPECT_EQ(test, memcmp(ctx.src, ctx.out, LZ4_TEST_SIZE), 0);
+
+	for (simd = lz4_simd_decoders; *simd; simd++) {
+		if (!(*simd)->valid())
+			continue;
+
+		memset(ctx.out, 0, LZ4_TEST_SIZE);
+		KUNIT_EXPECT_EQ_MSG(test,
+			lz4_test_decompress(test, &ctx, param, *simd),
+			LZ4_TEST_SIZE, "decoder %s", (*simd)->name);
+		KUNIT_EXPECT_EQ_MSG(test,
+			memcmp(ctx.src, ctx.out, LZ4_TEST_SIZE), 0,
+			"decoder %s", (*simd)->name);
+
+		/*
+		 * Truncated input must not decode to the whole block. It is not
+		 * necessarily an error: a cut right after a literal run is a
+		 * valid, shorter block.
+		 */
+		len = min(param->block_size, LZ4_TEST_SIZE);
+		ret = lz4_decompress_safe_using(*simd, ctx.comp, ctx.out,
+				ctx.comp_len[0] / 2, len);
+		KUNIT_EXPECT_LT_MSG(test, ret, len, "decoder %s", (*simd)->name);
+	}
+
+	/* Partial decoding stops at the requested size */
+	memset(ctx.out, 0, LZ4_TEST_SIZE);
+	ret = LZ4_decompress_safe_partial(ctx.comp, ctx.out, ctx.comp_len[0],
+					  param->block_size / 2 + 3,
+					  min(param->block_size, LZ4_TEST_SIZE));
+	KUNIT_EXPECT_EQ(test, ret, param->block_size / 2 + 3);
+	KUNIT_EXPECT_EQ(test, memcmp(ctx.src, ctx.out, ret), 0);
+
+	lz4_test_release(&ctx);
+}
+
+struct lz4_test_bench {
+	struct kunit *test;
+	struct lz4_test_ctx *ctx;
+	const struct lz4_test_param *param;
+	const struct lz4_simd_decoder *simd;
+};
+
+static void lz4_test_bench_fn(void *data)
+{
+	struct lz4_test_bench *b = data;
+
+	lz4_test_decompress(b->test, b->ctx, b->param, b->simd);
+}
+
+static void lz4_test_bench_one(struct kunit *test, struct lz4_test_ctx *ctx,
+			       const struct lz4_test_param *param,
+			       const struct lz4_simd_decoder *simd)
+{
+	struct lz4_test_bench b = {
+		.test = test, .ctx = ctx, .param = param, .simd = simd,
+	};
+	struct kunit_bench bench = {
+		.name = simd ? simd->name : "generic",
+		.fn = lz4_test_bench_fn,
+		.ctx = &b,
+		.warmup = 4,
+		.max_samples = 512,
+		.bytes = LZ4_TEST_SIZE,
+	};
+
+	/* Do not time a decoder that gets it wrong */
+	if (lz4_test_decompress(test, ctx, param, simd) == LZ4_TEST_SIZE)
+		kunit_bench_run(test, &bench, NULL);
+}
+
+static void lz4_test_bench(struct kunit *test)
+{
+	const struct lz4_test_param *param = test->param_value;
+	const struct lz4_simd_decoder * const *simd;
+	struct lz4_test_ctx ctx;
+	u64 comp = 0;
+	int i;
+
+	if (!kunit_bench_enabled(test))
+		kunit_skip(test, "benchmarks disabled or not exclusive");
+
+	lz4_test_prepare(test, &ctx, param);
+
+	for (i = 0; i < ctx.nr_blocks; i++)
+		comp += ctx.comp_len[i];
+	kunit_info(test, "%s: compressed to %llu%%\n", param->name,
+		   div_u64(comp * 100, LZ4_TEST_SIZE));
+
+	lz4_test_bench_one(test, &ctx, param, NULL);
+	for (simd = lz4_simd_decoders; *simd; simd++) {
+		if ((*simd)->valid())
+			lz4_test_bench_one(test, &ctx, param, *simd);
+	}
+
+	lz4_test_release(&ctx);
+}
+
+static struct kunit_case lz4_test_cases[] = {
+	KUNIT_CASE_PARAM(lz4_test_roundtrip, lz4_gen_params),
+	KUNIT_CASE_PARAM(lz4_test_bench, lz4_gen_params),
+	{}
+};
+
+static struct kunit_suite lz4_test_suite = {
+	.name = "lz4",
+	.test_cases = lz4_test_cases,
+	/* for the throughput numbers */
+	.exclusive = true,
+};
+
+kunit_test_suites(&lz4_test_suite);
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+MODULE_LICENSE("GPL");
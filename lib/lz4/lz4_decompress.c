@@ -39,6 +39,10 @@
 #include <linux/module.h>
 #include <linux/kernel.h>
 #include <asm/unaligned.h>
+#include "lz4_simd.h"
+#ifdef LZ4_SIMD
+#include <kunit/visibility.h>
+#endif
 
 /*-*****************************
  *	Decompression functions
@@ -457,22 +461,85 @@ static FORCE_INLINE int LZ4_decompress_generic(
 	return (int) (-(((const char *)ip) - src)) - 1;
 }
 
+#ifdef LZ4_SIMD
+/* Not worth saving the vector registers for less output than this */
+#define LZ4_SIMD_MIN_SIZE	(1 * KB)
+/* Bound the time spent with preemption disabled by the vector unit */
+#define LZ4_SIMD_CHUNK		(64 * KB)
+
+static const struct lz4_simd_decoder *lz4_simd __ro_after_init;
+
+/*
+ * Decode the bulk of the block with the vector unit, then leave the rest,
+ * starting at a sequence boundary, to LZ4_decompress_generic().
+ */
+static FORCE_INLINE int LZ4_decompress_safe_simd(
+	const struct lz4_simd_decoder *simd,
+	const char *src, char *dst, int srcSize, int outputSize,
+	earlyEnd_directive partialDecoding)
+{
+	const BYTE *ip = (const BYTE *)src;
+	const BYTE * const iend = ip + srcSize;
+	BYTE *op = (BYTE *)dst;
+	BYTE * const oend = op + outputSize;
+	BYTE *prev;
+	int ret;
+
+	if (simd && outputSize >= LZ4_SIMD_MIN_SIZE) {
+		do {
+			prev = op;
+			simd->decode(&ip, &op, iend,
+				     op + min_t(size_t, oend - op, LZ4_SIMD_CHUNK),
+				     (BYTE *)dst);
+		} while (op != prev && oend - op > LZ4_SIMD_CHUNK);
+	}
+
+	ret = LZ4_decompress_generic((const char *)ip, (char *)op,
+				     iend - ip, oend - op,
+				     endOnInputSize, partialDecoding,
+				     noDict, (BYTE *)dst, NULL, 0);
+	if (ret < 0)
+		return ret - (int)((const char *)ip - src);
+	return ret + (int)((char *)op - dst);
+}
+
+VISIBLE_IF_KUNIT int lz4_decompress_safe_using(
+	const struct lz4_simd_decoder *simd, const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize)
+{
+	return LZ4_decompress_safe_simd(simd, source, dest, compressedSize,
+					maxDecompressedSize, decode_full_block);
+}
+EXPORT_SYMBOL_IF_KUNIT(lz4_decompress_safe_using);
+#endif
+
 int LZ4_decompress_safe(const char *source, char *dest,
 	int compressedSize, int maxDecompressedSize)
 {
+#ifdef LZ4_SIMD
+	return LZ4_decompress_safe_simd(lz4_simd, source, dest,
+					compressedSize, maxDecompressedSize,
+					decode_full_block);
+#else
 	return LZ4_decompress_generic(source, dest,
 				      compressedSize, maxDecompressedSize,
 				      endOnInputSize, decode_full_block,
 				      noDict, (BYTE *)dest, NULL, 0);
+#endif
 }
 
 int LZ4_decompress_safe_partial(const char *src, char *dst,
 	int compressedSize, int targetOutputSize, int dstCapacity)
 {
 	dstCapacity = min(targetOutputSize, dstCapacity);
+#ifdef LZ4_SIMD
+	return LZ4_decompress_safe_simd(lz4_simd, src, dst, compressedSize,
+					dstCapacity, partial_decode);
+#else
 	return LZ4_decompress_generic(src, dst, compressedSize, dstCapacity,
 				      endOnInputSize, partial_decode,
 				      noDict, (BYTE *)dst, NULL, 0);
+#endif
 }
 
 int LZ4_decompress_fast(const char *source, char *dest, int originalSize)
@@ -715,6 +782,24 @@ EXPORT_SYMBOL(LZ4_decompress_fast_continue);
 EXPORT_SYMBOL(LZ4_decompress_safe_usingDict);
 EXPORT_SYMBOL(LZ4_decompress_fast_usingDict);
 
+#ifdef LZ4_SIMD
+static int __init lz4_decompress_init(void)
+{
+	const struct lz4_simd_decoder * const *simd;
+
+	for (simd = lz4_simd_decoders; *simd; simd++) {
+		if ((!lz4_simd || (*simd)->priority > lz4_simd->priority) &&
+		    (*simd)->valid())
+			lz4_simd = *simd;
+	}
+
+	if (lz4_simd)
+		pr_info("lz4: using %s decompression\n", lz4_simd->name);
+	return 0;
+}
+module_init(lz4_decompress_init);
+#endif
+
 MODULE_LICENSE("Dual BSD/GPL");
 MODULE_DESCRIPTION("LZ4 decompressor");
 #endif
@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * LZ4 sequence decoding loop for the vectorized decoders.
+ *
+ * Included without LZ4_FASTLOOP defined, this only provides the pattern
+ * tables. Otherwise the including file defines LZ4_FASTLOOP, the name of
+ * the function, and the copy primitives, all of which may write up to 31
+ * bytes past @e:
+ *
+ * lz4_copy16(d, s)			copy 16 bytes
+ * lz4_wildcopy32(d, s, e)		copy e - d bytes, the buffers do not
+ *					overlap
+ * lz4_matchcopy(d, s, e, offset)	copy e - d bytes of a match 16 or more
+ *					bytes back
+ * lz4_patterncopy(d, s, e, offset)	copy e - d bytes of a match 1 to 15
+ *					bytes back
+ *
+ * This file deliberately sticks to plain C types: the NEON flavour is built
+ * with <arm_neon.h>, which does not mix with the kernel headers.
+ *
+ * Only sequences that leave LZ4_FASTLOOP_MARGIN bytes of input and output
+ * are decoded, so that none of the copies need bounds checks. Everything
+ * else, the end of the block, matches reaching before @lowPrefix and
+ * malformed input, is left to LZ4_decompress_generic(), which carries on
+ * from the first sequence the loop did not decode.
+ */
+
+#ifndef LZ4_FASTLOOP_COMMON
+#define LZ4_FASTLOOP_COMMON
+
+#define LZ4_FASTLOOP_MARGIN	64
+
+#define LZ4_FL_MINMATCH		4
+#define LZ4_FL_ML_BITS		4
+#define LZ4_FL_ML_MASK		((1U << LZ4_FL_ML_BITS) - 1)
+#define LZ4_FL_RUN_MASK		((1U << (8 - LZ4_FL_ML_BITS)) - 1)
+
+/* lz4_pattern_shuffle[offset][i] = i % offset */
+static const uint8_t lz4_pattern_shuffle[16][16] __attribute__((aligned(16))) = {
+	{ 0 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 },
+	{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	{ 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 },
+	{ 0, 1, 2, 3, 4, 0, 1, 2, 3, 4, 0, 1, 2, 3, 4, 0 },
+	{ 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3 },
+	{ 0, 1, 2, 3, 4, 5, 6, 0, 1, 2, 3, 4, 5, 6, 0, 1 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 0, 1, 2, 3, 4, 5, 6 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 1, 2, 3, 4, 5 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 0, 1, 2, 3, 4 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 2, 3 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 0, 1, 2 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 0, 1 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0 },
+};
+
+/*
+ * A 16 byte pattern of period offset can be stored every
+ * lz4_pattern_step[offset] bytes, the largest multiple of offset <= 16.
+ */
+static const uint8_t lz4_pattern_step[16] = {
+	0, 16, 16, 15, 16, 15, 12, 14, 16, 9, 10, 11, 12, 13, 14, 15,
+};
+
+#endif /* LZ4_FASTLOOP_COMMON */
+
+#ifdef LZ4_FASTLOOP
+
+static void LZ4_FASTLOOP(const uint8_t **ipp, uint8_t **opp,
+			 const uint8_t *iend, uint8_t *oend,
+			 const uint8_t *lowPrefix)
+{
+	const uint8_t *ip = *ipp;
+	uint8_t *op = *opp;
+
+	for (;;) {
+		const uint8_t *seq_ip = ip;
+		uint8_t *seq_op = op;
+		unsigned long length, offset;
+		unsigned int token, s;
+		const uint8_t *match;
+
+		if (iend - ip < LZ4_FASTLOOP_MARGIN ||
+		    oend - op < LZ4_FASTLOOP_MARGIN)
+			break;
+
+		/* literals */
+		token = *ip++;
+		length = token >> LZ4_FL_ML_BITS;
+		if (length == LZ4_FL_RUN_MASK) {
+			do {
+				s = *ip++;
+				length += s;
+			} while (s == 255 && iend - ip > LZ4_FASTLOOP_MARGIN);
+
+			if (s == 255 ||
+			    length + LZ4_FASTLOOP_MARGIN > (unsigned long)(iend - ip) ||
+			    length + LZ4_FASTLOOP_MARGIN > (unsigned long)(oend - op))
+				goto bail;
+
+			lz4_wildcopy32(op, ip, op + length);
+		} else {
+			lz4_copy16(op, ip);
+		}
+		ip += length;
+		op += length;
+
+		/* match */
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (!offset || offset > (unsigned long)(op - lowPrefix))
+			goto bail;
+		match = op - offset;
+
+		length = token & LZ4_FL_ML_MASK;
+		if (length == LZ4_FL_ML_MASK) {
+			do {
+				s = *ip++;
+				length += s;
+			} while (s == 255 && iend - ip > LZ4_FASTLOOP_MARGIN);
+
+			if (s == 255)
+				goto bail;
+		}
+		length += LZ4_FL_MINMATCH;
+		if (length + LZ4_FASTLOOP_MARGIN > (unsigned long)(oend - op))
+			goto bail;
+
+		if (offset < 16)
+			lz4_patterncopy(op, match, op + length, offset);
+		else
+			lz4_matchcopy(op, match, op + length, offset);
+		op += length;
+		continue;
+bail:
+		ip = seq_ip;
+		op = seq_op;
+		break;
+	}
+
+	*ipp = ip;
+	*opp = op;
+}
+#endif /* LZ4_FASTLOOP */
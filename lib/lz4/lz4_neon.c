@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NEON LZ4 decoder glue
+ *
+ * The decoder itself lives in lz4_neon_inner.c, which is built with NEON
+ * enabled and with <arm_neon.h>, so that no NEON instruction ends up outside
+ * a kernel_neon_begin()/kernel_neon_end() pair.
+ */
+#include <linux/types.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include "lz4_simd.h"
+
+void __lz4_neon_decode(const u8 **ip, u8 **op, const u8 *iend, u8 *oend,
+		       const u8 *lowPrefix);
+
+static int lz4_have_neon(void)
+{
+	return cpu_has_neon();
+}
+
+static void lz4_neon_decode(const u8 **ip, u8 **op, const u8 *iend, u8 *oend,
+			    const u8 *lowPrefix)
+{
+	if (!may_use_simd())
+		return;
+
+	kernel_neon_begin();
+	__lz4_neon_decode(ip, op, iend, oend, lowPrefix);
+	kernel_neon_end();
+}
+
+const struct lz4_simd_decoder lz4_simd_neon = {
+	.decode = lz4_neon_decode,
+	.valid = lz4_have_neon,
+	.name = "neon",
+	.priority = 1,
+};
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * NEON LZ4 decoder
+ *
+ * Literals and matches are copied 16 bytes at a time, and matches less than
+ * 16 bytes back are expanded from a 16 byte pattern built with a table
+ * lookup. Built with NEON enabled, so only to be called between
+ * kernel_neon_begin() and kernel_neon_end(), see lz4_neon.c.
+ */
+
+#include <arm_neon.h>
+
+#include "lz4_fastloop.h"
+
+#ifdef CONFIG_ARM
+/*
+ * AArch32 does not provide this intrinsic natively because it does not
+ * implement the underlying instruction. AArch32 only provides a 64-bit
+ * wide vtbl.8 instruction, so use that instead.
+ */
+static uint8x16_t vqtbl1q_u8(uint8x16_t a, uint8x16_t b)
+{
+	union {
+		uint8x16_t	val;
+		uint8x8x2_t	pair;
+	} __a = { a };
+
+	return vcombine_u8(vtbl2_u8(__a.pair, vget_low_u8(b)),
+			   vtbl2_u8(__a.pair, vget_high_u8(b)));
+}
+#endif
+
+static inline void lz4_copy16(uint8_t *d, const uint8_t *s)
+{
+	vst1q_u8(d, vld1q_u8(s));
+}
+
+static inline void lz4_wildcopy32(uint8_t *d, const uint8_t *s, uint8_t *e)
+{
+	do {
+		vst1q_u8(d, vld1q_u8(s));
+		vst1q_u8(d + 16, vld1q_u8(s + 16));
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
+static inline void lz4_matchcopy(uint8_t *d, const uint8_t *s, uint8_t *e,
+				 unsigned long offset)
+{
+	do {
+		vst1q_u8(d, vld1q_u8(s));
+		d += 16;
+		s += 16;
+	} while (d < e);
+}
+
+static inline void lz4_patterncopy(uint8_t *d, const uint8_t *s, uint8_t *e,
+				   unsigned long offset)
+{
+	uint8x16_t v = vqtbl1q_u8(vld1q_u8(s),
+				  vld1q_u8(lz4_pattern_shuffle[offset]));
+	unsigned int step = lz4_pattern_step[offset];
+
+	do {
+		vst1q_u8(d, v);
+		d += step;
+	} while (d < e);
+}
+
+#define LZ4_FASTLOOP	lz4_neon_fastloop
+#include "lz4_fastloop.h"
+
+void __lz4_neon_decode(const uint8_t **ip, uint8_t **op, const uint8_t *iend,
+		       uint8_t *oend, const uint8_t *lowPrefix)
+{
+	lz4_neon_fastloop(ip, op, iend, oend, lowPrefix);
+}
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Vectorized LZ4 decoders
+ *
+ * The decoder used by lz4_decompress.c is picked at initialization, as the
+ * valid one with the highest priority.
+ */
+#include <linux/module.h>
+#include <linux/types.h>
+#include "lz4_simd.h"
+
+const struct lz4_simd_decoder * const lz4_simd_decoders[] = {
+#ifdef CONFIG_X86
+	&lz4_simd_avx2,
+	&lz4_simd_sse2,
+#endif
+#ifdef CONFIG_KERNEL_MODE_NEON
+	&lz4_simd_neon,
+#endif
+	NULL
+};
+EXPORT_SYMBOL_GPL(lz4_simd_decoders);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Vectorized LZ4 decoders");
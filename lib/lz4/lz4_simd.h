@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __LZ4_SIMD_H__
+#define __LZ4_SIMD_H__
+
+/*
+ * Vectorized decoding of the bulk of a block for LZ4_decompress_safe() and
+ * LZ4_decompress_safe_partial(), see lz4_fastloop.h. Not available to the
+ * pre-boot decompressors, which build lz4_decompress.c with STATIC defined.
+ */
+#if !defined(STATIC) && (defined(CONFIG_X86) || defined(CONFIG_KERNEL_MODE_NEON))
+#define LZ4_SIMD	1
+#endif
+
+struct lz4_simd_decoder {
+	/*
+	 * Decode whole sequences from *ip to *op, leaving both at the first
+	 * sequence not decoded. Does nothing when the vector unit cannot be
+	 * used in the current context.
+	 */
+	void (*decode)(const u8 **ip, u8 **op, const u8 *iend, u8 *oend,
+		       const u8 *lowPrefix);
+	int (*valid)(void);
+	const char *name;
+	int priority;
+};
+
+extern const struct lz4_simd_decoder lz4_simd_sse2;
+extern const struct lz4_simd_decoder lz4_simd_avx2;
+extern const struct lz4_simd_decoder lz4_simd_neon;
+
+/* NULL terminated, in lz4_simd.c */
+extern const struct lz4_simd_decoder * const lz4_simd_decoders[];
+
+#if IS_ENABLED(CONFIG_KUNIT)
+int lz4_decompress_safe_using(const struct lz4_simd_decoder *simd,
+			      const char *source, char *dest,
+			      int compressedSize, int maxDecompressedSize);
+#endif
+
+#endif /* __LZ4_SIMD_H__ */
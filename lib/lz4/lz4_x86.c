@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * SSE2 and AVX2 LZ4 decoders
+ *
+ * Literals and matches are copied 16 bytes (SSE2) or 32 bytes (AVX2) at a
+ * time, and matches less than 16 bytes back are expanded from a 16 byte
+ * pattern, which AVX2 builds with a single byte shuffle.
+ */
+#include <linux/types.h>
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include "lz4_simd.h"
+#include "lz4_fastloop.h"
+
+#define LZ4_V16(p)	(*(u8 (*)[16])(p))
+#define LZ4_V32(p)	(*(u8 (*)[32])(p))
+
+static __always_inline void lz4_sse2_copy16(u8 *d, const u8 *s)
+{
+	asm volatile("movdqu %1, %%xmm0\n\t"
+		     "movdqu %%xmm0, %0"
+		     : "=m" (LZ4_V16(d)) : "m" (LZ4_V16(s)));
+}
+
+static __always_inline void lz4_sse2_wildcopy32(u8 *d, const u8 *s, u8 *e)
+{
+	do {
+		lz4_sse2_copy16(d, s);
+		lz4_sse2_copy16(d + 16, s + 16);
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
+static __always_inline void lz4_sse2_matchcopy(u8 *d, const u8 *s, u8 *e,
+					       unsigned long offset)
+{
+	do {
+		lz4_sse2_copy16(d, s);
+		d += 16;
+		s += 16;
+	} while (d < e);
+}
+
+static __always_inline void lz4_sse2_store_pattern(u8 *d, u8 *e,
+						   unsigned long offset)
+{
+	unsigned int step = lz4_pattern_step[offset];
+
+	do {
+		asm volatile("movdqu %%xmm0, %0" : "=m" (LZ4_V16(d)));
+		d += step;
+	} while (d < e);
+}
+
+static void lz4_sse2_patterncopy(u8 *d, const u8 *s, u8 *e,
+				 unsigned long offset)
+{
+	u8 v[16];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		v[i] = s[lz4_pattern_shuffle[offset][i]];
+
+	asm volatile("movdqu %0, %%xmm0" : : "m" (LZ4_V16(v)));
+	lz4_sse2_store_pattern(d, e, offset);
+}
+
+static __always_inline void lz4_avx2_wildcopy32(u8 *d, const u8 *s, u8 *e)
+{
+	do {
+		asm volatile("vmovdqu %1, %%ymm0\n\t"
+			     "vmovdqu %%ymm0, %0"
+			     : "=m" (LZ4_V32(d)) : "m" (LZ4_V32(s)));
+		d += 32;
+		s += 32;
+	} while (d < e);
+}
+
+/*
+ * Everything below runs with the upper halves of the ymm registers dirty, so
+ * it must stick to VEX encoded instructions: mixing in legacy SSE ones costs
+ * a state transition each time.
+ */
+static __always_inline void lz4_avx2_copy16(u8 *d, const u8 *s)
+{
+	asm volatile("vmovdqu %1, %%xmm0\n\t"
+		     "vmovdqu %%xmm0, %0"
+		     : "=m" (LZ4_V16(d)) : "m" (LZ4_V16(s)));
+}
+
+static __always_inline void lz4_avx2_matchcopy(u8 *d, const u8 *s, u8 *e,
+					       unsigned long offset)
+{
+	/* A 32 byte load must not reach bytes this copy is yet to store */
+	if (offset >= 32) {
+		lz4_avx2_wildcopy32(d, s, e);
+		return;
+	}
+
+	do {
+		lz4_avx2_copy16(d, s);
+		d += 16;
+		s += 16;
+	} while (d < e);
+}
+
+static __always_inline void lz4_avx2_patterncopy(u8 *d, const u8 *s, u8 *e,
+						 unsigned long offset)
+{
+	unsigned int step = lz4_pattern_step[offset];
+
+	asm volatile("vmovdqu %0, %%xmm0\n\t"
+		     "vpshufb %1, %%xmm0, %%xmm0"
+		     : : "m" (LZ4_V16(s)), "m" (lz4_pattern_shuffle[offset]));
+
+	do {
+		asm volatile("vmovdqu %%xmm0, %0" : "=m" (LZ4_V16(d)));
+		d += step;
+	} while (d < e);
+}
+
+#define LZ4_FASTLOOP		lz4_sse2_fastloop
+#define lz4_copy16		lz4_sse2_copy16
+#define lz4_wildcopy32		lz4_sse2_wildcopy32
+#define lz4_matchcopy		lz4_sse2_matchcopy
+#define lz4_patterncopy		lz4_sse2_patterncopy
+#include "lz4_fastloop.h"
+#undef LZ4_FASTLOOP
+#undef lz4_copy16
+#undef lz4_wildcopy32
+#undef lz4_matchcopy
+#undef lz4_patterncopy
+
+#define LZ4_FASTLOOP		lz4_avx2_fastloop
+#define lz4_copy16		lz4_avx2_copy16
+#define lz4_wildcopy32		lz4_avx2_wildcopy32
+#define lz4_matchcopy		lz4_avx2_matchcopy
+#define lz4_patterncopy		lz4_avx2_patterncopy
+#include "lz4_fastloop.h"
+
+static int lz4_have_sse2(void)
+{
+	return boot_cpu_has(X86_FEATURE_XMM) &&
+		boot_cpu_has(X86_FEATURE_XMM2);
+}
+
+static void lz4_sse2_decode(const u8 **ip, u8 **op, const u8 *iend, u8 *oend,
+			    const u8 *lowPrefix)
+{
+	if (!irq_fpu_usable())
+		return;
+
+	kernel_fpu_begin();
+	lz4_sse2_fastloop(ip, op, iend, oend, lowPrefix);
+	kernel_fpu_end();
+}
+
+const struct lz4_simd_decoder lz4_simd_sse2 = {
+	.decode = lz4_sse2_decode,
+	.valid = lz4_have_sse2,
+	.name = "sse2",
+	.priority = 1,
+};
+
+static int lz4_have_avx2(void)
+{
+	return boot_cpu_has(X86_FEATURE_AVX2) &&
+		boot_cpu_has(X86_FEATURE_AVX);
+}
+
+static void lz4_avx2_decode(const u8 **ip, u8 **op, const u8 *iend, u8 *oend,
+			    const u8 *lowPrefix)
+{
+	if (!irq_fpu_usable())
+		return;
+
+	kernel_fpu_begin();
+	lz4_avx2_fastloop(ip, op, iend, oend, lowPrefix);
+	asm volatile("vzeroupper");
+	kernel_fpu_end();
+}
+
+const struct lz4_simd_decoder lz4_simd_avx2 = {
+	.decode = lz4_avx2_decode,
+	.valid = lz4_have_avx2,
+	.name = "avx2",
+	.priority = 2,
+};
@@ -225,6 +225,24 @@ extern UDItype __udiv_qrnnd(UDItype *, UDItype, UDItype, UDItype);
 #define UDIV_TIME 100
 #endif /* __arm__ */
 
+/***************************************
+	**************  ARM64, x86-64  ********
+	***************************************/
+#if (defined(__aarch64__) || defined(__x86_64__)) && W_TYPE_SIZE == 64
+/*
+ * Both have a 64x64->128 multiply (umulh, mulq), which the compilers emit
+ * for the TI mode product without a library call.
+ */
+#define umul_ppmm(w1, w0, u, v) \
+do {									\
+	typedef unsigned int __ll_UTItype __attribute__((mode(TI)));	\
+	__ll_UTItype __ll = (__ll_UTItype)(u) * (v);			\
+	w1 = __ll >> 64;						\
+	w0 = __ll;							\
+} while (0)
+#define UMUL_TIME 5
+#endif /* __aarch64__ || __x86_64__ */
+
 /***************************************
 	**************  CLIPPER  **************
 	***************************************/
@@ -189,6 +189,25 @@ int mpihelp_mul_karatsuba_case(mpi_ptr_t prodp,
 			       mpi_ptr_t vp, mpi_size_t vsize,
 			       struct karatsuba_ctx *ctx);
 
+/*-- mpih-mont.c --*/
+
+struct mpi_mont_ctx {
+	mpi_ptr_t mp;		/* the odd modulus */
+	mpi_size_t n;		/* its size in limbs */
+	mpi_limb_t minv;	/* -MP^-1 mod 2^BITS_PER_MPI_LIMB */
+	mpi_ptr_t tp;		/* 2 * N limbs for the products */
+	mpi_ptr_t tspace;	/* 2 * N limbs for Karatsuba squaring */
+	struct karatsuba_ctx karactx;
+};
+
+int mpihelp_mont_init(struct mpi_mont_ctx *ctx, mpi_ptr_t mp, mpi_size_t n);
+void mpihelp_mont_release(struct mpi_mont_ctx *ctx);
+int mpihelp_mont_mul(struct mpi_mont_ctx *ctx, mpi_ptr_t rp,
+		     mpi_ptr_t ap, mpi_ptr_t bp);
+void mpihelp_mont_sqr(struct mpi_mont_ctx *ctx, mpi_ptr_t rp, mpi_ptr_t ap);
+void mpihelp_mont_reduce(struct mpi_mont_ctx *ctx, mpi_ptr_t rp,
+			 mpi_ptr_t ap);
+
 /*-- generic_mpih-mul1.c --*/
 mpi_limb_t mpihelp_mul_1(mpi_ptr_t res_ptr, mpi_ptr_t s1_ptr,
 			 mpi_size_t s1_size, mpi_limb_t s2_limb);
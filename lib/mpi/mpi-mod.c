@@ -22,9 +22,9 @@ struct barrett_ctx_s {
 
 
 
-void mpi_mod(MPI rem, MPI dividend, MPI divisor)
+int mpi_mod(MPI rem, MPI dividend, MPI divisor)
 {
-	mpi_fdiv_r(rem, dividend, divisor);
+	return mpi_fdiv_r(rem, dividend, divisor);
 }
 
 /* This function returns a new context for Barrett based operations on
@@ -18,6 +18,134 @@
 #include "mpi-internal.h"
 #include "longlong.h"
 
+/****************
+ * Window size for the sliding window exponentiation, as in Libgcrypt.
+ * The table of odd powers has 2^(W-1) entries.
+ */
+static int mpi_powm_window(unsigned int ebits)
+{
+	if (ebits > 512)
+		return 5;
+	if (ebits > 256)
+		return 4;
+	if (ebits > 128)
+		return 3;
+	if (ebits > 64)
+		return 2;
+	return 1;
+}
+
+/****************
+ * RES = BASE ^ EXP mod MOD for an odd, positive MOD and a non-negative BASE.
+ *
+ * All the arithmetic is done in Montgomery form, where a modular product
+ * is reduced with multiplications instead of a division, and the exponent
+ * is scanned with a sliding window: every run of up to W bits ending in a
+ * one costs a single multiplication by a precomputed odd power of BASE.
+ */
+static int mpi_powm_mont(MPI res, MPI base, MPI exp, MPI mod)
+{
+	struct mpi_mont_ctx ctx;
+	mpi_size_t n = mod->nlimbs;
+	mpi_ptr_t tbl = NULL, acc = NULL, b2;
+	unsigned int ebits, w, i, j, k, wval;
+	bool started = false;
+	MPI t;
+	int rc;
+
+	rc = mpihelp_mont_init(&ctx, mod->d, n);
+	if (rc)
+		return rc;
+
+	rc = -ENOMEM;
+	ebits = mpi_get_nbits(exp);
+	w = mpi_powm_window(ebits);
+	tbl = mpi_alloc_limb_space((1 << (w - 1)) * n);
+	acc = mpi_alloc_limb_space(n);
+	t = mpi_alloc(2 * n + 1);
+	if (!tbl || !acc || !t)
+		goto leave;
+
+	/*
+	 * tbl[0] = BASE * R mod MOD. Once reduced, T fits its 2N + 1 limbs
+	 * through the shift and the second reduction without a resize.
+	 */
+	if (mpi_mod(t, base, mod) < 0)
+		goto leave;
+	mpi_lshift_limbs(t, n);
+	if (mpi_mod(t, t, mod) < 0)
+		goto leave;
+	MPN_ZERO(tbl, n);
+	MPN_COPY(tbl, t->d, t->nlimbs);
+
+	/* tbl[k] = BASE^(2k + 1) * R mod MOD */
+	if (w > 1) {
+		b2 = acc;
+		mpihelp_mont_sqr(&ctx, b2, tbl);
+		for (k = 1; k < (1 << (w - 1)); k++) {
+			if (mpihelp_mont_mul(&ctx, tbl + k * n,
+					     tbl + (k - 1) * n, b2) < 0)
+				goto leave;
+		}
+	}
+
+	for (i = ebits; i > 0; ) {
+		if (!mpi_test_bit(exp, i - 1)) {
+			if (started)
+				mpihelp_mont_sqr(&ctx, acc, acc);
+			i--;
+			continue;
+		}
+
+		/* The window is bits I - 1 down to J, with bit J set */
+		j = i > w ? i - w : 0;
+		while (!mpi_test_bit(exp, j))
+			j++;
+
+		wval = 0;
+		for (k = i; k > j; k--)
+			wval = (wval << 1) | mpi_test_bit(exp, k - 1);
+
+		if (started) {
+			for (k = i; k > j; k--)
+				mpihelp_mont_sqr(&ctx, acc, acc);
+			if (mpihelp_mont_mul(&ctx, acc, acc,
+					     tbl + (wval >> 1) * n) < 0)
+				goto leave;
+		} else {
+			MPN_COPY(acc, tbl + (wval >> 1) * n, n);
+			started = true;
+		}
+
+		i = j;
+		cond_resched();
+	}
+
+	if (!started) {
+		/* EXP is zero, with leading zero limbs */
+		mpi_set_ui(res, n == 1 && mod->d[0] == 1 ? 0 : 1);
+		rc = 0;
+		goto leave;
+	}
+
+	mpihelp_mont_reduce(&ctx, acc, acc);
+
+	if (mpi_resize(res, n) < 0)
+		goto leave;
+	MPN_COPY(res->d, acc, n);
+	res->nlimbs = n;
+	MPN_NORMALIZE(res->d, res->nlimbs);
+	res->sign = 0;
+	rc = 0;
+
+leave:
+	mpi_free(t);
+	mpi_free_limb_space(acc);
+	mpi_free_limb_space(tbl);
+	mpihelp_mont_release(&ctx);
+	return rc;
+}
+
 /****************
  * RES = BASE ^ EXP mod MOD
  */
@@ -63,6 +191,9 @@ int mpi_powm(MPI res, MPI base, MPI exp, MPI mod)
 		goto leave;
 	}
 
+	if ((mod->d[0] & 1) && !msign && !base->sign)
+		return mpi_powm_mont(res, base, exp, mod);
+
 	/* Normalize MOD (i.e. make its most significant bit set) as required by
 	 * mpn_divrem.  This will make the intermediate values in the calculation
 	 * slightly larger, but the correct result is obtained after a final
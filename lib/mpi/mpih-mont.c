@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* mpih-mont.c  -  Montgomery multiplication
+ *
+ * Numbers modulo an odd M of N limbs are kept multiplied by
+ * R = 2^(N * BITS_PER_MPI_LIMB), so that a modular product only needs a
+ * Montgomery reduction, which divides by R, instead of a long division by M.
+ */
+
+#include "mpi-internal.h"
+
+/****************
+ * Return -M0^-1 mod 2^BITS_PER_MPI_LIMB for an odd M0.  M0 is its own
+ * inverse modulo 8, and each Newton step doubles the number of correct
+ * low bits.
+ */
+static mpi_limb_t mont_minv(mpi_limb_t m0)
+{
+	mpi_limb_t inv = m0;
+	int bits;
+
+	for (bits = 3; bits < BITS_PER_MPI_LIMB; bits *= 2)
+		inv *= 2 - m0 * inv;
+
+	return -inv;
+}
+
+int mpihelp_mont_init(struct mpi_mont_ctx *ctx, mpi_ptr_t mp, mpi_size_t n)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->mp = mp;
+	ctx->n = n;
+	ctx->minv = mont_minv(mp[0]);
+
+	ctx->tp = mpi_alloc_limb_space(2 * n);
+	if (!ctx->tp)
+		return -ENOMEM;
+
+	if (n >= KARATSUBA_THRESHOLD) {
+		ctx->tspace = mpi_alloc_limb_space(2 * n);
+		if (!ctx->tspace) {
+			mpi_free_limb_space(ctx->tp);
+			return -ENOMEM;
+		}
+	}
+	return 0;
+}
+
+void mpihelp_mont_release(struct mpi_mont_ctx *ctx)
+{
+	mpihelp_release_karatsuba_ctx(&ctx->karactx);
+	mpi_free_limb_space(ctx->tspace);
+	mpi_free_limb_space(ctx->tp);
+}
+
+/****************
+ * RP = TP * R^-1 mod M, for the 2 * N limbs TP < M * R, which are clobbered.
+ * The result is fully reduced.
+ */
+static void mont_redc(struct mpi_mont_ctx *ctx, mpi_ptr_t rp)
+{
+	mpi_ptr_t tp = ctx->tp, mp = ctx->mp;
+	mpi_size_t i, n = ctx->n;
+	mpi_limb_t cy = 0, c;
+
+	/* Clear TP limb by limb by adding multiples of M */
+	for (i = 0; i < n; i++) {
+		c = mpihelp_addmul_1(tp + i, mp, n, tp[i] * ctx->minv);
+		cy += mpihelp_add_1(tp + i + n, tp + i + n, n - i, c);
+	}
+
+	/* What is left, CY:TP[N..2N-1], is below 2 * M */
+	if (cy || mpihelp_cmp(tp + n, mp, n) >= 0)
+		mpihelp_sub_n(rp, tp + n, mp, n);
+	else
+		MPN_COPY(rp, tp + n, n);
+}
+
+/****************
+ * RP = AP * BP * R^-1 mod M.  AP and BP are N limbs, below M, and RP may
+ * be either of them.
+ */
+int mpihelp_mont_mul(struct mpi_mont_ctx *ctx, mpi_ptr_t rp,
+		     mpi_ptr_t ap, mpi_ptr_t bp)
+{
+	mpi_limb_t tmp;
+
+	if (ctx->n < KARATSUBA_THRESHOLD) {
+		if (mpihelp_mul(ctx->tp, ap, ctx->n, bp, ctx->n, &tmp) < 0)
+			return -ENOMEM;
+	} else {
+		if (mpihelp_mul_karatsuba_case(ctx->tp, ap, ctx->n, bp, ctx->n,
+					       &ctx->karactx) < 0)
+			return -ENOMEM;
+	}
+
+	mont_redc(ctx, rp);
+	return 0;
+}
+
+/****************
+ * RP = AP * AP * R^-1 mod M.  AP is N limbs, below M, and RP may be AP.
+ */
+void mpihelp_mont_sqr(struct mpi_mont_ctx *ctx, mpi_ptr_t rp, mpi_ptr_t ap)
+{
+	if (ctx->n < KARATSUBA_THRESHOLD)
+		mpih_sqr_n_basecase(ctx->tp, ap, ctx->n);
+	else
+		mpih_sqr_n(ctx->tp, ap, ctx->n, ctx->tspace);
+
+	mont_redc(ctx, rp);
+}
+
+/****************
+ * RP = AP * R^-1 mod M, taking AP, N limbs below M, out of Montgomery form.
+ * RP may be AP.
+ */
+void mpihelp_mont_reduce(struct mpi_mont_ctx *ctx, mpi_ptr_t rp, mpi_ptr_t ap)
+{
+	MPN_COPY(ctx->tp, ap, ctx->n);
+	MPN_ZERO(ctx->tp + ctx->n, ctx->n);
+	mont_redc(ctx, rp);
+}
@@ -58,31 +58,67 @@
 
 	/* form the syndromes; i.e., evaluate data(x) at roots of
 	 * g(x) */
-	for (i = 0; i < nroots; i++)
-		syn[i] = (((uint16_t) data[0]) ^ invmsk) & msk;
+	if (rs->synmul) {
+		/* Symbols of up to 8 bits: table driven, see syndrome.h */
+		const uint8_t *tbl;
 
-	for (j = 1; j < len; j++) {
-		for (i = 0; i < nroots; i++) {
-			if (syn[i] == 0) {
-				syn[i] = (((uint16_t) data[j]) ^
-					  invmsk) & msk;
-			} else {
-				syn[i] = ((((uint16_t) data[j]) ^
-					   invmsk) & msk) ^
-					alpha_to[rs_modnn(rs, index_of[syn[i]] +
-						       (fcr + i) * prim)];
+		j = 0;
+		if (sizeof(data[0]) == 1)
+			j = rs_syndrome_simd(rs, (const uint8_t *)data, len,
+					     invmsk, syn);
+		if (!j)
+			memset(syn, 0, nroots * sizeof(syn[0]));
+
+		for (; j < len; j++) {
+			u = (((uint16_t) data[j]) ^ invmsk) & msk;
+			for (i = 0, tbl = rs->synmul; i < nroots;
+			     i++, tbl += RS_SYNMUL_SIZE)
+				syn[i] = rs_synmul(tbl, syn[i]) ^ u;
+		}
+
+		for (j = 0; j < nroots; j++) {
+			u = ((uint16_t) par[j]) & msk;
+			for (i = 0, tbl = rs->synmul; i < nroots;
+			     i++, tbl += RS_SYNMUL_SIZE)
+				syn[i] = rs_synmul(tbl, syn[i]) ^ u;
+		}
+	} else {
+		/*
+		 * The roots in index form, in the yet unused reg[], so that
+		 * each step needs a single conditional subtraction instead
+		 * of a rs_modnn() loop.
+		 */
+		for (i = 0; i < nroots; i++)
+			reg[i] = rs_modnn(rs, (fcr + i) * prim);
+
+		for (i = 0; i < nroots; i++)
+			syn[i] = (((uint16_t) data[0]) ^ invmsk) & msk;
+
+		for (j = 1; j < len; j++) {
+			u = (((uint16_t) data[j]) ^ invmsk) & msk;
+			for (i = 0; i < nroots; i++) {
+				if (syn[i] == 0) {
+					syn[i] = u;
+				} else {
+					tmp = index_of[syn[i]] + reg[i];
+					if (tmp >= nn)
+						tmp -= nn;
+					syn[i] = u ^ alpha_to[tmp];
+				}
 			}
 		}
-	}
 
-	for (j = 0; j < nroots; j++) {
-		for (i = 0; i < nroots; i++) {
-			if (syn[i] == 0) {
-				syn[i] = ((uint16_t) par[j]) & msk;
-			} else {
-				syn[i] = (((uint16_t) par[j]) & msk) ^
-					alpha_to[rs_modnn(rs, index_of[syn[i]] +
-						       (fcr+i)*prim)];
+		for (j = 0; j < nroots; j++) {
+			u = ((uint16_t) par[j]) & msk;
+			for (i = 0; i < nroots; i++) {
+				if (syn[i] == 0) {
+					syn[i] = u;
+				} else {
+					tmp = index_of[syn[i]] + reg[i];
+					if (tmp >= nn)
+						tmp -= nn;
+					syn[i] = u ^ alpha_to[tmp];
+				}
 			}
 		}
 	}
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit benchmarks for the Reed-Solomon decoder
+ *
+ * Times the decoding of error free blocks, by far the common case, with the
+ * codes of some users of the library. The correction tests stay in
+ * test_rslib.c.
+ */
+
+#include <kunit/bench.h>
+#include <kunit/test.h>
+
+#include <linux/random.h>
+#include <linux/rslib.h>
+
+struct rslib_test_code {
+	const char *name;
+	int symsize;
+	int genpoly;
+	int fcs;
+	int prim;
+	int nroots;
+	int dlen;
+};
+
+static const struct rslib_test_code rslib_test_codes[] = {
+	{ "ramoops",	 8,  0x11d, 0,   1, 16, 128 },
+	{ "rs(255,239)", 8,  0x11d, 0,   1, 16, 239 },
+	{ "diskonchip",	 10, 0x409, 510, 1, 4,  512 },
+};
+
+KUNIT_ARRAY_PARAM_DESC(rslib, rslib_test_codes, name);
+
+struct rslib_test_ctx {
+	struct rs_control *rs;
+	const struct rslib_test_code *code;
+	uint16_t par[16];
+	uint16_t *c16;
+	uint8_t *c8;
+};
+
+static int rslib_test_decode(struct rslib_test_ctx *ctx)
+{
+	int dlen = ctx->code->dlen;
+
+#if defined(CONFIG_REED_SOLOMON_ENC8) && defined(CONFIG_REED_SOLOMON_DEC8)
+	/* decode_rs8() has its own syndrome code for byte wide data */
+	if (ctx->code->symsize <= 8)
+		return decode_rs8(ctx->rs, ctx->c8, ctx->par, dlen, NULL, 0,
+				  NULL, 0, NULL);
+#endif
+	return decode_rs16(ctx->rs, ctx->c16, ctx->par, dlen, NULL, 0, NULL,
+			   0, NULL);
+}
+
+static void rslib_test_bench_fn(void *data)
+{
+	rslib_test_decode(data);
+}
+
+static void rslib_test_bench(struct kunit *test)
+{
+	const struct rslib_test_code *code = test->param_value;
+	struct rslib_test_ctx *ctx;
+	struct kunit_bench bench = {
+		.name = "decode",
+		.fn = rslib_test_bench_fn,
+		.loops = 16,
+		.bytes = code->dlen,
+	};
+	int i, ret;
+
+	if (!kunit_bench_enabled(test))
+		kunit_skip(test, "benchmarks disabled or not exclusive");
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	ctx->code = code;
+	ctx->c16 = kunit_kmalloc_array(test, code->dlen, sizeof(*ctx->c16),
+				       GFP_KERNEL);
+	ctx->c8 = kunit_kmalloc(test, code->dlen, GFP_KERNEL);
+	KUNIT_ASSERT_TRUE(test, ctx->c16 && ctx->c8);
+
+	ctx->rs = init_rs(code->symsize, code->genpoly, code->fcs, code->prim,
+			  code->nroots);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->rs);
+
+	for (i = 0; i < code->dlen; i++)
+		ctx->c8[i] = ctx->c16[i] = get_random_u32() & ctx->rs->codec->nn;
+
+#if defined(CONFIG_REED_SOLOMON_ENC8) && defined(CONFIG_REED_SOLOMON_DEC8)
+	if (code->symsize <= 8)
+		encode_rs8(ctx->rs, ctx->c8, code->dlen, ctx->par, 0);
+	else
+#endif
+		encode_rs16(ctx->rs, ctx->c16, code->dlen, ctx->par, 0);
+
+	/* Do not time a decoder that finds errors where there are none */
+	ret = rslib_test_decode(ctx);
+	KUNIT_EXPECT_EQ(test, ret, 0);
+	if (!ret) {
+		bench.ctx = ctx;
+		kunit_bench_run(test, &bench, NULL);
+	}
+
+	free_rs(ctx->rs);
+}
+
+static struct kunit_case rslib_test_cases[] = {
+	KUNIT_CASE_PARAM(rslib_test_bench, rslib_gen_params),
+	{}
+};
+
+static struct kunit_suite rslib_test_suite = {
+	.name = "rslib",
+	.test_cases = rslib_test_cases,
+	/* for the throughput numbers */
+	.exclusive = true,
+};
+
+kunit_test_suites(&rslib_test_suite);
+
+MODULE_LICENSE("GPL");
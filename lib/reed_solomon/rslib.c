@@ -37,6 +37,8 @@
 #include <linux/slab.h>
 #include <linux/mutex.h>
 
+#include "syndrome.h"
+
 enum {
 	RS_DECODE_LAMBDA,
 	RS_DECODE_SYN,
@@ -54,6 +56,54 @@ static LIST_HEAD(codec_list);
 /* Protection for the list */
 static DEFINE_MUTEX(rslistlock);
 
+/* @x times alpha^@e, or 0 if @x is not a symbol of the field */
+static uint8_t synmul_entry(struct rs_codec *rs, int x, int e)
+{
+	if (x == 0 || x > rs->nn)
+		return 0;
+	return rs->alpha_to[rs_modnn(rs, rs->index_of[x] + e)];
+}
+
+/* Fill the tables of syndrome.h for the root alpha^@root */
+static void synmul_init(struct rs_codec *rs, uint8_t *tbl, int root)
+{
+	int m, x;
+
+	for (m = 0; m < 5; m++, tbl += RS_SYNMUL_POW(1)) {
+		for (x = 0; x < 16; x++) {
+			tbl[x] = synmul_entry(rs, x, root);
+			tbl[16 + x] = synmul_entry(rs, x << 4, root);
+		}
+		root = rs_modnn(rs, 2 * root);
+	}
+}
+
+/**
+ * rs_syndrome_simd - Syndromes of the leading data symbols, vectorized
+ * @rs:		the rs codec, with 8 bit symbols
+ * @data:	data symbols
+ * @len:	number of data symbols
+ * @invmsk:	invert data mask
+ * @syn:	syndromes in polynomial form, one per root
+ *
+ * Returns the number of symbols accounted for in @syn, a multiple of 16,
+ * or 0 if no vector unit can be used, in which case @syn is untouched.
+ */
+static inline int rs_syndrome_simd(const struct rs_codec *rs,
+				   const uint8_t *data, int len,
+				   uint16_t invmsk, uint16_t *syn)
+{
+	if (rs->mm != 8 || len < RS_SYNDROME_SIMD_MIN)
+		return 0;
+#if defined(CONFIG_REED_SOLOMON_DEC8) && defined(CONFIG_X86)
+	return rs_syndrome_ssse3(rs, data, len / 16, invmsk, syn);
+#elif defined(CONFIG_REED_SOLOMON_DEC8) && defined(CONFIG_KERNEL_MODE_NEON)
+	return rs_syndrome_neon(rs, data, len / 16, invmsk, syn);
+#else
+	return 0;
+#endif
+}
+
 /**
  * codec_init - Initialize a Reed-Solomon codec
  * @symsize:	symbol size, bits (1-8)
@@ -152,11 +202,22 @@ static struct rs_codec *codec_init(int symsize, int gfpoly, int (*gffunc)(int),
 	for (i = 0; i <= nroots; i++)
 		rs->genpoly[i] = rs->index_of[rs->genpoly[i]];
 
+	/* Multiplication tables for computing the syndromes in decode_rs() */
+	if (symsize <= 8) {
+		rs->synmul = kmalloc_array(nroots, RS_SYNMUL_SIZE, gfp);
+		if (!rs->synmul)
+			goto err;
+		for (i = 0, root = fcr * prim; i < nroots; i++, root += prim)
+			synmul_init(rs, rs->synmul + i * RS_SYNMUL_SIZE,
+				    rs_modnn(rs, root));
+	}
+
 	rs->users = 1;
 	list_add(&rs->list, &codec_list);
 	return rs;
 
 err:
+	kfree(rs->synmul);
 	kfree(rs->genpoly);
 	kfree(rs->index_of);
 	kfree(rs->alpha_to);
@@ -188,6 +249,7 @@ void free_rs(struct rs_control *rs)
 		kfree(cd->alpha_to);
 		kfree(cd->index_of);
 		kfree(cd->genpoly);
+		kfree(cd->synmul);
 		kfree(cd);
 	}
 	mutex_unlock(&rslistlock);
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Syndrome computation helpers for the Reed Solomon decoder
+ *
+ * For symbol sizes up to 8 bits, the multiplication of a symbol by a root
+ * of the generator polynomial is linear over GF(2), so it is the xor of
+ * the products of its low and high nibble, each looked up in a 16 entry
+ * table. Tables of that size fit a vector register, and a byte shuffle
+ * then multiplies 16 symbols at once, as lib/raid6 does for its recovery.
+ */
+#ifndef _RS_SYNDROME_H
+#define _RS_SYNDROME_H
+
+/* Also built into the NEON intrinsics object, so no kernel headers here */
+struct rs_codec;
+
+/*
+ * rs_codec::synmul holds, for each root, the low and high nibble tables of
+ * the multiplication by the root, then by its 2nd, 4th, 8th and 16th power.
+ */
+#define RS_SYNMUL_POW(m)	((m) * 32)	/* root^(2^m) */
+#define RS_SYNMUL_SIZE		RS_SYNMUL_POW(5)
+
+/* The vector code is worth its setup from this many symbols on */
+#define RS_SYNDROME_SIMD_MIN	64
+
+static inline uint8_t rs_synmul(const uint8_t *tbl, uint8_t x)
+{
+	return tbl[x & 0x0f] ^ tbl[16 + (x >> 4)];
+}
+
+/*
+ * The vector code evaluates 16 interleaved polynomials at the 16th power of
+ * the root, lane k holding the symbols k, k + 16, ... Their combination,
+ *
+ *	syn = sum(lane[k] * root^(15 - k))
+ *	    = sum((lane[k] * root^8 + lane[k + 8]) * root^(7 - k)),  k < 8
+ *
+ * folds the upper half of the lanes into the lower one with a single
+ * multiplication by root^8, and so on down to one lane.
+ */
+
+int rs_syndrome_ssse3(const struct rs_codec *rs, const uint8_t *data,
+		      int blocks, uint8_t inv, uint16_t *syn);
+int rs_syndrome_neon(const struct rs_codec *rs, const uint8_t *data,
+		     int blocks, uint8_t inv, uint16_t *syn);
+uint8_t __rs_syndrome_neon(const uint8_t *tbl, const uint8_t *data, int blocks,
+			   uint8_t inv);
+
+#endif
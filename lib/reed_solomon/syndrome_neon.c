@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Reed Solomon syndromes for 8 bit symbols with NEON
+ */
+
+#include <linux/kernel.h>
+#include <linux/rslib.h>
+#include <asm/neon.h>
+#include <asm/simd.h>
+#include "syndrome.h"
+
+int rs_syndrome_neon(const struct rs_codec *rs, const uint8_t *data,
+		     int blocks, uint8_t inv, uint16_t *syn)
+{
+	int i;
+
+	if (!cpu_has_neon() || !may_use_simd())
+		return 0;
+
+	kernel_neon_begin();
+	for (i = 0; i < rs->nroots; i++)
+		syn[i] = __rs_syndrome_neon(rs->synmul + i * RS_SYNMUL_SIZE,
+					    data, blocks, inv);
+	kernel_neon_end();
+
+	return blocks * 16;
+}
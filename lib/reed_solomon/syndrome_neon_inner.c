@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Reed Solomon syndromes for 8 bit symbols with NEON
+ *
+ * Based on the split nibble multiplication of lib/raid6/recov_neon_inner.c
+ */
+
+#include <arm_neon.h>
+
+#include "syndrome.h"
+
+#ifdef CONFIG_ARM
+/*
+ * AArch32 does not provide this intrinsic natively because it does not
+ * implement the underlying instruction. AArch32 only provides a 64-bit
+ * wide vtbl.8 instruction, so use that instead.
+ */
+static uint8x16_t vqtbl1q_u8(uint8x16_t a, uint8x16_t b)
+{
+	union {
+		uint8x16_t	val;
+		uint8x8x2_t	pair;
+	} __a = { a };
+
+	return vcombine_u8(vtbl2_u8(__a.pair, vget_low_u8(b)),
+			   vtbl2_u8(__a.pair, vget_high_u8(b)));
+}
+#endif
+
+/* @acc times the root whose split nibble tables are at @tbl */
+static uint8x16_t rs_neon_mul(const uint8_t *tbl, uint8x16_t acc)
+{
+	uint8x16_t x0f = vdupq_n_u8(0x0f);
+	uint8x16_t vx, vy;
+
+	vx = vqtbl1q_u8(vld1q_u8(tbl), vandq_u8(acc, x0f));
+	vy = vqtbl1q_u8(vld1q_u8(tbl + 16), vshrq_n_u8(acc, 4));
+
+	return veorq_u8(vx, vy);
+}
+
+/*
+ * Evaluate the 16 interleaved polynomials of @data at the 16th power of the
+ * root whose tables are at @tbl, and fold the lanes into its syndrome.
+ */
+uint8_t __rs_syndrome_neon(const uint8_t *tbl, const uint8_t *data, int blocks,
+			   uint8_t inv)
+{
+	uint8x16_t lo = vld1q_u8(tbl + RS_SYNMUL_POW(4));
+	uint8x16_t hi = vld1q_u8(tbl + RS_SYNMUL_POW(4) + 16);
+	uint8x16_t vinv = vdupq_n_u8(inv);
+	uint8x16_t x0f = vdupq_n_u8(0x0f);
+	uint8x16_t zero = vdupq_n_u8(0);
+	uint8x16_t acc = zero;
+
+	/*
+	 * while (blocks--) {
+	 *	for (k = 0; k < 16; k++)
+	 *		acc[k] = mul16[acc[k]] ^ *data++ ^ inv;
+	 * }
+	 */
+
+	while (blocks) {
+		uint8x16_t vx, vy;
+
+		vy = vshrq_n_u8(acc, 4);
+		vx = vqtbl1q_u8(lo, vandq_u8(acc, x0f));
+		vy = vqtbl1q_u8(hi, vy);
+		acc = veorq_u8(vld1q_u8(data), vinv);
+		acc = veorq_u8(acc, veorq_u8(vx, vy));
+
+		blocks--;
+		data += 16;
+	}
+
+	/* acc[k] = acc[k] * root^m ^ acc[k + m], for m = 8, 4, 2, 1 */
+	acc = veorq_u8(rs_neon_mul(tbl + RS_SYNMUL_POW(3), acc),
+		       vextq_u8(acc, zero, 8));
+	acc = veorq_u8(rs_neon_mul(tbl + RS_SYNMUL_POW(2), acc),
+		       vextq_u8(acc, zero, 4));
+	acc = veorq_u8(rs_neon_mul(tbl + RS_SYNMUL_POW(1), acc),
+		       vextq_u8(acc, zero, 2));
+	acc = veorq_u8(rs_neon_mul(tbl + RS_SYNMUL_POW(0), acc),
+		       vextq_u8(acc, zero, 1));
+
+	return vgetq_lane_u8(acc, 0);
+}
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Reed Solomon syndromes for 8 bit symbols with SSSE3
+ *
+ * Based on the split nibble multiplication of lib/raid6/recov_ssse3.c
+ */
+
+#include <linux/kernel.h>
+#include <linux/rslib.h>
+#include <asm/cpufeature.h>
+#include <asm/fpu/api.h>
+#include <asm/simd.h>
+#include "syndrome.h"
+
+static const u8 __aligned(16) x0f[16] = {
+	 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+	 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f};
+
+/* xmm0 = (xmm0 times the root^(2^m) of @tbl) ^ (xmm0 >> @bytes) */
+#define RS_SSSE3_FOLD(tbl, m, bytes)					\
+do {									\
+	asm volatile("movdqa %xmm0,%xmm1");				\
+	asm volatile("psrldq $" #bytes ",%xmm1");			\
+	asm volatile("movdqa %xmm0,%xmm2");				\
+	asm volatile("psrlw  $4,%xmm0");				\
+	asm volatile("pand   %xmm7,%xmm2");				\
+	asm volatile("pand   %xmm7,%xmm0");				\
+	asm volatile("movdqu %0,%%xmm3" : : "m" ((tbl)[RS_SYNMUL_POW(m)])); \
+	asm volatile("pshufb %xmm2,%xmm3");				\
+	asm volatile("pxor   %xmm3,%xmm1");				\
+	asm volatile("movdqu %0,%%xmm3" : : "m" ((tbl)[RS_SYNMUL_POW(m) + 16])); \
+	asm volatile("pshufb %xmm0,%xmm3");				\
+	asm volatile("pxor   %xmm3,%xmm1");				\
+	asm volatile("movdqa %xmm1,%xmm0");				\
+} while (0)
+
+/* Combine the lanes of xmm0 into the syndrome of the root of @tbl */
+static u16 rs_ssse3_lanes(const u8 *tbl)
+{
+	u32 syn;
+
+	RS_SSSE3_FOLD(tbl, 3, 8);
+	RS_SSSE3_FOLD(tbl, 2, 4);
+	RS_SSSE3_FOLD(tbl, 1, 2);
+	RS_SSSE3_FOLD(tbl, 0, 1);
+	asm volatile("movd   %%xmm0,%0" : "=r" (syn));
+
+	return syn & 0xff;
+}
+
+int rs_syndrome_ssse3(const struct rs_codec *rs, const uint8_t *data,
+		      int blocks, uint8_t inv, uint16_t *syn)
+{
+	u8 __aligned(16) vinv[16];
+	const u8 *tbl, *p;
+	int i, n;
+
+	if (!boot_cpu_has(X86_FEATURE_SSSE3) || !may_use_simd())
+		return 0;
+
+	memset(vinv, inv, sizeof(vinv));
+
+	kernel_fpu_begin();
+
+	asm volatile("movdqa %0,%%xmm7" : : "m" (x0f[0]));
+	asm volatile("movdqa %0,%%xmm4" : : "m" (vinv[0]));
+
+	i = 0;
+#ifdef CONFIG_X86_64
+	/* Two roots per pass, sharing the loads */
+	for (; i + 2 <= rs->nroots; i += 2) {
+		tbl = rs->synmul + i * RS_SYNMUL_SIZE;
+
+		asm volatile("movdqu %0,%%xmm6" : : "m" (tbl[RS_SYNMUL_POW(4)]));
+		asm volatile("movdqu %0,%%xmm5" : : "m" (tbl[RS_SYNMUL_POW(4) + 16]));
+		asm volatile("movdqu %0,%%xmm14" : : "m" (tbl[RS_SYNMUL_SIZE + RS_SYNMUL_POW(4)]));
+		asm volatile("movdqu %0,%%xmm13" : : "m" (tbl[RS_SYNMUL_SIZE + RS_SYNMUL_POW(4) + 16]));
+		asm volatile("pxor   %xmm0,%xmm0");
+		asm volatile("pxor   %xmm8,%xmm8");
+
+		for (p = data, n = blocks; n; n--, p += 16) {
+			/* xmm0/8 = lanes times the 16th power of the root */
+			asm volatile("movdqa %xmm0,%xmm1");
+			asm volatile("movdqa %xmm8,%xmm9");
+			asm volatile("psrlw  $4,%xmm0");
+			asm volatile("psrlw  $4,%xmm8");
+			asm volatile("pand   %xmm7,%xmm1");
+			asm volatile("pand   %xmm7,%xmm9");
+			asm volatile("pand   %xmm7,%xmm0");
+			asm volatile("pand   %xmm7,%xmm8");
+			asm volatile("movdqa %xmm6,%xmm2");
+			asm volatile("movdqa %xmm14,%xmm10");
+			asm volatile("movdqa %xmm5,%xmm3");
+			asm volatile("movdqa %xmm13,%xmm11");
+			asm volatile("pshufb %xmm1,%xmm2");
+			asm volatile("pshufb %xmm9,%xmm10");
+			asm volatile("pshufb %xmm0,%xmm3");
+			asm volatile("pshufb %xmm8,%xmm11");
+
+			/* plus the next 16 data symbols */
+			asm volatile("movdqu %0,%%xmm12" : : "m" (p[0]));
+			asm volatile("pxor   %xmm4,%xmm12");
+			asm volatile("movdqa %xmm12,%xmm0");
+			asm volatile("movdqa %xmm12,%xmm8");
+			asm volatile("pxor   %xmm2,%xmm0");
+			asm volatile("pxor   %xmm10,%xmm8");
+			asm volatile("pxor   %xmm3,%xmm0");
+			asm volatile("pxor   %xmm11,%xmm8");
+		}
+
+		syn[i] = rs_ssse3_lanes(tbl);
+		asm volatile("movdqa %xmm8,%xmm0");
+		syn[i + 1] = rs_ssse3_lanes(tbl + RS_SYNMUL_SIZE);
+	}
+#endif
+	for (; i < rs->nroots; i++) {
+		tbl = rs->synmul + i * RS_SYNMUL_SIZE;
+
+		asm volatile("movdqu %0,%%xmm6" : : "m" (tbl[RS_SYNMUL_POW(4)]));
+		asm volatile("movdqu %0,%%xmm5" : : "m" (tbl[RS_SYNMUL_POW(4) + 16]));
+		asm volatile("pxor   %xmm0,%xmm0");
+
+		for (p = data, n = blocks; n; n--, p += 16) {
+			asm volatile("movdqa %xmm0,%xmm1");
+			asm volatile("psrlw  $4,%xmm0");
+			asm volatile("pand   %xmm7,%xmm1");
+			asm volatile("pand   %xmm7,%xmm0");
+			asm volatile("movdqa %xmm6,%xmm2");
+			asm volatile("movdqa %xmm5,%xmm3");
+			asm volatile("pshufb %xmm1,%xmm2");
+			asm volatile("pshufb %xmm0,%xmm3");
+			asm volatile("movdqu %0,%%xmm0" : : "m" (p[0]));
+			asm volatile("pxor   %xmm4,%xmm0");
+			asm volatile("pxor   %xmm2,%xmm0");
+			asm volatile("pxor   %xmm3,%xmm0");
+		}
+
+		syn[i] = rs_ssse3_lanes(tbl);
+	}
+
+	kernel_fpu_end();
+
+	return blocks * 16;
+}
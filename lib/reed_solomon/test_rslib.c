@@ -439,6 +439,67 @@ static int exercise_rs_bc(struct rs_control *rs, struct wspace *ws,
 	return stat.noncw;
 }
 
+#if defined(CONFIG_REED_SOLOMON_ENC8) && defined(CONFIG_REED_SOLOMON_DEC8)
+/*
+ * decode_rs8() has its own syndrome code for byte wide data. Check that it
+ * corrects what decode_rs16() does, with and without inverted data.
+ */
+static int exercise_rs8(struct rs_control *rs, struct wspace *ws,
+			int len, int trials)
+{
+	int nroots = rs->codec->nroots;
+	int dlen = len - nroots;
+	uint16_t *par = ws->s;
+	int nerrs, derrs, errloc, fail = 0;
+	uint16_t invmsk;
+	uint8_t *c, *r;
+	int i, j;
+
+	if (v >= V_PROGRESS)
+		pr_info("  Testing 8 bit data interface...\n");
+
+	c = kmalloc_array(2, len, GFP_KERNEL);
+	if (!c)
+		return -ENOMEM;
+	r = c + len;
+
+	for (j = 0; j < trials; j++) {
+		invmsk = j & 1 ? rs->codec->nn : 0;
+		for (i = 0; i < dlen; i++)
+			c[i] = get_random_u32() & rs->codec->nn;
+
+		memset(par, 0, nroots * sizeof(*par));
+		encode_rs8(rs, c, dlen, par, invmsk);
+
+		/* Error free in odd trials, up to capacity in even ones */
+		memcpy(r, c, dlen);
+		nerrs = j & 1 ? 0 : get_random_u32_below(nroots / 2 + 1);
+		for (i = 0; i < nerrs; i++) {
+			errloc = get_random_u32_below(dlen);
+			r[errloc] ^= 1 + get_random_u32_below(rs->codec->nn);
+		}
+
+		derrs = decode_rs8(rs, r, par, dlen, NULL, 0, NULL, invmsk,
+				   NULL);
+		if (derrs < 0 || derrs > nerrs || memcmp(r, c, dlen))
+			fail++;
+	}
+
+	kfree(c);
+
+	if (fail && v >= V_PROGRESS)
+		pr_warn("    FAIL: %d decoding failures!\n", fail);
+
+	return fail;
+}
+#else
+static int exercise_rs8(struct rs_control *rs, struct wspace *ws,
+			int len, int trials)
+{
+	return 0;
+}
+#endif
+
 static int run_exercise(struct etab *e)
 {
 	int nn = (1 << e->symsize) - 1;
@@ -473,6 +534,8 @@ static int run_exercise(struct etab *e)
 		}
 
 		retval |= exercise_rs(rsc, ws, len, e->ntrials);
+		if (e->symsize <= 8)
+			retval |= exercise_rs8(rsc, ws, len, e->ntrials);
 		if (bc)
 			retval |= exercise_rs_bc(rsc, ws, len, e->ntrials);
 	}
@@ -0,0 +1,86 @@
+/* chunkcopy.h -- fast, overlap-safe match copies for inffast_chunk.c
+ *
+ * Matches are copied a word at a time, in chunks of CHUNKCOPY_CHUNK_SIZE
+ * bytes, and every function here may write up to CHUNKCOPY_CHUNK_SIZE - 1
+ * bytes past the end of the match. The caller guarantees the room for it,
+ * see INFLATE_FAST_CHUNK_MIN_OUTPUT. Those bytes are overwritten by the
+ * following symbols, or lie beyond what inflate() reports as written.
+ */
+
+#ifndef CHUNKCOPY_H
+#define CHUNKCOPY_H
+
+#include <linux/types.h>
+#include <asm/unaligned.h>
+
+#define CHUNKCOPY_WORD_SIZE     sizeof(u64)
+#define CHUNKCOPY_CHUNK_SIZE    (2 * CHUNKCOPY_WORD_SIZE)
+
+/* Copy len bytes from a source at least CHUNKCOPY_CHUNK_SIZE bytes back */
+static inline unsigned char *chunkcopy_far(unsigned char *out,
+                                           const unsigned char *from,
+                                           unsigned len)
+{
+    unsigned char *end = out + len;
+
+    do {
+        u64 a = get_unaligned((const u64 *)from);
+        u64 b = get_unaligned((const u64 *)(from + CHUNKCOPY_WORD_SIZE));
+
+        put_unaligned(a, (u64 *)out);
+        put_unaligned(b, (u64 *)(out + CHUNKCOPY_WORD_SIZE));
+        out += CHUNKCOPY_CHUNK_SIZE;
+        from += CHUNKCOPY_CHUNK_SIZE;
+    } while (out < end);
+
+    return end;
+}
+
+/*
+   Copy len bytes of a match dist bytes back, dist > 0. Short distances
+   repeat a pattern of period dist: it is built once in a word and stored
+   every step bytes, step being the largest multiple of dist that fits in a
+   word, so that consecutive stores stay in phase.
+ */
+static inline unsigned char *chunkcopy_lapped(unsigned char *out,
+                                              unsigned dist, unsigned len)
+{
+    const unsigned char *from = out - dist;
+    unsigned char *end = out + len;
+    unsigned step, i;
+    u64 pat;
+
+    if (dist >= CHUNKCOPY_CHUNK_SIZE)
+        return chunkcopy_far(out, from, len);
+
+    if (dist >= CHUNKCOPY_WORD_SIZE) {
+        /* one word at a time, each load only reads finished bytes */
+        do {
+            put_unaligned(get_unaligned((const u64 *)from), (u64 *)out);
+            out += CHUNKCOPY_WORD_SIZE;
+            from += CHUNKCOPY_WORD_SIZE;
+        } while (out < end);
+        return end;
+    }
+
+    if (dist == 1) {
+        pat = 0x0101010101010101ULL * from[0];
+        step = CHUNKCOPY_WORD_SIZE;
+    } else {
+        unsigned char buf[CHUNKCOPY_WORD_SIZE];
+
+        for (i = 0; i < CHUNKCOPY_WORD_SIZE; i++)
+            buf[i] = from[i % dist];
+        memcpy(&pat, buf, sizeof(pat));
+        step = CHUNKCOPY_WORD_SIZE - CHUNKCOPY_WORD_SIZE % dist;
+    }
+
+    do {
+        put_unaligned(pat, (u64 *)out);
+        out += step;
+    } while (out < end);
+
+    return end;
+}
+
+#endif /* CHUNKCOPY_H */
@@ -9,3 +9,23 @@
  */
 
 void inflate_fast (z_streamp strm, unsigned start);
+
+/*
+   The chunked decoder in inffast_chunk.c refills the bit buffer a word at a
+   time and copies matches in chunks of CHUNKCOPY_CHUNK_SIZE bytes, so it
+   needs more input and output slack than inflate_fast(). The pre-boot
+   decompressors, which build this code with STATIC defined, keep using
+   inflate_fast().
+ */
+#if defined(CONFIG_ZLIB_INFLATE_CHUNKED) && !defined(STATIC)
+#define INFLATE_CHUNKED 1
+
+#define INFLATE_FAST_CHUNK_MIN_INPUT    32
+#define INFLATE_FAST_CHUNK_MIN_OUTPUT   (2 + 258 + 16) /* CHUNKCOPY_CHUNK_SIZE */
+
+void inflate_fast_chunk (z_streamp strm, unsigned start);
+
+#if IS_ENABLED(CONFIG_KUNIT)
+extern bool zlib_inflate_chunked;
+#endif
+#endif
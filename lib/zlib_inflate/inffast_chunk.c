@@ -0,0 +1,261 @@
+/* inffast_chunk.c -- fast decoding with wide refills and chunked copies
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ *
+ * Derived from inffast.c, along the lines of the chunked decoder of the
+ * Chromium zlib fork.
+ */
+
+#include <linux/zutil.h>
+#include <asm/unaligned.h>
+#include "inftrees.h"
+#include "inflate.h"
+#include "inffast.h"
+#include "chunkcopy.h"
+
+/*
+   Top up the bit buffer. On 64-bit, a single unaligned load brings it to 56
+   to 63 bits, enough for a whole length/distance pair (48 bits at most, see
+   inffast.c), so the refills in the middle of a symbol are almost never
+   taken. The load may bring in bits beyond the ones counted in bits: they
+   are the actual next bits of input, so or'ing them in again on the next
+   refill is harmless, and they are masked off on return.
+ */
+#if BITS_PER_LONG == 64
+#define REFILL() \
+    do { \
+        hold |= get_unaligned_le64(in) << bits; \
+        in += (63 - bits) >> 3; \
+        bits |= 56; \
+    } while (0)
+#else
+#define REFILL() \
+    do { \
+        hold += (unsigned long)(*in++) << bits; \
+        bits += 8; \
+        hold += (unsigned long)(*in++) << bits; \
+        bits += 8; \
+    } while (0)
+#endif
+
+/*
+   Decode literal, length, and distance codes like inflate_fast(), with the
+   same entry assumptions and return states, except for the larger margins:
+
+        strm->avail_in >= INFLATE_FAST_CHUNK_MIN_INPUT
+        strm->avail_out >= INFLATE_FAST_CHUNK_MIN_OUTPUT
+
+   Notes:
+
+    - A refill reads 8 bytes at in, which is at most 7 bytes past the first
+      unconsumed byte, and an iteration consumes at most 10 bytes, two
+      literals and a length/distance pair. So with
+      INFLATE_FAST_CHUNK_MIN_INPUT bytes left when an iteration is started,
+      no refill reads past the end of the input.
+
+    - On 64-bit, up to two literals are decoded straight off a refill before
+      the next symbol, so an iteration writes at most 2 + 258 bytes, and the
+      chunked copies may write up to CHUNKCOPY_CHUNK_SIZE - 1 more, which
+      INFLATE_FAST_CHUNK_MIN_OUTPUT accounts for. Copies from the window are
+      exact: the window ends the inflate workspace, so it cannot be read
+      past.
+
+    - @start:	inflate()'s starting value for strm->avail_out
+ */
+void inflate_fast_chunk(z_streamp strm, unsigned start)
+{
+    struct inflate_state *state;
+    const unsigned char *in;    /* local strm->next_in */
+    const unsigned char *last;  /* while in < last, enough input available */
+    unsigned char *out;         /* local strm->next_out */
+    unsigned char *beg;         /* inflate()'s initial strm->next_out */
+    unsigned char *end;         /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char *window;      /* allocated sliding window, if wsize != 0 */
+    unsigned long hold;         /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const *lcode;          /* local strm->lencode */
+    code const *dcode;          /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char *from;        /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_CHUNK_MIN_INPUT - 1));
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_CHUNK_MIN_OUTPUT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+#if BITS_PER_LONG == 64
+        /* a refill is cheap, and leaves enough bits for three codes */
+        REFILL();
+        this = lcode[hold & lmask];
+        if (this.op == 0) {
+            hold >>= this.bits;
+            bits -= this.bits;
+            *out++ = (unsigned char)(this.val);
+            this = lcode[hold & lmask];
+            if (this.op == 0) {
+                hold >>= this.bits;
+                bits -= this.bits;
+                *out++ = (unsigned char)(this.val);
+                this = lcode[hold & lmask];
+            }
+        }
+#else
+        if (bits < 15)
+            REFILL();
+        this = lcode[hold & lmask];
+#endif
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                if (bits < op)
+                    REFILL();
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            if (bits < 15)
+                REFILL();
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                if (bits < op)
+                    REFILL();
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    from = window;
+                    if (write == 0) {           /* very common case */
+                        from += wsize - op;
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from += wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            memcpy(out, from, op);
+                            out += op;
+                            len -= op;
+                            from = window;
+                            op = write;         /* rest from start of window */
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from += write - op;
+                    }
+                    if (op >= len) {            /* all from window */
+                        memcpy(out, from, len);
+                        out += len;
+                    }
+                    else {                      /* rest from output */
+                        memcpy(out, from, op);
+                        out += op;
+                        out = chunkcopy_lapped(out, dist, len - op);
+                    }
+                }
+                else {                          /* copy direct from output */
+                    out = chunkcopy_lapped(out, dist, len);
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes, and drop the bits read past the counted ones */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1UL << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_CHUNK_MIN_INPUT - 1) + (last - in) :
+                                (INFLATE_FAST_CHUNK_MIN_INPUT - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (INFLATE_FAST_CHUNK_MIN_OUTPUT - 1) + (end - out) :
+                                 (INFLATE_FAST_CHUNK_MIN_OUTPUT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+}
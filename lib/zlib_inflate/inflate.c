@@ -25,6 +25,15 @@
 #define INFLATE_NEED_CHECKSUM(strm) 1
 #endif
 
+#ifdef INFLATE_CHUNKED
+#include <linux/export.h>
+#include <kunit/visibility.h>
+
+/* Only cleared by the KUnit test, to compare against inflate_fast() */
+VISIBLE_IF_KUNIT bool zlib_inflate_chunked __read_mostly = true;
+EXPORT_SYMBOL_IF_KUNIT(zlib_inflate_chunked);
+#endif
+
 int zlib_inflate_workspacesize(void)
 {
     return sizeof(struct inflate_workspace);
@@ -577,6 +586,16 @@ int zlib_inflate(z_streamp strm, int flush)
             state->mode = LEN;
 	    fallthrough;
         case LEN:
+#ifdef INFLATE_CHUNKED
+            if (zlib_inflate_chunked &&
+                have >= INFLATE_FAST_CHUNK_MIN_INPUT &&
+                left >= INFLATE_FAST_CHUNK_MIN_OUTPUT) {
+                RESTORE();
+                inflate_fast_chunk(strm, out);
+                LOAD();
+                break;
+            }
+#endif
             if (have >= 6 && left >= 258) {
                 RESTORE();
                 inflate_fast(strm, out);
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit tests for zlib inflate
+ *
+ * Streams deflated at several levels are inflated whole, and in small
+ * pieces of input and output so that matches reach into the sliding window
+ * and the fast paths are entered and left often. With
+ * CONFIG_ZLIB_INFLATE_CHUNKED, the chunked decoder is checked against the
+ * byte-wise one, and the throughput of both is reported.
+ */
+
+#include <kunit/bench.h>
+#include <kunit/corpus.h>
+#include <kunit/test.h>
+
+#include <linux/vmalloc.h>
+#include <linux/zlib.h>
+#include <linux/zutil.h>
+
+#include "inffast.h"
+
+#define ZTEST_SIZE		(1024 * 1024)
+
+struct ztest_param {
+	enum kunit_corpus corpus;
+	int level;
+	unsigned int in_chunk;	/* input fed per zlib_inflate() call */
+	unsigned int out_chunk;	/* output room per zlib_inflate() call */
+	const char *name;
+};
+
+static const struct ztest_param ztest_params[] = {
+	{ KUNIT_CORPUS_TEXT,	6, ZTEST_SIZE, ZTEST_SIZE, "text, level 6, whole" },
+	{ KUNIT_CORPUS_TEXT,	1, ZTEST_SIZE, ZTEST_SIZE, "text, level 1, whole" },
+	{ KUNIT_CORPUS_TEXT,	9, 4096, 4096, "text, level 9, 4K pieces" },
+	{ KUNIT_CORPUS_BINARY,	6, ZTEST_SIZE, ZTEST_SIZE, "binary, level 6, whole" },
+	{ KUNIT_CORPUS_BINARY,	9, 1000, 300, "binary, level 9, small pieces" },
+	{ KUNIT_CORPUS_BINARY,	1, 37, 65536, "binary, level 1, tiny input" },
+	{ KUNIT_CORPUS_RANDOM,	6, ZTEST_SIZE, ZTEST_SIZE, "random, level 6, whole" },
+};
+
+KUNIT_ARRAY_PARAM_DESC(ztest, ztest_params, name);
+
+struct ztest_ctx {
+	u8 *src;
+	u8 *comp;
+	size_t comp_len;
+	u8 *out;
+	z_stream strm;
+};
+
+static void ztest_prepare(struct kunit *test, struct ztest_ctx *ctx,
+			  const struct ztest_param *param)
+{
+	size_t bound = 2 * ZTEST_SIZE;
+	z_stream *strm = &ctx->strm;
+	int ret;
+
+	ctx->src = vmalloc(ZTEST_SIZE);
+	ctx->out = vmalloc(ZTEST_SIZE);
+	ctx->comp = vmalloc(bound);
+	strm->workspace = vmalloc(max(zlib_deflate_workspacesize(MAX_WBITS,
+								  MAX_MEM_LEVEL),
+				      zlib_inflate_workspacesize()));
+	KUNIT_ASSERT_TRUE(test, ctx->src && ctx->out && ctx->comp &&
+				strm->workspace);
+
+	kunit_fill_corpus(ctx->src, ZTEST_SIZE, param->corpus, 32 * 1024,
+			  0x7a6c6962);
+
+	KUNIT_ASSERT_EQ(test, zlib_deflateInit2(strm, param->level, Z_DEFLATED,
+						MAX_WBITS, DEF_MEM_LEVEL,
+						Z_DEFAULT_STRATEGY), Z_OK);
+	strm->next_in = ctx->src;
+	strm->avail_in = ZTEST_SIZE;
+	strm->next_out = ctx->comp;
+	strm->avail_out = bound;
+	ret = zlib_deflate(strm, Z_FINISH);
+	ctx->comp_len = strm->total_out;
+	zlib_deflateEnd(strm);
+	KUNIT_ASSERT_EQ(test, ret, Z_STREAM_END);
+}
+
+static void ztest_release(struct ztest_ctx *ctx)
+{
+	vfree(ctx->strm.workspace);
+	vfree(ctx->src);
+	vfree(ctx->out);
+	vfree(ctx->comp);
+}
+
+/* Inflate the whole stream in the pieces @param asks for */
+static int ztest_inflate(struct ztest_ctx *ctx, const struct ztest_param *param)
+{
+	z_stream *strm = &ctx->strm;
+	size_t in_end, out_end;
+	int ret;
+
+	if (zlib_inflateInit2(strm, MAX_WBITS) != Z_OK)
+		return -EINVAL;
+
+	strm->next_in = ctx->comp;
+	strm->avail_in = 0;
+	strm->next_out = ctx->out;
+	strm->avail_out = 0;
+
+	do {
+		in_end = min_t(size_t, strm->total_in + param->in_chunk,
+			       ctx->comp_len);
+		out_end = min_t(size_t, strm->total_out + param->out_chunk,
+				ZTEST_SIZE);
+		strm->avail_in = in_end - strm->total_in;
+		strm->avail_out = out_end - strm->total_out;
+		ret = zlib_inflate(strm, Z_SYNC_FLUSH);
+	} while (ret == Z_OK);
+
+	zlib_inflateEnd(strm);
+	if (ret != Z_STREAM_END)
+		return -EIO;
+
+	return strm->total_out;
+}
+
+static void ztest_check(struct kunit *test, struct ztest_ctx *ctx,
+			const struct ztest_param *param, const char *decoder)
+{
+	memset(ctx->out, 0, ZTEST_SIZE);
+	KUNIT_EXPECT_EQ_MSG(test, ztest_inflate(ctx, param), ZTEST_SIZE,
+			    "decoder %s", decoder);
+	KUNIT_EXPECT_EQ_MSG(test, memcmp(ctx->src, ctx->out, ZTEST_SIZE), 0,
+			    "decoder %s", decoder);
+}
+
+static void ztest_roundtrip(struct kunit *test)
+{
+	const struct ztest_param *param = test->param_value;
+	struct ztest_ctx ctx;
+
+	ztest_prepare(test, &ctx, param);
+
+#ifdef INFLATE_CHUNKED
+	zlib_inflate_chunked = false;
+	ztest_check(test, &ctx, param, "byte-wise");
+	zlib_inflate_chunked = true;
+	ztest_check(test, &ctx, param, "chunked");
+#else
+	ztest_check(test, &ctx, param, "byte-wise");
+#endif
+
+	/* A corrupted stream must fail cleanly */
+	ctx.comp[ctx.comp_len / 2] ^= 0x55;
+	KUNIT_EXPECT_LT(test, ztest_inflate(&ctx, param), 0);
+
+	ztest_release(&ctx);
+}
+
+struct ztest_bench {
+	struct ztest_ctx *ctx;
+	const struct ztest_param *param;
+};
+
+static void ztest_bench_fn(void *data)
+{
+	struct ztest_bench *b = data;
+
+	ztest_inflate(b->ctx, b->param);
+}
+
+static void ztest_bench_one(struct kunit *test, struct ztest_ctx *ctx,
+			    const struct ztest_param *param, const char *decoder)
+{
+	struct ztest_bench b = { .ctx = ctx, .param = param };
+	struct kunit_bench bench = {
+		.name = decoder,
+		.fn = ztest_bench_fn,
+		.ctx = &b,
+		.warmup = 2,
+		.max_samples = 128,
+		.bytes = ZTEST_SIZE,
+	};
+	int ret;
+
+	/* Do not time a decoder that gets it wrong */
+	ret = ztest_inflate(ctx, param);
+	if (ret != ZTEST_SIZE) {
+		KUNIT_FAIL(test, "%s: inflate failed: %d", decoder, ret);
+		return;
+	}
+	kunit_bench_run(test, &bench, NULL);
+}
+
+static void ztest_bench(struct kunit *test)
+{
+	const struct ztest_param *param = test->param_value;
+	struct ztest_ctx ctx;
+
+	if (!kunit_bench_enabled(test))
+		kunit_skip(test, "benchmarks disabled or not exclusive");
+
+	ztest_prepare(test, &ctx, param);
+	kunit_info(test, "%s: compressed to %zu%%\n", param->name,
+		   ctx.comp_len * 100 / ZTEST_SIZE);
+
+#ifdef INFLATE_CHUNKED
+	zlib_inflate_chunked = false;
+	ztest_bench_one(test, &ctx, param, "byte-wise");
+	zlib_inflate_chunked = true;
+	ztest_bench_one(test, &ctx, param, "chunked");
+#else
+	ztest_bench_one(test, &ctx, param, "byte-wise");
+#endif
+
+	ztest_release(&ctx);
+}
+
+static struct kunit_case ztest_cases[] = {
+	KUNIT_CASE_PARAM(ztest_roundtrip, ztest_gen_params),
+	KUNIT_CASE_PARAM(ztest_bench, ztest_gen_params),
+	{}
+};
+
+static struct kunit_suite ztest_suite = {
+	.name = "zlib_inflate",
+	.test_cases = ztest_cases,
+	/* for the throughput numbers */
+	.exclusive = true,
+};
+
+kunit_test_suites(&ztest_suite);
+
+MODULE_IMPORT_NS(EXPORTED_FOR_KUNIT_TESTING);
+MODULE_LICENSE("GPL");
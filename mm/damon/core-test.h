@@ -318,6 +318,124 @@ static void damon_test_update_monitoring_result(struct kunit *test)
 	KUNIT_EXPECT_EQ(test, r->age, 20);
 }
 
+static void damon_test_feed_loop_next_input(struct kunit *test)
+{
+	unsigned long last_input = 900000, current_score = 200;
+
+	/*
+	 * If current score is lower than the goal, which is always 10,000
+	 * (see the comment of damon_feed_loop_next_input()), next input should
+	 * be higher than the last input.
+	 */
+	KUNIT_EXPECT_GT(test,
+			damon_feed_loop_next_input(last_input, current_score),
+			last_input);
+
+	/*
+	 * If current score is higher than the goal, next input should be lower
+	 * than the last input.
+	 */
+	current_score = 250000000;
+	KUNIT_EXPECT_LT(test,
+			damon_feed_loop_next_input(last_input, current_score),
+			last_input);
+
+	/*
+	 * The next input depends on the distance between the current score and
+	 * the goal
+	 */
+	KUNIT_EXPECT_GT(test,
+			damon_feed_loop_next_input(last_input, 200),
+			damon_feed_loop_next_input(last_input, 2000));
+
+	/* On the goal, keep the last input; never go below the minimum */
+	KUNIT_EXPECT_EQ(test, damon_feed_loop_next_input(last_input, 10000),
+			last_input);
+	KUNIT_EXPECT_EQ(test, damon_feed_loop_next_input(10000, 19999),
+			10000);
+}
+
+static void damos_test_set_effective_quota_goal(struct kunit *test)
+{
+	struct damos_quota quota = {};
+	struct damos_quota_goal *goal;
+
+	INIT_LIST_HEAD(&quota.goals);
+	goal = damos_new_quota_goal(DAMOS_QUOTA_USER_INPUT, 10000);
+	KUNIT_ASSERT_NOT_NULL(test, goal);
+	damos_add_quota_goal(&quota, goal);
+
+	/* Half of the goal achieved with 1000 bytes, go for 1500 */
+	quota.esz_bp = 1000 * 10000;
+	goal->current_value = 5000;
+	damos_set_effective_quota(&quota);
+	KUNIT_EXPECT_EQ(test, quota.esz, 1500);
+
+	/* Goal exceeded by half, back off by half */
+	goal->current_value = 15000;
+	damos_set_effective_quota(&quota);
+	KUNIT_EXPECT_EQ(test, quota.esz, 750);
+
+	/* The size quota is still the upper limit */
+	quota.sz = 500;
+	quota.esz_bp = 1000 * 10000;
+	goal->current_value = 0;
+	damos_set_effective_quota(&quota);
+	KUNIT_EXPECT_EQ(test, quota.esz, 500);
+
+	damos_destroy_quota_goal(goal);
+}
+
+static void damon_test_tune_intervals(struct kunit *test)
+{
+	struct damon_ctx *c = damon_new_ctx();
+	struct damon_target *t;
+	struct damon_region *r;
+	struct damon_attrs attrs;
+
+	KUNIT_ASSERT_NOT_NULL(test, c);
+	t = damon_new_target();
+	r = damon_new_region(0, 100);
+	damon_add_region(r, t);
+	damon_add_target(c, t);
+
+	attrs = c->attrs;
+	attrs.sample_interval = 5000;
+	attrs.aggr_interval = 100000;
+	attrs.intervals_goal = (struct damon_intervals_goal){
+		.access_bp = 500, .aggrs = 1,
+		.min_sample_us = 1000, .max_sample_us = 100000,
+	};
+	KUNIT_ASSERT_EQ(test, damon_set_attrs(c, &attrs), 0);
+
+	/* No access found, double the intervals */
+	r->nr_accesses = 0;
+	kdamond_tune_intervals(c);
+	KUNIT_EXPECT_EQ(test, c->attrs.sample_interval, 10000ul);
+	KUNIT_EXPECT_EQ(test, c->attrs.aggr_interval, 200000ul);
+	KUNIT_EXPECT_EQ(test, c->nr_tune_aggrs, 0ul);
+
+	/* Accessed in every sample, halve the intervals */
+	r->nr_accesses = 20;
+	kdamond_tune_intervals(c);
+	KUNIT_EXPECT_EQ(test, c->attrs.sample_interval, 5000ul);
+	KUNIT_EXPECT_EQ(test, c->attrs.aggr_interval, 100000ul);
+
+	/* Goal achieved, keep the intervals */
+	r->nr_accesses = 1;
+	kdamond_tune_intervals(c);
+	KUNIT_EXPECT_EQ(test, c->attrs.sample_interval, 5000ul);
+
+	/* The sampling interval is capped */
+	c->attrs.intervals_goal.max_sample_us = 8000;
+	r->nr_accesses = 0;
+	kdamond_tune_intervals(c);
+	KUNIT_EXPECT_EQ(test, c->attrs.sample_interval, 8000ul);
+	KUNIT_EXPECT_EQ(test, c->attrs.aggr_interval, 160000ul);
+
+	damon_destroy_ctx(c);
+}
+
 static struct kunit_case damon_test_cases[] = {
 	KUNIT_CASE(damon_test_target),
 	KUNIT_CASE(damon_test_regions),
@@ -329,6 +447,9 @@ static struct kunit_case damon_test_cases[] = {
 	KUNIT_CASE(damon_test_ops_registration),
 	KUNIT_CASE(damon_test_set_regions),
 	KUNIT_CASE(damon_test_update_monitoring_result),
+	KUNIT_CASE(damon_test_feed_loop_next_input),
+	KUNIT_CASE(damos_test_set_effective_quota_goal),
+	KUNIT_CASE(damon_test_tune_intervals),
 	{},
 };
 
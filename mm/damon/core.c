@@ -11,6 +11,7 @@
 #include <linux/delay.h>
 #include <linux/kthread.h>
 #include <linux/mm.h>
+#include <linux/psi.h>
 #include <linux/slab.h>
 #include <linux/string.h>
 
@@ -297,12 +298,64 @@ void damos_destroy_filter(struct damos_filter *f)
 	damos_free_filter(f);
 }
 
+static u64 damos_get_some_mem_psi_total(void)
+{
+#ifdef CONFIG_PSI
+	if (static_branch_likely(&psi_disabled))
+		return 0;
+	return div_u64(psi_system.total[PSI_AVGS][PSI_MEM_SOME],
+			NSEC_PER_USEC);
+#else
+	return 0;
+#endif
+}
+
+struct damos_quota_goal *damos_new_quota_goal(
+		enum damos_quota_goal_metric metric,
+		unsigned long target_value)
+{
+	struct damos_quota_goal *goal;
+
+	goal = kmalloc(sizeof(*goal), GFP_KERNEL);
+	if (!goal)
+		return NULL;
+	goal->metric = metric;
+	goal->target_value = target_value;
+	goal->current_value = 0;
+	if (metric == DAMOS_QUOTA_SOME_MEM_PSI_US)
+		goal->last_psi_total = damos_get_some_mem_psi_total();
+	INIT_LIST_HEAD(&goal->list);
+	return goal;
+}
+
+void damos_add_quota_goal(struct damos_quota *q, struct damos_quota_goal *g)
+{
+	list_add_tail(&g->list, &q->goals);
+}
+
+static void damos_del_quota_goal(struct damos_quota_goal *g)
+{
+	list_del(&g->list);
+}
+
+static void damos_free_quota_goal(struct damos_quota_goal *g)
+{
+	kfree(g);
+}
+
+void damos_destroy_quota_goal(struct damos_quota_goal *g)
+{
+	damos_del_quota_goal(g);
+	damos_free_quota_goal(g);
+}
+
 /* initialize private fields of damos_quota and return the pointer */
 static struct damos_quota *damos_quota_init_priv(struct damos_quota *quota)
 {
 	quota->total_charged_sz = 0;
 	quota->total_charged_ns = 0;
 	quota->esz = 0;
+	quota->esz_bp = 0;
 	quota->charged_sz = 0;
 	quota->charged_from = 0;
 	quota->charge_target_from = NULL;
@@ -326,6 +379,8 @@ struct damos *damon_new_scheme(struct damos_access_pattern *pattern,
 	INIT_LIST_HEAD(&scheme->list);
 
 	scheme->quota = *(damos_quota_init_priv(quota));
+	/* quota.goals should be separately set by caller */
+	INIT_LIST_HEAD(&scheme->quota.goals);
 
 	scheme->wmarks = *wmarks;
 	scheme->wmarks.activated = true;
@@ -350,8 +405,12 @@ static void damon_free_scheme(struct damos *s)
 
 void damon_destroy_scheme(struct damos *s)
 {
+	struct damos_quota_goal *g, *g_next;
 	struct damos_filter *f, *next;
 
+	damos_for_each_quota_goal_safe(g, g_next, &s->quota)
+		damos_destroy_quota_goal(g);
+
 	damos_for_each_filter_safe(f, next, s)
 		damos_destroy_filter(f);
 	damon_del_scheme(s);
@@ -547,13 +606,22 @@ static void damon_update_monitoring_results(struct damon_ctx *ctx,
  */
 int damon_set_attrs(struct damon_ctx *ctx, struct damon_attrs *attrs)
 {
+	struct damon_intervals_goal *goal = &attrs->intervals_goal;
+
 	if (attrs->min_nr_regions < 3)
 		return -EINVAL;
 	if (attrs->min_nr_regions > attrs->max_nr_regions)
 		return -EINVAL;
+	if (goal->aggrs && (!goal->min_sample_us ||
+				goal->min_sample_us > goal->max_sample_us))
+		return -EINVAL;
 
 	damon_update_monitoring_results(ctx, attrs);
 	ctx->attrs = *attrs;
+
+	ctx->nr_tune_aggrs = 0;
+	ctx->tune_access_events = 0;
+	ctx->tune_max_access_events = 0;
 	return 0;
 }
 
@@ -939,23 +1007,128 @@ static void damon_do_apply_schemes(struct damon_ctx *c,
 	}
 }
 
-/* Shouldn't be called if quota->ms and quota->sz are zero */
+/*
+ * damon_feed_loop_next_input() - get next input to achieve a target score.
+ * @last_input	The last input.
+ * @score	Current score that made with @last_input.
+ *
+ * Calculate next input to achieve the target score, based on the last input
+ * and current score.  Assuming the input and the score are positively
+ * proportional, calculate how much compensation should be added to or
+ * subtracted from the last input as a proportion of the last input.  Avoid
+ * next input always being zero by setting it non-zero always.  In short form
+ * (assuming support of float and signed calculations), the algorithm is as
+ * below.
+ *
+ * next_input = max(last_input * ((goal - current) / goal + 1), 1)
+ *
+ * For simple implementation, we assume the target score is always 10,000.  The
+ * caller should adjust @score for this.
+ *
+ * Returns next input that assumed to achieve the target score.
+ */
+static unsigned long damon_feed_loop_next_input(unsigned long last_input,
+		unsigned long score)
+{
+	const unsigned long goal = 10000;
+	/* Set minimum input as 10000 to avoid compensation be zero */
+	const unsigned long min_input = 10000;
+	unsigned long score_goal_diff, compensation;
+	bool over_achieving = score > goal;
+
+	if (score == goal)
+		return last_input;
+	if (score >= goal * 2)
+		return min_input;
+
+	if (over_achieving)
+		score_goal_diff = score - goal;
+	else
+		score_goal_diff = goal - score;
+
+	if (last_input < ULONG_MAX / score_goal_diff)
+		compensation = last_input * score_goal_diff / goal;
+	else
+		compensation = last_input / goal * score_goal_diff;
+
+	if (over_achieving)
+		return max(last_input - compensation, min_input);
+	if (last_input < ULONG_MAX - compensation)
+		return last_input + compensation;
+	return ULONG_MAX;
+}
+
+static void damos_set_quota_goal_current_value(struct damos_quota_goal *goal)
+{
+	struct sysinfo i;
+	u64 now_psi_total;
+
+	switch (goal->metric) {
+	case DAMOS_QUOTA_USER_INPUT:
+		/* User should already set goal->current_value */
+		break;
+	case DAMOS_QUOTA_SOME_MEM_PSI_US:
+		now_psi_total = damos_get_some_mem_psi_total();
+		goal->current_value = now_psi_total - goal->last_psi_total;
+		goal->last_psi_total = now_psi_total;
+		break;
+	case DAMOS_QUOTA_FREE_MEM_BP:
+		si_meminfo(&i);
+		goal->current_value = i.freeram * 10000 / i.totalram;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Return the highest score, in bp, among the goals of @quota */
+static unsigned long damos_quota_score(struct damos_quota *quota)
+{
+	struct damos_quota_goal *goal;
+	unsigned long highest_score = 0;
+
+	damos_for_each_quota_goal(goal, quota) {
+		damos_set_quota_goal_current_value(goal);
+		if (!goal->target_value)
+			continue;
+		highest_score = max(highest_score,
+				mult_frac(goal->current_value, 10000,
+					goal->target_value));
+	}
+
+	return highest_score;
+}
+
+/*
+ * Shouldn't be called if quota->ms and quota->sz are zero and quota->goals is
+ * empty
+ */
 static void damos_set_effective_quota(struct damos_quota *quota)
 {
 	unsigned long throughput;
-	unsigned long esz;
+	unsigned long esz = ULONG_MAX;
 
-	if (!quota->ms) {
+	if (!quota->ms && list_empty(&quota->goals)) {
 		quota->esz = quota->sz;
 		return;
 	}
 
-	if (quota->total_charged_ns)
-		throughput = quota->total_charged_sz * 1000000 /
-			quota->total_charged_ns;
-	else
-		throughput = PAGE_SIZE * 1024;
-	esz = throughput * quota->ms;
+	if (!list_empty(&quota->goals)) {
+		unsigned long score = damos_quota_score(quota);
+
+		quota->esz_bp = damon_feed_loop_next_input(
+				max(quota->esz_bp, 10000UL), score);
+		esz = quota->esz_bp / 10000;
+	}
+
+	if (quota->ms) {
+		if (quota->total_charged_ns)
+			throughput = quota->total_charged_sz * 1000000 /
+				quota->total_charged_ns;
+		else
+			throughput = PAGE_SIZE * 1024;
+		esz = min(throughput * quota->ms, esz);
+	}
 
 	if (quota->sz && quota->sz < esz)
 		esz = quota->sz;
@@ -970,7 +1143,7 @@ static void damos_adjust_quota(struct damon_ctx *c, struct damos *s)
 	unsigned long cumulated_sz;
 	unsigned int score, max_score = 0;
 
-	if (!quota->ms && !quota->sz)
+	if (!quota->ms && !quota->sz && list_empty(&quota->goals))
 		return;
 
 	/* New charge window starts */
@@ -1298,6 +1471,86 @@ static int kdamond_wait_activation(struct damon_ctx *ctx)
 	return -EBUSY;
 }
 
+/*
+ * Accumulate the size-weighted access events that are observed in the last
+ * aggregation interval, and the maximum of them.
+ */
+static void kdamond_account_access_events(struct damon_ctx *c)
+{
+	unsigned long max_nr_accesses = c->attrs.aggr_interval /
+		c->attrs.sample_interval;
+	struct damon_target *t;
+	struct damon_region *r;
+
+	damon_for_each_target(t, c) {
+		damon_for_each_region(r, t) {
+			unsigned long sz = damon_sz_region(r) / DAMON_MIN_REGION;
+
+			c->tune_access_events += (u64)sz * r->nr_accesses;
+			c->tune_max_access_events += (u64)sz * max_nr_accesses;
+		}
+	}
+}
+
+/*
+ * Get the next sampling interval for the intervals goal of @c.
+ *
+ * The score is the ratio of the observed access events to @access_bp of the
+ * maximum events.  Find the next interval with the feedback loop that is also
+ * used for the DAMOS quotas, and limit the change to between half and double
+ * of the current interval, so that one unusual period cannot swing it much.
+ */
+static unsigned long damon_get_intervals_adaptation_bp(struct damon_ctx *c)
+{
+	struct damon_intervals_goal *goal = &c->attrs.intervals_goal;
+	u64 target_events;
+	unsigned long score_bp, adaptation_bp;
+
+	target_events = div_u64(c->tune_max_access_events * goal->access_bp,
+			10000);
+	if (!target_events)
+		target_events = 1;
+	score_bp = min_t(u64, div64_u64(c->tune_access_events * 10000,
+				target_events), 20000);
+
+	adaptation_bp = damon_feed_loop_next_input(100000000, score_bp) /
+		10000;
+	/* the feed loop shrinks the input at most to 1 bp; make it half */
+	if (adaptation_bp <= 10000)
+		adaptation_bp = 5000 + adaptation_bp / 2;
+	return adaptation_bp;
+}
+
+/*
+ * Tune the sampling and aggregation intervals of @c for its intervals goal,
+ * once per &damon_intervals_goal->aggrs aggregations.
+ */
+static void kdamond_tune_intervals(struct damon_ctx *c)
+{
+	struct damon_intervals_goal *goal = &c->attrs.intervals_goal;
+	struct damon_attrs new_attrs;
+	unsigned long sample_interval;
+
+	if (!goal->aggrs || !goal->access_bp || !c->attrs.sample_interval)
+		return;
+
+	kdamond_account_access_events(c);
+	if (++c->nr_tune_aggrs < goal->aggrs)
+		return;
+
+	sample_interval = mult_frac(c->attrs.sample_interval,
+			damon_get_intervals_adaptation_bp(c), 10000);
+	sample_interval = clamp(sample_interval, goal->min_sample_us,
+			goal->max_sample_us);
+
+	new_attrs = c->attrs;
+	new_attrs.sample_interval = sample_interval;
+	new_attrs.aggr_interval = mult_frac(c->attrs.aggr_interval,
+			sample_interval, c->attrs.sample_interval);
+	/* also resets the accumulated events */
+	damon_set_attrs(c, &new_attrs);
+}
+
 /*
  * The monitoring daemon that runs as a kernel thread
  */
@@ -1342,6 +1595,7 @@ static int kdamond_fn(void *data)
 				break;
 			if (!list_empty(&ctx->schemes))
 				kdamond_apply_schemes(ctx);
+			kdamond_tune_intervals(ctx);
 			kdamond_reset_aggregated(ctx);
 			kdamond_split_regions(ctx);
 			if (ctx->ops.reset_aggregated)
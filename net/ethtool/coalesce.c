@@ -1,5 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <linux/dim.h>
+
 #include "netlink.h"
 #include "common.h"
 
@@ -12,6 +14,10 @@ struct coalesce_reply_data {
 	struct ethtool_coalesce		coalesce;
 	struct kernel_ethtool_coalesce	kernel_coalesce;
 	u32				supported_params;
+	u8				profile_flags;
+	u8				coal_flags;
+	struct dim_cq_moder		rx_profile[NET_DIM_PARAMS_NUM_PROFILES];
+	struct dim_cq_moder		tx_profile[NET_DIM_PARAMS_NUM_PROFILES];
 };
 
 #define COALESCE_REPDATA(__reply_base) \
@@ -51,12 +57,35 @@ __CHECK_SUPPORTED_OFFSET(COALESCE_RX_MAX_FRAMES_HIGH);
 __CHECK_SUPPORTED_OFFSET(COALESCE_TX_USECS_HIGH);
 __CHECK_SUPPORTED_OFFSET(COALESCE_TX_MAX_FRAMES_HIGH);
 __CHECK_SUPPORTED_OFFSET(COALESCE_RATE_SAMPLE_INTERVAL);
+__CHECK_SUPPORTED_OFFSET(COALESCE_RX_PROFILE);
+__CHECK_SUPPORTED_OFFSET(COALESCE_TX_PROFILE);
 
 const struct nla_policy ethnl_coalesce_get_policy[] = {
 	[ETHTOOL_A_COALESCE_HEADER]		=
 		NLA_POLICY_NESTED(ethnl_header_policy),
 };
 
+/* Snapshot of the DIM profiles in use, called under RTNL */
+static void coalesce_get_profiles(struct coalesce_reply_data *data,
+				  const struct net_device *dev)
+{
+	const struct dim_irq_moder *moder = dev->irq_moder;
+
+	if (!moder)
+		return;
+
+	data->profile_flags = moder->profile_flags;
+	data->coal_flags = moder->coal_flags;
+	if (moder->profile_flags & DIM_PROFILE_RX)
+		memcpy(data->rx_profile,
+		       rtnl_dereference(moder->rx_profile[moder->dim_rx_mode]),
+		       sizeof(data->rx_profile));
+	if (moder->profile_flags & DIM_PROFILE_TX)
+		memcpy(data->tx_profile,
+		       rtnl_dereference(moder->tx_profile[moder->dim_tx_mode]),
+		       sizeof(data->tx_profile));
+}
+
 static int coalesce_prepare_data(const struct ethnl_req_info *req_base,
 				 struct ethnl_reply_data *reply_base,
 				 struct genl_info *info)
@@ -75,14 +104,34 @@ static int coalesce_prepare_data(const struct ethnl_req_info *req_base,
 	ret = dev->ethtool_ops->get_coalesce(dev, &data->coalesce,
 					     &data->kernel_coalesce, extack);
 	ethnl_ops_complete(dev);
+	coalesce_get_profiles(data, dev);
 
 	return ret;
 }
 
+static int coalesce_profile_size(void)
+{
+	int moder_size = nla_total_size(sizeof(u32)) +	/* _USEC */
+			 nla_total_size(sizeof(u32)) +	/* _PKTS */
+			 nla_total_size(sizeof(u32));	/* _COMPS */
+
+	return nla_total_size(NET_DIM_PARAMS_NUM_PROFILES *
+			      nla_total_size(moder_size));
+}
+
 static int coalesce_reply_size(const struct ethnl_req_info *req_base,
 			       const struct ethnl_reply_data *reply_base)
 {
-	return nla_total_size(sizeof(u32)) +	/* _RX_USECS */
+	const struct coalesce_reply_data *data = COALESCE_REPDATA(reply_base);
+	int len = 0;
+
+	if (data->profile_flags & DIM_PROFILE_RX)
+		len += coalesce_profile_size();	/* _RX_PROFILE */
+	if (data->profile_flags & DIM_PROFILE_TX)
+		len += coalesce_profile_size();	/* _TX_PROFILE */
+
+	return len +
+	       nla_total_size(sizeof(u32)) +	/* _RX_USECS */
 	       nla_total_size(sizeof(u32)) +	/* _RX_MAX_FRAMES */
 	       nla_total_size(sizeof(u32)) +	/* _RX_USECS_IRQ */
 	       nla_total_size(sizeof(u32)) +	/* _RX_MAX_FRAMES_IRQ */
@@ -127,6 +176,45 @@ static bool coalesce_put_bool(struct sk_buff *skb, u16 attr_type, u32 val,
 	return nla_put_u8(skb, attr_type, !!val);
 }
 
+static int coalesce_put_profile(struct sk_buff *skb, u16 attr_type,
+				const struct dim_cq_moder *profile,
+				u8 coal_flags)
+{
+	struct nlattr *profile_attr, *moder_attr;
+	int i;
+
+	profile_attr = nla_nest_start(skb, attr_type);
+	if (!profile_attr)
+		return -EMSGSIZE;
+
+	for (i = 0; i < NET_DIM_PARAMS_NUM_PROFILES; i++) {
+		moder_attr = nla_nest_start(skb,
+					    ETHTOOL_A_PROFILE_IRQ_MODERATION);
+		if (!moder_attr)
+			goto nla_put_failure;
+
+		if (((coal_flags & DIM_COALESCE_USEC) &&
+		     nla_put_u32(skb, ETHTOOL_A_IRQ_MODERATION_USEC,
+				 profile[i].usec)) ||
+		    ((coal_flags & DIM_COALESCE_PKTS) &&
+		     nla_put_u32(skb, ETHTOOL_A_IRQ_MODERATION_PKTS,
+				 profile[i].pkts)) ||
+		    ((coal_flags & DIM_COALESCE_COMPS) &&
+		     nla_put_u32(skb, ETHTOOL_A_IRQ_MODERATION_COMPS,
+				 profile[i].comps)))
+			goto nla_put_failure;
+
+		nla_nest_end(skb, moder_attr);
+	}
+
+	nla_nest_end(skb, profile_attr);
+	return 0;
+
+nla_put_failure:
+	nla_nest_cancel(skb, profile_attr);
+	return -EMSGSIZE;
+}
+
 static int coalesce_fill_reply(struct sk_buff *skb,
 			       const struct ethnl_req_info *req_base,
 			       const struct ethnl_reply_data *reply_base)
@@ -192,11 +280,31 @@ static int coalesce_fill_reply(struct sk_buff *skb,
 			     kcoal->tx_aggr_time_usecs, supported))
 		return -EMSGSIZE;
 
+	if ((data->profile_flags & DIM_PROFILE_RX) &&
+	    coalesce_put_profile(skb, ETHTOOL_A_COALESCE_RX_PROFILE,
+				 data->rx_profile, data->coal_flags))
+		return -EMSGSIZE;
+	if ((data->profile_flags & DIM_PROFILE_TX) &&
+	    coalesce_put_profile(skb, ETHTOOL_A_COALESCE_TX_PROFILE,
+				 data->tx_profile, data->coal_flags))
+		return -EMSGSIZE;
+
 	return 0;
 }
 
 /* COALESCE_SET */
 
+static const struct nla_policy coalesce_irq_moder_policy[] = {
+	[ETHTOOL_A_IRQ_MODERATION_USEC]		= { .type = NLA_U32 },
+	[ETHTOOL_A_IRQ_MODERATION_PKTS]		= { .type = NLA_U32 },
+	[ETHTOOL_A_IRQ_MODERATION_COMPS]	= { .type = NLA_U32 },
+};
+
+static const struct nla_policy coalesce_profile_policy[] = {
+	[ETHTOOL_A_PROFILE_IRQ_MODERATION]	=
+		NLA_POLICY_NESTED(coalesce_irq_moder_policy),
+};
+
 const struct nla_policy ethnl_coalesce_set_policy[] = {
 	[ETHTOOL_A_COALESCE_HEADER]		=
 		NLA_POLICY_NESTED(ethnl_header_policy),
@@ -227,6 +335,10 @@ const struct nla_policy ethnl_coalesce_set_policy[] = {
 	[ETHTOOL_A_COALESCE_TX_AGGR_MAX_BYTES] = { .type = NLA_U32 },
 	[ETHTOOL_A_COALESCE_TX_AGGR_MAX_FRAMES] = { .type = NLA_U32 },
 	[ETHTOOL_A_COALESCE_TX_AGGR_TIME_USECS] = { .type = NLA_U32 },
+	[ETHTOOL_A_COALESCE_RX_PROFILE]		=
+		NLA_POLICY_NESTED(coalesce_profile_policy),
+	[ETHTOOL_A_COALESCE_TX_PROFILE]		=
+		NLA_POLICY_NESTED(coalesce_profile_policy),
 };
 
 static int
@@ -253,10 +365,153 @@ ethnl_set_coalesce_validate(struct ethnl_req_info *req_info,
 	return 1;
 }
 
+static int coalesce_update_moder(u16 *dst, const struct nlattr *attr,
+				 u8 coal_flags, u8 flag, bool *mod,
+				 struct netlink_ext_ack *extack)
+{
+	u32 val;
+
+	if (!attr)
+		return 0;
+	if (!(coal_flags & flag)) {
+		NL_SET_ERR_MSG_ATTR(extack, attr,
+				    "cannot modify an unsupported parameter");
+		return -EOPNOTSUPP;
+	}
+
+	val = nla_get_u32(attr);
+	if (val > U16_MAX) {
+		NL_SET_ERR_MSG_ATTR(extack, attr, "value out of range");
+		return -EINVAL;
+	}
+	if (*dst != val) {
+		*dst = val;
+		*mod = true;
+	}
+	return 0;
+}
+
+/*
+ * Build in *@new the DIM profile @nest asks for, from the one of the CQ period
+ * mode the device will be in, which @cqe_attr may change.  *@new is left NULL
+ * if the profile does not change, *@new_mode is the mode it was built for.
+ */
+static int coalesce_update_profile(struct net_device *dev, bool tx,
+				   const struct nlattr *nest,
+				   const struct nlattr *cqe_attr,
+				   struct dim_cq_moder **new, u8 *new_mode,
+				   struct netlink_ext_ack *extack)
+{
+	struct nlattr *tb[ARRAY_SIZE(coalesce_irq_moder_policy)];
+	struct dim_irq_moder *moder = dev->irq_moder;
+	struct dim_cq_moder *profile;
+	const struct nlattr *attr;
+	bool mod = false;
+	int i = 0, rem, ret;
+	u8 mode;
+
+	if (!nest)
+		return 0;
+	if (!moder ||
+	    !(moder->profile_flags & (tx ? DIM_PROFILE_TX : DIM_PROFILE_RX))) {
+		NL_SET_ERR_MSG_ATTR(extack, nest,
+				    "device has no modifiable DIM profile");
+		return -EOPNOTSUPP;
+	}
+
+	mode = tx ? moder->dim_tx_mode : moder->dim_rx_mode;
+	if (cqe_attr)
+		mode = nla_get_u8(cqe_attr) ? DIM_CQ_PERIOD_MODE_START_FROM_CQE :
+					      DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+
+	profile = kmemdup(rtnl_dereference(tx ? moder->tx_profile[mode] :
+						moder->rx_profile[mode]),
+			  sizeof(*profile) * NET_DIM_PARAMS_NUM_PROFILES,
+			  GFP_KERNEL);
+	if (!profile)
+		return -ENOMEM;
+
+	nla_for_each_nested(attr, nest, rem) {
+		if (nla_type(attr) != ETHTOOL_A_PROFILE_IRQ_MODERATION)
+			continue;
+		if (i == NET_DIM_PARAMS_NUM_PROFILES) {
+			NL_SET_ERR_MSG_ATTR(extack, attr,
+					    "too many DIM profile entries");
+			ret = -EINVAL;
+			goto err_free;
+		}
+
+		ret = nla_parse_nested(tb, ARRAY_SIZE(tb) - 1, attr,
+				       coalesce_irq_moder_policy, extack);
+		if (ret < 0)
+			goto err_free;
+
+		ret = coalesce_update_moder(&profile[i].usec,
+					    tb[ETHTOOL_A_IRQ_MODERATION_USEC],
+					    moder->coal_flags,
+					    DIM_COALESCE_USEC, &mod, extack);
+		if (!ret)
+			ret = coalesce_update_moder(&profile[i].pkts,
+						    tb[ETHTOOL_A_IRQ_MODERATION_PKTS],
+						    moder->coal_flags,
+						    DIM_COALESCE_PKTS, &mod,
+						    extack);
+		if (!ret)
+			ret = coalesce_update_moder(&profile[i].comps,
+						    tb[ETHTOOL_A_IRQ_MODERATION_COMPS],
+						    moder->coal_flags,
+						    DIM_COALESCE_COMPS, &mod,
+						    extack);
+		if (ret < 0)
+			goto err_free;
+		i++;
+	}
+
+	if (i != NET_DIM_PARAMS_NUM_PROFILES) {
+		NL_SET_ERR_MSG_ATTR(extack, nest,
+				    "DIM profile needs an entry per step");
+		ret = -EINVAL;
+		goto err_free;
+	}
+
+	if (mod) {
+		*new = profile;
+		*new_mode = mode;
+	} else {
+		kfree(profile);
+	}
+	return 0;
+
+err_free:
+	kfree(profile);
+	return ret;
+}
+
+/*
+ * Switch the profile of CQ period mode @mode to @new, if not NULL, the DIM
+ * works picking it up from their next moderation change on.  @mode is the
+ * one @new was built for, drivers need not record mode changes.
+ */
+static void coalesce_set_profile(struct dim_irq_moder *moder, bool tx,
+				 struct dim_cq_moder *new, u8 mode)
+{
+	struct dim_cq_moder __rcu **slot;
+	struct dim_cq_moder *old;
+
+	if (!new)
+		return;
+
+	slot = tx ? &moder->tx_profile[mode] : &moder->rx_profile[mode];
+	old = rcu_replace_pointer(*slot, new, lockdep_rtnl_is_held());
+	kfree_rcu_mightsleep(old);
+}
+
 static int
 ethnl_set_coalesce(struct ethnl_req_info *req_info, struct genl_info *info)
 {
+	struct dim_cq_moder *rx_profile = NULL, *tx_profile = NULL;
 	struct kernel_ethtool_coalesce kernel_coalesce = {};
+	u8 rx_mode = 0, tx_mode = 0;
 	struct net_device *dev = req_info->dev;
 	struct ethtool_coalesce coalesce = {};
 	struct nlattr **tb = info->attrs;
@@ -322,12 +577,38 @@ ethnl_set_coalesce(struct ethnl_req_info *req_info, struct genl_info *info)
 			 tb[ETHTOOL_A_COALESCE_TX_AGGR_MAX_FRAMES], &mod);
 	ethnl_update_u32(&kernel_coalesce.tx_aggr_time_usecs,
 			 tb[ETHTOOL_A_COALESCE_TX_AGGR_TIME_USECS], &mod);
-	if (!mod)
+
+	ret = coalesce_update_profile(dev, false,
+				      tb[ETHTOOL_A_COALESCE_RX_PROFILE],
+				      tb[ETHTOOL_A_COALESCE_USE_CQE_MODE_RX],
+				      &rx_profile, &rx_mode, info->extack);
+	if (ret < 0)
+		return ret;
+	ret = coalesce_update_profile(dev, true,
+				      tb[ETHTOOL_A_COALESCE_TX_PROFILE],
+				      tb[ETHTOOL_A_COALESCE_USE_CQE_MODE_TX],
+				      &tx_profile, &tx_mode, info->extack);
+	if (ret < 0)
+		goto out_free;
+	if (!mod && !rx_profile && !tx_profile)
 		return 0;
 
-	ret = dev->ethtool_ops->set_coalesce(dev, &coalesce, &kernel_coalesce,
-					     info->extack);
-	return ret < 0 ? ret : 1;
+	if (mod) {
+		ret = dev->ethtool_ops->set_coalesce(dev, &coalesce,
+						     &kernel_coalesce,
+						     info->extack);
+		if (ret < 0)
+			goto out_free;
+	}
+
+	coalesce_set_profile(dev->irq_moder, false, rx_profile, rx_mode);
+	coalesce_set_profile(dev->irq_moder, true, tx_profile, tx_mode);
+	return 1;
+
+out_free:
+	kfree(rx_profile);
+	kfree(tx_profile);
+	return ret;
 }
 
 const struct ethnl_request_ops ethnl_coalesce_request_ops = {
@@ -31,11 +31,13 @@ int main(int argc, char **argv)
 	int bits = 32, xdelay = 0, dir = DMA_MAP_BIDIRECTIONAL;
 	/* default granule 1 PAGESIZE */
 	int granule = 1;
+	/* default one mapping alive per thread */
+	int burst = 1;
 
 	int cmd = DMA_MAP_BENCHMARK;
 	char *p;
 
-	while ((opt = getopt(argc, argv, "t:s:n:b:d:x:g:")) != -1) {
+	while ((opt = getopt(argc, argv, "t:s:n:b:d:x:g:B:")) != -1) {
 		switch (opt) {
 		case 't':
 			threads = atoi(optarg);
@@ -58,6 +60,9 @@ int main(int argc, char **argv)
 		case 'g':
 			granule = atoi(optarg);
 			break;
+		case 'B':
+			burst = atoi(optarg);
+			break;
 		default:
 			return -1;
 		}
@@ -98,6 +103,12 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (burst < 1 || burst > DMA_MAP_MAX_BURST) {
+		fprintf(stderr, "invalid burst size, must be in 1-%d\n",
+			DMA_MAP_MAX_BURST);
+		exit(1);
+	}
+
 	fd = open("/sys/kernel/debug/dma_map_benchmark", O_RDWR);
 	if (fd == -1) {
 		perror("open");
@@ -112,14 +123,15 @@ int main(int argc, char **argv)
 	map.dma_dir = dir;
 	map.dma_trans_ns = xdelay;
 	map.granule = granule;
+	map.burst = burst;
 
 	if (ioctl(fd, cmd, &map)) {
 		perror("ioctl");
 		exit(1);
 	}
 
-	printf("dma mapping benchmark: threads:%d seconds:%d node:%d dir:%s granule: %d\n",
-			threads, seconds, node, dir[directions], granule);
+	printf("dma mapping benchmark: threads:%d seconds:%d node:%d dir:%s granule: %d burst: %d\n",
+			threads, seconds, node, dir[directions], granule, burst);
 	printf("average map latency(us):%.1f standard deviation:%.1f\n",
 			map.avg_map_100ns/10.0, map.map_stddev/10.0);
 	printf("average unmap latency(us):%.1f standard deviation:%.1f\n",
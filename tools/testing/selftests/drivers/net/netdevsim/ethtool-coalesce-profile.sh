@@ -0,0 +1,109 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Change the DIM profiles of a netdevsim device through ethtool and check
+# what the device's DIM lookups return in its ethtool/dim/*_profile debugfs
+# files. Then remove the device while the files are being read.
+
+# Kselftest framework requirement - SKIP code is 4.
+ksft_skip=4
+
+NSIM_ID=$((RANDOM % 1024))
+NSIM_BUS=/sys/bus/netdevsim
+NSIM_DFS=/sys/kernel/debug/netdevsim/netdevsim$NSIM_ID
+DIM_DFS=$NSIM_DFS/ports/0/ethtool/dim
+NSIM_NETDEV=
+num_passes=0
+num_errors=0
+
+cleanup()
+{
+	[ -d "$NSIM_BUS/devices/netdevsim$NSIM_ID" ] &&
+		echo $NSIM_ID > $NSIM_BUS/del_device
+}
+
+skip()
+{
+	echo "SKIP: $*"
+	cleanup
+	exit $ksft_skip
+}
+
+check()
+{
+	local what=$1 expected=$2 actual=$3
+
+	if [ "$expected" == "$actual" ]; then
+		((num_passes++))
+	else
+		echo "FAIL: $what"
+		echo "  expected: $(echo $expected)"
+		echo "  actual:   $(echo $actual)"
+		((num_errors++))
+	fi
+}
+
+# "usec pkts comps" lines to the ethtool rx-profile/tx-profile syntax
+to_ethtool()
+{
+	tr ' \n' ',_' | sed 's/_$//'
+}
+
+[ "$(id -u)" -eq 0 ] || skip "must be run as root"
+command -v ethtool > /dev/null || skip "ethtool not found"
+ethtool -h 2>&1 | grep -q rx-profile || skip "ethtool has no rx-profile"
+modprobe -q netdevsim || skip "netdevsim not available"
+[ -d /sys/kernel/debug/netdevsim ] || skip "debugfs not mounted"
+
+echo "$NSIM_ID 1" > $NSIM_BUS/new_device || skip "cannot create device"
+udevadm settle 2> /dev/null
+NSIM_NETDEV=$(ls $NSIM_BUS/devices/netdevsim$NSIM_ID/net/ | head -n1)
+[ -f "$DIM_DFS/rx_profile" ] || skip "no DIM profile files"
+
+tx_def=$(cat $DIM_DFS/tx_profile)
+
+rx_new=$(printf "1 2 3\n4 5 6\n7 8 9\n10 11 12\n13 14 15\n")
+tx_new=$(printf "20 21 22\n23 24 25\n26 27 28\n29 30 31\n32 33 34\n")
+
+ethtool -C $NSIM_NETDEV rx-profile "$(echo "$rx_new" | to_ethtool)"
+check "rx-profile set" "$rx_new" "$(cat $DIM_DFS/rx_profile)"
+check "tx-profile untouched by rx-profile" "$tx_def" \
+	"$(cat $DIM_DFS/tx_profile)"
+
+ethtool -C $NSIM_NETDEV tx-profile "$(echo "$tx_new" | to_ethtool)"
+check "tx-profile set" "$tx_new" "$(cat $DIM_DFS/tx_profile)"
+check "rx-profile untouched by tx-profile" "$rx_new" \
+	"$(cat $DIM_DFS/rx_profile)"
+
+# A step with a wrong number of entries is rejected as a whole
+ethtool -C $NSIM_NETDEV rx-profile "1,1,1_2,2,2" 2> /dev/null
+check "short rx-profile rejected" "$rx_new" "$(cat $DIM_DFS/rx_profile)"
+
+# Each CQ period mode has its own profile
+ethtool -C $NSIM_NETDEV cqe-mode-rx on
+rx_cqe=$(cat $DIM_DFS/rx_profile)
+[ "$rx_cqe" != "$rx_new" ]
+check "CQE mode uses its own rx-profile" 0 $?
+ethtool -C $NSIM_NETDEV cqe-mode-rx off
+check "EQE rx-profile kept across mode switches" "$rx_new" \
+	"$(cat $DIM_DFS/rx_profile)"
+
+# The profile files must go away before the profiles are freed
+dmesg -c > /dev/null
+for i in 1 2 3 4; do
+	(while cat $DIM_DFS/rx_profile $DIM_DFS/tx_profile; do :; done) \
+		> /dev/null 2>&1 &
+done
+sleep 0.5
+echo $NSIM_ID > $NSIM_BUS/del_device
+wait
+dmesg | grep -q "BUG:\|KASAN"
+check "no splat removing a device with open profile files" 1 $?
+
+if [ $num_errors -eq 0 ]; then
+	echo "PASSED all $num_passes checks"
+	exit 0
+else
+	echo "FAILED $num_errors/$((num_errors + num_passes)) checks"
+	exit 1
+fi
@@ -0,0 +1,116 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run verified I/O over nvme-loop against a file backed namespace with
+# ring_io and poll_io set. The file lives on a memory backed null_blk
+# device with poll queues and a tiny queue depth, so polled submissions
+# regularly fail with -EAGAIN on tag exhaustion and have to be retried
+# without polling instead of being completed with an error.
+
+# Kselftest framework requirement - SKIP code is 4.
+ksft_skip=4
+
+NQN=nvmet-file-ring-test
+CFS=/sys/kernel/config
+NULLB=$CFS/nullb/nvmet_file_ring
+SUBSYS=$CFS/nvmet/subsystems/$NQN
+PORT=$CFS/nvmet/ports/4242
+MNT=
+CTRL=
+
+cleanup()
+{
+	[ -n "$CTRL" ] && echo 1 > /sys/class/nvme/$CTRL/delete_controller
+	[ -L "$PORT/subsystems/$NQN" ] && rm "$PORT/subsystems/$NQN"
+	[ -d "$PORT" ] && rmdir "$PORT"
+	if [ -d "$SUBSYS" ]; then
+		echo 0 > "$SUBSYS/namespaces/1/enable"
+		rmdir "$SUBSYS/namespaces/1"
+		rmdir "$SUBSYS"
+	fi
+	if [ -n "$MNT" ]; then
+		umount "$MNT"
+		rmdir "$MNT"
+	fi
+	if [ -d "$NULLB" ]; then
+		echo 0 > "$NULLB/power"
+		rmdir "$NULLB"
+	fi
+}
+
+skip()
+{
+	echo "SKIP: $*"
+	cleanup
+	exit $ksft_skip
+}
+
+fail()
+{
+	echo "FAIL: $*"
+	cleanup
+	exit 1
+}
+
+[ "$(id -u)" -eq 0 ] || skip "must be run as root"
+for tool in fio mkfs.ext4; do
+	command -v $tool > /dev/null || skip "$tool not found"
+done
+for mod in null_blk nvmet nvme-loop; do
+	modprobe -q $mod || skip "module $mod not available"
+done
+[ -d "$CFS/nullb" ] || skip "null_blk configfs not available"
+
+mkdir "$NULLB" || fail "cannot create null_blk device"
+echo 1 > "$NULLB/memory_backed"
+echo 512 > "$NULLB/size"
+echo 2 > "$NULLB/hw_queue_depth"
+echo 1 > "$NULLB/poll_queues" || skip "null_blk has no poll queues"
+echo 1 > "$NULLB/power" || fail "cannot power on null_blk device"
+BDEV=/dev/nullb$(cat "$NULLB/index")
+udevadm settle 2> /dev/null
+[ -b "$BDEV" ] || fail "$BDEV did not appear"
+
+mkfs.ext4 -q "$BDEV" || fail "mkfs.ext4 $BDEV"
+MNT=$(mktemp -d)
+mount "$BDEV" "$MNT" || { rmdir "$MNT"; MNT=; fail "mount $BDEV"; }
+fallocate -l 256M "$MNT/ns" || fail "fallocate"
+
+mkdir "$SUBSYS" || fail "cannot create subsystem"
+echo 1 > "$SUBSYS/attr_allow_any_host"
+mkdir "$SUBSYS/namespaces/1"
+echo "$MNT/ns" > "$SUBSYS/namespaces/1/device_path"
+echo 0 > "$SUBSYS/namespaces/1/buffered_io"
+echo 1 > "$SUBSYS/namespaces/1/ring_io" || skip "no ring_io support"
+echo 1 > "$SUBSYS/namespaces/1/poll_io" || skip "no poll_io support"
+echo 1 > "$SUBSYS/namespaces/1/enable" || fail "cannot enable namespace"
+
+mkdir "$PORT"
+echo loop > "$PORT/addr_trtype"
+ln -s "$SUBSYS" "$PORT/subsystems/$NQN"
+
+exec 3<> /dev/nvme-fabrics || fail "cannot open /dev/nvme-fabrics"
+echo "transport=loop,nqn=$NQN" >&3 || fail "cannot connect"
+read -r reply <&3
+exec 3>&-
+CTRL=nvme$(echo "$reply" | sed -n 's/^instance=\([0-9]*\),.*/\1/p')
+[ "$CTRL" != nvme ] || { CTRL=; fail "unexpected reply: $reply"; }
+
+for i in $(seq 50); do
+	NSDEV=$(ls -d /sys/class/nvme/$CTRL/nvme*n1 2> /dev/null | head -n1)
+	[ -n "$NSDEV" ] && break
+	sleep 0.1
+done
+[ -n "$NSDEV" ] || fail "no namespace on $CTRL"
+NSDEV=/dev/$(basename "$NSDEV")
+
+dmesg -c > /dev/null
+fio --name=file-ring --filename="$NSDEV" --direct=1 --ioengine=libaio \
+	--rw=randwrite --bs=4k --iodepth=64 --numjobs=4 --size=32M \
+	--offset_increment=32M --verify=crc32c --verify_fatal=1 \
+	--group_reporting > /dev/null || fail "fio reported errors"
+dmesg | grep -qi "I/O error" && fail "I/O errors in the kernel log"
+
+echo "PASS: polled file ring I/O under tag exhaustion"
+cleanup
+exit 0
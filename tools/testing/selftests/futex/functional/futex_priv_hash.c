@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Private futex hash test
+ *
+ * Queue waiters on private futexes, switch the process to a private
+ * futex hash of various sizes with PR_FUTEX_HASH and check that none of
+ * the waiters gets lost on the way. With -b the test measures the private
+ * futex wake throughput of a number of threads instead, which shows the
+ * effect of the hash size on bucket contention.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <time.h>
+#include "logging.h"
+#include "futextest.h"
+
+#ifndef PR_FUTEX_HASH
+#define PR_FUTEX_HASH			78
+# define PR_FUTEX_HASH_SET_SLOTS	1
+# define PR_FUTEX_HASH_GET_SLOTS	2
+#endif
+
+#define TEST_NAME	"futex-priv-hash"
+#define MAX_THREADS	64
+#define WAKE_WAIT_US	10000
+
+static futex_t futexes[MAX_THREADS];
+static int nr_threads = 16;
+static volatile bool bench_stop;
+static unsigned long bench_ops[MAX_THREADS];
+
+void usage(char *prog)
+{
+	printf("Usage: %s\n", prog);
+	printf("  -b	Run the wake throughput benchmark\n");
+	printf("  -c	Use color\n");
+	printf("  -h	Display this help message\n");
+	printf("  -s N	Hash slots to use for the benchmark (0: global hash)\n");
+	printf("  -t N	Number of threads (default: %d, max: %d)\n",
+	       nr_threads, MAX_THREADS);
+	printf("  -v L	Verbosity level: %d=QUIET %d=CRITICAL %d=INFO\n",
+	       VQUIET, VCRITICAL, VINFO);
+}
+
+static int futex_hash_slots_set(unsigned int slots)
+{
+	return prctl(PR_FUTEX_HASH, PR_FUTEX_HASH_SET_SLOTS, slots, 0, 0);
+}
+
+static int futex_hash_slots_get(void)
+{
+	return prctl(PR_FUTEX_HASH, PR_FUTEX_HASH_GET_SLOTS, 0, 0, 0);
+}
+
+static void *waiterfn(void *arg)
+{
+	futex_t *f = &futexes[(long)arg];
+
+	while (*f == 0) {
+		if (futex_wait(f, 0, NULL, FUTEX_PRIVATE_FLAG) &&
+		    errno != EAGAIN && errno != EINTR) {
+			error("futex_wait failed\n", errno);
+			return (void *)1;
+		}
+	}
+	return NULL;
+}
+
+/* Queue a waiter on each futex, resize the hash and wake them all again */
+static void test_resize(unsigned int slots)
+{
+	pthread_t threads[MAX_THREADS];
+	int i, woken = 0, failed = 0;
+	void *res;
+
+	for (i = 0; i < nr_threads; i++) {
+		futexes[i] = 0;
+		if (pthread_create(&threads[i], NULL, waiterfn, (void *)(long)i))
+			error("pthread_create failed\n", errno);
+	}
+
+	usleep(WAKE_WAIT_US);
+
+	if (futex_hash_slots_set(slots)) {
+		ksft_test_result_fail("Resizing to %u slots failed: %s\n",
+				      slots, strerror(errno));
+		failed = 1;
+	}
+
+	for (i = 0; i < nr_threads; i++) {
+		futexes[i] = 1;
+		woken += futex_wake(&futexes[i], 1, FUTEX_PRIVATE_FLAG);
+	}
+
+	for (i = 0; i < nr_threads; i++) {
+		pthread_join(threads[i], &res);
+		if (res)
+			failed = 1;
+	}
+
+	if (failed)
+		return;
+
+	info("woke %d of %d waiters directly\n", woken, nr_threads);
+	if (futex_hash_slots_get() != (int)slots)
+		ksft_test_result_fail("Hash has %d slots, expected %u\n",
+				      futex_hash_slots_get(), slots);
+	else
+		ksft_test_result_pass("Resized to %u slots with %d waiters\n",
+				      slots, nr_threads);
+}
+
+static void *benchfn(void *arg)
+{
+	long i = (long)arg;
+
+	while (!bench_stop) {
+		futex_wake(&futexes[i], 1, FUTEX_PRIVATE_FLAG);
+		bench_ops[i]++;
+	}
+	return NULL;
+}
+
+static void run_bench(int slots)
+{
+	pthread_t threads[MAX_THREADS];
+	unsigned long total = 0;
+	long i;
+
+	if (slots >= 0 && futex_hash_slots_set(slots))
+		error("Setting %d slots failed\n", errno, slots);
+
+	for (i = 0; i < nr_threads; i++) {
+		if (pthread_create(&threads[i], NULL, benchfn, (void *)i))
+			error("pthread_create failed\n", errno);
+	}
+
+	sleep(1);
+	bench_stop = true;
+
+	for (i = 0; i < nr_threads; i++) {
+		pthread_join(threads[i], NULL);
+		total += bench_ops[i];
+	}
+
+	ksft_print_msg("%d threads, %d slots: %lu wakes/s\n", nr_threads,
+		       futex_hash_slots_get(), total);
+}
+
+int main(int argc, char *argv[])
+{
+	int c, slots = -1;
+	bool bench = false;
+
+	while ((c = getopt(argc, argv, "bchs:t:v:")) != -1) {
+		switch (c) {
+		case 'b':
+			bench = true;
+			break;
+		case 'c':
+			log_color(1);
+			break;
+		case 'h':
+			usage(basename(argv[0]));
+			exit(0);
+		case 's':
+			slots = atoi(optarg);
+			break;
+		case 't':
+			nr_threads = atoi(optarg);
+			if (nr_threads < 1 || nr_threads > MAX_THREADS) {
+				usage(basename(argv[0]));
+				exit(1);
+			}
+			break;
+		case 'v':
+			log_verbosity(atoi(optarg));
+			break;
+		default:
+			usage(basename(argv[0]));
+			exit(1);
+		}
+	}
+
+	ksft_print_header();
+
+	if (futex_hash_slots_get() < 0)
+		ksft_exit_skip("PR_FUTEX_HASH not supported\n");
+
+	if (bench) {
+		run_bench(slots);
+		ksft_exit_pass();
+	}
+
+	ksft_set_plan(5);
+	ksft_print_msg("%s: Test private futex hash resizing\n",
+		       basename(argv[0]));
+
+	if (futex_hash_slots_set(3) == 0 || errno != EINVAL)
+		ksft_test_result_fail("Non power of two slots accepted\n");
+	else
+		ksft_test_result_pass("Non power of two slots rejected\n");
+
+	/* Global hash to private hash, grow, shrink and back to global */
+	test_resize(16);
+	test_resize(256);
+	test_resize(2);
+	test_resize(0);
+
+	ksft_print_cnts();
+	return 0;
+}
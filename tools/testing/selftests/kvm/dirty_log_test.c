@@ -181,6 +181,9 @@ enum log_mode_t {
 	/* Use dirty ring for logging */
 	LOG_MODE_DIRTY_RING = 2,
 
+	/* Use dirty ring for logging, reset it with the per-vcpu ioctl */
+	LOG_MODE_DIRTY_RING_VCPU_RESET = 3,
+
 	LOG_MODE_NUM,
 
 	/* Run all supported modes */
@@ -274,6 +277,18 @@ static bool dirty_ring_supported(void)
 		kvm_has_cap(KVM_CAP_DIRTY_LOG_RING_ACQ_REL));
 }
 
+static bool dirty_ring_vcpu_reset_supported(void)
+{
+	return dirty_ring_supported() &&
+		kvm_has_cap(KVM_CAP_DIRTY_LOG_RING_VCPU_RESET);
+}
+
+static bool host_log_mode_is_dirty_ring(void)
+{
+	return host_log_mode == LOG_MODE_DIRTY_RING ||
+		host_log_mode == LOG_MODE_DIRTY_RING_VCPU_RESET;
+}
+
 static void dirty_ring_create_vm_done(struct kvm_vm *vm)
 {
 	uint64_t pages;
@@ -374,7 +389,10 @@ static void dirty_ring_collect_dirty_pages(struct kvm_vcpu *vcpu, int slot,
 				       slot, bitmap, num_pages,
 				       ring_buf_idx);
 
-	cleared = kvm_vm_reset_dirty_ring(vcpu->vm);
+	if (host_log_mode == LOG_MODE_DIRTY_RING_VCPU_RESET)
+		cleared = kvm_vcpu_reset_dirty_ring(vcpu);
+	else
+		cleared = kvm_vm_reset_dirty_ring(vcpu->vm);
 
 	/* Cleared pages should be the same as collected */
 	TEST_ASSERT(cleared == count, "Reset dirty pages (%u) mismatch "
@@ -455,6 +473,14 @@ struct log_mode {
 		.before_vcpu_join = dirty_ring_before_vcpu_join,
 		.after_vcpu_run = dirty_ring_after_vcpu_run,
 	},
+	{
+		.name = "dirty-ring-vcpu-reset",
+		.supported = dirty_ring_vcpu_reset_supported,
+		.create_vm_done = dirty_ring_create_vm_done,
+		.collect_dirty_pages = dirty_ring_collect_dirty_pages,
+		.before_vcpu_join = dirty_ring_before_vcpu_join,
+		.after_vcpu_run = dirty_ring_after_vcpu_run,
+	},
 };
 
 /*
@@ -606,7 +632,7 @@ static void vm_dirty_log_verify(enum vm_guest_mode mode, unsigned long *bmap)
 			matched = (*value_ptr == iteration ||
 				   *value_ptr == iteration - 1);
 
-			if (host_log_mode == LOG_MODE_DIRTY_RING && !matched) {
+			if (host_log_mode_is_dirty_ring() && !matched) {
 				if (*value_ptr == iteration - 2 && min_iter <= iteration - 2) {
 					/*
 					 * Short answer: this case is special
@@ -816,7 +842,7 @@ static void run_test(enum vm_guest_mode mode, void *arg)
 		 * the flush of the last page, and since we handle the last
 		 * page specially verification will succeed anyway.
 		 */
-		assert(host_log_mode == LOG_MODE_DIRTY_RING ||
+		assert(host_log_mode_is_dirty_ring() ||
 		       atomic_read(&vcpu_sync_stop_requested) == false);
 		vm_dirty_log_verify(mode, bmap);
 		sem_post(&sem_vcpu_cont);
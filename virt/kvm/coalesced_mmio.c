@@ -40,9 +40,9 @@ static int coalesced_mmio_in_range(struct kvm_coalesced_mmio_dev *dev,
 	return 1;
 }
 
-static int coalesced_mmio_has_room(struct kvm_coalesced_mmio_dev *dev, u32 last)
+static int coalesced_mmio_has_room(struct kvm_coalesced_mmio_ring *ring,
+				   u32 last)
 {
-	struct kvm_coalesced_mmio_ring *ring;
 	unsigned avail;
 
 	/* Are we able to batch it ? */
@@ -51,8 +51,7 @@ static int coalesced_mmio_has_room(struct kvm_coalesced_mmio_dev *dev, u32 last)
 	 * check if we don't meet the first used entry
 	 * there is always one unused entry in the buffer
 	 */
-	ring = dev->kvm->coalesced_mmio_ring;
-	avail = (ring->first - last - 1) % KVM_COALESCED_MMIO_MAX;
+	avail = (READ_ONCE(ring->first) - last - 1) % KVM_COALESCED_MMIO_MAX;
 	if (avail == 0) {
 		/* full */
 		return 0;
@@ -61,25 +60,16 @@ static int coalesced_mmio_has_room(struct kvm_coalesced_mmio_dev *dev, u32 last)
 	return 1;
 }
 
-static int coalesced_mmio_write(struct kvm_vcpu *vcpu,
-				struct kvm_io_device *this, gpa_t addr,
-				int len, const void *val)
+static int coalesced_mmio_insert(struct kvm_coalesced_mmio_dev *dev,
+				 struct kvm_coalesced_mmio_ring *ring,
+				 gpa_t addr, int len, const void *val)
 {
-	struct kvm_coalesced_mmio_dev *dev = to_mmio(this);
-	struct kvm_coalesced_mmio_ring *ring = dev->kvm->coalesced_mmio_ring;
 	__u32 insert;
 
-	if (!coalesced_mmio_in_range(dev, addr, len))
-		return -EOPNOTSUPP;
-
-	spin_lock(&dev->kvm->ring_lock);
-
 	insert = READ_ONCE(ring->last);
-	if (!coalesced_mmio_has_room(dev, insert) ||
-	    insert >= KVM_COALESCED_MMIO_MAX) {
-		spin_unlock(&dev->kvm->ring_lock);
+	if (!coalesced_mmio_has_room(ring, insert) ||
+	    insert >= KVM_COALESCED_MMIO_MAX)
 		return -EOPNOTSUPP;
-	}
 
 	/* copy data in first free entry of the ring */
 
@@ -89,10 +79,36 @@ static int coalesced_mmio_write(struct kvm_vcpu *vcpu,
 	ring->coalesced_mmio[insert].pio = dev->zone.pio;
 	smp_wmb();
 	ring->last = (insert + 1) % KVM_COALESCED_MMIO_MAX;
-	spin_unlock(&dev->kvm->ring_lock);
 	return 0;
 }
 
+static int coalesced_mmio_write(struct kvm_vcpu *vcpu,
+				struct kvm_io_device *this, gpa_t addr,
+				int len, const void *val)
+{
+	struct kvm_coalesced_mmio_dev *dev = to_mmio(this);
+	int ret;
+
+	if (!coalesced_mmio_in_range(dev, addr, len))
+		return -EOPNOTSUPP;
+
+	/*
+	 * A per-vCPU ring only ever has this vCPU as producer, and userspace
+	 * drains it while the vCPU is out of KVM_RUN, so no lock is needed.
+	 * When it fills up, the write exits to userspace like any other
+	 * MMIO/PIO and the VMM flushes the ring before completing it.
+	 */
+	if (vcpu && vcpu->coalesced_mmio_ring)
+		return coalesced_mmio_insert(dev, vcpu->coalesced_mmio_ring,
+					     addr, len, val);
+
+	spin_lock(&dev->kvm->ring_lock);
+	ret = coalesced_mmio_insert(dev, dev->kvm->coalesced_mmio_ring,
+				    addr, len, val);
+	spin_unlock(&dev->kvm->ring_lock);
+	return ret;
+}
+
 static void coalesced_mmio_destructor(struct kvm_io_device *this)
 {
 	struct kvm_coalesced_mmio_dev *dev = to_mmio(this);
@@ -134,6 +150,46 @@ void kvm_coalesced_mmio_free(struct kvm *kvm)
 		free_page((unsigned long)kvm->coalesced_mmio_ring);
 }
 
+int kvm_coalesced_mmio_vcpu_init(struct kvm_vcpu *vcpu)
+{
+	struct page *page;
+
+	if (!vcpu->kvm->coalesced_mmio_per_vcpu)
+		return 0;
+
+	page = alloc_page(GFP_KERNEL_ACCOUNT | __GFP_ZERO);
+	if (!page)
+		return -ENOMEM;
+
+	vcpu->coalesced_mmio_ring = page_address(page);
+	return 0;
+}
+
+void kvm_coalesced_mmio_vcpu_free(struct kvm_vcpu *vcpu)
+{
+	if (vcpu->coalesced_mmio_ring)
+		free_page((unsigned long)vcpu->coalesced_mmio_ring);
+}
+
+/*
+ * Give each vCPU its own ring, mapped at KVM_COALESCED_MMIO_PAGE_OFFSET of
+ * the vCPU fd in place of the shared one.  Writes coalesced by a vCPU are
+ * then only ordered with respect to that vCPU's other accesses.
+ */
+int kvm_vm_ioctl_enable_coalesced_mmio_per_vcpu(struct kvm *kvm)
+{
+	int r = -EINVAL;
+
+	mutex_lock(&kvm->lock);
+	if (!kvm->created_vcpus) {
+		kvm->coalesced_mmio_per_vcpu = true;
+		r = 0;
+	}
+	mutex_unlock(&kvm->lock);
+
+	return r;
+}
+
 int kvm_vm_ioctl_register_coalesced_mmio(struct kvm *kvm,
 					 struct kvm_coalesced_mmio_zone *zone)
 {
@@ -50,25 +50,69 @@ static bool kvm_dirty_ring_full(struct kvm_dirty_ring *ring)
 	return kvm_dirty_ring_used(ring) >= ring->size;
 }
 
-static void kvm_reset_dirty_gfn(struct kvm *kvm, u32 slot, u64 offset, u64 mask)
+/*
+ * Number of 64-gfn masks write-protected per mmu_lock hold while resetting a
+ * ring, so that a large harvested range doesn't take and drop the lock for
+ * every 64 pages, nor hold it for the whole ring.
+ *
+ * The TLBs are flushed before mmu_lock is dropped for each batch.  Ring
+ * resets don't hold slots_lock, which is what serializes the memslot wide
+ * write-protect operations flushing outside of mmu_lock (see
+ * kvm_arch_flush_remote_tlbs_memslot()).  Flushing under mmu_lock makes
+ * sure neither side can rely on a flush the other one has yet to issue.
+ */
+#define KVM_DIRTY_RING_RESET_BATCH	32
+
+struct kvm_dirty_ring_reset_batch {
+	struct kvm_memory_slot *memslot;
+	u32 slot;
+	int nr;		/* masks done under the current mmu_lock hold */
+};
+
+static void kvm_reset_dirty_gfn(struct kvm *kvm,
+				struct kvm_dirty_ring_reset_batch *batch,
+				u32 slot, u64 offset, u64 mask)
 {
 	struct kvm_memory_slot *memslot;
 	int as_id, id;
 
-	as_id = slot >> 16;
-	id = (u16)slot;
-
-	if (as_id >= KVM_ADDRESS_SPACE_NUM || id >= KVM_USER_MEM_SLOTS)
+	if (!mask)
 		return;
 
-	memslot = id_to_memslot(__kvm_memslots(kvm, as_id), id);
+	if (!batch->memslot || batch->slot != slot) {
+		as_id = slot >> 16;
+		id = (u16)slot;
+
+		if (as_id >= KVM_ADDRESS_SPACE_NUM || id >= KVM_USER_MEM_SLOTS)
+			return;
+
+		batch->memslot = id_to_memslot(__kvm_memslots(kvm, as_id), id);
+		batch->slot = slot;
+	}
+	memslot = batch->memslot;
 
 	if (!memslot || (offset + __fls(mask)) >= memslot->npages)
 		return;
 
-	KVM_MMU_LOCK(kvm);
+	if (!batch->nr++)
+		KVM_MMU_LOCK(kvm);
 	kvm_arch_mmu_enable_log_dirty_pt_masked(kvm, memslot, offset, mask);
-	KVM_MMU_UNLOCK(kvm);
+	if (batch->nr == KVM_DIRTY_RING_RESET_BATCH) {
+		kvm_flush_remote_tlbs(kvm);
+		KVM_MMU_UNLOCK(kvm);
+		batch->nr = 0;
+		cond_resched();
+	}
+}
+
+static void kvm_reset_dirty_gfn_finish(struct kvm *kvm,
+				       struct kvm_dirty_ring_reset_batch *batch)
+{
+	if (batch->nr) {
+		kvm_flush_remote_tlbs(kvm);
+		KVM_MMU_UNLOCK(kvm);
+	}
+	batch->nr = 0;
 }
 
 int kvm_dirty_ring_alloc(struct kvm_dirty_ring *ring, int index, u32 size)
@@ -82,6 +126,7 @@ int kvm_dirty_ring_alloc(struct kvm_dirty_ring *ring, int index, u32 size)
 	ring->dirty_index = 0;
 	ring->reset_index = 0;
 	ring->index = index;
+	mutex_init(&ring->reset_lock);
 
 	return 0;
 }
@@ -103,6 +148,7 @@ static inline bool kvm_dirty_gfn_harvested(struct kvm_dirty_gfn *gfn)
 
 int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 {
+	struct kvm_dirty_ring_reset_batch batch = { };
 	u32 cur_slot, next_slot;
 	u64 cur_offset, next_offset;
 	unsigned long mask;
@@ -113,6 +159,8 @@ int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 	/* This is only needed to make compilers happy */
 	cur_slot = cur_offset = mask = 0;
 
+	mutex_lock(&ring->reset_lock);
+
 	while (true) {
 		entry = &ring->dirty_gfns[ring->reset_index & (ring->size - 1)];
 
@@ -147,14 +195,16 @@ int kvm_dirty_ring_reset(struct kvm *kvm, struct kvm_dirty_ring *ring)
 				continue;
 			}
 		}
-		kvm_reset_dirty_gfn(kvm, cur_slot, cur_offset, mask);
+		kvm_reset_dirty_gfn(kvm, &batch, cur_slot, cur_offset, mask);
 		cur_slot = next_slot;
 		cur_offset = next_offset;
 		mask = 1;
 		first_round = false;
 	}
 
-	kvm_reset_dirty_gfn(kvm, cur_slot, cur_offset, mask);
+	kvm_reset_dirty_gfn(kvm, &batch, cur_slot, cur_offset, mask);
+	kvm_reset_dirty_gfn_finish(kvm, &batch);
+	mutex_unlock(&ring->reset_lock);
 
 	/*
 	 * The request KVM_REQ_DIRTY_RING_SOFT_FULL will be cleared
@@ -494,6 +494,7 @@ static void kvm_vcpu_destroy(struct kvm_vcpu *vcpu)
 	 */
 	put_pid(rcu_dereference_protected(vcpu->pid, 1));
 
+	kvm_coalesced_mmio_vcpu_free(vcpu);
 	free_page((unsigned long)vcpu->run);
 	kmem_cache_free(kvm_vcpu_cache, vcpu);
 }
@@ -3805,7 +3806,8 @@ static vm_fault_t kvm_vcpu_fault(struct vm_fault *vmf)
 #endif
 #ifdef CONFIG_KVM_MMIO
 	else if (vmf->pgoff == KVM_COALESCED_MMIO_PAGE_OFFSET)
-		page = virt_to_page(vcpu->kvm->coalesced_mmio_ring);
+		page = virt_to_page(vcpu->coalesced_mmio_ring ?:
+				    vcpu->kvm->coalesced_mmio_ring);
 #endif
 	else if (kvm_page_in_dirty_ring(vcpu->kvm, vmf->pgoff))
 		page = kvm_dirty_ring_get_page(
@@ -3934,10 +3936,14 @@ static int kvm_vm_ioctl_create_vcpu(struct kvm *kvm, u32 id)
 
 	kvm_vcpu_init(vcpu, kvm, id);
 
-	r = kvm_arch_vcpu_create(vcpu);
+	r = kvm_coalesced_mmio_vcpu_init(vcpu);
 	if (r)
 		goto vcpu_free_run_page;
 
+	r = kvm_arch_vcpu_create(vcpu);
+	if (r)
+		goto vcpu_free_coalesced_mmio;
+
 	if (kvm->dirty_ring_size) {
 		r = kvm_dirty_ring_alloc(&vcpu->dirty_ring,
 					 id, kvm->dirty_ring_size);
@@ -3990,6 +3996,8 @@ static int kvm_vm_ioctl_create_vcpu(struct kvm *kvm, u32 id)
 	kvm_dirty_ring_free(&vcpu->dirty_ring);
 arch_vcpu_destroy:
 	kvm_arch_vcpu_destroy(vcpu);
+vcpu_free_coalesced_mmio:
+	kvm_coalesced_mmio_vcpu_free(vcpu);
 vcpu_free_run_page:
 	free_page((unsigned long)vcpu->run);
 vcpu_free:
@@ -4050,6 +4058,29 @@ static int kvm_vcpu_ioctl_get_stats_fd(struct kvm_vcpu *vcpu)
 	return fd;
 }
 
+/*
+ * Reset only the ring of @vcpu, so that userspace can harvest and reset the
+ * rings of different vcpus from different threads. The memslots are only
+ * looked up, so SRCU is enough and slots_lock is left alone; concurrent resets
+ * of the same ring serialize on the ring itself.  Without slots_lock the
+ * reset has to flush the TLBs before dropping mmu_lock, which
+ * kvm_dirty_ring_reset() does.
+ */
+static int kvm_vcpu_ioctl_reset_dirty_ring(struct kvm_vcpu *vcpu)
+{
+	struct kvm *kvm = vcpu->kvm;
+	int cleared, idx;
+
+	if (!kvm->dirty_ring_size)
+		return -EINVAL;
+
+	idx = srcu_read_lock(&kvm->srcu);
+	cleared = kvm_dirty_ring_reset(kvm, &vcpu->dirty_ring);
+	srcu_read_unlock(&kvm->srcu, idx);
+
+	return cleared;
+}
+
 static long kvm_vcpu_ioctl(struct file *filp,
 			   unsigned int ioctl, unsigned long arg)
 {
@@ -4073,6 +4104,13 @@ static long kvm_vcpu_ioctl(struct file *filp,
 	if (r != -ENOIOCTLCMD)
 		return r;
 
+	/*
+	 * The dirty ring of a running vcpu is reset from another thread,
+	 * so don't wait for KVM_RUN to drop vcpu->mutex.
+	 */
+	if (ioctl == KVM_RESET_DIRTY_RING)
+		return kvm_vcpu_ioctl_reset_dirty_ring(vcpu);
+
 	if (mutex_lock_killable(&vcpu->mutex))
 		return -EINTR;
 	switch (ioctl) {
@@ -4490,6 +4528,7 @@ static long kvm_vm_ioctl_check_extension_generic(struct kvm *kvm, long arg)
 	case KVM_CAP_COALESCED_MMIO:
 		return KVM_COALESCED_MMIO_PAGE_OFFSET;
 	case KVM_CAP_COALESCED_PIO:
+	case KVM_CAP_COALESCED_MMIO_PER_VCPU:
 		return 1;
 #endif
 #ifdef CONFIG_KVM_GENERIC_DIRTYLOG_READ_PROTECT
@@ -4520,6 +4559,9 @@ static long kvm_vm_ioctl_check_extension_generic(struct kvm *kvm, long arg)
 #endif
 #ifdef CONFIG_NEED_KVM_DIRTY_RING_WITH_BITMAP
 	case KVM_CAP_DIRTY_LOG_RING_WITH_BITMAP:
+#endif
+#ifdef CONFIG_HAVE_KVM_DIRTY_RING
+	case KVM_CAP_DIRTY_LOG_RING_VCPU_RESET:
 #endif
 	case KVM_CAP_BINARY_STATS_FD:
 	case KVM_CAP_SYSTEM_EVENT_DATA:
@@ -4584,9 +4626,6 @@ static int kvm_vm_ioctl_reset_dirty_pages(struct kvm *kvm)
 
 	mutex_unlock(&kvm->slots_lock);
 
-	if (cleared)
-		kvm_flush_remote_tlbs(kvm);
-
 	return cleared;
 }
 
@@ -4673,6 +4712,13 @@ static int kvm_vm_ioctl_enable_cap_generic(struct kvm *kvm,
 
 		return r;
 	}
+#ifdef CONFIG_KVM_MMIO
+	case KVM_CAP_COALESCED_MMIO_PER_VCPU:
+		if (cap->flags || cap->args[0])
+			return -EINVAL;
+
+		return kvm_vm_ioctl_enable_coalesced_mmio_per_vcpu(kvm);
+#endif
 	default:
 		return kvm_vm_ioctl_enable_cap(kvm, cap);
 	}